@@ -0,0 +1,209 @@
+/**
+ * @file als_bench.cc
+ * @brief Benchmarks of the hot paths: simulation, Boolean difference, LAC pruning, SAT checks, and LAC rounds
+ * @brief Run from the top directory, e.g., ./als_bench.out --benchmark_out=bench.json --benchmark_out_format=json
+ * 
+ */
+#include <benchmark/benchmark.h>
+#include "als.h"
+
+
+using namespace std;
+
+
+// representative circuits; the first N_ARITH_CIRC ones have few POs, so that their maximum errors fit the SAT benchmarks
+const vector<string> BENCH_CIRCS = {
+    "./input/benchmark/sop/bacs/absdiff.blif",
+    "./input/benchmark/sop/bacs/mac.blif",
+    "./input/benchmark/sop/evoapprox/mul8u.blif",
+    "./input/benchmark/sop/iscas/c880.blif",
+    "./input/benchmark/sop/epfl/int2float.blif",
+};
+const int N_ARITH_CIRC = 3;
+const int BENCH_FRAME = 8192;
+const unsigned BENCH_SEED = 2025;
+
+
+/**
+ * @brief Get the metric of a circuit: MAXED for narrow outputs, otherwise MAXHD
+ * 
+ * @param net          the network
+ * @return METR_TYPE   the metric
+ */
+static METR_TYPE GetBenchMetr(const NetMan& net) {
+    return net.GetPoNum() <= 32? METR_TYPE::MAXED: METR_TYPE::MAXHD;
+}
+
+
+/**
+ * @brief Get an error bound of a circuit, loose enough to keep most LACs
+ * 
+ * @param net     the network
+ * @return ll     the error bound
+ */
+static ll GetBenchBound(const NetMan& net) {
+    return GetBenchMetr(net) == METR_TYPE::MAXED? (1ll << (net.GetPoNum() / 2)): std::max(1, net.GetPoNum() / 8);
+}
+
+
+/**
+ * @brief Build an approximate network by replacing a multi-fanout node with a constant
+ * 
+ * @param accNet     the accurate network
+ * @retval appNet    the approximate network
+ * @return void
+ */
+static void BuildBenchAppNet(const NetMan& accNet, NetMan& appNet) {
+    LACMan lacMan;
+    lacMan.GenConstLACs(appNet);
+    for (const auto& lac: lacMan.GetLacs()) {
+        if (appNet.GetFanoutNum(lac.GetTargId()) > 1 && !appNet.IsPoDriver(lac.GetTargId())) {
+            ApplyLac(appNet, lac);
+            return;
+        }
+    }
+}
+
+
+static void BM_UpdNodeAndPoPatts(benchmark::State& state) {
+    NetMan net(BENCH_CIRCS[state.range(0)]);
+    Simulator smlt(net, BENCH_SEED, BENCH_FRAME);
+    smlt.GenInpPatts();
+    for (auto _: state) {
+        smlt.UpdNodeAndPoPatts();
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(net.GetNetName());
+    state.counters["patterns/s"] = benchmark::Counter(static_cast<double>(BENCH_FRAME) * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_UpdNodeAndPoPatts)->DenseRange(0, static_cast<int>(BENCH_CIRCS.size()) - 1)->Unit(benchmark::kMicrosecond);
+
+
+static void BM_CalcBoolDiff(benchmark::State& state) {
+    NetMan net(BENCH_CIRCS[state.range(0)]);
+    Simulator smlt(net, BENCH_SEED, BENCH_FRAME);
+    smlt.LogicSim();
+    auto topoNodes = smlt.CalcTopoOrd(false);
+    BitMat bdPosWrtNode;
+    int iNode = 0;
+    for (auto _: state) {
+        smlt.CalcBoolDiff(topoNodes, iNode, bdPosWrtNode);
+        benchmark::ClobberMemory();
+        iNode = (iNode + 1) % static_cast<int>(topoNodes.size());
+    }
+    state.SetLabel(net.GetNetName());
+    state.counters["patterns/s"] = benchmark::Counter(static_cast<double>(BENCH_FRAME) * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_CalcBoolDiff)->DenseRange(0, static_cast<int>(BENCH_CIRCS.size()) - 1)->Unit(benchmark::kMicrosecond);
+
+
+static void BM_SimSop(benchmark::State& state) {
+    NetMan net(BENCH_CIRCS[state.range(0)]);
+    Simulator smlt(net, BENCH_SEED, BENCH_FRAME);
+    smlt.LogicSim();
+    // simulate the functions of the 2-input nodes on their fanins, as the LACs do
+    IntVect nodeIds;
+    for (int id = 0; id < net.GetIdMaxPlus1(); ++id) {
+        if (net.IsNode(id) && net.GetFaninNum(id) == 2)
+            nodeIds.emplace_back(id);
+    }
+    assert(!nodeIds.empty());
+    BitMat res(1, BENCH_FRAME);
+    int iNode = 0;
+    for (auto _: state) {
+        int id = nodeIds[iNode];
+        std::array<int, 2> faninIds = {net.GetFaninId(id, 0), net.GetFaninId(id, 1)};
+        smlt.SimSop(faninIds, net.GetSop(id), res[0]);
+        benchmark::ClobberMemory();
+        iNode = (iNode + 1) % static_cast<int>(nodeIds.size());
+    }
+    state.SetLabel(net.GetNetName());
+    state.counters["patterns/s"] = benchmark::Counter(static_cast<double>(BENCH_FRAME) * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SimSop)->DenseRange(0, static_cast<int>(BENCH_CIRCS.size()) - 1);
+
+
+static void BM_PruneLacsWithSim(benchmark::State& state) {
+    NetMan accNet(BENCH_CIRCS[state.range(0)]);
+    NetMan appNet(accNet);
+    Simulator accSmlt(accNet, BENCH_SEED, BENCH_FRAME);
+    accSmlt.LogicSim();
+    LACMan lacMan;
+    lacMan.GenResubLACs(appNet, BENCH_SEED, 4, INT_MAX, 10000);
+    LACVect lacs(lacMan.GetLacs());
+    BatchErrEst errEst(GetBenchMetr(accNet), BENCH_SEED, BENCH_FRAME, static_cast<int>(state.range(1)));
+    for (auto _: state) {
+        state.PauseTiming();
+        lacMan.ReplLacs(lacs);
+        state.ResumeTiming();
+        errEst.PruneLacsWithSim(lacMan, accSmlt, appNet, GetBenchBound(accNet), BENCH_FRAME);
+    }
+    state.SetLabel(accNet.GetNetName());
+    state.counters["LACs/s"] = benchmark::Counter(static_cast<double>(lacs.size()) * state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["patterns/s"] = benchmark::Counter(static_cast<double>(lacs.size()) * BENCH_FRAME * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_PruneLacsWithSim)->ArgsProduct({benchmark::CreateDenseRange(0, static_cast<int>(BENCH_CIRCS.size()) - 1, 1), {1, 4}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+
+static void BM_ComputeMaxErr(benchmark::State& state) {
+    NetMan accNet(BENCH_CIRCS[state.range(0)]);
+    NetMan appNet(accNet);
+    BuildBenchAppNet(accNet, appNet);
+    for (auto _: state) {
+        ErrMan errMan(accNet, appNet);
+        benchmark::DoNotOptimize(errMan.ComputeMaxErr(METR_TYPE::MAXED));
+    }
+    state.SetLabel(accNet.GetNetName());
+    state.counters["queries/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ComputeMaxErr)->DenseRange(0, N_ARITH_CIRC - 1)->Unit(benchmark::kMillisecond);
+
+
+static void BM_SatCheck(benchmark::State& state) {
+    // one check of a LAC: build the miter with the embedded bound, encode it, and solve it once
+    NetMan accNet(BENCH_CIRCS[state.range(0)]);
+    NetMan appNet(accNet);
+    BuildBenchAppNet(accNet, appNet);
+    int nPo = accNet.GetPoNum();
+    auto pDevNet = GenDevCompNetEmbedErrBound(GenDevCompNet(METR_TYPE::MAXED, nPo), nPo, GetBenchBound(accNet));
+    for (auto _: state) {
+        ErrMan errMan(accNet, appNet, *pDevNet);
+        benchmark::DoNotOptimize(errMan.SolveSat());
+    }
+    state.SetLabel(accNet.GetNetName());
+    state.counters["SAT calls/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SatCheck)->DenseRange(0, N_ARITH_CIRC - 1)->Unit(benchmark::kMillisecond);
+
+
+static void BM_SimplifyWithSingleLac(benchmark::State& state) {
+    // SimplifyWithSingleLac runs the rounds until no LAC is applicable; the counter reports the rounds
+    NetMan accNet(BENCH_CIRCS[state.range(0)]);
+    CreateDir("./tmp");
+    ALSOpt options("MAXED", BENCH_SEED, BENCH_FRAME, 0, 0.0, GetBenchBound(accNet), "./tmp/bench_");
+    ALSMan alsMan(accNet, options);
+    ll nRound = 0;
+    for (auto _: state) {
+        state.PauseTiming();
+        NetMan appNet(accNet);
+        int round = 1;
+        state.ResumeTiming();
+        alsMan.SimplifyWithSingleLac(LAC_TYPE::RESUB, appNet, round, std::chrono::high_resolution_clock::now(), true, false);
+        nRound += round;
+    }
+    state.SetLabel(accNet.GetNetName());
+    state.counters["rounds/s"] = benchmark::Counter(static_cast<double>(nRound), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SimplifyWithSingleLac)->DenseRange(0, N_ARITH_CIRC - 1)->Unit(benchmark::kSecond)->Iterations(1);
+
+
+int main(int argc, char** argv) {
+    GlobStartAbc();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    GlobStopAbc();
+    return 0;
+}
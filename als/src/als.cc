@@ -5,6 +5,7 @@
  * @date 2025-01-21
  * 
  */
+#include <fstream>
 #include "als.h"
 #include "pbd.h"
 
@@ -27,9 +28,10 @@ void ALSMan::Run_v1() {
     oss << options.outpPath << round;
     appNet.WriteNet(oss.str() + ".blif", true); // appNet.WriteNet(oss.str() + ".dot", true);
     clock_t st = clock();
+    // the PBD manager keeps its buffers and random input patterns across rounds
+    mecals_v1::PBDMan pbdMan(options.nThread);
     for (round = 1; ; ++round) {
         std::cout << "---------- round " << round <<  "---------- " << std::endl;
-        mecals_v1::PBDMan pbdMan;
         pbdMan.BuildMit(accNetStrash, appNet, *pDevCompNetEmbErr);
         pbdMan.BuildPBD(options.mecals1_exactPBDPerc);
         int ret = pbdMan.Synth(true); // enable SASIMI
@@ -75,14 +77,7 @@ void ALSMan::Run_v2() {
     SimplifyWithSingleLac(LAC_TYPE::SASIMI, appNet, round, startTime, fInclConst, fSimplify);
 
     // accurate logic synthesis
-    int resyn2rsTime = 3;
-    std::string resyn2rsStr;
-    for (int i = 0; i < resyn2rsTime; ++i)
-        resyn2rsStr += "resyn2rs; ps;";
-    appNet.Comm(fmt::format("ps; st; {}", resyn2rsStr));
-    appNet.Comm("dch; amap; stime;");
-    double area = appNet.GetArea(), delay = appNet.GetDelay();
-    appNet.WriteNet(fmt::format("{}final_mapped_a{:.2f}_d{:.2f}.blif", options.outpPath, area, delay), true);
+    SynthAndWrite(appNet);
     PrintRuntime(startTime);
 }
 
@@ -117,14 +112,7 @@ void ALSMan::Run_Trunc() {
         }
     }
     // accurate logic synthesis
-    int resyn2rsTime = 3;
-    std::string resyn2rsStr;
-    for (int i = 0; i < resyn2rsTime; ++i)
-        resyn2rsStr += "resyn2rs; ps;";
-    appNet.Comm(fmt::format("ps; st; {}", resyn2rsStr));
-    appNet.Comm("dch; amap; stime;");
-    double area = appNet.GetArea(), delay = appNet.GetDelay();
-    appNet.WriteNet(fmt::format("{}final_mapped_a{:.2f}_d{:.2f}.blif", options.outpPath, area, delay), true);
+    SynthAndWrite(appNet);
 }
 
 
@@ -138,35 +126,56 @@ void ALSMan::Run_FastFlow() {
     auto startTime = std::chrono::high_resolution_clock::now();
     assert(accNet.GetNetType() == NET_TYPE::SOP);
     auto appNet = accNet;
-    // truncation
+    // truncation; when resuming, it has been applied on the network of the checkpoint
+    if (pResume == nullptr)
+        TruncPos(appNet);
+    PrintRuntime(startTime);
+    SimplifyWithMixedLacs(appNet, startTime);
+
+    // accurate logic synthesis
+    SynthAndWrite(appNet);
+    PrintRuntime(startTime);
+}
+
+
+/**
+ * @brief Truncate the POs from the least significant bit, i.e., replace their drivers with constants, while the maximum error is within the bound
+ * @brief Only used for the MAXED metric; the network is swept and written afterwards
+ * 
+ * @param appNet   the approximate network, which should be the accurate one, since the truncation assumes zero error at the start
+ * @retval appNet  the truncated network
+ * @return void
+ */
+void ALSMan::TruncPos(NetMan& appNet) {
     auto constIds = appNet.CreateConstsIfNotExist();
     appNet.MergeConst();
     IntVect replTrace;
     if (options.metrType == METR_TYPE::MAXED) {
+    // changing the iBit-th PO increases the maximum error by at most (1 << iBit), which bounds the search of the SAT solver
+    // the trials share one miter and one SAT solver, and only differ in the assumptions on the controlled MUXes of the POs
+    TruncErrMan truncMan(accNet, appNet, METR_TYPE::MAXED);
+    BigInt currErr(0);
     for (int iBit = 0; iBit < appNet.GetPoNum(); ++iBit) {
         auto drivId = appNet.GetPoDrivId(iBit);
+        BigInt uppBound = currErr + (BigInt(1) << iBit);
         // try constant 0
-        if (drivId != constIds.first)
-            appNet.TempRepl_v2(drivId, constIds.first, replTrace, false);
-        ErrMan errMan0(accNet, appNet);
-        auto maxErr0 = errMan0.ComputeMaxErr(METR_TYPE::MAXED);
-        appNet.Recov_v2(replTrace, false);
+        auto maxErr0 = truncMan.TryTrunc(iBit, 0, 0, uppBound);
         // try constant 1
-        if (drivId != constIds.second)
-            appNet.TempRepl_v2(drivId, constIds.second, replTrace, false);
-        ErrMan errMan1(accNet, appNet);
-        auto maxErr1 = errMan1.ComputeMaxErr(METR_TYPE::MAXED);
-        appNet.Recov_v2(replTrace, false);
+        auto maxErr1 = truncMan.TryTrunc(iBit, 1, 0, uppBound);
         // apply the best one
         if (maxErr0 <= options.errUppBound || maxErr1 <= options.errUppBound) {
             if (maxErr0 <= maxErr1) {
                 if (drivId != constIds.first)
                     appNet.TempRepl_v2(drivId, constIds.first, replTrace, true);
+                truncMan.CommitTrunc(iBit, 0);
+                currErr = maxErr0;
                 fmt::print("current error = {}\n", maxErr0.str());
             }
             else {
                 if (drivId != constIds.second)
                     appNet.TempRepl_v2(drivId, constIds.second, replTrace, true);
+                truncMan.CommitTrunc(iBit, 1);
+                currErr = maxErr1;
                 fmt::print("current error = {}\n", maxErr1.str());
             }
         }
@@ -176,8 +185,18 @@ void ALSMan::Run_FastFlow() {
     }
     appNet.Sweep();
     appNet.WriteBlif(fmt::format("{}r0_{}xxx_s{}_d{}.blif", options.outpPath, options.metrType, appNet.GetArea(), appNet.GetDelay()));
-    PrintRuntime(startTime);
-    
+}
+
+
+/**
+ * @brief Simplify the network with constant LACs and then SASIMI LACs, as in the fast flow
+ * 
+ * @param appNet     the approximate network
+ * @param startTime  the start time of the flow
+ * @retval appNet    the simplified network in SOP form
+ * @return void
+ */
+void ALSMan::SimplifyWithMixedLacs(NetMan& appNet, const std::chrono::time_point<std::chrono::high_resolution_clock>& startTime) {
     // try constant LAC
     int round = 1;
     bool fInclConst = 0;
@@ -186,17 +205,98 @@ void ALSMan::Run_FastFlow() {
 
     // try SASIMI LAC
     SimplifyWithSingleLac(LAC_TYPE::SASIMI, appNet, round, startTime, fInclConst, fSimplify);
+}
 
-    // accurate logic synthesis
+
+/**
+ * @brief Perform accurate logic synthesis and technology mapping, and write the mapped network
+ * 
+ * @param appNet   the approximate network
+ * @retval appNet  the mapped network
+ * @return void
+ */
+void ALSMan::SynthAndWrite(NetMan& appNet) {
     int resyn2rsTime = 3;
     std::string resyn2rsStr;
     for (int i = 0; i < resyn2rsTime; ++i)
         resyn2rsStr += "resyn2rs; ps;";
-    appNet.Comm(fmt::format("ps; st; {}", resyn2rsStr));
-    appNet.Comm("dch; amap; stime;");
+    {
+        ProfTimer timer(PROF_PHASE::RESYN);
+        appNet.Comm(fmt::format("ps; st; {}", resyn2rsStr));
+        appNet.Comm("dch; amap; stime;");
+    }
     double area = appNet.GetArea(), delay = appNet.GetDelay();
     appNet.WriteNet(fmt::format("{}final_mapped_a{:.2f}_d{:.2f}.blif", options.outpPath, area, delay), true);
-    PrintRuntime(startTime);
+}
+
+
+/**
+ * @brief Set the error upper bound and the output path, e.g., for the next bound of a sweep
+ * @brief The simulator, the pattern bank, and the deviation network are kept; only the network with the embedded bound is regenerated (or taken from the cache)
+ * 
+ * @param errUppBound   the error upper bound
+ * @param outpPath      the output path
+ * @return void
+ */
+void ALSMan::SetErrUppBound(ll errUppBound, const std::string& outpPath) {
+    if (errUppBound < 0 || (options.metrType == METR_TYPE::MAXHD && errUppBound >= accNet.GetPoNum())) {
+        fmt::print(stderr, "Error: invalid error upper bound {}\n", errUppBound);
+        assert(0);
+    }
+    options.errUppBound = errUppBound;
+    options.outpPath = outpPath;
+    if (errUppBound > 0)
+        pDevCompNetEmbErr = GenDevCompNetEmbedErrBound(pDevCompNet, accNet.GetPoNum(), errUppBound);
+    else
+        pDevCompNetEmbErr = nullptr;
+    nStage = 0;
+    prevCkptNetPath.clear();
+    pSatSched->Restart();
+}
+
+
+/**
+ * @brief Run the ALS flow for a list of error upper bounds in increasing order
+ * @brief Each bound warm-starts from the approximate network of the previous bound, which is within the larger bound as well;
+ * @brief the simulator and the pattern bank with the counter examples of the smaller bounds are shared, and each bound writes its outputs to "<outpPath>e<bound>_"
+ * 
+ * @param errUppBounds   the error upper bounds
+ * @return void
+ */
+void ALSMan::RunSweep(LLVect errUppBounds) {
+    if (pResume != nullptr) {
+        fmt::print(stderr, "Error: the sweep mode does not support resuming\n");
+        assert(0);
+    }
+    std::ranges::sort(errUppBounds);
+    errUppBounds.erase(std::unique(errUppBounds.begin(), errUppBounds.end()), errUppBounds.end());
+    fmt::print("Sweep the error upper bounds: {}\n", fmt::join(errUppBounds, ", "));
+    assert(accNet.GetNetType() == NET_TYPE::SOP);
+    auto basePath = options.outpPath;
+    auto appNet = accNet;
+    for (int iBound = 0; iBound < static_cast<int>(errUppBounds.size()); ++iBound) {
+        auto errUppBound = errUppBounds[iBound];
+        fmt::print("{}\n{}error upper bound {}{}\n{}\n", DASH_LINE, HALF_DASH_LINE, errUppBound, HALF_DASH_LINE, DASH_LINE);
+        SetErrUppBound(errUppBound, fmt::format("{}e{}_", basePath, errUppBound));
+        auto startTime = std::chrono::high_resolution_clock::now();
+        if (options.fFastFlow) {
+            // the truncation assumes zero error at the start, so it is only applied for the first bound
+            if (iBound == 0)
+                TruncPos(appNet);
+            SimplifyWithMixedLacs(appNet, startTime);
+        }
+        else {
+            int round = 1;
+            bool fInclConst = 1;
+            bool fSimplify = 0;
+            SimplifyWithSingleLac(LAC_TYPE::SASIMI, appNet, round, startTime, fInclConst, fSimplify);
+        }
+        // the mapped copy is written, and the network in SOP form warm-starts the next bound
+        auto mappedNet = appNet;
+        SynthAndWrite(mappedNet);
+        fmt::print("Sweep: error upper bound = {}, area = {:.2f}, delay = {:.2f}\n", errUppBound, mappedNet.GetArea(), mappedNet.GetDelay());
+        PrintRuntime(startTime);
+    }
 }
 
 
@@ -208,6 +308,13 @@ void ALSMan::Run_FastFlow() {
  * @param startTime 
  */
 void ALSMan::SimplifyWithSingleLac(LAC_TYPE lacType, NetMan& appNet, int& round, const std::chrono::time_point<std::chrono::high_resolution_clock>& startTime, bool inclConst, bool fSimplify) {
+    int iStage = nStage++;
+    // skip the stages finished before the checkpoint
+    if (pResume != nullptr && iStage < pResume->stage) {
+        fmt::print("Resume: skip the finished stage {} using {} LAC\n", iStage, lacType);
+        return;
+    }
+
     // zero error upper bound
     if (options.errUppBound == 0) {
         fmt::print("Early stop: the maximum error upper bound is 0\n");
@@ -218,40 +325,72 @@ void ALSMan::SimplifyWithSingleLac(LAC_TYPE lacType, NetMan& appNet, int& round,
     fmt::print("{}\n", DASH_LINE);
     fmt::print("{}Using {} LAC{}\n", HALF_DASH_LINE, lacType, HALF_DASH_LINE);
     fmt::print("{}\n", DASH_LINE);
-    static int countExNum = 0; // track the ending index of counter-example simulation patterns in accSmlt
-    std::unordered_set<std::string> lacBlackList; // black list for LACs, which cause the SAT solver to return UNDEF
+    LacBlackList lacBlackList; // black list of the LACs, which cause the SAT solver to return UNDEF
     int oldSize = static_cast<int>(appNet.GetArea()), oldDepth = static_cast<int>(appNet.GetDelay());
+    if (pResume != nullptr) {
+        RestoreCkpt(appNet, round, oldSize, oldDepth, lacBlackList);
+        pResume = nullptr;
+    }
 
     // main loop
+    LACMan lacMan; // kept across rounds for the incremental generation
     for (; ; ++round) {
+        if (pSatSched->IsTimeOut()) {
+            fmt::print("Early stop: the time limit of {}s is reached\n", options.timeLimit);
+            break;
+        }
         fmt::print("{}round {}{}\n", HALF_DASH_LINE, round, HALF_DASH_LINE);
+        ProfRound profRound(round, fmt::format("{}", lacType));
+        if (options.fCkpt)
+            SaveCkpt(appNet, iStage, round, oldSize, oldDepth, lacBlackList);
         // generate LACs
-        LACMan lacMan;
-        if (lacType == LAC_TYPE::CONSTANT)
-            lacMan.GenConstLACs(appNet);
-        else if (lacType == LAC_TYPE::SASIMI)
-            lacMan.GenSasimiLACs(appNet, options.maxCandLacs, inclConst);
-        else if (lacType == LAC_TYPE::RESUB)
-            lacMan.GenResubLACs(appNet, options.seed, options.appResub_nFrame4ResubGen, options.appResub_maxLevelDiff, options.maxCandLacs, inclConst);
-        else {
-            fmt::print(stderr, "Error: unsupported LAC type\n");
-            assert(0);
+        {
+            ProfTimer timer(PROF_PHASE::LAC_GEN);
+            if (options.fIncLacGen)
+                lacMan.GenLACsInc(lacType, appNet, options.seed, options.appResub_nFrame4ResubGen, options.appResub_maxLevelDiff, options.maxCandLacs, inclConst, options.nThread);
+            else if (lacType == LAC_TYPE::CONSTANT)
+                lacMan.GenConstLACs(appNet);
+            else if (lacType == LAC_TYPE::SASIMI)
+                lacMan.GenSasimiLACs(appNet, options.maxCandLacs, inclConst, nullptr, options.nThread);
+            else if (lacType == LAC_TYPE::RESUB)
+                lacMan.GenResubLACs(appNet, options.seed, options.appResub_nFrame4ResubGen, options.appResub_maxLevelDiff, options.maxCandLacs, inclConst, nullptr, options.nThread);
+            else {
+                fmt::print(stderr, "Error: unsupported LAC type\n");
+                assert(0);
+            }
         }
         // remove LACs in the black list
         lacMan.RemLacsFromBlackList(lacBlackList);
+        Profiler::Get().AddCnt(PROF_CNT::LAC_GEN, lacMan.GetLacNum());
         // use logic simulation to estimate maximum error lower bound and prune large-error LACs
-        BatchErrEst errEst(options.metrType, options.seed, options.nFrame);
-        errEst.CompLacErrsBySimAndPruneBadLacs(lacMan, *pAccSmlt, appNet, options.errUppBound);
+        // the bank patterns are also simulated, and the patterns that keep rejecting LACs stay in the bank
+        pPattBank->Decay();
+        BatchErrEst errEst(options.metrType, options.seed, options.nFrame, options.nThread);
+        if (options.fLazyTopK)
+            errEst.CompLacErrsBySimAndKeepTopKLacs(lacMan, *pAccSmlt, appNet, options.errUppBound, options.topK, pPattBank.get());
+        else
+            errEst.CompLacErrsBySimAndPruneBadLacs(lacMan, *pAccSmlt, appNet, options.errUppBound, pPattBank.get());
+        pPattBank->Print();
+        // remember the surviving LACs and their errors for the incremental generation
+        if (options.fIncLacGen)
+            lacMan.CacheLacs();
         // if no valid LACs, break
         if (lacMan.GetLacNum() == 0)
             break;
         // sort LACs and keep top-K
-        const int TOP_K_LAC = 100;
-        lacMan.SortAndKeepTopKLACs(TOP_K_LAC);
+        lacMan.SortAndKeepTopKLACs(options.topK);
         lacMan.PrintLACs(10);
         // use SAT to estimate error
-        bool existValidLac = ApplyMultValidLacs(lacMan, appNet, lacBlackList, countExNum);
-        // bool existValidLac = ApplyMultValidLacs_NoSimPrune(lacMan, appNet, lacBlackList, countExNum);
+        bool existValidLac = false;
+        if (options.nThread > 1)
+            existValidLac = ApplyMultValidLacs_Par(lacMan, appNet, lacBlackList);
+        else if (options.nMaxGroup > 1)
+            existValidLac = ApplyMultValidLacs_Group(lacMan, appNet, lacBlackList);
+        else if (options.fIncSat)
+            existValidLac = ApplyMultValidLacs_IncSAT(lacMan, appNet, lacBlackList);
+        else
+            existValidLac = ApplyMultValidLacs(lacMan, appNet, lacBlackList);
+        // bool existValidLac = ApplyMultValidLacs_NoSimPrune(lacMan, appNet, lacBlackList);
         if (!existValidLac)
             break;
         // post processing
@@ -271,9 +410,325 @@ void ALSMan::SimplifyWithSingleLac(LAC_TYPE lacType, NetMan& appNet, int& round,
     }
     PrintRuntime(startTime);
 
-    // final logic synthesis
-    if (fSimplify)
+    // final logic synthesis, reported as a round of its own
+    // the flow stays on SOP, since the error estimation (CalcBoolDiff) and TempApplyLac work on SOP nodes
+    if (fSimplify) {
+        ProfRound profRound(round, fmt::format("{}-resyn", lacType));
+        ProfTimer timer(PROF_PHASE::RESYN);
         appNet.Comm("st; resyn2rs; ps; resyn2rs; ps; resyn2rs; ps; logic; sop;");
+    }
+}
+
+
+/**
+ * @brief Save the options in text, one "<name> <value>" line per option, ended by "end_options"
+ * @brief The runtime knobs (nThread, nSatThread, timeLimit, fQuiet, fCkpt, profPath) are not saved, so that they can be changed when resuming
+ * 
+ * @param fout   the output stream
+ * @return void
+ */
+void ALSOpt::Save(std::ostream& fout) const {
+    fout << fmt::format("metrType {}\n", metrType);
+    fout << fmt::format("seed {}\n", seed);
+    fout << fmt::format("nFrame {}\n", nFrame);
+    fout << fmt::format("fUseMecals1_0 {}\n", fUseMecals1_0);
+    fout << fmt::format("fFastFlow {}\n", fFastFlow);
+    fout << fmt::format("appResub_nFrame4ResubGen {}\n", appResub_nFrame4ResubGen);
+    fout << fmt::format("appResub_maxLevelDiff {}\n", appResub_maxLevelDiff);
+    fout << fmt::format("maxCandLacs {}\n", maxCandLacs);
+    fout << fmt::format("mecals1_exactPBDPerc {}\n", mecals1_exactPBDPerc);
+    fout << fmt::format("fIncSat {}\n", fIncSat);
+    fout << fmt::format("nPattBank {}\n", nPattBank);
+    fout << fmt::format("topK {}\n", topK);
+    fout << fmt::format("fLazyTopK {}\n", fLazyTopK);
+    fout << fmt::format("fIncLacGen {}\n", fIncLacGen);
+    fout << fmt::format("satInitConfl {}\n", satInitConfl);
+    fout << fmt::format("satMaxConfl {}\n", satMaxConfl);
+    fout << fmt::format("nMaxGroup {}\n", nMaxGroup);
+    fout << fmt::format("errUppBound {}\n", errUppBound);
+    fout << fmt::format("outpPath {}\n", outpPath);
+    fout << "end_options\n";
+}
+
+
+/**
+ * @brief Load the options saved by Save(); the options absent in the stream are kept
+ * 
+ * @param fin    the input stream
+ * @retval this  the loaded options
+ * @return void
+ */
+void ALSOpt::Load(std::istream& fin) {
+    std::string name;
+    while (fin >> name && name != "end_options") {
+        if (name == "metrType") {
+            std::string str;
+            fin >> str;
+            metrType = Str2MetrType(str);
+        }
+        else if (name == "seed")
+            fin >> seed;
+        else if (name == "nFrame")
+            fin >> nFrame;
+        else if (name == "fUseMecals1_0")
+            fin >> fUseMecals1_0;
+        else if (name == "fFastFlow")
+            fin >> fFastFlow;
+        else if (name == "appResub_nFrame4ResubGen")
+            fin >> appResub_nFrame4ResubGen;
+        else if (name == "appResub_maxLevelDiff")
+            fin >> appResub_maxLevelDiff;
+        else if (name == "maxCandLacs")
+            fin >> maxCandLacs;
+        else if (name == "mecals1_exactPBDPerc")
+            fin >> mecals1_exactPBDPerc;
+        else if (name == "fIncSat")
+            fin >> fIncSat;
+        else if (name == "nPattBank")
+            fin >> nPattBank;
+        else if (name == "topK")
+            fin >> topK;
+        else if (name == "fLazyTopK")
+            fin >> fLazyTopK;
+        else if (name == "fIncLacGen")
+            fin >> fIncLacGen;
+        else if (name == "satInitConfl")
+            fin >> satInitConfl;
+        else if (name == "satMaxConfl")
+            fin >> satMaxConfl;
+        else if (name == "nMaxGroup")
+            fin >> nMaxGroup;
+        else if (name == "errUppBound")
+            fin >> errUppBound;
+        else if (name == "outpPath") {
+            fin >> std::ws;
+            std::getline(fin, outpPath);
+        }
+        else {
+            fmt::print(stderr, "Error: unknown option {} in the checkpoint\n", name);
+            assert(0);
+        }
+        if (!fin) {
+            fmt::print(stderr, "Error: invalid value of option {} in the checkpoint\n", name);
+            assert(0);
+        }
+    }
+    if (name != "end_options") {
+        fmt::print(stderr, "Error: truncated options in the checkpoint\n");
+        assert(0);
+    }
+}
+
+
+/**
+ * @brief Write a checkpoint at the beginning of a round: "<outpPath>ckpt.txt" holds the options, the round state, the black list, and the pattern bank,
+ * @brief and refers to the approximate network in BLIF; the text is written to a temporary file and renamed, so an interrupted write keeps the previous checkpoint
+ * 
+ * @param appNet         the approximate network
+ * @param iStage         the index of the SimplifyWithSingleLac stage
+ * @param round          the round to start
+ * @param oldSize        the size of the approximate network before the round
+ * @param oldDepth       the depth of the approximate network before the round
+ * @param lacBlackList   the black list of LACs
+ * @return void
+ */
+void ALSMan::SaveCkpt(const NetMan& appNet, int iStage, int round, int oldSize, int oldDepth, const LacBlackList& lacBlackList) {
+    auto netPath = fmt::format("{}ckpt_s{}_r{}.blif", options.outpPath, iStage, round);
+    appNet.WriteBlif(netPath);
+    auto ckptPath = options.outpPath + "ckpt.txt";
+    auto tmpPath = ckptPath + ".tmp";
+    {
+        std::ofstream fout(tmpPath, std::ios::trunc);
+        fout << "ALS_CKPT 1\n";
+        options.Save(fout);
+        fout << fmt::format("stage {}\nround {}\noldSize {}\noldDepth {}\n", iStage, round, oldSize, oldDepth);
+        fout << fmt::format("net {}\n", netPath);
+        // the black-listed LACs are saved on the object names, since the object IDs change when the network is read back
+        std::vector<std::string> blackLacs;
+        auto isLive = [&](int id) {return id >= 0 && id < appNet.GetIdMaxPlus1() && appNet.GetObj(id) != nullptr;};
+        for (const auto& [key, lac]: lacBlackList) {
+            if (!isLive(lac.GetTargId()) || !std::ranges::all_of(lac.GetDivIds(), isLive))
+                continue;
+            std::string str = fmt::format("{} {} {}", lac.GetSopId(), lac.GetDivIds().size(), appNet.GetName(lac.GetTargId()));
+            for (int divId: lac.GetDivIds())
+                str += " " + appNet.GetName(divId);
+            blackLacs.emplace_back(std::move(str));
+        }
+        fout << fmt::format("black {}\n", blackLacs.size());
+        for (const auto& str: blackLacs)
+            fout << str << "\n";
+        pPattBank->Save(fout);
+        fout << "end\n";
+        if (!fout) {
+            fmt::print(stderr, "Error: cannot write the checkpoint {}\n", tmpPath);
+            assert(0);
+        }
+    }
+    std::filesystem::rename(tmpPath, ckptPath);
+    if (!prevCkptNetPath.empty() && prevCkptNetPath != netPath)
+        std::filesystem::remove(prevCkptNetPath);
+    prevCkptNetPath = netPath;
+    fmt::print("write checkpoint to {}\n", ckptPath);
+}
+
+
+/**
+ * @brief Load a checkpoint written by SaveCkpt(); the options should have been loaded by ALSOpt::Load() before constructing the ALS manager
+ * @brief The pattern bank is restored and loaded into the accurate network's simulator; the rest is restored when the stage of the checkpoint is entered
+ * 
+ * @param ckptPath   the path of the checkpoint
+ * @retval pResume   the checkpoint to resume from
+ * @retval pPattBank the restored pattern bank
+ * @retval pAccSmlt  the accurate network's simulator with the bank patterns
+ * @return void
+ */
+void ALSMan::LoadCkpt(const std::string& ckptPath) {
+    std::ifstream fin(ckptPath);
+    std::string tag;
+    int version = 0;
+    fin >> tag >> version;
+    if (!fin || tag != "ALS_CKPT" || version != 1) {
+        fmt::print(stderr, "Error: {} is not a checkpoint\n", ckptPath);
+        assert(0);
+    }
+    // the options are skipped, since they are given in the constructor
+    ALSOpt ckptOpt(options);
+    ckptOpt.Load(fin);
+    // round state
+    auto pCkpt = std::make_shared<ALSCkpt>();
+    auto readField = [&](const std::string& name, auto& value) {
+        fin >> tag >> value;
+        if (!fin || tag != name) {
+            fmt::print(stderr, "Error: missing field {} in the checkpoint\n", name);
+            assert(0);
+        }
+    };
+    readField("stage", pCkpt->stage);
+    readField("round", pCkpt->round);
+    readField("oldSize", pCkpt->oldSize);
+    readField("oldDepth", pCkpt->oldDepth);
+    fin >> tag >> std::ws;
+    std::getline(fin, pCkpt->netPath);
+    if (tag != "net" || !IsPathExist(pCkpt->netPath)) {
+        fmt::print(stderr, "Error: the network {} of the checkpoint does not exist\n", pCkpt->netPath);
+        assert(0);
+    }
+    int nBlack = 0;
+    readField("black", nBlack);
+    fin >> std::ws;
+    pCkpt->blackLacs.resize(nBlack);
+    for (auto& str: pCkpt->blackLacs)
+        std::getline(fin, str);
+    // pattern bank
+    pPattBank->Load(fin);
+    fin >> tag;
+    if (!fin || tag != "end") {
+        fmt::print(stderr, "Error: truncated checkpoint {}\n", ckptPath);
+        assert(0);
+    }
+    if (pPattBank->GetPattNum()) {
+        pPattBank->LoadInto(*pAccSmlt);
+        pAccSmlt->UpdDirtyPatts();
+    }
+    pResume = pCkpt;
+    fmt::print("Resume from {}: stage {}, round {}, {} black-listed LACs, {} bank patterns\n", ckptPath, pCkpt->stage, pCkpt->round, nBlack, pPattBank->GetPattNum());
+}
+
+
+/**
+ * @brief Restore the round state of the checkpoint to resume from
+ * @brief The black-listed LACs are mapped to the read network by the object names; the LACs on missing objects are dropped
+ * 
+ * @param appNet         the approximate network
+ * @param round          the round
+ * @param oldSize        the size of the approximate network before the round
+ * @param oldDepth       the depth of the approximate network before the round
+ * @param lacBlackList   the black list of LACs
+ * @retval appNet        the approximate network of the checkpoint
+ * @retval round         the round of the checkpoint
+ * @retval oldSize       the size of the approximate network of the checkpoint
+ * @retval oldDepth      the depth of the approximate network of the checkpoint
+ * @retval lacBlackList  the black list of the checkpoint
+ * @return void
+ */
+void ALSMan::RestoreCkpt(NetMan& appNet, int& round, int& oldSize, int& oldDepth, LacBlackList& lacBlackList) {
+    assert(pResume != nullptr);
+    appNet = NetMan(pResume->netPath);
+    if (appNet.GetNetType() != NET_TYPE::SOP) {
+        fmt::print(stderr, "Error: the network of the checkpoint should be in SOP form\n");
+        assert(0);
+    }
+    round = pResume->round;
+    // reading back may add buffers for the POs, so the size and the depth are taken from the read network
+    oldSize = static_cast<int>(appNet.GetArea());
+    oldDepth = static_cast<int>(appNet.GetDelay());
+    if (oldSize != pResume->oldSize || oldDepth != pResume->oldDepth)
+        fmt::print("Warning: the network of the checkpoint is read back with size = {}, depth = {}, instead of size = {}, depth = {}\n", oldSize, oldDepth, pResume->oldSize, pResume->oldDepth);
+    // black list
+    auto findObjId = [&](const std::string& name) {
+        // look up the PIs first, since a node name may be parsed as an internal name "n<ID>"
+        auto pObj = appNet.GetPiByName(name);
+        if (pObj == nullptr)
+            pObj = appNet.GetNodeByName(name);
+        return pObj == nullptr? -1: pObj->Id;
+    };
+    lacBlackList.clear();
+    for (const auto& str: pResume->blackLacs) {
+        std::istringstream iss(str);
+        int sopId = -1, nDiv = -1;
+        std::string name;
+        iss >> sopId >> nDiv >> name;
+        int targId = findObjId(name);
+        std::array<int, LAC::MAX_DIV> divs;
+        bool fValid = iss && targId != -1 && appNet.IsNode(targId) && sopId >= 0 && sopId < static_cast<int>(LAC_SOPS.size()) && nDiv >= 0 && nDiv <= LAC::MAX_DIV;
+        for (int i = 0; fValid && i < nDiv; ++i) {
+            fValid = static_cast<bool>(iss >> name);
+            divs[i] = fValid? findObjId(name): -1;
+            fValid = fValid && divs[i] != -1;
+        }
+        if (!fValid)
+            continue;
+        LAC lac(targId, -1, std::span<const int>(divs.data(), nDiv), sopId);
+        lacBlackList.emplace(lac.GetKey(), lac);
+    }
+    fmt::print("Resume: round {}, size = {}, depth = {}, {} black-listed LACs\n", round, oldSize, oldDepth, lacBlackList.size());
+}
+
+
+/**
+ * @brief Queue the undecided LACs for a retry with larger conflict budgets, if the budgets can still grow and the time limit allows
+ * @brief The LACs whose budgets cannot grow are added to the black list; the LACs stopped by the time limit are only skipped
+ * 
+ * @param  sched          the SAT scheduler
+ * @param  lacMan         the LAC manager
+ * @param  undefLacs      the undecided LACs and their last conflict budgets
+ * @param  lacQueue       the LACs to retry and their conflict budgets
+ * @param  lacBlackList   the black list of LACs
+ * @retval undefLacs      cleared
+ * @retval lacQueue       the LACs to retry
+ * @retval lacBlackList   the updated black list of LACs
+ * @return void
+ */
+static void RequeueUndefLacs(const SatSched& sched, const LACMan& lacMan, std::vector<std::pair<int, ll>>& undefLacs, std::vector<std::pair<int, ll>>& lacQueue, LacBlackList& lacBlackList) {
+    lacQueue.clear();
+    bool fTimeOut = sched.IsTimeOut();
+    for (const auto& [iLacId, confl]: undefLacs) {
+        ll nextConfl = sched.GetNextConfl(confl);
+        if (fTimeOut)
+            continue;
+        if (nextConfl > 0)
+            lacQueue.emplace_back(iLacId, nextConfl);
+        else {
+            const auto& lac = lacMan.GetLac(iLacId);
+            fmt::print("Warning: SAT solver returns undefined under the largest budget, add the LAC to the black list: {}\n", lac.ToStr());
+            lacBlackList.emplace(lac.GetKey(), lac);
+        }
+    }
+    if (fTimeOut && !undefLacs.empty())
+        fmt::print("Warning: the time limit is reached, skip {} undecided LACs\n", undefLacs.size());
+    if (!lacQueue.empty())
+        fmt::print("Retry {} undecided LACs with larger conflict budgets\n", lacQueue.size());
+    undefLacs.clear();
 }
 
 
@@ -286,14 +741,12 @@ void ALSMan::SimplifyWithSingleLac(LAC_TYPE lacType, NetMan& appNet, int& round,
  * @param  appNet         the approximate network
  * @param  devNet         the deviation network
  * @param  lacBlackList   the black list of LACs, which cause the SAT solver to return undefined
- * @param  countExNum     #counter examples
- * @retval accSmlt        the accurate network's simulator that includes the counter examples
+ * @retval accSmlt        the accurate network's simulator that includes the bank patterns
  * @retval appNet         the approximate network after applying the LACs
  * @retval lacBlackList   the updated black list of LACs
- * @retval countExNum     the updated #counter examples
  * @return true if there exists at least one valid LAC; false otherwise
  */
-bool ALSMan::ApplyMultValidLacs(const LACMan& lacMan, NetMan& appNet, std::unordered_set<std::string>& lacBlackList, int& countExNum) {
+bool ALSMan::ApplyMultValidLacs(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList) {
     auto startTime = std::chrono::high_resolution_clock::now();
     fmt::print("Check the maximum error for each LAC using SAT and apply multiple LACs\n");
     // prepare the counter example
@@ -303,87 +756,87 @@ bool ALSMan::ApplyMultValidLacs(const LACMan& lacMan, NetMan& appNet, std::unord
     int nPi = accNet.GetPiNum();
     assert(nPi > 0);
     counterEx.reserve(nPi);
-    std::vector<BitVect> counterExPiPatts(nPi); // piPatts[i][j] is the i-th PI's j-th counter-example pattern
-    for (auto& piPatt: counterExPiPatts)
-        piPatt.resize(0);
-    // apply the LACs in a heuristic way
+    assert(pDevCompNetEmbErr != nullptr);
+    CexErrChecker cexChecker(accNet, appNet, *pDevCompNetEmbErr);
+    // apply the LACs in a heuristic way; the undecided LACs are retried with larger conflict budgets after the others
     IntVect replTrace;
     IntSet frozTargNodes;
     bool existValidLac = false;
+    std::vector<std::pair<int, ll>> lacQueue, undefLacs; // (LAC index, conflict budget)
+    lacQueue.reserve(lacMan.GetLacNum());
+    for (int iLacId = 0; iLacId < lacMan.GetLacNum(); ++iLacId)
+        lacQueue.emplace_back(iLacId, pSatSched->GetInitConfl());
     // int nAppliedLac = 0;
-    for (int iLacId = 0; iLacId < lacMan.GetLacNum(); ++iLacId) {
-        auto pLac = lacMan.GetLac(iLacId);
-        fmt::print("{}checking {}-th LAC: {}\n", HALF_DASH_LINE, iLacId, pLac->ToStr());
-        // skip the LAC if the target node is frozen
-        int targId = pLac->GetTargId();
-        if (frozTargNodes.count(targId)) {
-            fmt::print("Warning: the target node is frozen, skip this LAC\n");
-            continue;
-        }
-        // check whether the target node is active or not
-        if (appNet.GetFanoutNum(targId) == 0) {
-            fmt::print("The target node is dangling, skip this LAC\n");
-            continue;
-        }
-        // temporarily apply the LAC
-        TempApplyLac(appNet, *pLac, replTrace, false);
-        // if the network is cyclic, skip this LAC
-        if (!appNet.IsAcyclic()) {
-            fmt::print("Warning: the network is cyclic, skip this LAC");
-            RecovNet(appNet, {replTrace}, false);
-            continue;
-        }
-        // create an error manager
-        assert(pDevCompNetEmbErr != nullptr);
-        ErrMan errMan(accNet, appNet, *pDevCompNetEmbErr);
-        const auto& errMit = errMan.GetErrMit();
-        assert(ComparePi(accNet, errMit, false));
-        // fast checking using counter examples
-        if (counterExPiPatts[0].size()) {
-            Simulator errMitSmlt(errMit, 0, counterExPiPatts[0].size(), DISTR_TYPE::UNIF);
-            errMitSmlt.GenInpFromBitVects(counterExPiPatts);
-            errMitSmlt.UpdNodeAndPoPatts();
-            assert(errMit.GetPoNum() == 1);
-            auto& outDat = errMitSmlt.GetDat(errMitSmlt.GetPoId(0));
-            if (outDat.count()) { // if the only PO is 1, then the error constraint is not satisfied
-                fmt::print("Fast checking: Exceed the error bound, skip this LAC\n");
+    while (!lacQueue.empty()) {
+        for (const auto& [iLacId, confl]: lacQueue) {
+            if (pSatSched->IsTimeOut()) {
+                fmt::print("Warning: the time limit is reached, stop checking LACs\n");
+                break;
+            }
+            const auto& lac = lacMan.GetLac(iLacId);
+            PrintLacInfo("{}checking {}-th LAC: {}\n", HALF_DASH_LINE, iLacId, lac.ToStr());
+            Profiler::Get().AddCnt(PROF_CNT::LAC_CHECK);
+            // skip the LAC if the target node is frozen
+            int targId = lac.GetTargId();
+            if (frozTargNodes.count(targId)) {
+                PrintLacInfo("Warning: the target node is frozen, skip this LAC\n");
+                continue;
+            }
+            // check whether the target node is active or not
+            if (appNet.GetFanoutNum(targId) == 0) {
+                PrintLacInfo("The target node is dangling, skip this LAC\n");
+                continue;
+            }
+            // temporarily apply the LAC
+            int ssId = TempApplyLac(appNet, lac, replTrace, false);
+            // if the network is cyclic, skip this LAC
+            if (!appNet.IsAcyclic()) {
+                PrintLacInfo("Warning: the network is cyclic, skip this LAC\n");
                 RecovNet(appNet, {replTrace}, false);
                 continue;
             }
-        }
-        // solve the SAT problem
-        auto res = errMan.SolveSat(counterEx, true);
-        if (res == CMSat::l_False) { // UNSAT, satisfy the error bound, apply the LAC
-            fmt::print("Satisfy the error bound, apply the LAC\n");
-            existValidLac = true;
-            // freeze nodes
-            frozTargNodes.insert(targId);
-        }
-        else if (res == CMSat::l_True) { // SAT, exceed the error bound, skip the LAC
-            fmt::print("Exceed the error bound, save the {}-th counter example\n", countExNum);
-            // save the counter example in the countExNum-th PI pattern in the accSmlt
-            pAccSmlt->ReplInp(countExNum, counterEx);
-            ++countExNum;
-            if (countExNum >= options.nFrame)
-                countExNum = 0;
-            for (int iPi = 0; iPi < nPi; ++iPi) {
-                assert(counterEx[iPi] == 0 || counterEx[iPi] == 1);
-                counterExPiPatts[iPi].push_back(counterEx[iPi]);
+            // fast checking using counter examples, only resimulating the TFO of the LAC
+            if (cexChecker.ExceedWithCand(ssId, replTrace)) { // the error constraint is not satisfied
+                PrintLacInfo("Fast checking: Exceed the error bound, skip this LAC\n");
+                RecovNet(appNet, {replTrace}, false);
+                continue;
+            }
+            // create an error manager
+            ErrMan errMan(accNet, appNet, *pDevCompNetEmbErr, pSatSched->GetThreadNum());
+            assert(errMan.GetMitPiNum() == accNet.GetPiNum());
+            // solve the SAT problem under the scheduled budget
+            errMan.SetSatBudget(*pSatSched, confl);
+            auto res = errMan.SolveSat(counterEx, !Profiler::Get().IsQuiet());
+            if (res == CMSat::l_False) { // UNSAT, satisfy the error bound, apply the LAC
+                PrintLacInfo("Satisfy the error bound, apply the LAC\n");
+                Profiler::Get().AddCnt(PROF_CNT::LAC_APPLY);
+                existValidLac = true;
+                // freeze nodes
+                frozTargNodes.insert(targId);
+                cexChecker.CommitCand(ssId, replTrace);
+            }
+            else if (res == CMSat::l_True) { // SAT, exceed the error bound, skip the LAC
+                PrintLacInfo("Exceed the error bound, save the counter example\n");
+                // save the counter example in the pattern bank
+                pPattBank->Add(counterEx);
+                // recover the network
+                RecovNet(appNet, {replTrace}, false);
+                cexChecker.AddCounterEx(counterEx);
+            }
+            else { // UNDEF, retry the LAC later
+                PrintLacInfo("SAT solver returns undefined under {} conflicts, retry this LAC later\n", confl);
+                undefLacs.emplace_back(iLacId, confl);
+                // recover the network
+                RecovNet(appNet, {replTrace}, false);
             }
-            // recover the network
-            RecovNet(appNet, {replTrace}, false);
-        }
-        else { // UNDEF, skip the LAC
-            fmt::print("Warning: SAT solver returns undefined, skip this LAC and add it to the black list\n");
-            // add the LAC to the black list
-            lacBlackList.insert(pLac->ToStrShort());
-            // recover the network
-            RecovNet(appNet, {replTrace}, false);
         }
+        RequeueUndefLacs(*pSatSched, lacMan, undefLacs, lacQueue, lacBlackList);
+    }
+    // load the bank patterns into the accurate network's simulator, and only re-simulate their words
+    if (cexChecker.GetCounterExNum()) {
+        pPattBank->LoadInto(*pAccSmlt);
+        pAccSmlt->UpdDirtyPatts();
     }
-    // re-simulate the accurate network if counter examples are generated
-    if (counterExPiPatts[0].size())
-        pAccSmlt->UpdNodeAndPoPatts();
     // clean up the appNet
     appNet.Sweep(false);
     assert(appNet.Check());
@@ -392,7 +845,7 @@ bool ALSMan::ApplyMultValidLacs(const LACMan& lacMan, NetMan& appNet, std::unord
 }
 
 
-bool ALSMan::ApplyMultValidLacs_NoSimPrune(const LACMan& lacMan, NetMan& appNet, std::unordered_set<std::string>& lacBlackList, int& countExNum) {
+bool ALSMan::ApplyMultValidLacs_NoSimPrune(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList) {
     auto startTime = std::chrono::high_resolution_clock::now();
     fmt::print("Check the maximum error for each LAC using SAT and apply multiple LACs\n");
     // prepare the counter example
@@ -402,58 +855,50 @@ bool ALSMan::ApplyMultValidLacs_NoSimPrune(const LACMan& lacMan, NetMan& appNet,
     int nPi = accNet.GetPiNum();
     assert(nPi > 0);
     counterEx.reserve(nPi);
-    std::vector<BitVect> counterExPiPatts(nPi); // piPatts[i][j] is the i-th PI's j-th counter-example pattern
-    for (auto& piPatt: counterExPiPatts)
-        piPatt.resize(0);
+    assert(pDevCompNetEmbErr != nullptr);
+    CexErrChecker cexChecker(accNet, appNet, *pDevCompNetEmbErr);
     // apply the LACs in a heuristic way
     IntVect replTrace;
     IntSet frozTargNodes;
     // bool existValidLac = false;
     int nAppliedLac = 0;
     for (int iLacId = 0; iLacId < lacMan.GetLacNum(); ++iLacId) {
-        auto pLac = lacMan.GetLac(iLacId);
-        fmt::print("{}checking {}-th LAC: {}\n", HALF_DASH_LINE, iLacId, pLac->ToStr());
+        const auto& lac = lacMan.GetLac(iLacId);
+        PrintLacInfo("{}checking {}-th LAC: {}\n", HALF_DASH_LINE, iLacId, lac.ToStr());
+        Profiler::Get().AddCnt(PROF_CNT::LAC_CHECK);
         // skip the LAC if the target node is frozen
-        int targId = pLac->GetTargId();
+        int targId = lac.GetTargId();
         if (frozTargNodes.count(targId)) {
-            fmt::print("Warning: the target node is frozen, skip this LAC\n");
+            PrintLacInfo("Warning: the target node is frozen, skip this LAC\n");
             continue;
         }
         // check whether the target node is active or not
         if (appNet.GetFanoutNum(targId) == 0) {
-            fmt::print("The target node is dangling, skip this LAC\n");
+            PrintLacInfo("The target node is dangling, skip this LAC\n");
             continue;
         }
         // temporarily apply the LAC
-        TempApplyLac(appNet, *pLac, replTrace, false);
+        int ssId = TempApplyLac(appNet, lac, replTrace, false);
         // if the network is cyclic, skip this LAC
         if (!appNet.IsAcyclic()) {
-            fmt::print("Warning: the network is cyclic, skip this LAC");
+            PrintLacInfo("Warning: the network is cyclic, skip this LAC\n");
+            RecovNet(appNet, {replTrace}, false);
+            continue;
+        }
+        // fast checking using counter examples, only resimulating the TFO of the LAC
+        if (cexChecker.ExceedWithCand(ssId, replTrace)) { // the error constraint is not satisfied
+            PrintLacInfo("Fast checking: Exceed the error bound, skip this LAC\n");
             RecovNet(appNet, {replTrace}, false);
             continue;
         }
         // create an error manager
-        assert(pDevCompNetEmbErr != nullptr);
         ErrMan errMan(accNet, appNet, *pDevCompNetEmbErr);
-        const auto& errMit = errMan.GetErrMit();
-        assert(ComparePi(accNet, errMit, false));
-        // fast checking using counter examples
-        if (counterExPiPatts[0].size()) {
-            Simulator errMitSmlt(errMit, 0, counterExPiPatts[0].size(), DISTR_TYPE::UNIF);
-            errMitSmlt.GenInpFromBitVects(counterExPiPatts);
-            errMitSmlt.UpdNodeAndPoPatts();
-            assert(errMit.GetPoNum() == 1);
-            auto& outDat = errMitSmlt.GetDat(errMitSmlt.GetPoId(0));
-            if (outDat.count()) { // if the only PO is 1, then the error constraint is not satisfied
-                fmt::print("Fast checking: Exceed the error bound, skip this LAC\n");
-                RecovNet(appNet, {replTrace}, false);
-                continue;
-            }
-        }
+        assert(errMan.GetMitPiNum() == accNet.GetPiNum());
         // solve the SAT problem
-        auto res = errMan.SolveSat(counterEx, true);
+        auto res = errMan.SolveSat(counterEx, !Profiler::Get().IsQuiet());
         if (res == CMSat::l_False) { // UNSAT, satisfy the error bound, apply the LAC
-            fmt::print("Satisfy the error bound, apply the LAC\n");
+            PrintLacInfo("Satisfy the error bound, apply the LAC\n");
+            Profiler::Get().AddCnt(PROF_CNT::LAC_APPLY);
             // existValidLac = true;
             ++nAppliedLac;
             const int MAX_APPLY_NUM = 100;
@@ -461,32 +906,29 @@ bool ALSMan::ApplyMultValidLacs_NoSimPrune(const LACMan& lacMan, NetMan& appNet,
                 break;
             // freeze nodes
             frozTargNodes.insert(targId);
+            cexChecker.CommitCand(ssId, replTrace);
         }
         else if (res == CMSat::l_True) { // SAT, exceed the error bound, skip the LAC
-            fmt::print("Exceed the error bound, save the {}-th counter example\n", countExNum);
-            // save the counter example in the countExNum-th PI pattern in the accSmlt
-            pAccSmlt->ReplInp(countExNum, counterEx);
-            ++countExNum;
-            if (countExNum >= options.nFrame)
-                countExNum = 0;
-            for (int iPi = 0; iPi < nPi; ++iPi) {
-                assert(counterEx[iPi] == 0 || counterEx[iPi] == 1);
-                counterExPiPatts[iPi].push_back(counterEx[iPi]);
-            }
+            PrintLacInfo("Exceed the error bound, save the counter example\n");
+            // save the counter example in the pattern bank
+            pPattBank->Add(counterEx);
             // recover the network
             RecovNet(appNet, {replTrace}, false);
+            cexChecker.AddCounterEx(counterEx);
         }
         else { // UNDEF, skip the LAC
             fmt::print("Warning: SAT solver returns undefined, skip this LAC and add it to the black list\n");
             // add the LAC to the black list
-            lacBlackList.insert(pLac->ToStrShort());
+            lacBlackList.emplace(lac.GetKey(), lac);
             // recover the network
             RecovNet(appNet, {replTrace}, false);
         }
     }
-    // re-simulate the accurate network if counter examples are generated
-    if (counterExPiPatts[0].size())
-        pAccSmlt->UpdNodeAndPoPatts();
+    // load the bank patterns into the accurate network's simulator, and only re-simulate their words
+    if (cexChecker.GetCounterExNum()) {
+        pPattBank->LoadInto(*pAccSmlt);
+        pAccSmlt->UpdDirtyPatts();
+    }
     // clean up the appNet
     appNet.Sweep(false);
     assert(appNet.Check());
@@ -496,166 +938,518 @@ bool ALSMan::ApplyMultValidLacs_NoSimPrune(const LACMan& lacMan, NetMan& appNet,
 }
 
 
-// /**
-//  * @brief Apply multiple LACs using incremental SAT, after which the real maximum error is no more than the given bound
-//  * @brief Assume that the LACs are sorted: primary key = (smaller) error, secondary key = (larger) sizeGain
-//  * 
-//  * @param  lacMan         the LAC manager
-//  * @param  appNet         the approximate network
-//  * @param  lacBlackList   the black list of LACs, which cause the SAT solver to return undefined
-//  * @param  countExNum     #counter examples
-//  * @retval pAccSmlt       the accurate network's simulator that includes the counter examples
-//  * @retval appNet         the approximate network after applying the LACs
-//  * @retval lacBlackList   the updated black list of LACs
-//  * @retval countExNum     the updated #counter examples
-//  * @return true if there exists at least one valid LAC; false otherwise
-//  */
-// bool ALSMan::ApplyMultValidLacs_IncSAT(const LACMan& lacMan, NetMan& appNet, std::unordered_set<std::string>& lacBlackList, int& counterExNum) {
-//     auto startTime = std::chrono::high_resolution_clock::now();
-//     fmt::print("Check the maximum error for each LAC using SAT and apply multiple LACs\n");
+/**
+ * @brief Apply multiple LACs using incremental SAT, after which the real maximum error is no more than the given bound
+ * @brief The accurate network and the deviation network are encoded only once; each LAC adds the re-encoded TFO of its target node to the same solver
+ * @brief Assume that the LACs are sorted: primary key = (smaller) error, secondary key = (larger) sizeGain
+ * 
+ * @param  lacMan         the LAC manager
+ * @param  appNet         the approximate network
+ * @param  lacBlackList   the black list of LACs, which cause the SAT solver to return undefined
+ * @retval pAccSmlt       the accurate network's simulator that includes the bank patterns
+ * @retval appNet         the approximate network after applying the LACs
+ * @retval lacBlackList   the updated black list of LACs
+ * @return true if there exists at least one valid LAC; false otherwise
+ */
+bool ALSMan::ApplyMultValidLacs_IncSAT(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    fmt::print("Check the maximum error for each LAC using incremental SAT and apply multiple LACs\n");
+    // prepare the incremental error checker
+    assert(pAccSmlt != nullptr);
+    assert(pDevCompNetEmbErr != nullptr);
+    const auto& accNet = static_cast<const NetMan&>(*pAccSmlt);
+    IncErrMan incErrMan(accNet, appNet, *pDevCompNetEmbErr, pSatSched->GetThreadNum());
+    CexErrChecker cexChecker(accNet, appNet, *pDevCompNetEmbErr);
+    IntVect counterEx;
+    counterEx.reserve(accNet.GetPiNum());
+    PrintRuntime(startTime, "encode the error miter");
+    // apply the LACs in a heuristic way; the undecided LACs are retried with larger conflict budgets after the others
+    IntVect replTrace;
+    IntSet frozTargNodes;
+    bool existValidLac = false;
+    std::vector<std::pair<int, ll>> lacQueue, undefLacs; // (LAC index, conflict budget)
+    lacQueue.reserve(lacMan.GetLacNum());
+    for (int iLacId = 0; iLacId < lacMan.GetLacNum(); ++iLacId)
+        lacQueue.emplace_back(iLacId, pSatSched->GetInitConfl());
+    while (!lacQueue.empty()) {
+        for (const auto& [iLacId, confl]: lacQueue) {
+            if (pSatSched->IsTimeOut()) {
+                fmt::print("Warning: the time limit is reached, stop checking LACs\n");
+                break;
+            }
+            const auto& lac = lacMan.GetLac(iLacId);
+            PrintLacInfo("{}checking {}-th LAC: {}\n", HALF_DASH_LINE, iLacId, lac.ToStr());
+            Profiler::Get().AddCnt(PROF_CNT::LAC_CHECK);
+            // skip the LAC if the target node is frozen
+            int targId = lac.GetTargId();
+            if (frozTargNodes.count(targId)) {
+                PrintLacInfo("Warning: the target node is frozen, skip this LAC\n");
+                continue;
+            }
+            // check whether the target node is active or not
+            if (appNet.GetFanoutNum(targId) == 0) {
+                PrintLacInfo("The target node is dangling, skip this LAC\n");
+                continue;
+            }
+            // temporarily apply the LAC
+            int ssId = TempApplyLac(appNet, lac, replTrace, false);
+            // if the network is cyclic, skip this LAC
+            if (!appNet.IsAcyclic()) {
+                PrintLacInfo("Warning: the network is cyclic, skip this LAC\n");
+                RecovNet(appNet, {replTrace}, false);
+                continue;
+            }
+            // fast checking using counter examples, only resimulating the TFO of the LAC
+            if (cexChecker.ExceedWithCand(ssId, replTrace)) {
+                PrintLacInfo("Fast checking: Exceed the error bound, skip this LAC\n");
+                RecovNet(appNet, {replTrace}, false);
+                continue;
+            }
+            // solve the SAT problem under the scheduled budget
+            auto res = incErrMan.CheckCand(ssId, counterEx, !Profiler::Get().IsQuiet(), pSatSched.get(), confl);
+            if (res == CMSat::l_False) { // UNSAT, satisfy the error bound, apply the LAC
+                PrintLacInfo("Satisfy the error bound, apply the LAC\n");
+                Profiler::Get().AddCnt(PROF_CNT::LAC_APPLY);
+                incErrMan.CommitCand();
+                cexChecker.CommitCand(ssId, replTrace);
+                existValidLac = true;
+                // freeze nodes
+                frozTargNodes.insert(targId);
+            }
+            else if (res == CMSat::l_True) { // SAT, exceed the error bound, skip the LAC
+                PrintLacInfo("Exceed the error bound, save the counter example\n");
+                incErrMan.RejectCand();
+                // save the counter example in the pattern bank
+                pPattBank->Add(counterEx);
+                // recover the network
+                RecovNet(appNet, {replTrace}, false);
+                cexChecker.AddCounterEx(counterEx);
+            }
+            else { // UNDEF, retry the LAC later
+                PrintLacInfo("SAT solver returns undefined under {} conflicts, retry this LAC later\n", confl);
+                incErrMan.RejectCand();
+                undefLacs.emplace_back(iLacId, confl);
+                // recover the network
+                RecovNet(appNet, {replTrace}, false);
+            }
+        }
+        RequeueUndefLacs(*pSatSched, lacMan, undefLacs, lacQueue, lacBlackList);
+    }
+    // load the bank patterns into the accurate network's simulator, and only re-simulate their words
+    if (cexChecker.GetCounterExNum()) {
+        pPattBank->LoadInto(*pAccSmlt);
+        pAccSmlt->UpdDirtyPatts();
+    }
+    // clean up the appNet
+    appNet.Sweep(false);
+    assert(appNet.Check());
+    PrintRuntime(startTime, "apply multiple LACs");
+    return existValidLac;
+}
 
-//     // prepare counter example patterns
-//     assert(pAccSmlt != nullptr);
-//     const auto& accNet = static_cast<const NetMan&>(*pAccSmlt);
-//     int accPiNum = accNet.GetPiNum();
-//     assert(accPiNum > 0);
-//     std::vector<BitVect> counterExPiPatts(accPiNum); // piPatts[i][j] is the i-th PI's j-th counter-example pattern
-//     for (auto& piPatt: counterExPiPatts)
-//         piPatt.resize(0);
 
-//     // incremental SAT solving for each group
-//     const int GROUP_SIZE = 20;
-//     bool fUpd = false;
-//     IntSet appearedNodes;
-//     LACPtrVect candidateLacs;
-//     candidateLacs.reserve(GROUP_SIZE);
-//     int iGroup = 0, procLacIdx = 0;
-// while (1) {
-//     fmt::print("{}group {}{}\n", HALF_DASH_LINE, iGroup++, HALF_DASH_LINE);
-//     // make sure that the candidate LACs are applied to different nodes
-//     candidateLacs.clear();
-//     while (static_cast<int>(candidateLacs.size()) < GROUP_SIZE && procLacIdx < lacMan.GetLacNum()) {
-//         auto pLac = lacMan.GetLac(procLacIdx++);
-//         int nodeId = pLac->GetTargId();
-//         if (appearedNodes.count(nodeId))
-//             fmt::print("ignore LAC: {}\n", pLac->ToStr());
-//         else {
-//             appearedNodes.insert(nodeId);
-//             candidateLacs.emplace_back(pLac);
-//         }
-//     }
-//     fmt::print("#candidate LACs: {}\n", candidateLacs.size());
-//     if (candidateLacs.empty())
-//         break;
-
-//     // integrate candidate LACs into the approximate network
-//     Int2DVect replTraces;
-//     int nCandLacs = candidateLacs.size();
-//     replTraces.resize(nCandLacs);
-//     for (int iLac = 0; iLac < nCandLacs; ++iLac) {
-//         auto pLac = candidateLacs[iLac];
-//         TempApplyLacWithController(appNet, *pLac, iLac, replTraces[iLac], false);
-//     }
-//     assert(appNet.IsAcyclic());
-
-//     // build the error miter
-//     assert(pDevCompNetEmbErr != nullptr);
-//     ErrMan errMan(accNet, appNet, *pDevCompNetEmbErr);
-//     const auto& errMit = errMan.GetErrMit();
-//     assert(ComparePi(accNet, errMit, true));
-//     assert(errMit.GetPiNum() == accPiNum + nCandLacs); // errMit PIs = accNet PIs + control signals (#control signals = #candidate LACs)
-//     assert(errMit.GetPoNum() == 1);
-
-//     // prepare the counter example simulator
-//     Simulator errMitSmlt(errMit, 0, counterExPiPatts[0].size(), DISTR_TYPE::UNIF);
-//     errMitSmlt.GenInpFromBitVects(counterExPiPatts);
-
-//     // incremental SAT solving
-//     std::vector<CMSat::Lit> assumpts(nCandLacs);
-//     IntVect applLacIds;
-//     IntVect counterEx;
-//     for (int iLac = 0; iLac < nCandLacs; ++iLac) {
-//         auto pLac = candidateLacs[iLac];
-//         fmt::print("{}checking {}-th LAC: {}\n", HALF_DASH_LINE, iLac, pLac->ToStr());
-//         // fast checking using simulation
-//         if (errMitSmlt.GetFrameNumb() > 0) {
-//             for (int iCtrl = 0; iCtrl < nCandLacs; ++iCtrl) // reset the control signals
-//                 errMitSmlt.SetPiConst(accPiNum + iCtrl, 0);
-//             errMitSmlt.SetPiConst(accPiNum + iLac, 1); // the i-th LAC is applied
-//             for (auto applLacId: applLacIds) // already applied LACs
-//                 errMitSmlt.SetPiConst(accPiNum + applLacId, 1);
-//             errMitSmlt.UpdNodeAndPoPatts();
-//             auto simRes = (errMitSmlt.GetDat(errMitSmlt.GetPoId(0))).count();
-//             if (simRes) { // if the only PO is 1, then the error constraint is not satisfied
-//                 fmt::print("Fast checking: Exceed the error bound, skip this LAC\n");
-//                 errMan.AddUnitClauseOfPi(accPiNum + iLac, true); // add unit clause for the i-th LAC (ctrl_i = 0)
-//                 continue;
-//             }
-//         }
-//         // here, LAC 0~iLac-1 have already been processed by adding unit clauses
-//         // we only need to add assumptions for LAC iLac~nCandLacs-1
-//         assumpts.clear();
-//         assumpts.emplace_back(errMan.GetCnfVarIdOfIthPi(accPiNum + iLac), false); // ctrl_{iLac} = 1
-//         for (int iCtrl = iLac + 1; iCtrl < nCandLacs; ++iCtrl)
-//             assumpts.emplace_back(errMan.GetCnfVarIdOfIthPi(accPiNum + iCtrl), true); // ctrl_{iCtrl} = 0
-//         // solve the SAT problem
-//         auto res = errMan.SolveSat(assumpts, counterEx, true);
-//         if (res == CMSat::l_False) { // UNSAT, satisfy the error bound
-//             fmt::print("Satisfy the error bound, apply the LAC\n");
-//             applLacIds.emplace_back(iLac);
-//             // add unit clause for the i-th LAC (ctrl_i = 1)
-//             errMan.AddUnitClauseOfPi(accPiNum + iLac, false);
-//         }
-//         else if (res == CMSat::l_True) { // SAT, exceed the error bound
-//             fmt::print("Exceed the error bound, save the {}-th counter example\n", counterExNum);
-//             // save the counter example in the countExNum-th PI pattern in the accSmlt
-//             assert(static_cast<int>(counterEx.size()) == accPiNum + nCandLacs);
-//             errMitSmlt.AppendInp(counterEx);
-//             counterEx.resize(accPiNum);
-//             pAccSmlt->ReplInp(counterExNum, counterEx);
-//             ++counterExNum;
-//             if (counterExNum >= options.nFrame)
-//                 counterExNum = 0;
-//             for (int iPi = 0; iPi < accPiNum; ++iPi) {
-//                 assert(counterEx[iPi] == 0 || counterEx[iPi] == 1);
-//                 counterExPiPatts[iPi].push_back(counterEx[iPi]);
-//             }
-//             // add unit clause for the i-th LAC (ctrl_i = 0)
-//             errMan.AddUnitClauseOfPi(accPiNum + iLac, true);
-//         }
-//         else {
-//             fmt::print("Warning: SAT solver returns undefined, skip this LAC and add it to the black list\n");
-//             // add the LAC to the black list
-//             lacBlackList.insert(pLac->ToStrShort());
-//             // add unit clause for the i-th LAC (ctrl_i = 0)
-//             errMan.AddUnitClauseOfPi(accPiNum + iLac, true);
-//         }
-//     }
+/**
+ * @brief Apply multiple LACs, after which the real maximum error is no more than the given bound
+ * @brief Group testing: the next non-overlapping LACs are applied together and verified by one SAT check;
+ * @brief a passing group is committed whole, and a failing or undecided group is bisected, where the counter example rejects the failing halves by simulation
+ * @brief Two LACs overlap if one reads or writes the TFO of the other's target; the group size follows the recent pass rate, so that about half of the groups pass
+ * 
+ * @param  lacMan         the LAC manager
+ * @param  appNet         the approximate network
+ * @param  lacBlackList   the black list of LACs, which cause the SAT solver to return undefined
+ * @retval accSmlt        the accurate network's simulator that includes the bank patterns
+ * @retval appNet         the approximate network after applying the LACs
+ * @retval lacBlackList   the updated black list of LACs
+ * @return true if there exists at least one valid LAC; false otherwise
+ */
+bool ALSMan::ApplyMultValidLacs_Group(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    int nMaxGroup = options.nMaxGroup;
+    assert(nMaxGroup >= 1);
+    fmt::print("Check the maximum error for groups of at most {} LACs using SAT and apply multiple LACs\n", nMaxGroup);
+    // prepare the counter example
+    assert(pAccSmlt != nullptr);
+    const auto& accNet = static_cast<const NetMan&>(*pAccSmlt);
+    IntVect counterEx;
+    int nPi = accNet.GetPiNum();
+    assert(nPi > 0);
+    counterEx.reserve(nPi);
+    assert(pDevCompNetEmbErr != nullptr);
+    CexErrChecker cexChecker(accNet, appNet, *pDevCompNetEmbErr);
+    // apply the LACs in groups; the undecided LACs are retried with larger conflict budgets after the others
+    using LacGroup = std::vector<std::pair<int, ll>>; // (LAC index, conflict budget)
+    const double PASS_RATE_DECAY = 0.8;
+    double passRate = 0.9; // recent pass rate of the verified LACs, exponentially smoothed
+    IntVect replTrace;
+    IntSet frozTargNodes;
+    bool existValidLac = false;
+    LacGroup lacQueue, undefLacs;
+    lacQueue.reserve(lacMan.GetLacNum());
+    for (int iLacId = 0; iLacId < lacMan.GetLacNum(); ++iLacId)
+        lacQueue.emplace_back(iLacId, pSatSched->GetInitConfl());
+    std::vector<LacGroup> groupStack;
+    while (!lacQueue.empty()) {
+        int iNext = 0;
+        while (iNext < static_cast<int>(lacQueue.size())) {
+            if (pSatSched->IsTimeOut()) {
+                fmt::print("Warning: the time limit is reached, stop checking LACs\n");
+                break;
+            }
+            // collect the next group of non-overlapping LACs, each passing the fast checks on its own
+            double groupSizeReal = passRate < 1? std::log(0.5) / std::log(passRate): nMaxGroup;
+            int groupSize = std::clamp(static_cast<int>(std::min(groupSizeReal, static_cast<double>(nMaxGroup))), 1, nMaxGroup);
+            LacGroup group;
+            IntSet groupTfo, groupUses; // the targets and their TFOs; the targets and the divisors
+            for (; iNext < static_cast<int>(lacQueue.size()) && static_cast<int>(group.size()) < groupSize; ++iNext) {
+                const auto& [iLacId, confl] = lacQueue[iNext];
+                const auto& lac = lacMan.GetLac(iLacId);
+                // skip the LAC if the target node is frozen or dangling
+                int targId = lac.GetTargId();
+                if (frozTargNodes.count(targId) || appNet.GetFanoutNum(targId) == 0)
+                    continue;
+                // an overlapping LAC starts the next group
+                IntVect tfo{targId};
+                for (auto pObj: appNet.GetTFO(appNet.GetObj(targId)))
+                    tfo.emplace_back(pObj->Id);
+                bool fOverlap = groupTfo.count(targId) > 0;
+                for (int divId: lac.GetDivIds())
+                    fOverlap = fOverlap || groupTfo.count(divId) > 0;
+                for (int id: tfo)
+                    fOverlap = fOverlap || groupUses.count(id) > 0;
+                if (fOverlap)
+                    break;
+                PrintLacInfo("{}checking {}-th LAC: {}\n", HALF_DASH_LINE, iLacId, lac.ToStr());
+                Profiler::Get().AddCnt(PROF_CNT::LAC_CHECK);
+                // temporarily apply the LAC alone
+                int ssId = TempApplyLac(appNet, lac, replTrace, false);
+                // if the network is cyclic, skip this LAC
+                if (!appNet.IsAcyclic()) {
+                    PrintLacInfo("Warning: the network is cyclic, skip this LAC\n");
+                    RecovNet(appNet, {replTrace}, false);
+                    continue;
+                }
+                // fast checking using counter examples, only resimulating the TFO of the LAC
+                if (cexChecker.ExceedWithCand(ssId, replTrace)) {
+                    PrintLacInfo("Fast checking: Exceed the error bound, skip this LAC\n");
+                    RecovNet(appNet, {replTrace}, false);
+                    continue;
+                }
+                RecovNet(appNet, {replTrace}, false);
+                group.emplace_back(iLacId, confl);
+                groupTfo.insert(tfo.begin(), tfo.end());
+                groupUses.insert(targId);
+                for (int divId: lac.GetDivIds())
+                    groupUses.insert(divId);
+            }
+            // verify the group, and bisect it if it is rejected or undecided
+            groupStack.clear();
+            if (!group.empty())
+                groupStack.emplace_back(std::move(group));
+            while (!groupStack.empty()) {
+                auto subGroup = std::move(groupStack.back());
+                groupStack.pop_back();
+                int nSub = static_cast<int>(subGroup.size());
+                // temporarily apply the LACs together, under the largest budget of them
+                IntVect ssIds;
+                Int2DVect replTraces(nSub);
+                ll confl = 0;
+                for (int i = 0; i < nSub; ++i) {
+                    ssIds.emplace_back(TempApplyLac(appNet, lacMan.GetLac(subGroup[i].first), replTraces[i], false));
+                    confl = std::max(confl, subGroup[i].second);
+                }
+                // the counter examples reject the group by simulation; otherwise solve the SAT problem
+                bool fCyclic = !appNet.IsAcyclic();
+                bool fExceed = !fCyclic && cexChecker.ExceedWithCands(ssIds, replTraces);
+                auto res = CMSat::l_Undef;
+                if (!fCyclic && !fExceed) {
+                    ErrMan errMan(accNet, appNet, *pDevCompNetEmbErr, pSatSched->GetThreadNum());
+                    assert(errMan.GetMitPiNum() == accNet.GetPiNum());
+                    errMan.SetSatBudget(*pSatSched, confl);
+                    res = errMan.SolveSat(counterEx, !Profiler::Get().IsQuiet());
+                }
+                if (res == CMSat::l_False) { // UNSAT, satisfy the error bound, apply the group
+                    PrintLacInfo("Satisfy the error bound, apply the group of {} LACs\n", nSub);
+                    Profiler::Get().AddCnt(PROF_CNT::LAC_APPLY, nSub);
+                    existValidLac = true;
+                    // freeze nodes
+                    for (const auto& [iLacId, _]: subGroup)
+                        frozTargNodes.insert(lacMan.GetLac(iLacId).GetTargId());
+                    cexChecker.CommitCands(ssIds, replTraces);
+                    for (int i = 0; i < nSub; ++i)
+                        passRate = PASS_RATE_DECAY * passRate + (1 - PASS_RATE_DECAY);
+                    continue;
+                }
+                // recover the network
+                RecovNet(appNet, replTraces, false);
+                if (res == CMSat::l_True) { // SAT, exceed the error bound, save the counter example
+                    PrintLacInfo("The group of {} LACs exceeds the error bound, save the counter example\n", nSub);
+                    pPattBank->Add(counterEx);
+                    cexChecker.AddCounterEx(counterEx);
+                }
+                if (nSub == 1) {
+                    if (fCyclic || fExceed || res == CMSat::l_True) { // skip the LAC
+                        PrintLacInfo("Skip the LAC\n");
+                        passRate = PASS_RATE_DECAY * passRate;
+                    }
+                    else { // UNDEF, retry the LAC later
+                        PrintLacInfo("SAT solver returns undefined under {} conflicts, retry this LAC later\n", confl);
+                        undefLacs.emplace_back(subGroup[0]);
+                    }
+                    continue;
+                }
+                // bisect the group; the first half is verified first
+                int nHalf = nSub / 2;
+                groupStack.emplace_back(subGroup.begin() + nHalf, subGroup.end());
+                groupStack.emplace_back(subGroup.begin(), subGroup.begin() + nHalf);
+            }
+        }
+        RequeueUndefLacs(*pSatSched, lacMan, undefLacs, lacQueue, lacBlackList);
+    }
+    // load the bank patterns into the accurate network's simulator, and only re-simulate their words
+    if (cexChecker.GetCounterExNum()) {
+        pPattBank->LoadInto(*pAccSmlt);
+        pAccSmlt->UpdDirtyPatts();
+    }
+    // clean up the appNet
+    appNet.Sweep(false);
+    assert(appNet.Check());
+    PrintRuntime(startTime, "apply multiple LACs");
+    return existValidLac;
+}
 
-//     // recover the appNet
-//     RecovNet(appNet, replTraces, false);
-    
-//     // apply the valid LACs
-//     fmt::print("apply the valid LACs\n");
-//     IntVect tmpReplTrace;
-//     for (auto appliLacId: applLacIds) {
-//         auto pLac = candidateLacs[appliLacId];
-//         fmt::print("apply the {}-th LAC: {}\n", appliLacId, pLac->ToStr());
-//         TempApplyLac(appNet, *pLac, tmpReplTrace, false);
-//     }
-//     assert(appNet.Check());
-//     fUpd |= (!applLacIds.empty());
-// }
 
-//     // sweep the appNet
-//     appNet.Sweep(false);
+/**
+ * @brief Private verification context of a worker thread
+ */
+struct LacVerifWorker {
+    std::shared_ptr<NetMan> pAppNet;          // private copy of the approximate network with the committed LACs
+    IntVect old2NewId;                        // old2NewId[id] is the ID in the copy of the object id in the original network; -1 if absent
+    std::shared_ptr<IncErrMan> pIncErrMan;    // private incremental error checker on the copy
+    CMSat::lbool res;                         // checking result of the assigned LAC
+    IntVect counterEx;                        // counter example of the assigned LAC (if the result is SAT)
+};
 
-//     // re-simulate the accurate network because counter examples may be generated
-//     pAccSmlt->UpdNodeAndPoPatts();
- 
-//     PrintRuntime(startTime, "apply multiple LACs");
-//     return fUpd;
-// }
+
+/**
+ * @brief Duplicate the network for a worker and map the object IDs, since the duplication compacts the IDs
+ * @brief Should be called serially, because the duplication writes the copy pointers of the original network
+ * 
+ * @param net       the original network
+ * @param worker    the worker
+ * @retval worker   the worker with the network copy and the ID map
+ * @return void
+ */
+static void DuplNetForWorker(const NetMan& net, LacVerifWorker& worker) {
+    worker.pAppNet = std::make_shared<NetMan>(net);
+    worker.old2NewId.assign(net.GetIdMaxPlus1(), -1);
+    for (int id = 0; id < net.GetIdMaxPlus1(); ++id) {
+        auto pObj = net.GetObj(id);
+        if (pObj != nullptr && pObj->pCopy != nullptr)
+            worker.old2NewId[id] = pObj->pCopy->Id;
+    }
+}
+
+
+/**
+ * @brief Map a LAC on the original network to the worker's network copy
+ * 
+ * @param lac      the LAC on the original network
+ * @param worker   the worker
+ * @return LAC     the LAC on the worker's network copy
+ */
+static LAC MapLacToWorker(const LAC& lac, const LacVerifWorker& worker) {
+    std::array<int, LAC::MAX_DIV> divs;
+    auto oldDivs = lac.GetDivIds();
+    for (int i = 0; i < static_cast<int>(oldDivs.size()); ++i) {
+        assert(worker.old2NewId[oldDivs[i]] != -1);
+        divs[i] = worker.old2NewId[oldDivs[i]];
+    }
+    assert(worker.old2NewId[lac.GetTargId()] != -1);
+    return LAC(worker.old2NewId[lac.GetTargId()], lac.GetSizeGain(), std::span<const int>(divs.data(), oldDivs.size()), lac.GetSopId());
+}
+
+
+/**
+ * @brief Apply multiple LACs, after which the real maximum error is no more than the given bound
+ * @brief Speculatively check a batch of LACs in parallel, each on a worker's private network copy and SAT solver;
+ * @brief the i-th worker checks the i-th LAC on top of the LACs before it in the batch, as if they all passed
+ * @brief The results are processed in the sorted order: the passing prefix of the batch is applied at once, the first failing LAC is rejected exactly,
+ * @brief and only the LACs after it are checked again, because their checks assumed it
+ * 
+ * @param  lacMan         the LAC manager
+ * @param  appNet         the approximate network
+ * @param  lacBlackList   the black list of LACs, which cause the SAT solver to return undefined
+ * @retval accSmlt        the accurate network's simulator that includes the bank patterns
+ * @retval appNet         the approximate network after applying the LACs
+ * @retval lacBlackList   the updated black list of LACs
+ * @return true if there exists at least one valid LAC; false otherwise
+ */
+bool ALSMan::ApplyMultValidLacs_Par(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    int nThread = options.nThread;
+    assert(nThread >= 1);
+    fmt::print("Check the maximum error for each LAC using SAT with {} threads and apply multiple LACs\n", nThread);
+    assert(pAccSmlt != nullptr);
+    assert(pDevCompNetEmbErr != nullptr);
+    const auto& accNet = static_cast<const NetMan&>(*pAccSmlt);
+    const auto& devNet = *pDevCompNetEmbErr;
+    int nPi = accNet.GetPiNum();
+    assert(nPi > 0);
+    // prepare the workers; the shared networks are only read by the workers, so their topological orders are precomputed
+    auto accTopoIds = accNet.CalcTopoOrdOfIds(false);
+    auto devTopoIds = devNet.CalcTopoOrdOfIds(false);
+    std::vector<LacVerifWorker> workers(nThread);
+    for (auto& worker: workers)
+        DuplNetForWorker(appNet, worker);
+    RunJobsInParallel(nThread, [&](int iWorker) {
+        auto& worker = workers[iWorker];
+        worker.pIncErrMan = std::make_shared<IncErrMan>(accNet, *worker.pAppNet, devNet, accTopoIds, devTopoIds, pSatSched->GetThreadNum());
+    });
+    PrintRuntime(startTime, "encode the error miters");
+    // prepare the counter examples
+    CexErrChecker cexChecker(accNet, appNet, devNet);
+    // apply the LACs in a heuristic way; the undecided LACs are retried with larger conflict budgets after the others
+    IntVect replTrace;
+    IntSet frozTargNodes;
+    bool existValidLac = false;
+    std::vector<std::pair<int, ll>> lacQueue, undefLacs; // (LAC index, conflict budget)
+    lacQueue.reserve(lacMan.GetLacNum());
+    for (int iLacId = 0; iLacId < lacMan.GetLacNum(); ++iLacId)
+        lacQueue.emplace_back(iLacId, pSatSched->GetInitConfl());
+    IntVect batch; // positions in lacQueue
+    batch.reserve(nThread);
+    while (!lacQueue.empty()) {
+        int iNext = 0;
+        while (iNext < static_cast<int>(lacQueue.size())) {
+            if (pSatSched->IsTimeOut()) {
+                fmt::print("Warning: the time limit is reached, stop checking LACs\n");
+                break;
+            }
+            // collect a batch of LACs
+            batch.clear();
+            for (; iNext < static_cast<int>(lacQueue.size()) && static_cast<int>(batch.size()) < nThread; ++iNext) {
+                const auto& lac = lacMan.GetLac(lacQueue[iNext].first);
+                int targId = lac.GetTargId();
+                // skip the LAC if the target node is frozen or dangling
+                if (frozTargNodes.count(targId) || appNet.GetFanoutNum(targId) == 0)
+                    continue;
+                // skip the LAC if it is cyclic or rejected by the counter examples, before it occupies a worker
+                int ssId = TempApplyLac(appNet, lac, replTrace, false);
+                bool fReject = !appNet.IsAcyclic() || cexChecker.ExceedWithCand(ssId, replTrace);
+                RecovNet(appNet, {replTrace}, false);
+                if (fReject) {
+                    PrintLacInfo("{}checking {}-th LAC: {}\n", HALF_DASH_LINE, lacQueue[iNext].first, lac.ToStr());
+                    Profiler::Get().AddCnt(PROF_CNT::LAC_CHECK);
+                    PrintLacInfo("Fast checking: the network is cyclic or exceeds the error bound, skip this LAC\n");
+                    continue;
+                }
+                batch.emplace_back(iNext);
+            }
+            int nBatch = static_cast<int>(batch.size());
+            // speculatively check the batch on the workers; the i-th worker applies the first i + 1 LACs, skipping the ones dangling by then
+            RunJobsInParallel(nBatch, [&](int iWorker) {
+                auto& worker = workers[iWorker];
+                IntVect ssIds;
+                Int2DVect workerReplTraces;
+                for (int i = 0; i <= iWorker; ++i) {
+                    auto lac = MapLacToWorker(lacMan.GetLac(lacQueue[batch[i]].first), worker);
+                    if (worker.pAppNet->GetFanoutNum(lac.GetTargId()) == 0)
+                        continue;
+                    workerReplTraces.emplace_back();
+                    ssIds.emplace_back(TempApplyLac(*worker.pAppNet, lac, workerReplTraces.back(), false));
+                }
+                if (!ssIds.empty() && worker.pAppNet->IsAcyclic()) {
+                    worker.res = worker.pIncErrMan->CheckCands(ssIds, worker.counterEx, false, pSatSched.get(), lacQueue[batch[iWorker]].second);
+                    worker.pIncErrMan->RejectCand();
+                }
+                else
+                    worker.res = CMSat::l_Undef;
+                RecovNet(*worker.pAppNet, workerReplTraces, false);
+            });
+            // process the results in order; the i-th result is exact as long as the LACs before it are applied
+            std::vector<const LAC*> commitLacs;
+            int nDone = 0; // number of the LACs of the batch with exact results
+            for (int iBatch = 0; iBatch < nBatch; ++iBatch) {
+                nDone = iBatch + 1;
+                const auto& [iLacId, confl] = lacQueue[batch[iBatch]];
+                const auto& lac = lacMan.GetLac(iLacId);
+                auto& worker = workers[iBatch];
+                PrintLacInfo("{}checking {}-th LAC: {}\n", HALF_DASH_LINE, iLacId, lac.ToStr());
+                Profiler::Get().AddCnt(PROF_CNT::LAC_CHECK);
+                // skip the LAC if the target node is dangling after the LACs applied before it; the workers skipped it as well
+                if (appNet.GetFanoutNum(lac.GetTargId()) == 0) {
+                    PrintLacInfo("The target node is dangling, skip this LAC\n");
+                    continue;
+                }
+                // temporarily apply the LAC
+                int ssId = TempApplyLac(appNet, lac, replTrace, false);
+                // if the network is cyclic, skip this LAC
+                if (!appNet.IsAcyclic()) {
+                    PrintLacInfo("Warning: the network is cyclic, skip this LAC\n");
+                    RecovNet(appNet, {replTrace}, false);
+                    break;
+                }
+                // fast checking using the counter examples found by the earlier LACs
+                if (worker.res != CMSat::l_False && cexChecker.ExceedWithCand(ssId, replTrace)) {
+                    PrintLacInfo("Fast checking: Exceed the error bound, skip this LAC\n");
+                    RecovNet(appNet, {replTrace}, false);
+                    break;
+                }
+                if (worker.res == CMSat::l_False) { // UNSAT, satisfy the error bound, apply the LAC
+                    PrintLacInfo("Satisfy the error bound, apply the LAC\n");
+                    Profiler::Get().AddCnt(PROF_CNT::LAC_APPLY);
+                    existValidLac = true;
+                    // freeze nodes
+                    frozTargNodes.insert(lac.GetTargId());
+                    cexChecker.CommitCand(ssId, replTrace);
+                    commitLacs.emplace_back(&lac);
+                    continue;
+                }
+                else if (worker.res == CMSat::l_True) { // SAT, exceed the error bound, skip the LAC
+                    PrintLacInfo("Exceed the error bound, save the counter example\n");
+                    // save the counter example in the pattern bank
+                    pPattBank->Add(worker.counterEx);
+                    // recover the network
+                    RecovNet(appNet, {replTrace}, false);
+                    cexChecker.AddCounterEx(worker.counterEx);
+                }
+                else { // UNDEF, retry the LAC later
+                    PrintLacInfo("SAT solver returns undefined under {} conflicts, retry this LAC later\n", confl);
+                    undefLacs.emplace_back(iLacId, confl);
+                    // recover the network
+                    RecovNet(appNet, {replTrace}, false);
+                }
+                // the results after a skipped LAC assumed it, so they are checked again
+                break;
+            }
+            if (nDone < nBatch)
+                iNext = batch[nDone];
+            // apply the passing LACs on all workers
+            if (!commitLacs.empty()) {
+                RunJobsInParallel(nThread, [&](int iWorker) {
+                    auto& worker = workers[iWorker];
+                    for (auto pLac: commitLacs) {
+                        IntVect workerReplTrace;
+                        int ssId = TempApplyLac(*worker.pAppNet, MapLacToWorker(*pLac, worker), workerReplTrace, false);
+                        worker.pIncErrMan->EncCand(ssId);
+                        worker.pIncErrMan->CommitCand();
+                    }
+                });
+            }
+        }
+        RequeueUndefLacs(*pSatSched, lacMan, undefLacs, lacQueue, lacBlackList);
+    }
+    // load the bank patterns into the accurate network's simulator, and only re-simulate their words
+    if (cexChecker.GetCounterExNum()) {
+        pPattBank->LoadInto(*pAccSmlt);
+        pAccSmlt->UpdDirtyPatts();
+    }
+    // clean up the appNet
+    appNet.Sweep(false);
+    assert(appNet.Check());
+    PrintRuntime(startTime, "apply multiple LACs");
+    return existValidLac;
+}
 
 
 // /**
@@ -672,7 +1466,7 @@ bool ALSMan::ApplyMultValidLacs_NoSimPrune(const LACMan& lacMan, NetMan& appNet,
 //  * @retval countExNum     the updated #counter examples
 //  * @return true if there exists at least one valid LAC; false otherwise
 //  */
-// bool ALSMan::ApplyMultValidLacsUsingBaseErr(const LACMan& lacMan, NetMan& appNet, std::unordered_set<std::string>& lacBlackList, int& countExNum) {
+// bool ALSMan::ApplyMultValidLacsUsingBaseErr(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList, int& countExNum) {
 //     auto startTime = std::chrono::high_resolution_clock::now();
 //     fmt::print("Apply multiple LACs using base error\n");
 //     // get real maximum error
@@ -12,6 +12,7 @@
 #include "error.h"
 #include "lac.h"
 #include "my_util.hpp"
+#include "prof.h"
 
 
 /**
@@ -25,12 +26,27 @@ public:
     unsigned seed;                    // seed
     int nFrame;                       // number of simulation frames used for maximum error lower bound computation
     int fUseMecals1_0;                // flag of using MECALS 1.0 (DATE'23 version)
+    int fFastFlow;                    // flag of using the fast flow for EPFL large benchmarks
     int appResub_nFrame4ResubGen;     // Resub-based LAC: number of simulation frames for approximate resubstitution generation
     int appResub_maxLevelDiff;        // Resub-based LAC: maximum level difference between the target node and divisors when generating approximate resubstitutions
     int maxCandLacs;                  // Resub-based/SASIMI LAC: maximum number of candidate LACs
     double mecals1_exactPBDPerc;      // MECALS1.0: proportion of exact partial Boolean difference
+    int fIncSat;                      // flag of checking LACs with one incremental SAT solver per round
+    int nThread;                      // number of threads for generating, pruning, and checking LACs; 1 means serial generation, pruning, and checking
+    int nPattBank;                    // capacity of the counter-example pattern bank, at most half of the simulation frames are used
+    int topK;                         // number of the best LACs checked by SAT in each round
+    int fLazyTopK;                    // flag of finely simulating the LACs lazily, only until the top-K LACs are certain
+    int fIncLacGen;                   // flag of generating the LACs incrementally across rounds, only for the nodes affected by the applied LACs
+    int fQuiet;                       // flag of suppressing the per-LAC console output
+    int fCkpt;                        // flag of writing a checkpoint at the beginning of each round, which can be resumed by --resume
+    int satInitConfl;                 // conflict budget of the first SAT check of a LAC
+    int satMaxConfl;                  // largest conflict budget of the retries of the undecided LACs, which are black-listed beyond it
+    int nSatThread;                   // number of threads of each SAT solver; more than one runs a portfolio stopping at the first decisive answer
+    double timeLimit;                 // time limit of an ALS run in seconds, within which the undecided LACs are retried; non-positive if unlimited
+    int nMaxGroup;                    // maximum number of non-overlapping LACs verified together by one SAT check; 1 checks each LAC on its own
     ll errUppBound;                   // upper bound of error
     std::string outpPath;             // output path
+    std::string profPath;             // path of the JSON Lines profiling trace; empty if no trace
 
     explicit ALSOpt(const std::string& metr_type, unsigned _seed, int n_frame, int f_use_mecals1_0, double exact_pbd_perc, ll err_upp_bound, const std::string& outp_path): 
         // lacType(LAC_TYPE::CONSTANT),
@@ -38,13 +54,28 @@ public:
         seed(_seed), 
         nFrame(n_frame),
         fUseMecals1_0(f_use_mecals1_0),
+        fFastFlow(0),
         // appResub_nFrame4ResubGen(64), 
         appResub_nFrame4ResubGen(4),
         appResub_maxLevelDiff(INT_MAX), 
         maxCandLacs(100000), 
         mecals1_exactPBDPerc(exact_pbd_perc),
+        fIncSat(0),
+        nThread(1),
+        nPattBank(1024),
+        topK(100),
+        fLazyTopK(0),
+        fIncLacGen(0),
+        fQuiet(0),
+        fCkpt(0),
+        satInitConfl(1 << 12),
+        satMaxConfl(1 << 20),
+        nSatThread(1),
+        timeLimit(0),
+        nMaxGroup(1),
         errUppBound(err_upp_bound),
-        outpPath(outp_path)
+        outpPath(outp_path),
+        profPath("")
     {
         if (errUppBound < 0) {
             fmt::print(stderr, "Error: errUppBound should be non-negative.\n");
@@ -61,6 +92,9 @@ public:
             seed = static_cast <unsigned> (unif(rng));
         }
     }
+
+    void Save(std::ostream& fout) const;
+    void Load(std::istream& fin);
 };
 template <>
 struct fmt::formatter<ALSOpt> {
@@ -75,18 +109,47 @@ struct fmt::formatter<ALSOpt> {
         str += fmt::format("seed = {}\n", value.seed);
         str += fmt::format("nFrame = {}\n", value.nFrame);
         str += fmt::format("fUseMecals1_0 = {}\n", value.fUseMecals1_0);
+        str += fmt::format("fFastFlow = {}\n", value.fFastFlow);
         str += fmt::format("appResub_nFrame4ResubGen = {}\n", value.appResub_nFrame4ResubGen);
         str += fmt::format("appResub_maxLevelDiff = {}\n", value.appResub_maxLevelDiff);
         str += fmt::format("maxCandLacs = {}\n", value.maxCandLacs);
         str += fmt::format("mecals1_exactPBDPerc = {}\n", value.mecals1_exactPBDPerc);
+        str += fmt::format("fIncSat = {}\n", value.fIncSat);
+        str += fmt::format("nThread = {}\n", value.nThread);
+        str += fmt::format("nPattBank = {}\n", value.nPattBank);
+        str += fmt::format("topK = {}\n", value.topK);
+        str += fmt::format("fLazyTopK = {}\n", value.fLazyTopK);
+        str += fmt::format("fIncLacGen = {}\n", value.fIncLacGen);
+        str += fmt::format("fQuiet = {}\n", value.fQuiet);
+        str += fmt::format("fCkpt = {}\n", value.fCkpt);
+        str += fmt::format("satInitConfl = {}\n", value.satInitConfl);
+        str += fmt::format("satMaxConfl = {}\n", value.satMaxConfl);
+        str += fmt::format("nSatThread = {}\n", value.nSatThread);
+        str += fmt::format("timeLimit = {}\n", value.timeLimit);
+        str += fmt::format("nMaxGroup = {}\n", value.nMaxGroup);
         str += fmt::format("errUppBound = {}\n", value.errUppBound);
         str += fmt::format("outpPath = {}\n", value.outpPath);
+        str += fmt::format("profPath = {}\n", value.profPath);
         str += fmt::format("--------------------\n");
         return fmt::format_to(ctx.out(), "{}", str);
     }
 };
 
 
+/**
+ * @brief State of an ALS run at the beginning of a round of SimplifyWithSingleLac, restored by --resume
+ * @brief The accurate network's simulator is not saved: its random patterns are regenerated from the seed, and the bank patterns are loaded into its first frames
+ */
+struct ALSCkpt {
+    int stage;                        // index of the SimplifyWithSingleLac stage in the flow
+    int round;                        // round to start
+    int oldSize;                      // size of the approximate network before the round
+    int oldDepth;                     // depth of the approximate network before the round
+    std::string netPath;              // path of the approximate network in BLIF
+    std::vector<std::string> blackLacs;   // black-listed LACs on the object names, "<sopId> <#divisors> <target> <divisors>"
+};
+
+
 /**
  * @brief ALS manager
  */
@@ -96,18 +159,33 @@ private:
     ALSOpt options;                                   // options
     std::shared_ptr<Simulator> pAccSmlt;              // simulator for accurate network
     std::shared_ptr<NetMan> pDevCompNet;              // network for maximum error computation (PI: accNet PI, appNetPI, ref_err; single PO = error > ref_err)
+    std::shared_ptr<PatternBank> pPattBank;           // bank of the counter examples, kept across rounds and LAC types
+    std::shared_ptr<SatSched> pSatSched;              // scheduler of the conflict budgets and the time limit of the SAT checks
     std::shared_ptr<NetMan> pDevCompNetEmbErr;        // network for maximum error checking with embedded reference error (PI: accNet PI, appNetPI; single PO = error > ref_err; ref_err is a constant vector embedded in the network)
+    int nStage;                                       // number of the entered SimplifyWithSingleLac stages
+    std::shared_ptr<ALSCkpt> pResume;                 // checkpoint to resume from; nullptr if not resuming or already resumed
+    std::string prevCkptNetPath;                      // network of the last written checkpoint, removed when it is superseded
+
+    void SaveCkpt(const NetMan& appNet, int iStage, int round, int oldSize, int oldDepth, const LacBlackList& lacBlackList);
+    void RestoreCkpt(NetMan& appNet, int& round, int& oldSize, int& oldDepth, LacBlackList& lacBlackList);
+    void TruncPos(NetMan& appNet);
+    void SimplifyWithMixedLacs(NetMan& appNet, const std::chrono::time_point<std::chrono::high_resolution_clock>& startTime);
+    void SynthAndWrite(NetMan& appNet);
+    void SetErrUppBound(ll errUppBound, const std::string& outpPath);
 
 public:
-    explicit ALSMan(NetMan& acc_net, ALSOpt& _options): accNet(acc_net), options(_options) {
+    explicit ALSMan(NetMan& acc_net, ALSOpt& _options): accNet(acc_net), options(_options), nStage(0), pResume(nullptr) {
         if (options.metrType == METR_TYPE::MAXHD) {
             if (options.errUppBound >= accNet.GetPoNum()) {
                 fmt::print(stderr, "Error: the upper bound of the maximum Hamming distance should be less than the output width\n");
                 assert(0);
             }
         }
+        Profiler::Get().Config(options.fQuiet, options.profPath);
         pAccSmlt = std::make_shared<Simulator>(accNet, options.seed, options.nFrame, DISTR_TYPE::UNIF);
-        pAccSmlt->LogicSim();
+        pAccSmlt->LogicSim(options.nThread);
+        pPattBank = std::make_shared<PatternBank>(accNet.GetPiNum(), std::min(options.nPattBank, options.nFrame / 2));
+        pSatSched = std::make_shared<SatSched>(options.satInitConfl, options.satMaxConfl, options.nSatThread, options.timeLimit);
         pDevCompNet = GenDevCompNet(options.metrType, accNet.GetPoNum());
         if (options.errUppBound > 0)
             pDevCompNetEmbErr = GenDevCompNetEmbedErrBound(pDevCompNet, accNet.GetPoNum(), options.errUppBound);
@@ -124,9 +202,13 @@ public:
     void Run_v2();
     void Run_Trunc();
     void Run_FastFlow();
+    void RunSweep(LLVect errUppBounds);
+    void LoadCkpt(const std::string& ckptPath);
     void SimplifyWithSingleLac(LAC_TYPE lacType, NetMan& appNet, int& round, const std::chrono::time_point<std::chrono::high_resolution_clock>& startTime, bool inclConst, bool fSimplify);
-    bool ApplyMultValidLacs(const LACMan& lacMan, NetMan& appNet, std::unordered_set<std::string>& lacBlackList, int& countExNum);
-    bool ApplyMultValidLacs_NoSimPrune(const LACMan& lacMan, NetMan& appNet, std::unordered_set<std::string>& lacBlackList, int& countExNum);
-    // bool ApplyMultValidLacs_IncSAT(const LACMan& lacMan, NetMan& appNet, std::unordered_set<std::string>& lacBlackList, int& countExNum);
-    // bool ApplyMultValidLacsUsingBaseErr(const LACMan& lacMan, NetMan& appNet, std::unordered_set<std::string>& lacBlackList, int& countExNum);
+    bool ApplyMultValidLacs(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList);
+    bool ApplyMultValidLacs_NoSimPrune(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList);
+    bool ApplyMultValidLacs_IncSAT(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList);
+    bool ApplyMultValidLacs_Par(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList);
+    bool ApplyMultValidLacs_Group(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList);
+    // bool ApplyMultValidLacsUsingBaseErr(const LACMan& lacMan, NetMan& appNet, LacBlackList& lacBlackList, int& countExNum);
 };
\ No newline at end of file
@@ -0,0 +1,354 @@
+/**
+ * @file bit_mat.cc
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief Flat, cache-aligned storage of simulation patterns
+ *
+ */
+#include "bit_mat.h"
+
+
+using namespace std;
+
+
+/**
+ * @brief Count the ones in the row
+ *
+ * @return int   the number of ones
+ */
+int ConstBitSpan::Count() const {
+    int ret = 0;
+    for (int i = 0; i < GetWordNum(); ++i)
+        ret += popcount(pWords[i]);
+    return ret;
+}
+
+
+/**
+ * @brief Check whether the row has a one
+ *
+ * @return bool  true if some bit is one
+ */
+bool ConstBitSpan::Any() const {
+    for (int i = 0; i < GetWordNum(); ++i) {
+        if (pWords[i])
+            return true;
+    }
+    return false;
+}
+
+
+/**
+ * @brief Copy the row into a bit vector
+ *
+ * @return BitVect   the bit vector with Size() bits
+ */
+BitVect ConstBitSpan::ToBitVect() const {
+    BitVect ret(pWords, pWords + GetWordNum());
+    ret.resize(nBit);
+    return ret;
+}
+
+
+/**
+ * @brief Set all bits to val
+ *
+ * @param val    the value
+ * @return void
+ */
+void BitSpan::Fill(bool val) {
+    ull word = val? ~0ull: 0ull;
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] = word;
+    ClearTail();
+}
+
+
+/**
+ * @brief Complement all bits
+ *
+ * @return void
+ */
+void BitSpan::Flip() {
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] = ~pWords[i];
+    ClearTail();
+}
+
+
+/**
+ * @brief Copy src into this row
+ *
+ * @param src    the source row
+ * @return void
+ */
+void BitSpan::Assign(ConstBitSpan src) {
+    assert(src.Size() == nBit);
+    auto pSrc = src.GetWords();
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] = pSrc[i];
+}
+
+
+/**
+ * @brief Copy ~src into this row
+ *
+ * @param src    the source row
+ * @return void
+ */
+void BitSpan::AssignNot(ConstBitSpan src) {
+    assert(src.Size() == nBit);
+    auto pSrc = src.GetWords();
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] = ~pSrc[i];
+    ClearTail();
+}
+
+
+/**
+ * @brief Copy a ^ b into this row
+ *
+ * @param a      the first row
+ * @param b      the second row
+ * @return void
+ */
+void BitSpan::AssignXor(ConstBitSpan a, ConstBitSpan b) {
+    assert(a.Size() == nBit && b.Size() == nBit);
+    auto pA = a.GetWords(), pB = b.GetWords();
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] = pA[i] ^ pB[i];
+}
+
+
+/**
+ * @brief Copy (a ^ fComplA) & (b ^ fComplB) into this row
+ *
+ * @param a        the first row
+ * @param fComplA  whether to complement the first row
+ * @param b        the second row
+ * @param fComplB  whether to complement the second row
+ * @return void
+ */
+void BitSpan::AssignAnd(ConstBitSpan a, bool fComplA, ConstBitSpan b, bool fComplB) {
+    assert(a.Size() == nBit && b.Size() == nBit);
+    auto pA = a.GetWords(), pB = b.GetWords();
+    ull maskA = fComplA? ~0ull: 0ull, maskB = fComplB? ~0ull: 0ull;
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] = (pA[i] ^ maskA) & (pB[i] ^ maskB);
+    if (fComplA && fComplB)
+        ClearTail();
+}
+
+
+/**
+ * @brief Copy a bit vector into this row
+ *
+ * @param src    the bit vector with Size() bits
+ * @return void
+ */
+void BitSpan::AssignBitVect(const BitVect& src) {
+    assert(static_cast<int>(src.size()) == nBit);
+    boost::to_block_range(src, pWords);
+}
+
+
+/**
+ * @brief this &= (src ^ fCompl)
+ *
+ * @param src     the source row
+ * @param fCompl  whether to complement the source row
+ * @return void
+ */
+void BitSpan::AndWith(ConstBitSpan src, bool fCompl) {
+    assert(src.Size() == nBit);
+    auto pSrc = src.GetWords();
+    ull mask = fCompl? ~0ull: 0ull;
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] &= pSrc[i] ^ mask;
+}
+
+
+/**
+ * @brief this |= src
+ *
+ * @param src    the source row
+ * @return void
+ */
+void BitSpan::OrWith(ConstBitSpan src) {
+    assert(src.Size() == nBit);
+    auto pSrc = src.GetWords();
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] |= pSrc[i];
+}
+
+
+/**
+ * @brief this ^= a & b
+ *
+ * @param a      the first row
+ * @param b      the second row
+ * @return void
+ */
+void BitSpan::XorAndWith(ConstBitSpan a, ConstBitSpan b) {
+    assert(a.Size() == nBit && b.Size() == nBit);
+    auto pA = a.GetWords(), pB = b.GetWords();
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] ^= pA[i] & pB[i];
+}
+
+
+/**
+ * @brief this |= a ^ b
+ *
+ * @param a      the first row
+ * @param b      the second row
+ * @return void
+ */
+void BitSpan::OrXorWith(ConstBitSpan a, ConstBitSpan b) {
+    assert(a.Size() == nBit && b.Size() == nBit);
+    auto pA = a.GetWords(), pB = b.GetWords();
+    for (int i = 0; i < GetWordNum(); ++i)
+        pWords[i] |= pA[i] ^ pB[i];
+}
+
+
+/**
+ * @brief Count the ones in a ^ b
+ *
+ * @param a      the first row
+ * @param b      the second row
+ * @return int   the number of ones
+ */
+int CountXor(ConstBitSpan a, ConstBitSpan b) {
+    assert(a.Size() == b.Size());
+    auto pA = a.GetWords(), pB = b.GetWords();
+    int ret = 0;
+    for (int i = 0; i < a.GetWordNum(); ++i)
+        ret += popcount(pA[i] ^ pB[i]);
+    return ret;
+}
+
+
+/**
+ * @brief Count the ones in ((a ^ fComplA) & (b ^ fComplB)) ^ t
+ *
+ * @param a        the first row
+ * @param fComplA  whether to complement the first row
+ * @param b        the second row
+ * @param fComplB  whether to complement the second row
+ * @param t        the target row
+ * @return int     the number of ones
+ */
+int CountAndXor(ConstBitSpan a, bool fComplA, ConstBitSpan b, bool fComplB, ConstBitSpan t) {
+    assert(a.Size() == b.Size() && a.Size() == t.Size());
+    int nWord = a.GetWordNum();
+    if (nWord == 0)
+        return 0;
+    auto pA = a.GetWords(), pB = b.GetWords(), pT = t.GetWords();
+    ull maskA = fComplA? ~0ull: 0ull, maskB = fComplB? ~0ull: 0ull;
+    int ret = 0;
+    for (int i = 0; i < nWord - 1; ++i)
+        ret += popcount(((pA[i] ^ maskA) & (pB[i] ^ maskB)) ^ pT[i]);
+    ull last = ((pA[nWord - 1] ^ maskA) & (pB[nWord - 1] ^ maskB)) ^ pT[nWord - 1];
+    return ret + popcount(last & GetTailMask(a.Size()));
+}
+
+
+/**
+ * @brief Check whether (a ^ fComplA) & b is all-zero
+ *
+ * @param a        the first row
+ * @param fComplA  whether to complement the first row
+ * @param b        the second row
+ * @return bool    true if no bit is one
+ */
+bool IsAndNone(ConstBitSpan a, bool fComplA, ConstBitSpan b) {
+    assert(a.Size() == b.Size());
+    auto pA = a.GetWords(), pB = b.GetWords();
+    ull maskA = fComplA? ~0ull: 0ull;
+    for (int i = 0; i < a.GetWordNum(); ++i) {
+        if ((pA[i] ^ maskA) & pB[i])
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Check whether (a ^ b ^ fComplB) & c is all-zero
+ *
+ * @param a        the first row
+ * @param b        the second row
+ * @param fComplB  whether to complement the second row
+ * @param c        the care row
+ * @return bool    true if no bit is one
+ */
+bool IsXorAndNone(ConstBitSpan a, ConstBitSpan b, bool fComplB, ConstBitSpan c) {
+    assert(a.Size() == b.Size() && a.Size() == c.Size());
+    auto pA = a.GetWords(), pB = b.GetWords(), pC = c.GetWords();
+    ull maskB = fComplB? ~0ull: 0ull;
+    for (int i = 0; i < a.GetWordNum(); ++i) {
+        if ((pA[i] ^ pB[i] ^ maskB) & pC[i])
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Resize the matrix; all bits are reset to zero
+ *
+ * @param _nRow    the number of rows
+ * @param _nBit    the number of bits per row
+ * @return void
+ */
+void BitMat::Resize(int _nRow, int _nBit) {
+    assert(_nRow >= 0 && _nBit >= 0);
+    nRow = _nRow;
+    nBit = _nBit;
+    nStride = CalcStride(nBit);
+    words.assign(static_cast<ll>(nRow) * nStride, 0);
+}
+
+
+/**
+ * @brief Change the number of bits per row, keeping the leading bits of each row
+ *
+ * @param _nBit    the number of bits per row
+ * @return void
+ */
+void BitMat::ResizeBits(int _nBit) {
+    assert(_nBit >= 0);
+    int newStride = CalcStride(_nBit);
+    if (newStride != nStride) {
+        AlignedWordVect newWords(static_cast<ll>(nRow) * newStride, 0);
+        int nCopy = min(GetWordNumOfBits(nBit), GetWordNumOfBits(_nBit));
+        for (int i = 0; i < nRow; ++i)
+            copy_n(words.data() + static_cast<ll>(i) * nStride, nCopy, newWords.data() + static_cast<ll>(i) * newStride);
+        words.swap(newWords);
+        nStride = newStride;
+    }
+    if (_nBit < nBit) {
+        // clear the dropped bits to keep the padding zero
+        int nWordNew = GetWordNumOfBits(_nBit), nWordOld = GetWordNumOfBits(nBit);
+        for (int i = 0; i < nRow; ++i) {
+            auto pRow = words.data() + static_cast<ll>(i) * nStride;
+            if (nWordNew)
+                pRow[nWordNew - 1] &= GetTailMask(_nBit);
+            fill(pRow + nWordNew, pRow + min(nWordOld, nStride), 0ull);
+        }
+    }
+    nBit = _nBit;
+}
+
+
+/**
+ * @brief Change the number of rows, keeping the existing rows; the new rows are zero
+ *
+ * @param _nRow    the number of rows
+ * @return void
+ */
+void BitMat::ResizeRows(int _nRow) {
+    assert(_nRow >= 0);
+    words.resize(static_cast<ll>(_nRow) * nStride, 0);
+    nRow = _nRow;
+}
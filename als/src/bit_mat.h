@@ -0,0 +1,162 @@
+/**
+ * @file bit_mat.h
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief Flat, cache-aligned storage of simulation patterns
+ *
+ */
+#pragma once
+
+
+#include <bit>
+#include <new>
+#include "header.h"
+
+
+/**
+ * @brief Allocator returning cache-line aligned memory
+ */
+template <typename T>
+struct CacheAlignedAlloc {
+    using value_type = T;
+    static constexpr std::size_t ALIGN = 64;
+
+    CacheAlignedAlloc() = default;
+    template <typename U> CacheAlignedAlloc(const CacheAlignedAlloc<U>&) {}
+    T* allocate(std::size_t n) {return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGN)));}
+    void deallocate(T* p, std::size_t) {::operator delete(p, std::align_val_t(ALIGN));}
+    template <typename U> bool operator == (const CacheAlignedAlloc<U>&) const {return true;}
+};
+using AlignedWordVect = std::vector<ull, CacheAlignedAlloc<ull>>;
+
+
+/**
+ * @brief Get the number of words holding nBit bits
+ *
+ * @param nBit   the number of bits
+ * @return int   the number of words
+ */
+static inline int GetWordNumOfBits(int nBit) {return (nBit + 63) >> 6;}
+
+
+/**
+ * @brief Get the mask of the valid bits in the last word of a row with nBit bits
+ *
+ * @param nBit   the number of bits
+ * @return ull   the mask
+ */
+static inline ull GetTailMask(int nBit) {return (nBit & 63)? (1ull << (nBit & 63)) - 1: ~0ull;}
+
+
+/**
+ * @brief Read-only view of a row of simulation patterns
+ * @brief The bits beyond Size() in the last word are always zero
+ */
+class ConstBitSpan {
+private:
+    const ull* pWords;   // the words of the row
+    int nBit;            // the number of valid bits
+
+public:
+    ConstBitSpan(const ull* _pWords, int _nBit): pWords(_pWords), nBit(_nBit) {}
+
+    int Count() const;
+    bool Any() const;
+    BitVect ToBitVect() const;
+
+    inline int Size() const {return nBit;}
+    inline int GetWordNum() const {return GetWordNumOfBits(nBit);}
+    inline const ull* GetWords() const {return pWords;}
+    inline bool None() const {return !Any();}
+    inline bool operator [] (int i) const {assert(i >= 0 && i < nBit); return (pWords[i >> 6] >> (i & 63)) & 1;}
+};
+
+
+/**
+ * @brief Writable view of a row of simulation patterns
+ * @brief The in-place kernels never allocate; they keep the bits beyond Size() zero
+ */
+class BitSpan {
+private:
+    ull* pWords;   // the words of the row
+    int nBit;      // the number of valid bits
+
+    inline void ClearTail() {if (nBit) pWords[GetWordNum() - 1] &= GetTailMask(nBit);}
+
+public:
+    BitSpan(ull* _pWords, int _nBit): pWords(_pWords), nBit(_nBit) {}
+
+    void Fill(bool val);
+    void Flip();
+    void Assign(ConstBitSpan src);
+    void AssignNot(ConstBitSpan src);
+    void AssignXor(ConstBitSpan a, ConstBitSpan b);
+    void AssignAnd(ConstBitSpan a, bool fComplA, ConstBitSpan b, bool fComplB);
+    void AssignBitVect(const BitVect& src);
+    void AndWith(ConstBitSpan src, bool fCompl);
+    void OrWith(ConstBitSpan src);
+    void XorAndWith(ConstBitSpan a, ConstBitSpan b);
+    void OrXorWith(ConstBitSpan a, ConstBitSpan b);
+
+    inline operator ConstBitSpan() const {return ConstBitSpan(pWords, nBit);}
+    inline int Size() const {return nBit;}
+    inline int GetWordNum() const {return GetWordNumOfBits(nBit);}
+    inline ull* GetWords() const {return pWords;}
+    inline int Count() const {return ConstBitSpan(*this).Count();}
+    inline bool Any() const {return ConstBitSpan(*this).Any();}
+    inline BitVect ToBitVect() const {return ConstBitSpan(*this).ToBitVect();}
+    inline bool operator [] (int i) const {return ConstBitSpan(*this)[i];}
+    inline void Set(int i, bool val) {
+        assert(i >= 0 && i < nBit);
+        if (val)
+            pWords[i >> 6] |= (1ull << (i & 63));
+        else
+            pWords[i >> 6] &= ~(1ull << (i & 63));
+    }
+};
+
+
+// counting kernels over rows of the same size
+int CountXor(ConstBitSpan a, ConstBitSpan b);
+int CountAndXor(ConstBitSpan a, bool fComplA, ConstBitSpan b, bool fComplB, ConstBitSpan t);
+bool IsAndNone(ConstBitSpan a, bool fComplA, ConstBitSpan b);
+bool IsXorAndNone(ConstBitSpan a, ConstBitSpan b, bool fComplB, ConstBitSpan c);
+
+
+/**
+ * @brief Row-major matrix of simulation patterns in one cache-aligned buffer
+ * @brief Row i holds the patterns of object i; each row starts on a cache line, and the padding words are zero
+ * @brief The stride is a multiple of 8 words, so the rows can be fed to the bit-sliced kernels directly
+ */
+class BitMat {
+private:
+    int nRow;                 // the number of rows
+    int nBit;                 // the number of bits per row
+    int nStride;              // the number of words between two consecutive rows
+    AlignedWordVect words;    // the words of all rows
+
+    static inline int CalcStride(int _nBit) {
+        const int WORD_PER_LINE = 8;
+        return (GetWordNumOfBits(_nBit) + WORD_PER_LINE - 1) / WORD_PER_LINE * WORD_PER_LINE;
+    }
+
+public:
+    BitMat(): nRow(0), nBit(0), nStride(0) {}
+    BitMat(int _nRow, int _nBit): nRow(0), nBit(0), nStride(0) {Resize(_nRow, _nBit);}
+    ~BitMat() = default;
+    BitMat(const BitMat&) = delete;
+    BitMat(BitMat&&) = delete;
+    BitMat& operator = (const BitMat&) = delete;
+    BitMat& operator = (BitMat&&) = delete;
+
+    void Resize(int _nRow, int _nBit);
+    void ResizeBits(int _nBit);
+    void ResizeRows(int _nRow);
+
+    inline int GetRowNum() const {return nRow;}
+    inline int GetBitNum() const {return nBit;}
+    inline int GetStride() const {return nStride;}
+    inline bool IsShape(int _nRow, int _nBit) const {return nRow == _nRow && nBit == _nBit;}
+    inline const ull* GetWords() const {return words.data();}
+    inline BitSpan operator [] (int i) {assert(i >= 0 && i < nRow); return BitSpan(words.data() + static_cast<ll>(i) * nStride, nBit);}
+    inline ConstBitSpan operator [] (int i) const {assert(i >= 0 && i < nRow); return ConstBitSpan(words.data() + static_cast<ll>(i) * nStride, nBit);}
+};
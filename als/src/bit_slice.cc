@@ -0,0 +1,304 @@
+/**
+ * @file bit_slice.cc
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief Bit-sliced kernels for error evaluation on simulation patterns
+ *
+ */
+#include "bit_slice.h"
+
+
+using namespace std;
+
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BIT_SLICE_USE_AVX2
+#endif
+
+
+/**
+ * @brief Operations on a lane word, i.e., the patterns processed together by one kernel step
+ */
+template <typename W>
+struct LaneWord;
+
+
+/**
+ * @brief Scalar lane word: 64 patterns
+ */
+template <>
+struct LaneWord<ull> {
+    static constexpr int N_WORD = 1;
+    static inline __attribute__((always_inline)) ull Load(const ull* p) {return *p;}
+    static inline __attribute__((always_inline)) void Store(ull* p, ull w) {*p = w;}
+    static inline __attribute__((always_inline)) ull Zero() {return 0;}
+    static inline __attribute__((always_inline)) ull Ones() {return ~0ull;}
+    static inline __attribute__((always_inline)) bool Any(ull w) {return w != 0;}
+};
+
+
+#ifdef BIT_SLICE_USE_AVX2
+// the AVX2 lane word is only used inside functions compiled for AVX2, where all the kernels are inlined
+#pragma GCC diagnostic ignored "-Wpsabi"
+typedef ull AvxWord __attribute__((vector_size(32)));
+
+
+/**
+ * @brief AVX2 lane word: 256 patterns
+ */
+template <>
+struct LaneWord<AvxWord> {
+    static constexpr int N_WORD = 4;
+    static inline __attribute__((always_inline)) AvxWord Load(const ull* p) {AvxWord w; __builtin_memcpy(&w, p, sizeof(w)); return w;}
+    static inline __attribute__((always_inline)) void Store(ull* p, const AvxWord& w) {__builtin_memcpy(p, &w, sizeof(w));}
+    static inline __attribute__((always_inline)) AvxWord Zero() {return AvxWord{0, 0, 0, 0};}
+    static inline __attribute__((always_inline)) AvxWord Ones() {return ~Zero();}
+    static inline __attribute__((always_inline)) bool Any(const AvxWord& w) {return (w[0] | w[1] | w[2] | w[3]) != 0;}
+};
+#endif
+
+
+/**
+ * @brief Compare the bit-sliced values with a constant bound
+ *
+ * @param pVal     pVal[k * N_WORD], bit k of the values
+ * @param nRow     the number of bits
+ * @param bound    the non-negative bound
+ * @return W       the lanes whose values are larger than the bound
+ */
+template <typename W, typename T = LaneWord<W>>
+static inline __attribute__((always_inline)) W GreaterThan(const ull* pVal, int nRow, ll bound) {
+    W gt = T::Zero(), eq = T::Ones();
+    if (nRow < 63 && bound >= (1ll << nRow))
+        return gt;
+    for (int k = nRow - 1; k >= 0; --k) {
+        W v = T::Load(pVal + k * T::N_WORD);
+        if (k < 63 && ((bound >> k) & 1))
+            eq &= v;
+        else {
+            gt |= eq & v;
+            eq &= ~v;
+        }
+    }
+    return gt;
+}
+
+
+/**
+ * @brief Get the maximum of the bit-sliced values over all lanes
+ * @brief The values should be less than 2^63
+ *
+ * @param pVal     pVal[k * N_WORD], bit k of the values
+ * @param nRow     the number of bits
+ * @return ll      the maximum value
+ */
+template <typename W, typename T = LaneWord<W>>
+static inline __attribute__((always_inline)) ll MaxOverLanes(const ull* pVal, int nRow) {
+    W cand = T::Ones();
+    ll maxVal = 0;
+    for (int k = std::min(nRow, 63) - 1; k >= 0; --k) {
+        W t = cand & T::Load(pVal + k * T::N_WORD);
+        if (T::Any(t)) {
+            cand = t;
+            maxVal |= 1ll << k;
+        }
+    }
+    return maxVal;
+}
+
+
+/**
+ * @brief Scan the patterns for the maximum absolute difference between two bit-sliced unsigned integers
+ *
+ * @param pApp     the approximate outputs, row k holds bit k of all patterns
+ * @param pAcc     the accurate outputs, row k holds bit k of all patterns
+ * @param nRow     the output width
+ * @param nWord    the number of words per row
+ * @param bound    the error bound
+ * @param pDiff    scratch space of nRow * N_WORD words
+ * @return BitSliceScanRes  the scanning result
+ */
+template <typename W, typename T = LaneWord<W>>
+static inline __attribute__((always_inline)) BitSliceScanRes ScanMaxAbsDiff_(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, ull* pDiff) {
+    BitSliceScanRes res{0, -1};
+    for (int iWord = 0; iWord < nWord; iWord += T::N_WORD) {
+        // diff = app - acc, using a ripple-borrow subtractor
+        W borrow = T::Zero();
+        for (int k = 0; k < nRow; ++k) {
+            W y = T::Load(pApp + static_cast<ll>(k) * nWord + iWord);
+            W a = T::Load(pAcc + static_cast<ll>(k) * nWord + iWord);
+            W t = y ^ a;
+            T::Store(pDiff + k * T::N_WORD, t ^ borrow);
+            borrow = (~y & a) | (~t & borrow);
+        }
+        // |diff|: negate the lanes with a final borrow
+        W carry = borrow;
+        for (int k = 0; k < nRow; ++k) {
+            W d = T::Load(pDiff + k * T::N_WORD) ^ borrow;
+            T::Store(pDiff + k * T::N_WORD, d ^ carry);
+            carry = d & carry;
+        }
+        // compare with the bound
+        if (T::Any(GreaterThan<W>(pDiff, nRow, bound))) {
+            res.iWordExceed = iWord;
+            return res;
+        }
+        res.maxErr = std::max(res.maxErr, MaxOverLanes<W>(pDiff, nRow));
+    }
+    return res;
+}
+
+
+/**
+ * @brief Scan the patterns for the maximum Hamming distance between two groups of bit vectors
+ * @brief The Hamming distance of each pattern is accumulated in bit-sliced vertical counters
+ *
+ * @param pApp     the approximate outputs, row k holds output k of all patterns
+ * @param pAcc     the accurate outputs, row k holds output k of all patterns
+ * @param nRow     the output width
+ * @param nWord    the number of words per row
+ * @param bound    the error bound
+ * @param pCnt     scratch space of nCntBit * N_WORD words
+ * @param nCntBit  the width of the counters, enough to hold nRow
+ * @return BitSliceScanRes  the scanning result
+ */
+template <typename W, typename T = LaneWord<W>>
+static inline __attribute__((always_inline)) BitSliceScanRes ScanMaxHammDist_(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, ull* pCnt, int nCntBit) {
+    const int CHECK_PERIOD = 8; // check the bound every CHECK_PERIOD rows; the counters never decrease
+    BitSliceScanRes res{0, -1};
+    for (int iWord = 0; iWord < nWord; iWord += T::N_WORD) {
+        for (int j = 0; j < nCntBit; ++j)
+            T::Store(pCnt + j * T::N_WORD, T::Zero());
+        bool fExceed = false;
+        for (int k = 0; k < nRow && !fExceed; ++k) {
+            // add the difference of row k to the counters
+            W carry = T::Load(pApp + static_cast<ll>(k) * nWord + iWord) ^ T::Load(pAcc + static_cast<ll>(k) * nWord + iWord);
+            for (int j = 0; j < nCntBit && T::Any(carry); ++j) {
+                W c = T::Load(pCnt + j * T::N_WORD);
+                T::Store(pCnt + j * T::N_WORD, c ^ carry);
+                carry &= c;
+            }
+            // exit early once a pattern exceeds the bound
+            if ((k + 1) % CHECK_PERIOD == 0 || k + 1 == nRow)
+                fExceed = T::Any(GreaterThan<W>(pCnt, nCntBit, bound));
+        }
+        if (fExceed) {
+            res.iWordExceed = iWord;
+            return res;
+        }
+        res.maxErr = std::max(res.maxErr, MaxOverLanes<W>(pCnt, nCntBit));
+    }
+    return res;
+}
+
+
+/**
+ * @brief Get the width of the vertical counters for nRow rows
+ *
+ * @param nRow     the number of rows
+ * @return int     the width
+ */
+static inline int GetCntBitNum(int nRow) {
+    int nCntBit = 1;
+    while ((1ll << nCntBit) <= nRow)
+        ++nCntBit;
+    return nCntBit;
+}
+
+
+/**
+ * @brief Scalar version of ScanMaxHammDist
+ */
+static BitSliceScanRes ScanMaxHammDist_Scalar(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, std::vector<ull>& scratch) {
+    int nCntBit = GetCntBitNum(nRow);
+    scratch.resize(nCntBit * LaneWord<ull>::N_WORD);
+    return ScanMaxHammDist_<ull>(pApp, pAcc, nRow, nWord, bound, scratch.data(), nCntBit);
+}
+
+
+/**
+ * @brief Scalar version of ScanMaxAbsDiff
+ */
+static BitSliceScanRes ScanMaxAbsDiff_Scalar(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, std::vector<ull>& scratch) {
+    scratch.resize(nRow * LaneWord<ull>::N_WORD);
+    return ScanMaxAbsDiff_<ull>(pApp, pAcc, nRow, nWord, bound, scratch.data());
+}
+
+
+#ifdef BIT_SLICE_USE_AVX2
+/**
+ * @brief AVX2 version of ScanMaxAbsDiff
+ */
+__attribute__((target("avx2")))
+static BitSliceScanRes ScanMaxAbsDiff_Avx2(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, std::vector<ull>& scratch) {
+    scratch.resize(nRow * LaneWord<AvxWord>::N_WORD);
+    return ScanMaxAbsDiff_<AvxWord>(pApp, pAcc, nRow, nWord, bound, scratch.data());
+}
+
+
+/**
+ * @brief AVX2 version of ScanMaxHammDist
+ */
+__attribute__((target("avx2")))
+static BitSliceScanRes ScanMaxHammDist_Avx2(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, std::vector<ull>& scratch) {
+    int nCntBit = GetCntBitNum(nRow);
+    scratch.resize(nCntBit * LaneWord<AvxWord>::N_WORD);
+    return ScanMaxHammDist_<AvxWord>(pApp, pAcc, nRow, nWord, bound, scratch.data(), nCntBit);
+}
+
+
+/**
+ * @brief Check whether the CPU supports AVX2
+ *
+ * @return bool    true if AVX2 is supported
+ */
+static bool UseAvx2() {
+    static const bool fAvx2 = __builtin_cpu_supports("avx2");
+    return fAvx2;
+}
+#endif
+
+
+/**
+ * @brief Scan the patterns for the maximum error distance between the approximate and accurate outputs
+ * @brief Works on the PO bit vectors directly; the scan stops at the first block containing a pattern whose error exceeds the bound
+ * @brief The kernel is selected at runtime: AVX2 (256 patterns per step) if available, otherwise scalar (64 patterns per step)
+ *
+ * @param pApp     the approximate outputs, row k (nWord words) holds bit k of all patterns
+ * @param pAcc     the accurate outputs, row k (nWord words) holds bit k of all patterns
+ * @param nRow     the output width
+ * @param nWord    the number of words per row, from GetBitSliceWordNum
+ * @param bound    the error bound, non-negative
+ * @param scratch  scratch space
+ * @return BitSliceScanRes  the scanning result
+ */
+BitSliceScanRes ScanMaxAbsDiff(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, std::vector<ull>& scratch) {
+    assert(bound >= 0);
+#ifdef BIT_SLICE_USE_AVX2
+    if (UseAvx2() && nWord % LaneWord<AvxWord>::N_WORD == 0)
+        return ScanMaxAbsDiff_Avx2(pApp, pAcc, nRow, nWord, bound, scratch);
+#endif
+    return ScanMaxAbsDiff_Scalar(pApp, pAcc, nRow, nWord, bound, scratch);
+}
+
+
+/**
+ * @brief Scan the patterns for the maximum Hamming distance between the approximate and accurate outputs
+ * @brief Works on the PO bit vectors directly; the scan stops at the first block containing a pattern whose error exceeds the bound
+ * @brief The kernel is selected at runtime: AVX2 (256 patterns per step) if available, otherwise scalar (64 patterns per step)
+ *
+ * @param pApp     the approximate outputs, row k (nWord words) holds output k of all patterns
+ * @param pAcc     the accurate outputs, row k (nWord words) holds output k of all patterns
+ * @param nRow     the output width
+ * @param nWord    the number of words per row, from GetBitSliceWordNum
+ * @param bound    the error bound, non-negative
+ * @param scratch  scratch space
+ * @return BitSliceScanRes  the scanning result
+ */
+BitSliceScanRes ScanMaxHammDist(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, std::vector<ull>& scratch) {
+    assert(bound >= 0);
+#ifdef BIT_SLICE_USE_AVX2
+    if (UseAvx2() && nWord % LaneWord<AvxWord>::N_WORD == 0)
+        return ScanMaxHammDist_Avx2(pApp, pAcc, nRow, nWord, bound, scratch);
+#endif
+    return ScanMaxHammDist_Scalar(pApp, pAcc, nRow, nWord, bound, scratch);
+}
@@ -0,0 +1,54 @@
+/**
+ * @file bit_slice.h
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief Bit-sliced kernels for error evaluation on simulation patterns
+ *
+ */
+#pragma once
+
+
+#include "header.h"
+
+
+/**
+ * @brief Result of scanning the patterns for the maximum error
+ */
+struct BitSliceScanRes {
+    ll maxErr;         // maximum error over the patterns before the block iWordExceed
+    int iWordExceed;   // first word of the block containing a pattern whose error exceeds the bound; -1 if no such pattern
+};
+
+
+/**
+ * @brief Get the number of words per bit-sliced row, padded for the widest kernel
+ *
+ * @param nPatt    the number of patterns
+ * @return int     the number of words
+ */
+static inline int GetBitSliceWordNum(int nPatt) {
+    const int WORD_PER_BLOCK = 4;
+    int nWord = (nPatt + 63) / 64;
+    return (nWord + WORD_PER_BLOCK - 1) / WORD_PER_BLOCK * WORD_PER_BLOCK;
+}
+
+
+/**
+ * @brief Copy bit vectors into a row-major word matrix, where row i holds bit i of all patterns
+ *
+ * @param rows     the bit vectors, rows[i][j] is bit i of the j-th pattern
+ * @param nWord    the number of words per row, from GetBitSliceWordNum
+ * @param words    the word matrix
+ * @retval words   the word matrix, padded with zeros
+ * @return void
+ */
+static inline void LoadBitSlices(const std::vector<BitVect>& rows, int nWord, std::vector<ull>& words) {
+    words.assign(rows.size() * nWord, 0);
+    for (int i = 0; i < static_cast<int>(rows.size()); ++i) {
+        assert(static_cast<int>(rows[i].num_blocks()) <= nWord);
+        boost::to_block_range(rows[i], words.begin() + static_cast<ll>(i) * nWord);
+    }
+}
+
+
+BitSliceScanRes ScanMaxAbsDiff(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, std::vector<ull>& scratch);
+BitSliceScanRes ScanMaxHammDist(const ull* pApp, const ull* pAcc, int nRow, int nWord, ll bound, std::vector<ull>& scratch);
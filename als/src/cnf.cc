@@ -0,0 +1,382 @@
+/**
+ * @file cnf.cc
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief CNF encoding of logic networks
+ *
+ */
+#include "cnf.h"
+
+
+using namespace abc;
+using namespace std;
+using CMSat::Lit;
+using CMSat::SATSolver;
+
+
+/**
+ * @brief Create a fresh variable in the solver
+ *
+ * @return Lit    the positive literal of the new variable
+ */
+Lit SopCnfEnc::NewLit() {
+    solver.new_var();
+    return Lit(solver.nVars() - 1, false);
+}
+
+
+/**
+ * @brief Get the literal of constant 1; create it when it does not exist
+ *
+ * @return Lit    the literal of constant 1
+ */
+Lit SopCnfEnc::GetConst1() {
+    if (litConst1 == CMSat::lit_Undef) {
+        litConst1 = NewLit();
+        AddUnit(litConst1);
+    }
+    return litConst1;
+}
+
+
+/**
+ * @brief Encode the conjunction of literals
+ *
+ * @param lits    the literals, non-empty
+ * @return Lit    the literal of the conjunction
+ */
+Lit SopCnfEnc::EncAnd(const LitVect& lits) {
+    assert(!lits.empty());
+    if (lits.size() == 1)
+        return lits[0];
+    auto out = NewLit();
+    // out -> lit
+    for (const auto& lit: lits) {
+        clause.assign({~out, lit});
+        solver.add_clause(clause);
+    }
+    // (lit_0 & lit_1 & ...) -> out
+    clause.clear();
+    for (const auto& lit: lits)
+        clause.emplace_back(~lit);
+    clause.emplace_back(out);
+    solver.add_clause(clause);
+    return out;
+}
+
+
+/**
+ * @brief Encode an SOP function over the fanin literals
+ *
+ * @param faninLits  the fanin literals
+ * @param pSop       the SOP string in ABC format
+ * @return Lit       the literal of the function output
+ */
+Lit SopCnfEnc::EncSop(const LitVect& faninLits, const char* pSop) {
+    auto sop = const_cast<char*>(pSop);
+    int nVars = Abc_SopGetVarNum(sop);
+    assert(nVars == static_cast<int>(faninLits.size()));
+    bool fCompl = Abc_SopIsComplement(sop);
+    // encode cubes
+    bool fTaut = false;
+    products.clear();
+    LitVect cubeLits;
+    cubeLits.reserve(nVars);
+    for (char* pCube = sop; *pCube; pCube += nVars + 3) {
+        cubeLits.clear();
+        for (int i = 0; pCube[i] != ' '; ++i) {
+            if (pCube[i] == '1')
+                cubeLits.emplace_back(faninLits[i]);
+            else if (pCube[i] == '0')
+                cubeLits.emplace_back(~faninLits[i]);
+            else
+                assert(pCube[i] == '-');
+        }
+        if (cubeLits.empty()) {
+            fTaut = true;
+            break;
+        }
+        products.emplace_back(EncAnd(cubeLits));
+    }
+    // encode the disjunction of cubes
+    Lit out = CMSat::lit_Undef;
+    if (fTaut)
+        out = GetConst1();
+    else if (products.size() == 1)
+        out = products[0];
+    else {
+        out = NewLit();
+        // cube -> out
+        for (const auto& cube: products) {
+            clause.assign({~cube, out});
+            solver.add_clause(clause);
+        }
+        // out -> (cube_0 | cube_1 | ...)
+        clause.assign(products.begin(), products.end());
+        clause.emplace_back(~out);
+        solver.add_clause(clause);
+    }
+    return fCompl? ~out: out;
+}
+
+
+/**
+ * @brief Encode an object and the not-yet-encoded objects in its TFI
+ * @brief The literals of PIs should be assigned before calling this function
+ *
+ * @param net      the SOP network
+ * @param id       the object ID
+ * @param obj2Lit  obj2Lit[id] is the literal of the object id; lit_Undef if not encoded
+ * @retval obj2Lit the updated literals
+ * @return Lit     the literal of the object
+ */
+Lit SopCnfEnc::EncObj(const NetMan& net, int id, LitVect& obj2Lit) {
+    if (static_cast<int>(obj2Lit.size()) < net.GetIdMaxPlus1())
+        obj2Lit.resize(net.GetIdMaxPlus1(), CMSat::lit_Undef);
+    if (obj2Lit[id] != CMSat::lit_Undef)
+        return obj2Lit[id];
+    auto pObj = net.GetObj(id);
+    if (net.IsObjPo(pObj)) {
+        obj2Lit[id] = EncObj(net, net.GetFaninId(pObj, 0), obj2Lit);
+        return obj2Lit[id];
+    }
+    if (!net.IsNode(pObj)) {
+        fmt::print(stderr, "Error: object {} is not encoded\n", *pObj);
+        assert(0);
+    }
+    LitVect faninLits;
+    faninLits.reserve(net.GetFaninNum(pObj));
+    for (int i = 0; i < net.GetFaninNum(pObj); ++i)
+        faninLits.emplace_back(EncObj(net, net.GetFaninId(pObj, i), obj2Lit));
+    obj2Lit[id] = EncSop(faninLits, static_cast<char*>(pObj->pData));
+    return obj2Lit[id];
+}
+
+
+/**
+ * @brief Encode the nodes and POs of a network
+ * @brief Only reads the network, so it can be called on a shared network from multiple threads as long as topoIds is precomputed
+ *
+ * @param net      the SOP network
+ * @param topoIds  the node IDs in topological order
+ * @param obj2Lit  obj2Lit[id] is the literal of the object id; the PIs should already be assigned
+ * @retval obj2Lit the literals of all encoded objects
+ * @return void
+ */
+void SopCnfEnc::EncNet(const NetMan& net, const IntVect& topoIds, LitVect& obj2Lit) {
+    if (net.GetNetType() != NET_TYPE::SOP) {
+        fmt::print(stderr, "Error: only SOP networks are supported\n");
+        assert(0);
+    }
+    obj2Lit.resize(net.GetIdMaxPlus1(), CMSat::lit_Undef);
+    for (auto id: topoIds)
+        EncObj(net, id, obj2Lit);
+    for (int i = 0; i < net.GetPoNum(); ++i)
+        EncObj(net, net.GetPoId(i), obj2Lit);
+}
+
+
+/**
+ * @brief Append the nodes and POs of a network to an AIG in GIA form
+ * @brief SOP nodes are decomposed cube by cube; the AND nodes of a structurally hashed network are copied with their complemented edges
+ * 
+ * @param pGia         the AIG, with the hash table allocated
+ * @param net          the SOP or structurally hashed network
+ * @param obj2GiaLit   obj2GiaLit[id] is the GIA literal of the object id; the PIs should already be assigned
+ * @retval obj2GiaLit  the literals of the nodes and POs; a PO takes the literal of its driver
+ * @return void
+ */
+static void AppendNetToGia(Gia_Man_t* pGia, const NetMan& net, IntVect& obj2GiaLit) {
+    auto type = net.GetNetType();
+    if (type != NET_TYPE::SOP && type != NET_TYPE::STRASH) {
+        fmt::print(stderr, "Error: only SOP and strashed networks are supported\n");
+        assert(0);
+    }
+    obj2GiaLit.resize(net.GetIdMaxPlus1(), -1);
+    if (type == NET_TYPE::STRASH) {
+        obj2GiaLit[net.GetConst1IdInStrashNet()] = 1;
+        for (auto id: net.CalcTopoOrdOfIds(true)) {
+            auto pObj = net.GetObj(id);
+            int faninLit0 = obj2GiaLit[net.GetFaninId(pObj, 0)], faninLit1 = obj2GiaLit[net.GetFaninId(pObj, 1)];
+            assert(faninLit0 != -1 && faninLit1 != -1);
+            obj2GiaLit[id] = Gia_ManHashAnd(pGia, Abc_LitNotCond(faninLit0, Abc_ObjFaninC0(pObj)), Abc_LitNotCond(faninLit1, Abc_ObjFaninC1(pObj)));
+        }
+        for (int i = 0; i < net.GetPoNum(); ++i) {
+            auto pPo = net.GetPo(i);
+            int drivLit = obj2GiaLit[net.GetPoDrivId(i)];
+            assert(drivLit != -1);
+            obj2GiaLit[net.GetPoId(i)] = Abc_LitNotCond(drivLit, Abc_ObjFaninC0(pPo));
+        }
+        return;
+    }
+    for (int id = 0; id < net.GetIdMaxPlus1(); ++id) {
+        if (net.IsNode(id) && net.GetFaninNum(id) == 0)
+            obj2GiaLit[id] = net.IsConst1(id)? 1: 0;
+    }
+    for (auto id: net.CalcTopoOrdOfIds(true)) {
+        auto pObj = net.GetObj(id);
+        auto pSop = static_cast<char*>(pObj->pData);
+        int nVars = Abc_SopGetVarNum(pSop);
+        assert(nVars == net.GetFaninNum(pObj));
+        int orLit = 0;
+        for (char* pCube = pSop; *pCube; pCube += nVars + 3) {
+            int andLit = 1;
+            for (int i = 0; i < nVars; ++i) {
+                int faninLit = obj2GiaLit[net.GetFaninId(pObj, i)];
+                assert(faninLit != -1);
+                if (pCube[i] == '1')
+                    andLit = Gia_ManHashAnd(pGia, andLit, faninLit);
+                else if (pCube[i] == '0')
+                    andLit = Gia_ManHashAnd(pGia, andLit, Abc_LitNot(faninLit));
+                else
+                    assert(pCube[i] == '-');
+            }
+            orLit = Gia_ManHashOr(pGia, orLit, andLit);
+        }
+        obj2GiaLit[id] = Abc_SopIsComplement(pSop)? Abc_LitNot(orLit): orLit;
+    }
+    for (int i = 0; i < net.GetPoNum(); ++i) {
+        int drivLit = obj2GiaLit[net.GetPoDrivId(i)];
+        assert(drivLit != -1);
+        obj2GiaLit[net.GetPoId(i)] = drivLit;
+    }
+}
+
+
+/**
+ * @brief Build an AIG in GIA form from the network, without going through the ABC frame
+ * @brief Only reads the network and allocates a new manager, so different networks can be converted at the same time
+ * 
+ * @param net          the SOP or structurally hashed network
+ * @return Gia_Man_t*  the structurally hashed AIG owned by the caller (free it with Gia_ManStop)
+ */
+Gia_Man_t* BuildGiaFromNet(const NetMan& net) {
+    auto pGia = Gia_ManStart(net.GetObjNum() * 4 + 1);
+    pGia->pName = Abc_UtilStrsav(net.GetNet()->pName);
+    Gia_ManHashAlloc(pGia);
+    IntVect obj2GiaLit(net.GetIdMaxPlus1(), -1);
+    for (int i = 0; i < net.GetPiNum(); ++i)
+        obj2GiaLit[net.GetPiId(i)] = Gia_ManAppendCi(pGia);
+    AppendNetToGia(pGia, net, obj2GiaLit);
+    for (int i = 0; i < net.GetPoNum(); ++i)
+        Gia_ManAppendCo(pGia, obj2GiaLit[net.GetPoId(i)]);
+    Gia_ManHashStop(pGia);
+    auto pNew = Gia_ManCleanup(pGia);
+    Gia_ManStop(pGia);
+    return pNew;
+}
+
+
+/**
+ * @brief Build the error miter directly as an AIG in GIA form, without building a miter network
+ * @brief The objects are linked by their positions: the i-th PI of the approximate network is the i-th PI of the accurate one, and the extra ones are control PIs;
+ * @brief the POs of the accurate and the approximate networks drive the first 2 * #PO PIs of the deviation network, and its other PIs are the reference errors
+ * @brief The CIs are ordered like the PIs of ErrMan::BuildErrMit: accurate PIs, control PIs, reference errors
+ * 
+ * @param accNet       the accurate network, in SOP or strashed
+ * @param appNet       the approximate network, in SOP or strashed
+ * @param devNet       the deviation network, in SOP or strashed
+ * @return Gia_Man_t*  the structurally hashed error miter owned by the caller (free it with Gia_ManStop)
+ */
+Gia_Man_t* BuildErrMitGia(const NetMan& accNet, const NetMan& appNet, const NetMan& devNet) {
+    ProfTimer timer(PROF_PHASE::MITER_BUILD);
+    assert(ComparePi(accNet, appNet, true) && ComparePo(accNet, appNet));
+    int nPo = accNet.GetPoNum();
+    assert(devNet.GetPiNum() >= nPo * 2 && devNet.GetPoNum() >= 1);
+    auto pGia = Gia_ManStart((accNet.GetObjNum() + appNet.GetObjNum() + devNet.GetObjNum()) * 4 + 1);
+    pGia->pName = Abc_UtilStrsav(const_cast<char*>("error_miter"));
+    Gia_ManHashAlloc(pGia);
+    // PIs of the accurate network, shared with the approximate network, and the control PIs
+    IntVect accLits(accNet.GetIdMaxPlus1(), -1), appLits(appNet.GetIdMaxPlus1(), -1), devLits(devNet.GetIdMaxPlus1(), -1);
+    for (int i = 0; i < accNet.GetPiNum(); ++i) {
+        accLits[accNet.GetPiId(i)] = Gia_ManAppendCi(pGia);
+        appLits[appNet.GetPiId(i)] = accLits[accNet.GetPiId(i)];
+    }
+    for (int i = accNet.GetPiNum(); i < appNet.GetPiNum(); ++i)
+        appLits[appNet.GetPiId(i)] = Gia_ManAppendCi(pGia);
+    AppendNetToGia(pGia, accNet, accLits);
+    AppendNetToGia(pGia, appNet, appLits);
+    // deviation network on the POs, and the reference errors
+    for (int i = 0; i < nPo; ++i) {
+        devLits[devNet.GetPiId(i)] = accLits[accNet.GetPoId(i)];
+        devLits[devNet.GetPiId(i + nPo)] = appLits[appNet.GetPoId(i)];
+    }
+    for (int i = nPo * 2; i < devNet.GetPiNum(); ++i)
+        devLits[devNet.GetPiId(i)] = Gia_ManAppendCi(pGia);
+    AppendNetToGia(pGia, devNet, devLits);
+    for (int i = 0; i < devNet.GetPoNum(); ++i)
+        Gia_ManAppendCo(pGia, devLits[devNet.GetPoId(i)]);
+    Gia_ManHashStop(pGia);
+    auto pNew = Gia_ManCleanup(pGia);
+    Gia_ManStop(pGia);
+    return pNew;
+}
+
+
+/**
+ * @brief Build a SAT solver from the AIG with a single PO, without going through the ABC frame
+ * @brief The CNF is generated by the LUT-mapping-based encoder of ABC "&write_cnf"; the mapping and CNF are local to pGia
+ * 
+ * @param pGia              the AIG owned by the caller, with one PO that is asserted to be 1
+ * @param cnfVarIdOfIthPi   the CNF variable ID of the i-th PI
+ * @param maxConfl          the maximum number of conflicts
+ * @param nThread           the number of solver threads; more than one runs a portfolio
+ * @retval cnfVarIdOfIthPi  the CNF variable ID of the i-th PI
+ * @return a pointer to the SAT solver
+ */
+std::shared_ptr<SATSolver> BuildSatSolverFromGia(Gia_Man_t* pGia, IntVect& cnfVarIdOfIthPi, ll maxConfl, int nThread) {
+    if (Gia_ManCoNum(pGia) != 1) {
+        fmt::print(stderr, "Error: the network defining the SAT problem should have only one PO\n");
+        assert(0);
+    }
+
+    // default parameters
+    int nLutSize    = 8;
+    int fCnfObjIds  = 0;
+    int fAddOrCla   = 1;
+    Jf_Par_t pars;
+    Mf_ManSetDefaultPars(&pars);
+    pars.fGenCnf     = 1;
+    pars.fCoarsen    = !fCnfObjIds;
+    pars.nLutSize    = nLutSize;
+    pars.fCnfObjIds  = fCnfObjIds;
+    pars.fAddOrCla   = fAddOrCla;
+    pars.fCnfMapping = 0;
+    pars.fVerbose    = 0;
+
+    // convert the GIA network to CNF
+    // variables 1, 2, ..., nPOs represent POs; the last nPIs variables represent PIs in their natural order
+    auto pNew = Mf_ManPerformMapping(pGia, &pars);
+    Gia_ManStopP(&pNew);
+    auto pCnf = static_cast<Cnf_Dat_t*>(pGia->pData);
+    pGia->pData = nullptr;
+
+    // start solver
+    auto pSolver = std::make_shared<SATSolver>();
+    if (nThread > 1) // should be set before adding variables
+        pSolver->set_num_threads(nThread);
+    pSolver->set_max_confl(maxConfl);
+    pSolver->new_vars(pCnf->nVars + 1); // in the ABC cnf, the variable id starts from 1
+
+    // add clauses
+    LitVect clause;
+    for (int i = 0; i < pCnf->nClauses; i++) {
+        clause.clear();
+        for (auto pLit = pCnf->pClauses[i], pStop = pCnf->pClauses[i+1]; pLit < pStop; pLit++) {
+            int var = ::Cnf_Lit2Var(*pLit);
+            clause.emplace_back(Lit(abs(var), var < 0));
+        }
+        pSolver->add_clause(clause);
+    }
+
+    // update the CNF variable ID of the i-th PI
+    int nPi = Gia_ManCiNum(pGia);
+    assert(static_cast<int>(pSolver->nVars()) - nPi >= 1);
+    cnfVarIdOfIthPi.resize(nPi);
+    for (int i = 0; i < nPi; ++i)
+        cnfVarIdOfIthPi[i] = pSolver->nVars() - nPi + i;
+
+    // clean up
+    Cnf_DataFree(pCnf);
+
+    return pSolver;
+}
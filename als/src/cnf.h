@@ -0,0 +1,64 @@
+/**
+ * @file cnf.h
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief CNF encoding of logic networks
+ *
+ */
+#pragma once
+
+
+#include "header.h"
+#include "my_abc.h"
+#include "sat_wrapper.hpp"
+
+
+using LitVect = std::vector<CMSat::Lit>;
+
+
+/**
+ * @brief Convert the literal in the ABC CNF to the variable
+ * 
+ * @param Lit     the literal
+ * @return int    the variable
+ */
+static inline int Cnf_Lit2Var(int Lit) {return (Lit & 1)? -(Lit >> 1) - 1 : (Lit >> 1) + 1;}
+
+
+/**
+ * @brief Tseitin encoder from SOP networks to CNF
+ * @brief Each object is represented by a literal; buffers and inverters are aliased to their fanin literals
+ * @brief Encoding only adds fresh variables defined by their fanins, so it can extend a solver that is already in use
+ */
+class SopCnfEnc {
+private:
+    CMSat::SATSolver& solver;    // the SAT solver receiving the clauses
+    CMSat::Lit litConst1;        // literal of constant 1, created on demand
+    LitVect clause;              // scratch clause
+    LitVect products;            // scratch cube literals
+
+public:
+    explicit SopCnfEnc(CMSat::SATSolver& _solver): solver(_solver), litConst1(CMSat::lit_Undef) {}
+    ~SopCnfEnc() = default;
+    SopCnfEnc(const SopCnfEnc&) = delete;
+    SopCnfEnc(SopCnfEnc&&) = delete;
+    SopCnfEnc& operator = (const SopCnfEnc&) = delete;
+    SopCnfEnc& operator = (SopCnfEnc&&) = delete;
+
+    CMSat::Lit NewLit();
+    CMSat::Lit GetConst1();
+    CMSat::Lit EncAnd(const LitVect& lits);
+    CMSat::Lit EncSop(const LitVect& faninLits, const char* pSop);
+    CMSat::Lit EncObj(const NetMan& net, int id, LitVect& obj2Lit);
+    void EncNet(const NetMan& net, const IntVect& topoIds, LitVect& obj2Lit);
+
+    inline CMSat::Lit GetConst0() {return ~GetConst1();}
+    inline void AddClause(const LitVect& lits) {clause.assign(lits.begin(), lits.end()); solver.add_clause(clause);}
+    inline void AddUnit(CMSat::Lit lit) {clause.assign(1, lit); solver.add_clause(clause);}
+    inline CMSat::SATSolver& GetSolver() const {return solver;}
+};
+
+
+// frame-free CNF generation
+abc::Gia_Man_t* BuildGiaFromNet(const NetMan& net);
+abc::Gia_Man_t* BuildErrMitGia(const NetMan& accNet, const NetMan& appNet, const NetMan& devNet);
+std::shared_ptr<CMSat::SATSolver> BuildSatSolverFromGia(abc::Gia_Man_t* pGia, IntVect& cnfVarIdOfIthPi, ll maxConfl = 1ll << 18, int nThread = 1);
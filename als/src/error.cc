@@ -35,7 +35,7 @@ using CMSat::lbool;
  * @param netMan1      the approximate network
  */
 ErrMan::ErrMan(const NetMan& netMan0, const NetMan& netMan1):
-    net0(netMan0), net1(netMan1), pSmlt0(nullptr), pSmlt1(nullptr), pErrMit(nullptr), pSolver(nullptr) {
+    net0(netMan0), net1(netMan1), pSmlt0(nullptr), pSmlt1(nullptr), nMitPi(0), pSolver(nullptr) {
     // ensure the POs are the same
     if (!ComparePo(net0, net1)) {
         fmt::print(stderr, "Error: different POs\n");
@@ -55,8 +55,9 @@ ErrMan::ErrMan(const NetMan& netMan0, const NetMan& netMan1):
  * @param netMan0      the accurate network
  * @param netMan1      the approximate network
  * @param devNet       the deviation network
+ * @param nSatThread   the number of threads of the SAT solver; more than one runs a portfolio
  */
-ErrMan::ErrMan(const NetMan& netMan0, const NetMan& netMan1, const NetMan& devNet):
+ErrMan::ErrMan(const NetMan& netMan0, const NetMan& netMan1, const NetMan& devNet, int nSatThread):
     net0(netMan0), net1(netMan1), pSmlt0(nullptr), pSmlt1(nullptr) {
     // ensure the POs are the same
     if (!ComparePo(net0, net1)) {
@@ -69,8 +70,13 @@ ErrMan::ErrMan(const NetMan& netMan0, const NetMan& netMan1, const NetMan& devNe
         assert(0);
     }
     // initialize the error miter and SAT solver
-    pErrMit = BuildErrMit(net0, net1, devNet);
-    pSolver = BuildSatSolver_Abc(*pErrMit, cnfVarIdOfIthPi);
+    auto pGia = BuildErrMitGia(net0, net1, devNet);
+    nMitPi = abc::Gia_ManCiNum(pGia);
+    {
+        ProfTimer timer(PROF_PHASE::CNF_MAP);
+        pSolver = BuildSatSolverFromGia(pGia, cnfVarIdOfIthPi, 1ll << 18, nSatThread);
+    }
+    abc::Gia_ManStop(pGia);
 }
 
 
@@ -97,13 +103,44 @@ void ErrMan::LogicSim(unsigned seed, int nFrame, DISTR_TYPE distrType) {
 }
 
 
+/**
+ * @brief Compute the maximum error distance by enumerating all input patterns
+ * @brief The patterns are streamed in windows of ENUM_WINDOW_FRAME frames, so the memory does not grow with 2^#PI
+ * 
+ * @param uppBound   stop as soon as the running maximum exceeds this bound; -1 if no bound
+ * @return ll        the maximum error distance; if it exceeds uppBound, a lower bound of it that exceeds uppBound
+ */
+ll ErrMan::GetMaxErrDistUsingEnum(ll uppBound) const {
+    assert(net0.IsPIOSame(net1));
+    int nPi = net0.GetPiNum();
+    assert(nPi < 63 && net0.GetPoNum() < 63);
+    ll nPatt = 1ll << nPi;
+    int nWinFrame = static_cast<int>(std::min(nPatt, static_cast<ll>(ENUM_WINDOW_FRAME)));
+    Simulator smlt0(net0, 0, nWinFrame), smlt1(net1, 0, nWinFrame);
+    ll maxEd = 0;
+    for (ll iFirstPatt = 0; iFirstPatt < nPatt; iFirstPatt += nWinFrame) {
+        smlt0.GenInpEnumWindow(iFirstPatt);
+        smlt1.GenInpEnumWindow(iFirstPatt);
+        smlt0.UpdNodeAndPoPatts();
+        smlt1.UpdNodeAndPoPatts();
+        maxEd = std::max(maxEd, smlt0.GetMaxErrDistFast(smlt1));
+        if (uppBound >= 0 && maxEd > uppBound)
+            break;
+    }
+    return maxEd;
+}
+
+
 /**
  * @brief Compute the maximum error
+ * @brief Known bounds, e.g., a simulation lower bound from GetMaxErrDistLowBound and a loose upper bound, shorten the search
  * 
- * @param metrType metric type
- * @return long long the maximum error
+ * @param metrType   metric type
+ * @param lowBound   a known lower bound of the maximum error
+ * @param uppBound   a known upper bound of the maximum error; -1 if unknown
+ * @return BigInt    the maximum error
  */
-BigInt ErrMan::ComputeMaxErr(METR_TYPE metrType) {
+BigInt ErrMan::ComputeMaxErr(METR_TYPE metrType, const BigInt& lowBound, const BigInt& uppBound) {
     // check the metric type
     if (metrType != METR_TYPE::MAXED && metrType != METR_TYPE::MAXHD) {
         fmt::print(stderr, "Error: unsupport metric type\n");
@@ -121,30 +158,66 @@ BigInt ErrMan::ComputeMaxErr(METR_TYPE metrType) {
     auto pDevCompNet = GenDevCompNet(metrType, outWidth);
 
     // build an error miter
-    auto pErrMit = BuildErrMit(net0, net1, *pDevCompNet);
-    
+    auto pGia = BuildErrMitGia(net0, net1, *pDevCompNet);
+    int nPi = abc::Gia_ManCiNum(pGia);
+
     // build a SAT solver
-    auto pSolver = BuildSatSolver_Abc(*pErrMit, cnfVarIdOfIthPi);
+    std::shared_ptr<CMSat::SATSolver> pSolver = nullptr;
+    {
+        ProfTimer timer(PROF_PHASE::CNF_MAP);
+        pSolver = BuildSatSolverFromGia(pGia, cnfVarIdOfIthPi);
+    }
+    abc::Gia_ManStop(pGia);
 
     // return the maximum error
     int refErrWidth = outWidth;
     if (metrType == METR_TYPE::MAXHD)
         refErrWidth = static_cast<int>(log2(outWidth)) + 1;
-    return SolveSatsForMaxErrBinSearch(*pErrMit, *pSolver, refErrWidth);
+    return SolveSatsForMaxErrGuided(nPi, *pSolver, refErrWidth, metrType, lowBound, uppBound);
+}
+
+
+/**
+ * @brief Compute the maximum error on the miter built by the constructor, under the assumptions on its control PIs
+ * @brief The SAT solver is kept, so the learned clauses are reused by the next call
+ * 
+ * @param metrType       metric type, consistent with the deviation network given to the constructor
+ * @param ctrlAssumpts   the assumptions on the control PIs of the approximate network
+ * @param lowBound       a known lower bound of the maximum error
+ * @param uppBound       a known upper bound of the maximum error; -1 if unknown
+ * @return BigInt        the maximum error
+ */
+BigInt ErrMan::ComputeMaxErrWithAssumpts(METR_TYPE metrType, const LitVect& ctrlAssumpts, const BigInt& lowBound, const BigInt& uppBound) {
+    if (pSolver == nullptr) {
+        fmt::print(stderr, "Error: the error miter is not built\n");
+        assert(0);
+    }
+    if (metrType != METR_TYPE::MAXED && metrType != METR_TYPE::MAXHD) {
+        fmt::print(stderr, "Error: unsupport metric type\n");
+        assert(0);
+    }
+    int outWidth = net0.GetPoNum();
+    int refErrWidth = outWidth;
+    if (metrType == METR_TYPE::MAXHD)
+        refErrWidth = static_cast<int>(log2(outWidth)) + 1;
+    return SolveSatsForMaxErrGuided(nMitPi, *pSolver, refErrWidth, metrType, lowBound, uppBound, ctrlAssumpts);
 }
 
 
 /**
  * @brief Build an error miter
+ * @brief The objects are matched by their indices, not by their names: the approximate network shares the first PIs with the accurate network, and its remaining PIs are control signals
+ * @brief Only the PIs and POs keep their names; the internal nodes are unnamed, and ABC generates their names lazily when the miter is written
  * 
  * @param accNet   the accurate network
  * @param appNet   the approximate network
  * @param devNet   the deviation network
- * @param errMit   the error miter
- * @retval errMit  the error miter
- * @return void
+ * @param pMap     the object ID maps from the three networks to the miter; nullptr if not needed
+ * @retval pMap    the object ID maps
+ * @return std::shared_ptr<NetMan>  the error miter
  */
-std::shared_ptr<NetMan> ErrMan::BuildErrMit(const NetMan& accNet, const NetMan& appNet, const NetMan& devNet) {
+std::shared_ptr<NetMan> ErrMan::BuildErrMit(const NetMan& accNet, const NetMan& appNet, const NetMan& devNet, ErrMitMap* pMap) {
+    ProfTimer timer(PROF_PHASE::MITER_BUILD);
     // check & prepare
     if (accNet.GetNetType() != NET_TYPE::SOP) {
         fmt::print(stderr, "Error: the accurate network should be in SOP\n");
@@ -170,16 +243,10 @@ std::shared_ptr<NetMan> ErrMan::BuildErrMit(const NetMan& accNet, const NetMan&
     AbcObj* pObj = nullptr, *pFanin = nullptr;
     int i = 0, k = 0;
     Abc_NtkCleanCopy(pAccNet);
-    unordered_map <string, AbcObj*> name2PI;
-    Abc_NtkForEachPi(pAccNet, pObj, i) {
-        Abc_NtkDupObj(pErrMitNet, pObj, 0);
-        RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)));
-        name2PI[string(Abc_ObjName(pObj))] = pObj->pCopy;
-    }
-    Abc_NtkForEachNode(pAccNet, pObj, i) {
+    Abc_NtkForEachPi(pAccNet, pObj, i)
+        Abc_NtkDupObj(pErrMitNet, pObj, 1);
+    Abc_NtkForEachNode(pAccNet, pObj, i)
         Abc_NtkDupObj(pErrMitNet, pObj, 0);
-        RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)) + "_acc");
-    }
     Abc_NtkForEachNode(pAccNet, pObj, i) {
         Abc_ObjForEachFanin(pObj, pFanin, k)
             Abc_ObjAddFanin(pObj->pCopy, pFanin->pCopy);
@@ -187,21 +254,16 @@ std::shared_ptr<NetMan> ErrMan::BuildErrMit(const NetMan& accNet, const NetMan&
 
     // copy appNet
     auto pAppNet = appNet.GetNet();
+    int nAccPi = accNet.GetPiNum();
     Abc_NtkCleanCopy(pAppNet);
     Abc_NtkForEachPi(pAppNet, pObj, i) {
-        if (name2PI.count(string(Abc_ObjName(pObj)))) // the PI is in accNet
-            pObj->pCopy = name2PI[string(Abc_ObjName(pObj))];
-        else { // the PI is unique in appNet (a control signal)
-            // fmt::print("Warning: control signal {}\n", Abc_ObjName(pObj));
-            Abc_NtkDupObj(pErrMitNet, pObj, 0);
-            RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)));
-            name2PI[string(Abc_ObjName(pObj))] = pObj->pCopy;
-        }
+        if (i < nAccPi) // the PI is in accNet
+            pObj->pCopy = Abc_NtkPi(pAccNet, i)->pCopy;
+        else // the PI is unique in appNet (a control signal)
+            Abc_NtkDupObj(pErrMitNet, pObj, 1);
     }
-    Abc_NtkForEachNode(pAppNet, pObj, i) {
+    Abc_NtkForEachNode(pAppNet, pObj, i)
         Abc_NtkDupObj(pErrMitNet, pObj, 0);
-        RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)) + "_app");
-    }
     Abc_NtkForEachNode(pAppNet, pObj, i) {
         Abc_ObjForEachFanin(pObj, pFanin, k)
             Abc_ObjAddFanin(pObj->pCopy, pFanin->pCopy);
@@ -229,16 +291,13 @@ std::shared_ptr<NetMan> ErrMan::BuildErrMit(const NetMan& accNet, const NetMan&
         int refErrWidth = Abc_NtkPiNum(pDevNet) - nPo * 2;
         for (int i = 0; i < refErrWidth; ++i) {
             auto pRefErrI = Abc_NtkPi(pDevNet, i + nPo * 2);
-            Abc_NtkDupObj(pErrMitNet, pRefErrI, 0);
-            RenameAbcObj(pRefErrI->pCopy, string(Abc_ObjName(pRefErrI)));
+            Abc_NtkDupObj(pErrMitNet, pRefErrI, 1);
             assert(string(Abc_ObjName(pRefErrI)) == fmt::format("ref_err[{}]", i));
         }
     }
     // copy nodes
-    Abc_NtkForEachNode(pDevNet, pObj, i) {
+    Abc_NtkForEachNode(pDevNet, pObj, i)
         Abc_NtkDupObj(pErrMitNet, pObj, 0);
-        RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)) + "_mit");
-    }
     Abc_NtkForEachNode(pDevNet, pObj, i) {
         Abc_ObjForEachFanin(pObj, pFanin, k)
             Abc_ObjAddFanin(pObj->pCopy, pFanin->pCopy);
@@ -249,6 +308,22 @@ std::shared_ptr<NetMan> ErrMan::BuildErrMit(const NetMan& accNet, const NetMan&
     Abc_NtkForEachPo(pDevNet, pObj, i)
         Abc_ObjAddFanin(pObj->pCopy, Abc_ObjChild0Copy(pObj));
 
+    // record the object ID maps
+    if (pMap != nullptr) {
+        auto CollectMap = [](Abc_Ntk_t* pNtk, IntVect& old2Mit) {
+            old2Mit.assign(Abc_NtkObjNumMax(pNtk), -1);
+            AbcObj* pObj = nullptr;
+            int i = 0;
+            Abc_NtkForEachObj(pNtk, pObj, i) {
+                if (pObj->pCopy != nullptr)
+                    old2Mit[i] = Abc_ObjRegular(pObj->pCopy)->Id;
+            }
+        };
+        CollectMap(pAccNet, pMap->acc2Mit);
+        CollectMap(pAppNet, pMap->app2Mit);
+        CollectMap(pDevNet, pMap->dev2Mit);
+    }
+
     return pErrMit;
 }
 
@@ -333,92 +408,24 @@ std::shared_ptr<CMSat::SATSolver> ErrMan::BuildSatSolver_Naive(NetMan& net) {
 }
 
 
-/**
- * @brief Convert the literal to the variable
- * @brief Auxiliary function for BuildSatSolver_Abc
- * 
- * @param Lit     the literal
- * @return int    the variable
- */
-static inline int Cnf_Lit2Var(int Lit) {return (Lit & 1)? -(Lit >> 1) - 1 : (Lit >> 1) + 1;}
-
-
 /**
  * @brief Build SAT solver from the network
- * @brief Copied from ABC "&write_cnf" command
+ * @brief Mapped with the mapper of ABC "&write_cnf"; the network is converted into a GIA owned by this function, so it is reentrant
  * 
- * @param net      the network defining the SAT problem
+ * @param net               the network defining the SAT problem
+ * @param cnfVarIdOfIthPi   the CNF variable ID of the i-th PI
+ * @retval cnfVarIdOfIthPi  the CNF variable ID of the i-th PI
  * @return a pointer to the SAT solver
  */
-std::shared_ptr<CMSat::SATSolver> ErrMan::BuildSatSolver_Abc(NetMan& net, IntVect& cnfVarIdOfIthPi) {
-    // preprocess the network
+std::shared_ptr<CMSat::SATSolver> ErrMan::BuildSatSolver_Gia(const NetMan& net, IntVect& cnfVarIdOfIthPi) {
+    ProfTimer timer(PROF_PHASE::CNF_MAP);
     if (net.GetPoNum() != 1) {
         fmt::print(stderr, "Error: the network defining the SAT problem should have only one PO\n");
         assert(0);
     }
-    // net.Comm("ps; st; ps; ifraig; &get; &ps");
-    net.Comm("st; ifraig; &get");
-    auto pGia = AbcMan().GetAbcFrame()->pGia;
-
-    // default parameters
-    int nLutSize    = 8;
-    int fCnfObjIds  = 0;
-    int fAddOrCla   = 1;
-    abc::Jf_Par_t pars;
-    assert( nLutSize >= 3 && nLutSize <= 8 );
-    abc::Mf_ManSetDefaultPars(&pars);
-    pars.fGenCnf     = 1;
-    pars.fCoarsen    = !fCnfObjIds;
-    pars.nLutSize    = nLutSize;
-    pars.fCnfObjIds  = fCnfObjIds;
-    pars.fAddOrCla   = fAddOrCla;
-    pars.fCnfMapping = 0;
-    pars.fVerbose    = 0;
-
-    // convert the GIA network to CNF
-    // CNF variable mapping rules:
-    // Assume CNF has N variables, with variable IDs running from 0 to N-1.
-    // Variable number 0 is not used in the CNF.
-    // Variables 1, 2, 3,... <nPOs> represent POs in their natural order.
-    // Variables N-<nPIs>, N-<nPIs>+1, N-<nPIs>+2, ... N-1, represent PIs in their natural order.
-    // The internal variables are ordered in a reverse topological order from outputs to inputs.
-    // That is, smaller variable IDs tend to be closer to the outputs, while larger
-    // variable IDs tend to be closer to the inputs. It was found that this ordering
-    // leads to faster SAT solving for hard UNSAT CEC problems.
-    auto pNew = abc::Mf_ManPerformMapping(pGia, &pars);
-    abc::Gia_ManStopP(&pNew);
-    auto pCnf = (abc::Cnf_Dat_t *)pGia->pData;
-
-    // start solver
-    auto pSolver = std::make_shared<CMSat::SATSolver>();
-    // pSolver->set_max_confl(1ll << 20);
-    // pSolver->set_max_confl(1ll << 16);
-    pSolver->set_max_confl(1ll << 18);
-    pSolver->new_vars(pCnf->nVars + 1); // in the ABC cnf, the variable id starts from 1
-
-    // add clauses
-    vector<Lit> clause;
-    for (int i = 0; i < pCnf->nClauses; i++) {
-        clause.clear();
-        for (auto pLit = pCnf->pClauses[i], pStop = pCnf->pClauses[i+1]; pLit < pStop; pLit++) {
-            int var = Cnf_Lit2Var(*pLit);
-            clause.emplace_back(Lit(abs(var), var < 0));
-        }
-        pSolver->add_clause(clause);
-    }
-
-    // update the CNF variable ID of the i-th PI of the error miter
-    assert(pSolver->nVars() - net.GetPiNum() >= 1);
-    cnfVarIdOfIthPi.clear();
-    cnfVarIdOfIthPi.resize(net.GetPiNum());
-    for (int i = 0; i < net.GetPiNum(); ++i) {
-        // Assume CNF has N variables, with variable IDs running from 0 to N-1; Variables N-<nPIs>, N-<nPIs>+1, N-<nPIs>+2, ... N-1, represent PIs in their natural order.
-        cnfVarIdOfIthPi[i] = pSolver->nVars() - net.GetPiNum() + i;
-    }
-    
-    // clean up
-    Cnf_DataFree(pCnf);
-
+    auto pGia = BuildGiaFromNet(net);
+    auto pSolver = BuildSatSolverFromGia(pGia, cnfVarIdOfIthPi);
+    abc::Gia_ManStop(pGia);
     return pSolver;
 }
 
@@ -426,14 +433,13 @@ std::shared_ptr<CMSat::SATSolver> ErrMan::BuildSatSolver_Abc(NetMan& net, IntVec
 /**
  * @brief Get the maximum error defined by the error miter and the corresponding SAT solver using binary search
  * 
- * @param net        the error miter
+ * @param netPiNum   the number of PIs of the error miter
  * @param solver     the SAT solver corresponding to the error miter
  * @param refEdWidth the width of the "ref_err" signal
  * @return BigInt    the maximum error
  */
-BigInt ErrMan::SolveSatsForMaxErrBinSearch(NetMan& net, CMSat::SATSolver& solver, int refEdWidth) {
+BigInt ErrMan::SolveSatsForMaxErrBinSearch(int netPiNum, CMSat::SATSolver& solver, int refEdWidth) {
     // init
-    int netPiNum = net.GetPiNum();
     if (refEdWidth >= 500 || refEdWidth >= netPiNum) {
         fmt::print(stderr, "Error: the reference error width is too large\n");
         assert(0);
@@ -456,7 +462,7 @@ BigInt ErrMan::SolveSatsForMaxErrBinSearch(NetMan& net, CMSat::SATSolver& solver
         }
         assert(refEdTmp == 0);
         // solve
-        lbool res = solver.solve(&assumptions);
+        lbool res = ProfSolve_(solver, &assumptions);
         // fmt::print("left = {}, right = {}, mid = {}, res = {}\n", left.str(), right.str(), mid.str(), res);
         // check the result
         if (res == CMSat::l_False) {
@@ -472,6 +478,180 @@ BigInt ErrMan::SolveSatsForMaxErrBinSearch(NetMan& net, CMSat::SATSolver& solver
 }
 
 
+/**
+ * @brief Get the maximum error defined by the error miter and the corresponding SAT solver using model-guided search
+ * @brief Each SAT model is decoded by simulating the two networks, so the lower bound jumps to the real error of the model instead of the queried reference;
+ * @brief the first query checks whether the known lower bound is already the maximum, the later ones bisect the remaining interval
+ * 
+ * @param netPiNum   the number of PIs of the error miter, whose last refEdWidth PIs are the "ref_err" signal
+ * @param solver     the SAT solver corresponding to the error miter
+ * @param refEdWidth the width of the "ref_err" signal
+ * @param metrType   metric type
+ * @param lowBound   a known lower bound of the maximum error
+ * @param uppBound   a known upper bound of the maximum error; -1 if unknown
+ * @param ctrlAssumpts   the assumptions on the control PIs of the approximate network, i.e., its PIs absent in the accurate network
+ * @return BigInt    the maximum error
+ */
+BigInt ErrMan::SolveSatsForMaxErrGuided(int netPiNum, CMSat::SATSolver& solver, int refEdWidth, METR_TYPE metrType, const BigInt& lowBound, const BigInt& uppBound, const LitVect& ctrlAssumpts) {
+    // init
+    if (refEdWidth >= 500 || refEdWidth >= netPiNum) {
+        fmt::print(stderr, "Error: the reference error width is too large\n");
+        assert(0);
+    }
+    int refEdStartPi = netPiNum - refEdWidth;
+    assert(refEdStartPi == net1.GetPiNum());
+    assert(static_cast<int>(cnfVarIdOfIthPi.size()) == netPiNum);
+    BigInt maxRefEd = (BigInt(1) << refEdWidth) - 1;
+    BigInt maxErr = (metrType == METR_TYPE::MAXED)? (BigInt(1) << net0.GetPoNum()) - 1: BigInt(net0.GetPoNum());
+    BigInt left = std::max(lowBound, BigInt(0)), right = std::min(maxErr, maxRefEd);
+    if (uppBound >= 0)
+        right = std::min(right, uppBound);
+    if (left > right) {
+        fmt::print(stderr, "Error: the lower bound {} is larger than the upper bound {}\n", left.str(), right.str());
+        assert(0);
+    }
+    int nCtrl = static_cast<int>(ctrlAssumpts.size());
+    vector<Lit> assumptions(ctrlAssumpts);
+    assumptions.resize(nCtrl + refEdWidth, Lit(0, true));
+    IntVect model, piVals;
+    Simulator smlt0(net0, 0, 1), smlt1(net1, 0, 1);
+    smlt0.InitConstNodes();
+    smlt1.InitConstNodes();
+    BigInt out0(0), out1(0);
+
+    // solve; invariant: left <= the maximum error <= right
+    bool fFirst = true;
+    int nCall = 0;
+    while (left < right) {
+        BigInt ref = fFirst? left: left + (right - left) / 2;
+        fFirst = false;
+        // set the assumptions, asking for an error larger than ref
+        BigInt refEdTmp = ref;
+        for (int i = 0; i < refEdWidth; ++i) {
+            auto piCnfVarId = cnfVarIdOfIthPi[refEdStartPi + i];
+            assumptions[nCtrl + i] = Lit(piCnfVarId, !(refEdTmp & 1));
+            refEdTmp >>= 1;
+        }
+        assert(refEdTmp == 0);
+        // solve
+        lbool res = SolveSatAndGetCountEx(solver, assumptions, cnfVarIdOfIthPi, model);
+        ++nCall;
+        if (res == CMSat::l_False)
+            right = ref;
+        else if (res == CMSat::l_True) {
+            // decode the real error of the model
+            // the control PIs of net1 follow the PIs shared with net0
+            piVals.assign(model.begin(), model.begin() + refEdStartPi);
+            smlt1.ReplInp(0, piVals);
+            piVals.resize(net0.GetPiNum());
+            smlt0.ReplInp(0, piVals);
+            smlt0.UpdNodeAndPoPatts();
+            smlt1.UpdNodeAndPoPatts();
+            BigInt err(0);
+            if (metrType == METR_TYPE::MAXED) {
+                smlt0.GetOutput(0, out0);
+                smlt1.GetOutput(0, out1);
+                err = abs(out0 - out1);
+            }
+            else {
+                for (int i = 0; i < net0.GetPoNum(); ++i)
+                    err += (smlt0.GetDat(smlt0.GetPoId(i))[0] != smlt1.GetDat(smlt1.GetPoId(i))[0]);
+            }
+            assert(err > ref && err <= right);
+            left = err;
+        }
+        else {
+            fmt::print("Error: SAT solver returns undefined\n");
+            assert(0);
+        }
+    }
+    fmt::print("maximum error = {}, #SAT calls = {}\n", left.str(), nCall);
+    return left;
+}
+
+
+/**
+ * @brief Constructor of the truncation engine
+ * @brief A MUX "en ? val : driver" replaces each PO driver of a copy of the approximate network, and the miter is encoded once
+ * 
+ * @param acc_net      the accurate network
+ * @param app_net      the approximate network, which is not modified
+ * @param metr_type    the error metric type, MAXED or MAXHD
+ */
+TruncErrMan::TruncErrMan(const NetMan& acc_net, const NetMan& app_net, METR_TYPE metr_type):
+    metrType(metr_type), ctrlNet(app_net), pErrMan(nullptr) {
+    if (metrType != METR_TYPE::MAXED && metrType != METR_TYPE::MAXHD) {
+        fmt::print(stderr, "Error: unsupport metric type\n");
+        assert(0);
+    }
+    if (ctrlNet.GetNetType() != NET_TYPE::SOP) {
+        fmt::print(stderr, "Error: the approximate network should be in SOP\n");
+        assert(0);
+    }
+    assert(ctrlNet.GetPiNum() == acc_net.GetPiNum());
+    // the miter keeps the PIs of the accurate network first, then the control PIs in creation order
+    int nPo = ctrlNet.GetPoNum();
+    enPis.resize(nPo);
+    valPis.resize(nPo);
+    commVals.assign(nPo, -1);
+    IntVect replTrace;
+    for (int iPo = 0; iPo < nPo; ++iPo) {
+        int drivId = ctrlNet.GetPoDrivId(iPo);
+        enPis[iPo] = ctrlNet.GetPiNum();
+        auto pEn = ctrlNet.CreatePi(fmt::format("trunc_en_{}", iPo).c_str());
+        valPis[iPo] = ctrlNet.GetPiNum();
+        auto pVal = ctrlNet.CreatePi(fmt::format("trunc_val_{}", iPo).c_str());
+        int muxId = ctrlNet.CreateNode({drivId, pEn->Id, pVal->Id}, "10- 1\n-11 1\n");
+        ctrlNet.TempRepl_v2(drivId, muxId, replTrace, false);
+    }
+    auto pDevCompNet = GenDevCompNet(metrType, nPo);
+    pErrMan = std::make_shared<ErrMan>(acc_net, ctrlNet, *pDevCompNet);
+}
+
+
+/**
+ * @brief Compute the maximum error if the iPo-th PO is truncated to the constant val, on top of the committed truncations
+ * @brief The POs that are neither committed nor tried are kept
+ * 
+ * @param iPo        the PO index
+ * @param val        the constant
+ * @param lowBound   a known lower bound of the maximum error
+ * @param uppBound   a known upper bound of the maximum error; -1 if unknown
+ * @return BigInt    the maximum error
+ */
+BigInt TruncErrMan::TryTrunc(int iPo, bool val, const BigInt& lowBound, const BigInt& uppBound) {
+    assert(iPo >= 0 && iPo < static_cast<int>(commVals.size()));
+    assert(commVals[iPo] == -1);
+    // the committed POs are fixed by unit clauses
+    LitVect assumpts;
+    for (int i = 0; i < static_cast<int>(commVals.size()); ++i) {
+        if (commVals[i] != -1)
+            continue;
+        bool fEn = (i == iPo);
+        assumpts.emplace_back(Lit(pErrMan->GetCnfVarIdOfIthPi(enPis[i]), !fEn));
+        if (fEn)
+            assumpts.emplace_back(Lit(pErrMan->GetCnfVarIdOfIthPi(valPis[i]), !val));
+    }
+    return pErrMan->ComputeMaxErrWithAssumpts(metrType, assumpts, lowBound, uppBound);
+}
+
+
+/**
+ * @brief Commit the truncation of the iPo-th PO to the constant val
+ * 
+ * @param iPo        the PO index
+ * @param val        the constant
+ * @return void
+ */
+void TruncErrMan::CommitTrunc(int iPo, bool val) {
+    assert(iPo >= 0 && iPo < static_cast<int>(commVals.size()));
+    assert(commVals[iPo] == -1);
+    commVals[iPo] = val;
+    pErrMan->AddUnitClauseOfPi(enPis[iPo], false);
+    pErrMan->AddUnitClauseOfPi(valPis[iPo], !val);
+}
+
+
 /**
  * @brief Add a unit clause in the SAT solver for the i-th PI of the error miter
  * 
@@ -488,6 +668,431 @@ void ErrMan::AddUnitClauseOfPi(int iPi, bool fVarCompl) {
 }
 
 
+/**
+ * @brief Constructor of the incremental error checker
+ * @brief Encode the accurate network, the approximate network and the deviation network into a persistent SAT solver
+ * 
+ * @param acc_net      the accurate network
+ * @param app_net      the approximate network
+ * @param dev_net      the deviation network with embedded error bound
+ * @param nSatThread   the number of threads of the SAT solver; more than one runs a portfolio
+ */
+IncErrMan::IncErrMan(const NetMan& acc_net, const NetMan& app_net, const NetMan& dev_net, int nSatThread):
+    IncErrMan(acc_net, app_net, dev_net, acc_net.CalcTopoOrdOfIds(false), dev_net.CalcTopoOrdOfIds(false), nSatThread) {
+}
+
+
+/**
+ * @brief Constructor of the incremental error checker with precomputed topological orders
+ * @brief accNet and devNet are only read, so they can be shared by the checkers in different threads
+ * 
+ * @param acc_net      the accurate network
+ * @param app_net      the approximate network
+ * @param dev_net      the deviation network with embedded error bound
+ * @param accTopoIds   the nodes of the accurate network in topological order
+ * @param devTopoIds   the nodes of the deviation network in topological order
+ * @param nSatThread   the number of threads of the SAT solver; more than one runs a portfolio
+ */
+IncErrMan::IncErrMan(const NetMan& acc_net, const NetMan& app_net, const NetMan& dev_net, const IntVect& accTopoIds, const IntVect& dev_topo_ids, int nSatThread):
+    accNet(acc_net), appNet(app_net), devNet(dev_net), devTopoIds(dev_topo_ids), candAct(CMSat::lit_Undef), fAccPosValid(false) {
+    // check
+    if (accNet.GetNetType() != NET_TYPE::SOP || appNet.GetNetType() != NET_TYPE::SOP || devNet.GetNetType() != NET_TYPE::SOP) {
+        fmt::print(stderr, "Error: the networks should be in SOP\n");
+        assert(0);
+    }
+    if (!ComparePi(accNet, appNet, false) || !ComparePo(accNet, appNet)) {
+        fmt::print(stderr, "Error: different PIs/POs\n");
+        assert(0);
+    }
+    int nPi = accNet.GetPiNum(), nPo = accNet.GetPoNum();
+    if (devNet.GetPiNum() != nPo * 2 || devNet.GetPoNum() != 1) {
+        fmt::print(stderr, "Error: the deviation network should have an embedded error bound\n");
+        assert(0);
+    }
+
+    // start solver
+    pSolver = std::make_shared<SATSolver>();
+    if (nSatThread > 1) // should be set before adding variables
+        pSolver->set_num_threads(nSatThread);
+    pEnc = std::make_shared<SopCnfEnc>(*pSolver);
+
+    // share the PI variables between accNet and appNet
+    accLits.assign(accNet.GetIdMaxPlus1(), CMSat::lit_Undef);
+    appLits.assign(appNet.GetIdMaxPlus1(), CMSat::lit_Undef);
+    devLits.assign(devNet.GetIdMaxPlus1(), CMSat::lit_Undef);
+    cnfVarIdOfIthPi.resize(nPi);
+    for (int i = 0; i < nPi; ++i) {
+        auto lit = pEnc->NewLit();
+        accLits[accNet.GetPiId(i)] = lit;
+        appLits[appNet.GetPiId(i)] = lit;
+        cnfVarIdOfIthPi[i] = lit.var();
+    }
+
+    // encode the networks
+    pEnc->EncNet(accNet, accTopoIds, accLits);
+    pEnc->EncNet(appNet, appNet.CalcTopoOrdOfIds(false), appLits);
+    for (int i = 0; i < nPo; ++i) {
+        devLits[devNet.GetPiId(i)] = accLits[accNet.GetPoId(i)];
+        devLits[devNet.GetPiId(i + nPo)] = appLits[appNet.GetPoId(i)];
+    }
+    pEnc->EncNet(devNet, devTopoIds, devLits);
+
+    // prepare counter examples
+    counterExPiPatts.resize(nPi);
+    counterExAccPos.resize(nPo);
+}
+
+
+/**
+ * @brief Encode the candidate applied on appNet as the pending candidate, without solving
+ * @brief The candidate should have been temporarily applied, e.g., by TempApplyLac
+ * 
+ * @param  ssId          the substitution node of the candidate
+ * @return void
+ */
+void IncErrMan::EncCand(int ssId) {
+    EncCands(IntVect{ssId});
+}
+
+
+/**
+ * @brief Encode several candidates applied together on appNet as one pending candidate, without solving
+ * @brief The candidates should have been temporarily applied in order, e.g., by TempApplyLac
+ * 
+ * @param  ssIds         the substitution nodes of the candidates
+ * @return void
+ */
+void IncErrMan::EncCands(const IntVect& ssIds) {
+    assert(candAct == CMSat::lit_Undef);
+    assert(!ssIds.empty());
+    AbcObjVect tfo;
+    if (ssIds.size() == 1) {
+        // the substitution node is either a new node or an existing constant, so its function is independent of the candidate
+        pEnc->EncObj(appNet, ssIds[0], appLits);
+        tfo = appNet.GetTFO(appNet.GetObj(ssIds[0]));
+    }
+    else {
+        // the divisors of a new substitution node may be changed by another candidate,
+        // so the substitution nodes are re-encoded with the union of the TFOs, in topological order
+        IntSet changedIds;
+        for (int ssId: ssIds) {
+            pEnc->EncObj(appNet, ssId, appLits);
+            if (!appNet.IsConst(ssId))
+                changedIds.insert(ssId);
+            for (auto pObj: appNet.GetTFO(appNet.GetObj(ssId)))
+                changedIds.insert(pObj->Id);
+        }
+        for (auto pObj: appNet.CalcTopoOrd()) {
+            if (changedIds.count(pObj->Id))
+                tfo.emplace_back(pObj);
+        }
+    }
+
+    // re-encode the TFO of the substitution nodes
+    candAppLits.clear();
+    LitVect faninLits;
+    for (auto pObj: tfo) {
+        faninLits.clear();
+        for (int i = 0; i < appNet.GetFaninNum(pObj); ++i)
+            faninLits.emplace_back(GetAppLit(appNet.GetFaninId(pObj, i)));
+        candAppLits[pObj->Id] = pEnc->EncSop(faninLits, static_cast<char*>(pObj->pData));
+    }
+
+    // re-encode the devNet nodes affected by the changed appNet POs
+    int nPo = appNet.GetPoNum();
+    candDevLits = devLits;
+    for (int i = 0; i < nPo; ++i)
+        candDevLits[devNet.GetPiId(i + nPo)] = GetAppLit(appNet.GetPoDrivId(i));
+    for (auto id: devTopoIds) {
+        auto pObj = devNet.GetObj(id);
+        bool fFaninChanged = false;
+        faninLits.clear();
+        for (int i = 0; i < devNet.GetFaninNum(pObj); ++i) {
+            auto faninId = devNet.GetFaninId(pObj, i);
+            faninLits.emplace_back(candDevLits[faninId]);
+            fFaninChanged |= (candDevLits[faninId] != devLits[faninId]);
+        }
+        if (fFaninChanged)
+            candDevLits[id] = pEnc->EncSop(faninLits, static_cast<char*>(pObj->pData));
+    }
+    auto devPoId = devNet.GetPoId(0);
+    candDevLits[devPoId] = candDevLits[devNet.GetPoDrivId(0)];
+
+    // assert "error > bound" under the activation literal
+    candAct = pEnc->NewLit();
+    pEnc->AddClause({~candAct, candDevLits[devPoId]});
+}
+
+
+/**
+ * @brief Check whether the candidate applied on appNet exceeds the error bound
+ * @brief The candidate should have been temporarily applied, e.g., by TempApplyLac
+ * 
+ * @param  ssId          the substitution node of the candidate
+ * @param  counterEx     the counter example (if the result is SAT)
+ * @param  printTime     whether to print the runtime
+ * @param  pSched        the SAT scheduler bounding the check; nullptr if the default budget is used
+ * @param  confl         the conflict budget given by the scheduler
+ * @retval counterEx     the counter example (if the result is SAT)
+ * @return CMSat::lbool  l_False if the error bound is satisfied, l_True if exceeded, l_Undef if unknown
+ */
+CMSat::lbool IncErrMan::CheckCand(int ssId, IntVect& counterEx, bool printTime, const SatSched* pSched, ll confl) {
+    return CheckCands(IntVect{ssId}, counterEx, printTime, pSched, confl);
+}
+
+
+/**
+ * @brief Check whether the candidates applied together on appNet exceed the error bound
+ * @brief The candidates should have been temporarily applied in order, e.g., by TempApplyLac
+ * 
+ * @param  ssIds         the substitution nodes of the candidates
+ * @param  counterEx     the counter example (if the result is SAT)
+ * @param  printTime     whether to print the runtime
+ * @param  pSched        the SAT scheduler bounding the check; nullptr if the default budget is used
+ * @param  confl         the conflict budget given by the scheduler
+ * @retval counterEx     the counter example (if the result is SAT)
+ * @return CMSat::lbool  l_False if the error bound is satisfied, l_True if exceeded, l_Undef if unknown
+ */
+CMSat::lbool IncErrMan::CheckCands(const IntVect& ssIds, IntVect& counterEx, bool printTime, const SatSched* pSched, ll confl) {
+    EncCands(ssIds);
+    if (pSched != nullptr)
+        pSched->Config(*pSolver, confl);
+    else
+        pSolver->set_max_confl(MAX_CONFL);
+    return SolveSatAndGetCountEx(*pSolver, {candAct}, cnfVarIdOfIthPi, counterEx, printTime);
+}
+
+
+/**
+ * @brief Commit the pending candidate: later candidates are encoded on top of it
+ * 
+ * @return void
+ */
+void IncErrMan::CommitCand() {
+    assert(candAct != CMSat::lit_Undef);
+    pEnc->AddUnit(~candAct);
+    candAct = CMSat::lit_Undef;
+    if (static_cast<int>(appLits.size()) < appNet.GetIdMaxPlus1())
+        appLits.resize(appNet.GetIdMaxPlus1(), CMSat::lit_Undef);
+    for (const auto& [id, lit]: candAppLits)
+        appLits[id] = lit;
+    candAppLits.clear();
+    for (int i = 0; i < appNet.GetPoNum(); ++i)
+        appLits[appNet.GetPoId(i)] = GetAppLit(appNet.GetPoDrivId(i));
+    devLits.swap(candDevLits);
+}
+
+
+/**
+ * @brief Reject the pending candidate: its assertion is permanently disabled
+ * 
+ * @return void
+ */
+void IncErrMan::RejectCand() {
+    assert(candAct != CMSat::lit_Undef);
+    pEnc->AddUnit(~candAct);
+    candAct = CMSat::lit_Undef;
+    candAppLits.clear();
+}
+
+
+/**
+ * @brief Record a counter example for the fast checking of later candidates
+ * 
+ * @param counterEx    the counter example on the PIs
+ * @return void
+ */
+void IncErrMan::AddCounterEx(const IntVect& counterEx) {
+    assert(counterEx.size() == counterExPiPatts.size());
+    for (int iPi = 0; iPi < static_cast<int>(counterEx.size()); ++iPi) {
+        assert(counterEx[iPi] == 0 || counterEx[iPi] == 1);
+        counterExPiPatts[iPi].push_back(counterEx[iPi]);
+    }
+    fAccPosValid = false;
+}
+
+
+/**
+ * @brief Check whether the current appNet exceeds the error bound on the recorded counter examples using logic simulation
+ * 
+ * @return bool    true if the error bound is exceeded on some counter example
+ */
+bool IncErrMan::ExceedOnCounterExs() {
+    int nCounterEx = GetCounterExNum();
+    if (nCounterEx == 0)
+        return false;
+    int nPo = accNet.GetPoNum();
+    // accurate outputs
+    if (!fAccPosValid) {
+        Simulator accSmlt(accNet, 0, nCounterEx);
+        accSmlt.GenInpFromBitVects(counterExPiPatts);
+        accSmlt.UpdNodeAndPoPatts();
+        for (int i = 0; i < nPo; ++i)
+            counterExAccPos[i] = accSmlt.GetDat(accSmlt.GetPoId(i)).ToBitVect();
+        fAccPosValid = true;
+    }
+    return ExceedOnPatts(appNet, devNet, counterExPiPatts, counterExAccPos);
+}
+
+
+/**
+ * @brief Constructor of the counter-example checker, starting without counter examples
+ * 
+ * @param acc_net   the accurate network
+ * @param app_net   the approximate network, on which the candidates are temporarily applied
+ * @param dev_net   the deviation network with embedded error bound
+ */
+CexErrChecker::CexErrChecker(const NetMan& acc_net, const NetMan& app_net, const NetMan& dev_net): accSmlt(acc_net, 0, 0), appSmlt(app_net, 0, 0), devSmlt(dev_net, 0, 0) {
+    assert(acc_net.IsPIOSame(app_net));
+    assert(dev_net.GetPiNum() == app_net.GetPoNum() * 2 && dev_net.GetPoNum() == 1);
+    devPiVals.resize(dev_net.GetPiNum());
+}
+
+
+/**
+ * @brief Record a counter example; only its word is simulated
+ * @brief The candidate should have been recovered, so that the approximate patterns follow the current network
+ * 
+ * @param counterEx    the counter example on the PIs
+ * @return void
+ */
+void CexErrChecker::AddCounterEx(const IntVect& counterEx) {
+    accSmlt.AppendInp(counterEx);
+    accSmlt.UpdDirtyPatts();
+    appSmlt.AppendInp(counterEx);
+    appSmlt.UpdDirtyPatts();
+    int nPo = accSmlt.GetPoNum(), iPatt = accSmlt.GetFrameNumb() - 1;
+    for (int i = 0; i < nPo; ++i) {
+        devPiVals[i] = accSmlt.GetDat(accSmlt.GetPoId(i))[iPatt];
+        devPiVals[i + nPo] = appSmlt.GetDat(appSmlt.GetPoId(i))[iPatt];
+    }
+    devSmlt.AppendInp(devPiVals);
+    devSmlt.UpdDirtyPatts();
+}
+
+
+/**
+ * @brief Add the seeds of the incremental simulation of a candidate: its substitution node and the patched fanouts
+ * 
+ * @param ssId        the substitution node of the candidate
+ * @param replTrace   the replacement trace of the candidate, from TempApplyLac
+ * @retval seedIds    the seeds including the candidate's ones
+ * @return void
+ */
+void CexErrChecker::AddCandSeeds(int ssId, const IntVect& replTrace) {
+    seedIds.emplace_back(ssId);
+    auto itDelObj = std::ranges::find(replTrace, -1);
+    int patchFaninEnd = static_cast<int>(itDelObj - replTrace.begin());
+    for (int i = 1; i < patchFaninEnd / 2; ++i)
+        seedIds.emplace_back(replTrace[i * 2]);
+}
+
+
+/**
+ * @brief Resimulate the approximate and deviation networks from the seeds, after the candidates are applied
+ * 
+ * @return void
+ */
+void CexErrChecker::UpdSeeds() {
+    // the substitution nodes and the patched fanouts are recomputed
+    appSmlt.UpdTfoPatts(seedIds);
+    // propagate the approximate outputs to the deviation network
+    int nPo = appSmlt.GetPoNum();
+    for (int i = 0; i < nPo; ++i)
+        devSmlt.SetInp(i + nPo, appSmlt.GetDat(appSmlt.GetPoId(i)));
+    devSmlt.UpdDirtyPatts();
+}
+
+
+/**
+ * @brief Check whether the candidates given by the seeds exceed the error bound on the counter examples, and roll the patterns back
+ * 
+ * @return bool  whether the error bound is exceeded
+ */
+bool CexErrChecker::ExceedOnSeeds() {
+    ProfTimer timer(PROF_PHASE::CEX_CHECK);
+    appSmlt.StartUndoLog();
+    devSmlt.StartUndoLog();
+    UpdSeeds();
+    bool fExceed = devSmlt.GetDat(devSmlt.GetPoId(0)).Any();
+    appSmlt.RollBack();
+    devSmlt.RollBack();
+    if (fExceed)
+        Profiler::Get().AddCnt(PROF_CNT::CEX_REJECT);
+    return fExceed;
+}
+
+
+/**
+ * @brief Check whether the candidate exceeds the error bound on the counter examples
+ * @brief The candidate should have been temporarily applied, e.g., by TempApplyLac
+ * 
+ * @param ssId        the substitution node of the candidate
+ * @param replTrace   the replacement trace of the candidate, from TempApplyLac
+ * @return bool       whether the error bound is exceeded
+ */
+bool CexErrChecker::ExceedWithCand(int ssId, const IntVect& replTrace) {
+    if (GetCounterExNum() == 0)
+        return false;
+    seedIds.clear();
+    AddCandSeeds(ssId, replTrace);
+    return ExceedOnSeeds();
+}
+
+
+/**
+ * @brief Check whether a group of candidates, applied together, exceeds the error bound on the counter examples
+ * @brief The candidates should have been temporarily applied in order, e.g., by TempApplyLac
+ * 
+ * @param ssIds        the substitution nodes of the candidates
+ * @param replTraces   the replacement traces of the candidates, from TempApplyLac
+ * @return bool        whether the error bound is exceeded
+ */
+bool CexErrChecker::ExceedWithCands(const IntVect& ssIds, const Int2DVect& replTraces) {
+    assert(ssIds.size() == replTraces.size());
+    if (GetCounterExNum() == 0)
+        return false;
+    seedIds.clear();
+    for (int i = 0; i < static_cast<int>(ssIds.size()); ++i)
+        AddCandSeeds(ssIds[i], replTraces[i]);
+    return ExceedOnSeeds();
+}
+
+
+/**
+ * @brief Keep the patterns of the candidate applied on the approximate network
+ * 
+ * @param ssId        the substitution node of the candidate
+ * @param replTrace   the replacement trace of the candidate, from TempApplyLac
+ * @return void
+ */
+void CexErrChecker::CommitCand(int ssId, const IntVect& replTrace) {
+    if (GetCounterExNum() == 0)
+        return;
+    seedIds.clear();
+    AddCandSeeds(ssId, replTrace);
+    UpdSeeds();
+}
+
+
+/**
+ * @brief Keep the patterns of a group of candidates applied together on the approximate network
+ * 
+ * @param ssIds        the substitution nodes of the candidates
+ * @param replTraces   the replacement traces of the candidates, from TempApplyLac
+ * @return void
+ */
+void CexErrChecker::CommitCands(const IntVect& ssIds, const Int2DVect& replTraces) {
+    assert(ssIds.size() == replTraces.size());
+    if (GetCounterExNum() == 0)
+        return;
+    seedIds.clear();
+    for (int i = 0; i < static_cast<int>(ssIds.size()); ++i)
+        AddCandSeeds(ssIds[i], replTraces[i]);
+    UpdSeeds();
+}
+
+
 // /**
 //  * @brief Pick the first LAC whose real maximum error is no more than the given bound
 //  * @brief Assume that the LACs are sorted: primary key = (smaller) error, secondary key = (larger) sizeGain
@@ -556,17 +1161,20 @@ void ErrMan::AddUnitClauseOfPi(int iPi, bool fVarCompl) {
  */
 void BatchErrEst::CompLacErrsByEnumAndPruneBadLacs(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound) {
     fmt::print("Max error computation using enumeration\n");
-    assert(accSmlt.GetPiNum() < 30);
-    int enumFrame = 1 << accSmlt.GetPiNum();
+    assert(accSmlt.GetPiNum() < 63);
+    ll enumFrame = 1ll << accSmlt.GetPiNum();
     // rough estimation
     if (ROUGH_SIM_FRAME < enumFrame) {
         auto startTime = std::chrono::high_resolution_clock::now();
+        ProfTimer timer(PROF_PHASE::ROUGH_SIM);
         PruneLacsWithSim(lacMan, accSmlt, appNet, errUppBound, ROUGH_SIM_FRAME, DISTR_TYPE::UNIF);
         PrintRuntime(startTime, "rough simulation");
     }
     // enumeration
     auto startTime = std::chrono::high_resolution_clock::now();
-    PruneLacsWithSim(lacMan, accSmlt, appNet, errUppBound, enumFrame, DISTR_TYPE::ENUM);
+    ProfTimer timer(PROF_PHASE::FINE_SIM);
+    // the enumeration is streamed in windows of ENUM_WINDOW_FRAME patterns
+    PruneLacsWithSim(lacMan, accSmlt, appNet, errUppBound, ENUM_WINDOW_FRAME, DISTR_TYPE::ENUM);
     PrintRuntime(startTime, "enumeration");
 }
 
@@ -578,30 +1186,97 @@ void BatchErrEst::CompLacErrsByEnumAndPruneBadLacs(LACMan& lacMan, Simulator& ac
  * @param accSmlt      the accurate network's simulator
  * @param appNet       the approximate network
  * @param errUppBound  the upper bound of the error
+ * @param pBank        the counter-example pattern bank fed to both stages; nullptr if unused
  */
-void BatchErrEst::CompLacErrsBySimAndPruneBadLacs(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound) {
+void BatchErrEst::CompLacErrsBySimAndPruneBadLacs(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound, PatternBank* pBank) {
     // rough estimation
     auto startTime = std::chrono::high_resolution_clock::now();
-    PruneLacsWithSim(lacMan, accSmlt, appNet, errUppBound, ROUGH_SIM_FRAME, DISTR_TYPE::UNIF);
+    {
+        ProfTimer timer(PROF_PHASE::ROUGH_SIM);
+        PruneLacsWithSim(lacMan, accSmlt, appNet, errUppBound, ROUGH_SIM_FRAME, DISTR_TYPE::UNIF, pBank);
+    }
     PrintRuntime(startTime, "rough simulation");
     // fine estimation
     if (ROUGH_SIM_FRAME < nFrame) {
         startTime = std::chrono::high_resolution_clock::now();
-        PruneLacsWithSim(lacMan, accSmlt, appNet, errUppBound, nFrame, DISTR_TYPE::UNIF);
+        ProfTimer timer(PROF_PHASE::FINE_SIM);
+        PruneLacsWithSim(lacMan, accSmlt, appNet, errUppBound, nFrame, DISTR_TYPE::UNIF, pBank);
         PrintRuntime(startTime, "fine-grained simulation");
     }
 }
 
 
+/**
+ * @brief Compute the maximum error lower bounds of the LACs lazily, until the top-K LACs are certain, and prune large-error LACs
+ * @brief The rough stage simulates the first frames of accSmlt, so the rough error of a LAC is a lower bound of its fine error;
+ * @brief the LACs are then finely simulated in the order of their rough errors and size gains, in growing batches,
+ * @brief until the K-th best finely simulated LAC is no worse than the rough key of every remaining LAC
+ * 
+ * @param lacMan       the LAC manager
+ * @param accSmlt      the accurate network's simulator, whose first frames hold the bank patterns
+ * @param appNet       the approximate network
+ * @param errUppBound  the upper bound of the error
+ * @param topK         the number of the best LACs to be certain of
+ * @param pBank        the counter-example pattern bank fed to both stages; nullptr if unused
+ * @retval lacMan      the finely simulated LACs within the error bound, including the top-K ones
+ * @return void
+ */
+void BatchErrEst::CompLacErrsBySimAndKeepTopKLacs(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound, int topK, PatternBank* pBank) {
+    assert(topK > 0);
+    // rough estimation on the first frames
+    auto startTime = std::chrono::high_resolution_clock::now();
+    int nFrameRough = std::min(ROUGH_SIM_FRAME, nFrame);
+    {
+        ProfTimer timer(PROF_PHASE::ROUGH_SIM);
+        PruneLacsWithSim(lacMan, accSmlt, appNet, errUppBound, nFrameRough, DISTR_TYPE::UNIF, pBank, true);
+    }
+    PrintRuntime(startTime, "rough simulation");
+    if (nFrameRough == nFrame)
+        return;
+    // order the LACs by the lower bounds of their keys
+    lacMan.SortAndKeepTopKLACs(-1);
+    LACVect cands(lacMan.GetLacs()), evals;
+    // fine estimation in growing batches
+    startTime = std::chrono::high_resolution_clock::now();
+    ProfTimer timer(PROF_PHASE::FINE_SIM);
+    LACMan batchMan;
+    int iNext = 0, batchSize = std::max(topK * 4, 1024);
+    while (iNext < static_cast<int>(cands.size())) {
+        int iEnd = std::min(static_cast<int>(cands.size()), iNext + batchSize);
+        batchMan.ReplLacs(LACVect(cands.begin() + iNext, cands.begin() + iEnd));
+        PruneLacsWithSim(batchMan, accSmlt, appNet, errUppBound, nFrame, DISTR_TYPE::UNIF, pBank);
+        evals.insert(evals.end(), batchMan.GetLacs().begin(), batchMan.GetLacs().end());
+        iNext = iEnd;
+        batchSize <<= 1;
+        // stop if no remaining LAC can beat the K-th best one
+        if (static_cast<int>(evals.size()) >= topK && iNext < static_cast<int>(cands.size())) {
+            std::nth_element(evals.begin(), evals.begin() + (topK - 1), evals.end(), Lac0BetterThanLac1);
+            if (!Lac0BetterThanLac1(cands[iNext], evals[topK - 1])) {
+                fmt::print("Lazy evaluation: the top-{} LACs are certain, skip the remaining {} LACs\n", topK, cands.size() - iNext);
+                break;
+            }
+        }
+    }
+    PrintRuntime(startTime, "fine-grained simulation");
+    lacMan.ReplLacs(evals);
+    fmt::print("#promising LACs after lazy pruning: {}\n", lacMan.GetLacNum());
+}
+
+
 /**
  * @brief Prune large-error LACs using logic simulation
+ * @brief The FFR roots with LACs are dynamically distributed over nThread threads, each with its own scratch
+ * @brief Under uniform patterns, the first frames hold the bank patterns; if nFramePrune == nFrame or fPrefix, accSmlt should already hold them
+ * @brief Under enumeration, nFramePrune is ignored: all 2^#PI patterns are streamed in windows of ENUM_WINDOW_FRAME frames, the errors are reduced into running maxima, and the LACs exceeding the bound skip the remaining windows
  * 
  * @param lacMan       the LAC manager
  * @param accNet       the accurate network
  * @param appNet       the approximate network
  * @param errUppBound  the upper bound of the error
+ * @param pBank        the counter-example pattern bank, credited with the LACs that its patterns reject; nullptr if unused
+ * @param fPrefix      whether to simulate the first nFramePrune frames of accSmlt instead of new random patterns, so that the errors are lower bounds of those under all the frames
  */
-void BatchErrEst::PruneLacsWithSim(LACMan& lacMan, Simulator& acc_smlt, const NetMan& appNet, ll errUppBound, int nFramePrune, DISTR_TYPE distrType) {
+void BatchErrEst::PruneLacsWithSim(LACMan& lacMan, Simulator& acc_smlt, const NetMan& appNet, ll errUppBound, int nFramePrune, DISTR_TYPE distrType, PatternBank* pBank, bool fPrefix) {
     // regroup LACs by node
     lacMan.RegroupLACsByNode(true);
     auto& node2Lacs = lacMan.GetNode2Lacs();
@@ -612,141 +1287,215 @@ void BatchErrEst::PruneLacsWithSim(LACMan& lacMan, Simulator& acc_smlt, const Ne
         fmt::print(stderr, "Error: different PI/PO\n");
         assert(0);
     }
-    if (distrType == DISTR_TYPE::ENUM) {
+    // in enumeration, the patterns are streamed in windows, so the memory scales with the window size instead of 2^#PI
+    bool useEnum = (distrType == DISTR_TYPE::ENUM);
+    ll nWindow = 1;
+    if (useEnum) {
         int nPi = appNet.GetPiNum();
-        assert(nPi < 30);
-        nFramePrune = 1 << nPi;
+        assert(nPi < 63);
+        ll nEnumPatt = 1ll << nPi;
+        nFramePrune = static_cast<int>(std::min(nEnumPatt, static_cast<ll>(ENUM_WINDOW_FRAME)));
+        nWindow = nEnumPatt / nFramePrune;
     }
     int nPo = appNet.GetPoNum();
-    vector<BigInt> YAcc(nFramePrune, 0);
-    vector<BitVect> accPos(nPo);
-    Simulator appSmlt(appNet, seed, nFramePrune, distrType);
-    if (nFramePrune == nFrame) {
+    // the rows of BitMat are bit slices padded to a multiple of 8 words, so they feed the word-parallel kernels directly
+    BitMat accPos(nPo, nFramePrune);
+    Simulator appSmlt(appNet, seed, nFramePrune, useEnum? DISTR_TYPE::UNIF: distrType);
+    std::unique_ptr<Simulator> pAccSmltWin;
+    bool useBank = (pBank != nullptr && !useEnum);
+    int nBankPatt = 0;
+    if (useEnum)
+        pAccSmltWin = std::make_unique<Simulator>(accNet, seed, nFramePrune);
+    else if (nFramePrune == nFrame) {
         appSmlt.GenInpFromOthSmlt(acc_smlt);
         appSmlt.UpdNodeAndPoPatts();
-        if (metrType == METR_TYPE::MAXED) {
-            for (int iPatt = 0; iPatt < nFramePrune; ++iPatt)
-                acc_smlt.GetOutput(iPatt, YAcc[iPatt]);
-        }
-        else if (metrType == METR_TYPE::MAXHD) {
-            for (int iPo = 0; iPo < nPo; ++iPo)
-                accPos[iPo] = acc_smlt.GetDat(acc_smlt.GetPoId(iPo));
-        }
+        for (int iPo = 0; iPo < nPo; ++iPo)
+            accPos[iPo].Assign(acc_smlt.GetDat(acc_smlt.GetPoId(iPo)));
+        if (useBank)
+            nBankPatt = std::min(pBank->GetPattNum(), nFramePrune);
+    }
+    else if (fPrefix) {
+        assert(nFramePrune < acc_smlt.GetFrameNumb());
+        Simulator accSmltFewPatt(accNet, seed, nFramePrune, distrType);
+        accSmltFewPatt.GenInpFromOthSmlt(acc_smlt);
+        appSmlt.GenInpFromOthSmlt(acc_smlt);
+        accSmltFewPatt.UpdNodeAndPoPatts();
+        appSmlt.UpdNodeAndPoPatts();
+        for (int iPo = 0; iPo < nPo; ++iPo)
+            accPos[iPo].Assign(accSmltFewPatt.GetDat(accSmltFewPatt.GetPoId(iPo)));
+        if (useBank)
+            nBankPatt = std::min(pBank->GetPattNum(), nFramePrune);
     }
     else {
         Simulator accSmltFewPatt(accNet, seed, nFramePrune, distrType);
-        accSmltFewPatt.LogicSim();
-        appSmlt.LogicSim();
-        if (metrType == METR_TYPE::MAXED) {
-            for (int iPatt = 0; iPatt < nFramePrune; ++iPatt)
-                accSmltFewPatt.GetOutput(iPatt, YAcc[iPatt]);
-        }
-        else if (metrType == METR_TYPE::MAXHD) {
-            for (int iPo = 0; iPo < nPo; ++iPo) {
-                accPos[iPo] = accSmltFewPatt.GetDat(accSmltFewPatt.GetPoId(iPo));
-                accPos[iPo].resize(nFramePrune);
-            }
+        accSmltFewPatt.GenInpPatts(nThread);
+        appSmlt.GenInpPatts(nThread);
+        if (useBank) {
+            nBankPatt = pBank->LoadInto(accSmltFewPatt);
+            pBank->LoadInto(appSmlt);
         }
+        accSmltFewPatt.UpdNodeAndPoPatts();
+        appSmlt.UpdNodeAndPoPatts();
+        for (int iPo = 0; iPo < nPo; ++iPo)
+            accPos[iPo].Assign(accSmltFewPatt.GetDat(accSmltFewPatt.GetPoId(iPo)));
     }
+    int nWord = accPos.GetStride();
+    // the number of LACs rejected first by each bank pattern
+    LLVect bankKills(nBankPatt, 0);
 
     // prune large-error LACs
     // prepare
-    fmt::print("Compute maximum error lower bound for each of the {} LACs using {} simulation patterns\n", lacMan.GetLacNum(), nFramePrune);
+    fmt::print("Compute maximum error lower bound for each of the {} LACs using {} simulation patterns{} with {} threads\n", lacMan.GetLacNum(), nFramePrune, nWindow > 1? fmt::format(" x {} windows", nWindow): "", nThread);
     auto topoNodes = appNet.CalcTopoOrd(false);
-    vector<BitVect> bdPosWrtNode;
-    vector<BitVect> tempPos(nPo);
-    vector<BitVect> poDiffs(nPo);
-    BitVect nodePatt(nFramePrune, 0);
-    bool useEnum = (distrType == DISTR_TYPE::ENUM);
-    BigInt runMin(errUppBound);
-    // iterate over the nodes
-    boost::timer::progress_display pd(lacMan.GetLacNum());
-    // fmt::print("#lacs = {}\n", lacMan.GetLacNum());
-    // int count = 0;
-    for (int iNode = 0; iNode < static_cast<int>(topoNodes.size()); ++iNode) {
-        // skip the node if it is not associated with any LAC
-        if (!node2Lacs.count(topoNodes[iNode]->Id))
-            continue;
-        // flip the i-th node and simulate the circuit
-        appSmlt.CalcBoolDiff(topoNodes, iNode, bdPosWrtNode);
-        // iterate over the LACs associated with the i-th node
-        for (const auto& pLac: node2Lacs.at(topoNodes[iNode]->Id)) {
-            ++pd;
-            // ++count;
-            int pTargId = pLac->GetTargId();
-            if (pTargId != topoNodes[iNode]->Id) {
-                fmt::print(stderr, "Error: inconsistent node id, pTargId = {}, topoNodes[iNode]->Id = {}\n", pTargId, topoNodes[iNode]->Id);
-                assert(0);
-            }
-            // compute the simulation pattern of the target node of the LAC
-            appSmlt.SimSop(pLac->GetDivIds(), pLac->GetSop(), nodePatt);
-            // compute whether the node value change after applying the LAC
-            auto& nodeChange = nodePatt;
-            nodeChange ^= appSmlt.GetDat(pTargId);
-            // get the PO patterns after applying the LAC
-            for (int j = 0; j < nPo; ++j) {
-                auto poId = appSmlt.GetPoId(j);
-                tempPos[j] = appSmlt.GetDat(poId) ^ (nodeChange & bdPosWrtNode[j]); 
-            }
-            // get max error (obtained by simulation)
-            if (metrType == METR_TYPE::MAXED) {
-                BigInt maxErrSim(0), YNew(0);
-                if (!useEnum) {
-                    for (int iPatt = 0; iPatt < nFramePrune; ++iPatt) {
-                        GetValue(tempPos, iPatt, YNew);
-                        maxErrSim = std::max(maxErrSim, abs(YNew - YAcc[iPatt]));
-                        if (maxErrSim > errUppBound)
-                            break;
-                    }
-                }
-                else { // enumeration
-                    for (int iPatt = 0; iPatt < nFramePrune; ++iPatt) {
-                        GetValue(tempPos, iPatt, YNew);
-                        maxErrSim = std::max(maxErrSim, abs(YNew - YAcc[iPatt]));
-                        // we only need to identify the LAC with the smallest error 
-                        // so we can break if the error is already larger than the current minimum error
-                        if (maxErrSim > runMin)
-                            break;
-                    }
-                    runMin = std::min(runMin, maxErrSim);
-                }
-                pLac->SetErr(static_cast<double>(maxErrSim));
-            }
-            else if (metrType == METR_TYPE::MAXHD) {
-                ll maxErrSim = 0;
-                for (int iPo = 0; iPo < nPo; ++iPo)
-                    poDiffs[iPo] = tempPos[iPo] ^ accPos[iPo];
-                if (!useEnum) {
-                    // BigInt YNew(0);
-                    for (int iPatt = 0; iPatt < nFramePrune; ++iPatt) {
-                        // GetValue(tempPos, iPatt, YNew);
-                        ll hd = 0;
-                        for (int iPo = 0; iPo < nPo; ++iPo)
-                            hd += poDiffs[iPo][iPatt];
-                        maxErrSim = std::max(maxErrSim, hd);
-                        if (maxErrSim > errUppBound)
-                            break;
+    // the progress is shown for a single window; multiple windows print one line each
+    std::unique_ptr<boost::timer::progress_display> pPd;
+    if (nWindow == 1)
+        pPd = std::make_unique<boost::timer::progress_display>(lacMan.GetLacNum());
+    std::mutex pdMutex, killMutex;
+    for (ll iWindow = 0; iWindow < nWindow; ++iWindow) {
+        // the errors of the later windows are reduced into the running maxima; the LACs exceeding the bound are dropped early
+        auto isAlive = [&](const LAC& lac) {return iWindow == 0 || !DoubleGreat(lac.GetErr(), static_cast<double>(errUppBound));};
+        // group the target nodes by the roots of their fanout-free regions (FFRs);
+        // the Boolean difference is only simulated exactly for the roots, and composed with the observability inside the FFRs
+        std::unordered_map<int, int> nLacOfRoot;
+        for (const auto& [targId, lacs]: node2Lacs) {
+            int nAlive = 0;
+            for (int iLac: lacs)
+                nAlive += isAlive(lacMan.GetLac(iLac));
+            if (nAlive)
+                nLacOfRoot[appSmlt.GetFfrRoot(targId)] += nAlive;
+        }
+        if (nLacOfRoot.empty())
+            break;
+        if (useEnum) {
+            ll iFirstPatt = iWindow * nFramePrune;
+            pAccSmltWin->GenInpEnumWindow(iFirstPatt);
+            appSmlt.GenInpEnumWindow(iFirstPatt);
+            pAccSmltWin->UpdNodeAndPoPatts();
+            appSmlt.UpdNodeAndPoPatts();
+            for (int iPo = 0; iPo < nPo; ++iPo)
+                accPos[iPo].Assign(pAccSmltWin->GetDat(pAccSmltWin->GetPoId(iPo)));
+            if (nWindow > 1)
+                fmt::print("window {}/{}: {} alive LACs\n", iWindow + 1, nWindow, std::accumulate(nLacOfRoot.begin(), nLacOfRoot.end(), 0, [](int sum, const auto& item) {return sum + item.second;}));
+        }
+        // the jobs are the indices of the roots in topoNodes; in parallel, the heavy roots are taken first to balance the threads
+        IntVect jobs;
+        for (int iNode = 0; iNode < static_cast<int>(topoNodes.size()); ++iNode) {
+            if (nLacOfRoot.count(topoNodes[iNode]->Id))
+                jobs.emplace_back(iNode);
+        }
+        if (nThread > 1)
+            std::ranges::stable_sort(jobs, std::ranges::greater(), [&](int iNode) {return nLacOfRoot.at(topoNodes[iNode]->Id);});
+        appSmlt.PrepBoolDiff();
+        std::atomic<int> iNextJob(0);
+        // iterate over the roots
+        auto worker = [&](int) {
+            // per-thread scratch
+            BoolDiffScratch bdScratch;
+            AbcObjVect ffrNodes;
+            BitMat obsFfr2Root;
+            BitMat bdPosWrtNode;
+            BitMat tempPos(nPo, nFramePrune);
+            BitMat nodePatt(1, nFramePrune);
+            vector<ull> scratch;
+            LLVect kills(nBankPatt, 0);
+            auto creditKill = [&](int iPattExceed) {
+                if (!useEnum && iPattExceed >= 0 && iPattExceed < nBankPatt)
+                    ++kills[iPattExceed];
+            };
+            for (int iJob = iNextJob++; iJob < static_cast<int>(jobs.size()); iJob = iNextJob++) {
+                int iNode = jobs[iJob];
+                // flip the root and simulate the circuit
+                appSmlt.CalcBoolDiff(topoNodes, iNode, bdPosWrtNode, bdScratch);
+                // compute the observability of the nodes in the FFR at the root
+                appSmlt.CalcObsInFfr(topoNodes[iNode], ffrNodes, obsFfr2Root, bdScratch);
+                for (int iFfr = 0; iFfr < static_cast<int>(ffrNodes.size()); ++iFfr) {
+                    int targId = ffrNodes[iFfr]->Id;
+                    auto itLacs = node2Lacs.find(targId);
+                    if (itLacs == node2Lacs.end())
+                        continue;
+                    // iterate over the LACs associated with the node
+                    for (int iLac: itLacs->second) {
+                        auto& lac = lacMan.GetLac(iLac);
+                        if (!isAlive(lac))
+                            continue;
+                        int pTargId = lac.GetTargId();
+                        if (pTargId != targId) {
+                            fmt::print(stderr, "Error: inconsistent node id, pTargId = {}, targId = {}\n", pTargId, targId);
+                            assert(0);
+                        }
+                        // compute the simulation pattern of the target node of the LAC
+                        appSmlt.SimSop(lac.GetDivIds(), lac.GetSop(), nodePatt[0], bdScratch);
+                        // compute whether the root value change after applying the LAC
+                        auto nodeChange = nodePatt[0];
+                        nodeChange.AssignXor(nodeChange, appSmlt.GetDat(pTargId));
+                        nodeChange.AndWith(obsFfr2Root[iFfr], false);
+                        // get the PO patterns after applying the LAC
+                        for (int j = 0; j < nPo; ++j) {
+                            auto poId = appSmlt.GetPoId(j);
+                            tempPos[j].Assign(appSmlt.GetDat(poId));
+                            tempPos[j].XorAndWith(nodeChange, bdPosWrtNode[j]);
+                        }
+                        // get max error (obtained by simulation), stopping at the first pattern exceeding the error bound;
+                        // the bound is the same for all LACs, so the errors do not depend on the thread count or the LAC order
+                        ll bound = errUppBound;
+                        if (metrType == METR_TYPE::MAXED) {
+                            auto scanRes = ScanMaxAbsDiff(tempPos.GetWords(), accPos.GetWords(), nPo, nWord, bound, scratch);
+                            BigInt maxErrSim(scanRes.maxErr);
+                            if (scanRes.iWordExceed != -1) {
+                                // locate the first violating pattern in the block, to report the same error as a pattern-by-pattern scan
+                                BigInt YNew(0), YAcc(0);
+                                for (int iPatt = scanRes.iWordExceed * 64; iPatt < nFramePrune; ++iPatt) {
+                                    GetValue(tempPos, iPatt, YNew);
+                                    GetValue(accPos, iPatt, YAcc);
+                                    maxErrSim = std::max(maxErrSim, abs(YNew - YAcc));
+                                    if (maxErrSim > bound) {
+                                        creditKill(iPatt);
+                                        break;
+                                    }
+                                }
+                            }
+                            lac.SetErr(iWindow == 0? static_cast<double>(maxErrSim): std::max(lac.GetErr(), static_cast<double>(maxErrSim)));
+                        }
+                        else if (metrType == METR_TYPE::MAXHD) {
+                            auto scanRes = ScanMaxHammDist(tempPos.GetWords(), accPos.GetWords(), nPo, nWord, bound, scratch);
+                            ll maxErrSim = scanRes.maxErr;
+                            if (scanRes.iWordExceed != -1) {
+                                // locate the first violating pattern in the block, to report the same error as a pattern-by-pattern scan
+                                for (int iPatt = scanRes.iWordExceed * 64; iPatt < nFramePrune; ++iPatt) {
+                                    ll hd = 0;
+                                    for (int iPo = 0; iPo < nPo; ++iPo)
+                                        hd += (tempPos[iPo][iPatt] != accPos[iPo][iPatt]);
+                                    maxErrSim = std::max(maxErrSim, hd);
+                                    if (maxErrSim > bound) {
+                                        creditKill(iPatt);
+                                        break;
+                                    }
+                                }
+                            }
+                            lac.SetErr(iWindow == 0? static_cast<double>(maxErrSim): std::max(lac.GetErr(), static_cast<double>(maxErrSim)));
+                        }
+                        else {
+                            fmt::print(stderr, "Error: unsupported metric type\n");
+                            assert(0);
+                        }
                     }
                 }
-                else {
-                    for (int iPatt = 0; iPatt < nFramePrune; ++iPatt) {
-                        ll hd = 0;
-                        for (int iPo = 0; iPo < nPo; ++iPo)
-                            hd += poDiffs[iPo][iPatt];
-                        maxErrSim = std::max(maxErrSim, hd);
-                        if (maxErrSim > runMin)
-                            break;
-                    } 
-                    runMin = std::min(runMin, static_cast<BigInt>(maxErrSim));
-                }
-                pLac->SetErr(static_cast<double>(maxErrSim));
-            }
-            else {
-                fmt::print(stderr, "Error: unsupported metric type\n");
-                assert(0);
+                std::lock_guard<std::mutex> lock(pdMutex);
+                if (pPd != nullptr)
+                    *pPd += nLacOfRoot.at(topoNodes[iNode]->Id);
             }
-        }
+            std::lock_guard<std::mutex> lock(killMutex);
+            for (int i = 0; i < nBankPatt; ++i)
+                bankKills[i] += kills[i];
+        };
+        if (nThread > 1)
+            RunJobsInParallel(nThread, worker);
+        else
+            worker(0);
     }
+    if (nBankPatt)
+        pBank->AddScores(bankKills);
     // fmt::print("#LACs processed: {}\n", count);
     // assert(count == lacMan.GetLacNum());
     
@@ -794,8 +1543,8 @@ void BatchErrEst::CalcErrLooseUppBound(LACMan& lacMan, const NetMan& appNet) {
         }
         // update the upper bound of the LACs associated with the node
         if (lacMan.GetNode2Lacs().count(nodeId)) {
-            for (const auto& pLac: lacMan.GetNode2Lacs().at(nodeId))
-                pLac->SetErr2(uppBounds[nodeId]);
+            for (int iLac: lacMan.GetNode2Lacs().at(nodeId))
+                lacMan.GetLac(iLac).SetErr2(uppBounds[nodeId]);
         }
     }
     
@@ -805,6 +1554,36 @@ void BatchErrEst::CalcErrLooseUppBound(LACMan& lacMan, const NetMan& appNet) {
 }
 
 
+static std::mutex devNetCacheMutex; // guard of the deviation network cache and of the ABC frame used to generate the networks
+
+
+/**
+ * @brief Get the process-wide cache of the deviation networks, keyed by the file path, which encodes the metric, the output width and the error bound
+ * @brief The cache is never freed, since the ABC frame may be stopped before the static objects are destroyed
+ * 
+ * @return the cache
+ */
+static unordered_map<string, std::shared_ptr<NetMan>>& GetDevNetCache() {
+    static auto pCache = new unordered_map<string, std::shared_ptr<NetMan>>();
+    return *pCache;
+}
+
+
+/**
+ * @brief Look up the deviation network cache
+ * 
+ * @param path      the file path of the network, without suffix
+ * @return pNet     a copy of the cached network; nullptr if the network is not cached
+ */
+static std::shared_ptr<NetMan> LookUpDevNetCache(const string& path) {
+    auto& cache = GetDevNetCache();
+    auto it = cache.find(path);
+    if (it == cache.end())
+        return nullptr;
+    return std::make_shared<NetMan>(*it->second);
+}
+
+
 /**
  * @brief Generate a deviation network 
  * @brief to compute the deviation between the accurate and approximate networks
@@ -837,6 +1616,11 @@ std::shared_ptr<NetMan> GenDevNet(METR_TYPE metrType, int outWidth) {
         assert(0);
     }
     devNetPath = fmt::format("{}/{}_width{}", folder, err, outWidth);
+    // if the deviation network is generated by this process, copy it
+    std::lock_guard<std::mutex> lock(devNetCacheMutex);
+    auto pCachedNet = LookUpDevNetCache(devNetPath);
+    if (pCachedNet != nullptr)
+        return pCachedNet;
     // if the deviation network file exists, use it
     if (IsPathExist(devNetPath + "_opt.blif"))
         fmt::print("Use the existing circuit in {} to compute {}\n", devNetPath + "_opt.blif", err);
@@ -883,6 +1667,7 @@ std::shared_ptr<NetMan> GenDevNet(METR_TYPE metrType, int outWidth) {
     // load the deviation network
     auto pDevNet = std::make_shared<NetMan>(devNetPath + "_opt.blif");
     pDevNet->Comm("ps");
+    GetDevNetCache().emplace(devNetPath, std::make_shared<NetMan>(*pDevNet));
     return pDevNet;
 }
 
@@ -919,6 +1704,11 @@ std::shared_ptr<NetMan> GenDevCompNet(METR_TYPE metrType, int outWidth) {
         assert(0);
     }
     devCompNetPath = fmt::format("{}/comp_{}_width{}", folder, err, outWidth);
+    // if the deviation network is generated by this process, copy it
+    std::lock_guard<std::mutex> lock(devNetCacheMutex);
+    auto pCachedNet = LookUpDevNetCache(devCompNetPath);
+    if (pCachedNet != nullptr)
+        return pCachedNet;
     // if the deviation network file exists, use it
     if (IsPathExist(devCompNetPath + "_opt.blif"))
         fmt::print("Use the existing circuit in {} to compute {} and compare the error with the reference error\n", devCompNetPath + "_opt.blif", err);
@@ -968,12 +1758,14 @@ std::shared_ptr<NetMan> GenDevCompNet(METR_TYPE metrType, int outWidth) {
     // load the deviation network
     auto pDevCompNet = std::make_shared<NetMan>(devCompNetPath + "_opt.blif");
     pDevCompNet->Comm("ps");
+    GetDevNetCache().emplace(devCompNetPath, std::make_shared<NetMan>(*pDevCompNet));
     return pDevCompNet;
 }
 
 
 /**
  * @brief Generate a deviation network to check whether the maximum error is within the upper bound
+ * @brief The optimized network is cached in memory and in "./tmp", so the same (metric, width, bound) is optimized only once
  * 
  * @param pDevNet                the deviation network to measure the maximum error
  * @param outWidth               output width of the accurate and approximate networks
@@ -981,19 +1773,40 @@ std::shared_ptr<NetMan> GenDevCompNet(METR_TYPE metrType, int outWidth) {
  * @return pRetNet               the deviation network to check whether the maximum error is within the upper bound
  */
 std::shared_ptr<NetMan> GenDevCompNetEmbedErrBound(std::shared_ptr<NetMan> pDevNet, int outWidth, ll errUppBound) {
-    // copy the deviation network
-    auto pRetNet = std::make_shared<NetMan>(*pDevNet);
-    pRetNet->RenameNet(pDevNet->GetNetName() + "_embed_err_bound");
     // check the "ref_err" PIs
     int refErrWidth = -1;
-    if (pDevNet->GetNetName() == "error_distance_devcomp")
+    string err;
+    if (pDevNet->GetNetName() == "error_distance_devcomp") {
+        err = "error_distance";
         refErrWidth = outWidth;
-    else if (pDevNet->GetNetName() == "hamming_distance_devcomp")
+    }
+    else if (pDevNet->GetNetName() == "hamming_distance_devcomp") {
+        err = "hamming_distance";
         refErrWidth = static_cast<int>(log2(outWidth)) + 1;
+    }
     else {
         fmt::print(stderr, "Error: unknown error metric\n");
         assert(0);
     }
+    // if the network is generated by this process or in "./tmp", reuse it
+    string folder = "./tmp";
+    CreateDir(folder);
+    string retNetPath = fmt::format("{}/comp_{}_width{}_bound{}", folder, err, outWidth, errUppBound);
+    std::lock_guard<std::mutex> lock(devNetCacheMutex);
+    auto pCachedNet = LookUpDevNetCache(retNetPath);
+    if (pCachedNet != nullptr)
+        return pCachedNet;
+    if (IsPathExist(retNetPath + "_opt.blif")) {
+        fmt::print("Use the existing circuit in {} to check the error upper bound {}\n", retNetPath + "_opt.blif", errUppBound);
+        auto pRetNet = std::make_shared<NetMan>(retNetPath + "_opt.blif");
+        pRetNet->RenameNet(pDevNet->GetNetName() + "_embed_err_bound");
+        assert(pRetNet->GetNetType() == NET_TYPE::SOP && pRetNet->GetPiNum() == outWidth * 2);
+        GetDevNetCache().emplace(retNetPath, std::make_shared<NetMan>(*pRetNet));
+        return pRetNet;
+    }
+    // copy the deviation network
+    auto pRetNet = std::make_shared<NetMan>(*pDevNet);
+    pRetNet->RenameNet(pDevNet->GetNetName() + "_embed_err_bound");
     AbcObjVect pRefErrs;
     pRefErrs.reserve(refErrWidth);
     assert(pRetNet->GetPiNum() == outWidth * 2 + refErrWidth); // 0~outWidth-1: accOut; outWidth~2*outWidth-1: appOut; 2*outWidth~refErrWidth-1: ref_err
@@ -1023,6 +1836,42 @@ std::shared_ptr<NetMan> GenDevCompNetEmbedErrBound(std::shared_ptr<NetMan> pDevN
     fmt::print("Optimizing the deviation network with embedded error upper bound {}\n", errUppBound);
     pRetNet->Comm("st; resyn2rs; resyn2rs; resyn2rs; logic; sop; ps;");
     fmt::print("{}\n", DASH_LINE);
+    // write to a temporary file first, so that concurrent jobs never read a partial file
+    string tmpPath = fmt::format("{}_opt.blif.{}", retNetPath, getpid());
+    pRetNet->WriteBlif(tmpPath);
+    std::filesystem::rename(tmpPath, retNetPath + "_opt.blif");
+    GetDevNetCache().emplace(retNetPath, std::make_shared<NetMan>(*pRetNet));
     return pRetNet;
 }
 
+
+
+/**
+ * @brief Check whether appNet exceeds the error bound on the given input patterns using logic simulation
+ * 
+ * @param appNet       the approximate network
+ * @param devNet       the deviation network with embedded error bound
+ * @param piPatts      piPatts[i][j] is the i-th PI's j-th pattern
+ * @param accPoPatts   accPoPatts[i][j] is the accurate network's i-th PO under the j-th pattern
+ * @return bool        true if the error bound is exceeded on some pattern
+ */
+bool ExceedOnPatts(const NetMan& appNet, const NetMan& devNet, const std::vector<BitVect>& piPatts, const std::vector<BitVect>& accPoPatts) {
+    assert(!piPatts.empty());
+    int nPatt = static_cast<int>(piPatts[0].size()), nPo = appNet.GetPoNum();
+    if (nPatt == 0)
+        return false;
+    assert(static_cast<int>(accPoPatts.size()) == nPo);
+    // approximate outputs
+    Simulator appSmlt(appNet, 0, nPatt);
+    appSmlt.GenInpFromBitVects(piPatts);
+    appSmlt.UpdNodeAndPoPatts();
+    // deviation
+    std::vector<BitVect> devPiPatts(accPoPatts);
+    devPiPatts.reserve(nPo * 2);
+    for (int i = 0; i < nPo; ++i)
+        devPiPatts.emplace_back(appSmlt.GetDat(appSmlt.GetPoId(i)).ToBitVect());
+    Simulator devSmlt(devNet, 0, nPatt);
+    devSmlt.GenInpFromBitVects(devPiPatts);
+    devSmlt.UpdNodeAndPoPatts();
+    return devSmlt.GetDat(devSmlt.GetPoId(0)).Any();
+}
@@ -13,6 +13,9 @@
 #include "simulator.h"
 #include "lac.h"
 #include "sat_wrapper.hpp"
+#include "cnf.h"
+#include "bit_slice.h"
+#include "pattern_bank.h"
 
 
 /**
@@ -52,6 +55,17 @@ static inline METR_TYPE Str2MetrType(const std::string& str) {
 }
 
 
+/**
+ * @brief Object ID maps from the networks to their error miter
+ * @brief acc2Mit[id], app2Mit[id], and dev2Mit[id] are the miter object IDs of the object id in the accurate, approximate, and deviation networks; -1 if the object is not copied
+ */
+struct ErrMitMap {
+    IntVect acc2Mit;   // accurate network object ID -> miter object ID
+    IntVect app2Mit;   // approximate network object ID -> miter object ID
+    IntVect dev2Mit;   // deviation network object ID -> miter object ID
+};
+
+
 /**
  * @brief Error measurement manager
  */
@@ -61,13 +75,13 @@ private:
     const NetMan& net1;                        // approximate network
     std::shared_ptr<Simulator> pSmlt0;         // simulator for accurate network
     std::shared_ptr<Simulator> pSmlt1;         // simulator for approximate network
-    std::shared_ptr<NetMan> pErrMit;           // error miter
+    int nMitPi;                                // number of PIs of the error miter
     std::shared_ptr<CMSat::SATSolver> pSolver; // SAT solver
     IntVect cnfVarIdOfIthPi;                   // CNF variable ID of the i-th PI of the error miter
 
 public:
     ErrMan(const NetMan& netMan0, const NetMan& netMan1);
-    ErrMan(const NetMan& netMan0, const NetMan& netMan1, const NetMan& devNet);
+    ErrMan(const NetMan& netMan0, const NetMan& netMan1, const NetMan& devNet, int nSatThread = 1);
     ~ErrMan() = default;
     ErrMan(const ErrMan&) = delete;
     ErrMan(ErrMan&&) = delete;
@@ -75,25 +89,140 @@ public:
     ErrMan& operator = (ErrMan&&) = delete;
 
     void LogicSim(unsigned seed, int nFrame, DISTR_TYPE distrType);
-    BigInt ComputeMaxErr(METR_TYPE metrType);
-    std::shared_ptr<NetMan> BuildErrMit(const NetMan& accNet, const NetMan& appNet, const NetMan& devNet);
+    ll GetMaxErrDistUsingEnum(ll uppBound = -1) const;
+    BigInt ComputeMaxErr(METR_TYPE metrType, const BigInt& lowBound = 0, const BigInt& uppBound = -1);
+    BigInt ComputeMaxErrWithAssumpts(METR_TYPE metrType, const LitVect& ctrlAssumpts, const BigInt& lowBound = 0, const BigInt& uppBound = -1);
+    std::shared_ptr<NetMan> BuildErrMit(const NetMan& accNet, const NetMan& appNet, const NetMan& devNet, ErrMitMap* pMap = nullptr);
     std::shared_ptr<CMSat::SATSolver> BuildSatSolver_Naive(NetMan& net);
-    std::shared_ptr<CMSat::SATSolver> BuildSatSolver_Abc(NetMan& net, IntVect& cnfVarIdOfIthPi);
-    BigInt SolveSatsForMaxErrBinSearch(NetMan& net, CMSat::SATSolver& solver, int refEdWidth);
+    std::shared_ptr<CMSat::SATSolver> BuildSatSolver_Gia(const NetMan& net, IntVect& cnfVarIdOfIthPi);
+    BigInt SolveSatsForMaxErrBinSearch(int netPiNum, CMSat::SATSolver& solver, int refEdWidth);
+    BigInt SolveSatsForMaxErrGuided(int netPiNum, CMSat::SATSolver& solver, int refEdWidth, METR_TYPE metrType, const BigInt& lowBound = 0, const BigInt& uppBound = -1, const LitVect& ctrlAssumpts = LitVect());
     void AddUnitClauseOfPi(int iPi, bool fVarCompl);
 
+    inline void SetSatBudget(const SatSched& sched, ll confl) {assert(pSolver != nullptr); sched.Config(*pSolver, confl);}
     inline CMSat::lbool SolveSat(bool printTime = false) {assert(pSolver != nullptr); return SolveSat_(*pSolver, printTime);}
     inline CMSat::lbool SolveSat(IntVect& counterExample, bool printTime = false) {assert(pSolver != nullptr); return SolveSatAndGetCountEx(*pSolver, std::vector<CMSat::Lit>{}, cnfVarIdOfIthPi, counterExample, printTime);}
     inline CMSat::lbool SolveSat(const std::vector<CMSat::Lit>& assumpts, IntVect& counterExample, bool printTime = false) {assert(pSolver != nullptr); return SolveSatAndGetCountEx(*pSolver, assumpts, cnfVarIdOfIthPi, counterExample, printTime);}
-    inline const NetMan& GetErrMit() const {assert(pErrMit != nullptr); return *pErrMit;}
+    inline int GetMitPiNum() const {assert(pSolver != nullptr); return nMitPi;}
     inline double GetErrRate(unsigned seed, int nFrame, DISTR_TYPE distrType) {LogicSim(seed, nFrame, distrType); return pSmlt0->GetErrRate(*pSmlt1);}
     inline double GetMeanErrDist(unsigned seed, int nFrame, bool isSign, DISTR_TYPE distrType) {LogicSim(seed, nFrame, distrType); return pSmlt0->GetMeanErrDist(*pSmlt1, isSign);}
-    inline ll GetMaxErrDistUsingEnum() {assert(net0.GetPiNum() < 20); LogicSim(0, 1ll << net0.GetPiNum(), DISTR_TYPE::ENUM); return pSmlt0->GetMaxErrDistFast(*pSmlt1);}
     inline void GetMaxErrDistLowBound(unsigned seed, int nFrame, BigInt& maxErrLowBound) {LogicSim(seed, nFrame, DISTR_TYPE::UNIF); pSmlt0->GetMaxErrDist(*pSmlt1, false, maxErrLowBound);}
     inline int GetCnfVarIdOfIthPi(int iPi) const {assert(iPi >= 0 && iPi < static_cast<int>(cnfVarIdOfIthPi.size())); return cnfVarIdOfIthPi[iPi];}
 };
 
 
+/**
+ * @brief Truncation engine for the POs of the approximate network
+ * @brief The miter is encoded once, with a MUX "en ? val : driver" on each PO driver, where en and val are new control PIs;
+ * @brief each truncation trial only changes the assumptions on the control PIs, so the learned clauses are carried from bit to bit
+ */
+class TruncErrMan {
+private:
+    METR_TYPE metrType;                 // error metric type
+    NetMan ctrlNet;                     // copy of the approximate network with a controlled MUX on each PO driver
+    std::shared_ptr<ErrMan> pErrMan;    // error manager holding the miter and the incremental SAT solver
+    IntVect enPis;                      // enPis[i], miter PI index of the signal "the i-th PO is truncated"
+    IntVect valPis;                     // valPis[i], miter PI index of the constant of the i-th PO
+    IntVect commVals;                   // commVals[i], committed constant of the i-th PO; -1 if the PO is kept
+
+public:
+    explicit TruncErrMan(const NetMan& acc_net, const NetMan& app_net, METR_TYPE metr_type);
+    ~TruncErrMan() = default;
+    TruncErrMan(const TruncErrMan&) = delete;
+    TruncErrMan(TruncErrMan&&) = delete;
+    TruncErrMan& operator = (const TruncErrMan&) = delete;
+    TruncErrMan& operator = (TruncErrMan&&) = delete;
+
+    BigInt TryTrunc(int iPo, bool val, const BigInt& lowBound = 0, const BigInt& uppBound = -1);
+    void CommitTrunc(int iPo, bool val);
+
+    inline int GetCommVal(int iPo) const {return commVals[iPo];}
+};
+
+
+/**
+ * @brief Incremental error checker for LAC candidates
+ * @brief The accurate, approximate and deviation networks are encoded once into a persistent SAT solver;
+ * @brief each candidate only re-encodes the TFO of its substitution node, and its "error > bound" assertion is guarded by an activation literal
+ */
+class IncErrMan {
+private:
+    const ll MAX_CONFL = 1ll << 18;                // conflict budget of each candidate check
+    const NetMan& accNet;                          // accurate network
+    const NetMan& appNet;                          // approximate network, candidates are temporarily applied on it
+    const NetMan& devNet;                          // deviation network with embedded error bound (PI: accNet PO, appNet PO; single PO = error > bound)
+    std::shared_ptr<CMSat::SATSolver> pSolver;     // persistent SAT solver
+    std::shared_ptr<SopCnfEnc> pEnc;               // CNF encoder attached to pSolver
+    IntVect devTopoIds;                            // nodes of devNet in topological order
+    IntVect cnfVarIdOfIthPi;                       // CNF variable ID of the i-th PI
+    LitVect accLits;                               // accLits[id], literal of the object id in accNet
+    LitVect appLits;                               // appLits[id], literal of the object id in appNet under the committed LACs
+    LitVect devLits;                               // devLits[id], literal of the object id in devNet under the committed LACs
+    std::unordered_map<int, CMSat::Lit> candAppLits; // literals of the re-encoded appNet nodes of the pending candidate
+    LitVect candDevLits;                           // literals of devNet objects of the pending candidate
+    CMSat::Lit candAct;                            // activation literal of the pending candidate
+    std::vector<BitVect> counterExPiPatts;         // counterExPiPatts[i][j] is the i-th PI's j-th counter-example pattern
+    std::vector<BitVect> counterExAccPos;          // counterExAccPos[i][j] is the accNet's i-th PO under the j-th counter example
+    bool fAccPosValid;                             // whether counterExAccPos is up to date
+
+public:
+    explicit IncErrMan(const NetMan& acc_net, const NetMan& app_net, const NetMan& dev_net, int nSatThread = 1);
+    explicit IncErrMan(const NetMan& acc_net, const NetMan& app_net, const NetMan& dev_net, const IntVect& accTopoIds, const IntVect& dev_topo_ids, int nSatThread = 1);
+    ~IncErrMan() = default;
+    IncErrMan(const IncErrMan&) = delete;
+    IncErrMan(IncErrMan&&) = delete;
+    IncErrMan& operator = (const IncErrMan&) = delete;
+    IncErrMan& operator = (IncErrMan&&) = delete;
+
+    void EncCand(int ssId);
+    void EncCands(const IntVect& ssIds);
+    CMSat::lbool CheckCand(int ssId, IntVect& counterEx, bool printTime = false, const SatSched* pSched = nullptr, ll confl = 0);
+    CMSat::lbool CheckCands(const IntVect& ssIds, IntVect& counterEx, bool printTime = false, const SatSched* pSched = nullptr, ll confl = 0);
+    void CommitCand();
+    void RejectCand();
+    void AddCounterEx(const IntVect& counterEx);
+    bool ExceedOnCounterExs();
+
+    inline int GetCounterExNum() const {return counterExPiPatts.empty()? 0: static_cast<int>(counterExPiPatts[0].size());}
+    inline CMSat::Lit GetAppLit(int id) {auto it = candAppLits.find(id); if (it != candAppLits.end()) return it->second; return pEnc->EncObj(appNet, id, appLits);}
+};
+
+
+/**
+ * @brief Fast checker of the error bound on the recorded counter examples
+ * @brief The accurate, approximate and deviation networks stay simulated under the counter examples;
+ * @brief a candidate only resimulates the TFO of its substitution node, and is rolled back with the undo logs
+ */
+class CexErrChecker {
+private:
+    Simulator accSmlt;          // accurate network under the counter examples
+    Simulator appSmlt;          // approximate network under the counter examples, sharing the network being modified
+    Simulator devSmlt;          // deviation network (PI: accNet PO, appNet PO; single PO = error > bound) under the counter examples
+    IntVect seedIds;            // scratch seeds of the incremental simulation
+    IntVect devPiVals;          // scratch PI values of the deviation network
+
+    void AddCandSeeds(int ssId, const IntVect& replTrace);
+    void UpdSeeds();
+    bool ExceedOnSeeds();
+
+public:
+    explicit CexErrChecker(const NetMan& acc_net, const NetMan& app_net, const NetMan& dev_net);
+    ~CexErrChecker() = default;
+    CexErrChecker(const CexErrChecker&) = delete;
+    CexErrChecker(CexErrChecker&&) = delete;
+    CexErrChecker& operator = (const CexErrChecker&) = delete;
+    CexErrChecker& operator = (CexErrChecker&&) = delete;
+
+    void AddCounterEx(const IntVect& counterEx);
+    bool ExceedWithCand(int ssId, const IntVect& replTrace);
+    bool ExceedWithCands(const IntVect& ssIds, const Int2DVect& replTraces);
+    void CommitCand(int ssId, const IntVect& replTrace);
+    void CommitCands(const IntVect& ssIds, const Int2DVect& replTraces);
+
+    inline int GetCounterExNum() const {return accSmlt.GetFrameNumb();}
+};
+
+
 /**
  * @brief Batch error estimator for multiple LACs
  */
@@ -103,9 +232,10 @@ private:
     METR_TYPE metrType;               // error metric type
     unsigned seed;                    // random seed
     int nFrame;                       // number of simulation frames
+    int nThread;                      // number of threads for pruning LACs with simulation
 
 public:
-    explicit BatchErrEst(METR_TYPE metr_type, unsigned _seed, int n_frame): metrType(metr_type), seed(_seed), nFrame(n_frame) {}
+    explicit BatchErrEst(METR_TYPE metr_type, unsigned _seed, int n_frame, int n_thread = 1): metrType(metr_type), seed(_seed), nFrame(n_frame), nThread(n_thread) {assert(nThread >= 1);}
     ~BatchErrEst() = default;
     BatchErrEst(const BatchErrEst &) = delete;
     BatchErrEst(BatchErrEst &&) = delete;
@@ -114,8 +244,9 @@ public:
 
     // std::shared_ptr<LAC> PickFirstValidLac(LACMan& lacMan, Simulator& accSmlt, NetMan& appNet, const NetMan& devNet, std::unordered_set<std::string>& lacBlackList);
     void CompLacErrsByEnumAndPruneBadLacs(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound);
-    void CompLacErrsBySimAndPruneBadLacs(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound);
-    void PruneLacsWithSim(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound, int nFramePrune, DISTR_TYPE distrType = DISTR_TYPE::UNIF);
+    void CompLacErrsBySimAndPruneBadLacs(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound, PatternBank* pBank = nullptr);
+    void CompLacErrsBySimAndKeepTopKLacs(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound, int topK, PatternBank* pBank = nullptr);
+    void PruneLacsWithSim(LACMan& lacMan, Simulator& accSmlt, const NetMan& appNet, ll errUppBound, int nFramePrune, DISTR_TYPE distrType = DISTR_TYPE::UNIF, PatternBank* pBank = nullptr, bool fPrefix = false);
     void CalcErrLooseUppBound(LACMan& lacMan, const NetMan& appNet);
 };
 
@@ -124,3 +255,7 @@ public:
 std::shared_ptr<NetMan> GenDevNet(METR_TYPE metrType, int outWidth);
 std::shared_ptr<NetMan> GenDevCompNet(METR_TYPE metrType, int outWidth);
 std::shared_ptr<NetMan> GenDevCompNetEmbedErrBound(std::shared_ptr<NetMan> pDevNet, int outWidth, ll errUppBound);
+
+
+// miscellaneous functions
+bool ExceedOnPatts(const NetMan& appNet, const NetMan& devNet, const std::vector<BitVect>& piPatts, const std::vector<BitVect>& accPoPatts);
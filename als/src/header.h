@@ -10,6 +10,9 @@
 
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
 #include <boost/multiprecision/cpp_dec_float.hpp>
@@ -26,17 +29,20 @@
 #include <list>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <omp.h>
 #include <queue>
 #include <random>
 #include <regex>
 #include <set>
+#include <span>
 #include <sstream>
 #include <stdint.h>
 #include <thread>
 #include <tuple>
 #include <unordered_set>
 #include <unordered_map>
+#include <unistd.h>
 
 
 using ll = int64_t;
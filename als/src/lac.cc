@@ -4,6 +4,7 @@
  * @brief Local approximate change (LAC) management
  * 
  */
+#include <boost/functional/hash.hpp>
 #include "lac.h"
 
 
@@ -15,26 +16,116 @@ using namespace abc;
  * @brief Generate constant LACs: Shin, Doochul, and Sandeep K. Gupta. "Approximate logic synthesis for error tolerant applications." 2010 Design, Automation & Test in Europe Conference & Exhibition (DATE 2010). IEEE, 2010.
  * 
  * @param net     the network
- * @retval pLacs  generated LACs
+ * @param pTargs  if not nullptr, only generate the LACs of these target nodes
+ * @retval lacs   generated LACs
  * @return void
  */
-void LACMan::GenConstLACs(const NetMan& net) {
-    if (net.GetNetType() != NET_TYPE::SOP) {
-        fmt::print(stderr, "Error: only support generating LACs on SOP network.\n");
+void LACMan::GenConstLACs(const NetMan& net, const IntSet* pTargs) {
+    if (net.GetNetType() != NET_TYPE::SOP && !net.IsStrash()) {
+        fmt::print(stderr, "Error: only support generating LACs on SOP or strashed network.\n");
         assert(0);
     }
-    pLacs.clear();
-    pLacs.reserve(net.GetNodeNum() << 1);
+    lacs.clear();
+    node2Lacs.clear();
+    lacs.reserve(net.GetNodeNum() << 1);
     for (int nodeId = 0; nodeId < net.GetIdMaxPlus1(); ++nodeId) {
+        if (pTargs != nullptr && !pTargs->count(nodeId))
+            continue;
         if (net.IsNode(nodeId) && !net.IsConst(nodeId)) {
             int sizeGain = net.GetSizeGain(nodeId, IntVect{});
-            pLacs.emplace_back(make_shared<LAC>(nodeId, sizeGain, IntVect{}, string(" 1\n")));
-            pLacs.emplace_back(make_shared<LAC>(nodeId, sizeGain, IntVect{}, string(" 0\n")));
+            lacs.emplace_back(nodeId, sizeGain, std::span<const int>(), LAC_SOP_CONST1);
+            lacs.emplace_back(nodeId, sizeGain, std::span<const int>(), LAC_SOP_CONST0);
         }
     }
 
     // print
-    fmt::print("generated {} constant LACs\n", pLacs.size());
+    fmt::print("generated {} constant LACs\n", lacs.size());
+}
+
+
+/**
+ * @brief Build the signature index on the PIs and the nodes of the simulated network
+ * 
+ * @param smlt   the simulator, already simulated
+ */
+SigIndex::SigIndex(const Simulator& smlt): keys(smlt.GetIdMaxPlus1(), 0), partSigs(smlt.GetIdMaxPlus1(), 0), partMask(GetTailMask(min(smlt.GetFrameNumb(), 64))) {
+    const ull MUL = 0x9e3779b97f4a7c15ull;
+    for (int id = 0; id < smlt.GetIdMaxPlus1(); ++id) {
+        if (!smlt.IsObj(id) || !(smlt.IsObjPi(id) || smlt.IsNode(id)))
+            continue;
+        auto row = smlt.GetDat(id);
+        int nWord = row.GetWordNum();
+        if (nWord == 0)
+            continue;
+        auto pWords = row.GetWords();
+        ull phase = (pWords[0] & 1)? ~0ull: 0ull;
+        ull key = 0;
+        for (int i = 0; i < nWord; ++i) {
+            ull word = pWords[i] ^ phase;
+            if (i == nWord - 1)
+                word &= GetTailMask(row.Size());
+            key = (key ^ word) * MUL;
+            key ^= key >> 29;
+        }
+        keys[id] = key;
+        partSigs[id] = pWords[0] & partMask;
+        classes[key].emplace_back(id);
+    }
+}
+
+
+/**
+ * @brief Get the equivalence class of an object, i.e., the objects whose signatures may equal its signature or its complement
+ * 
+ * @param id           the object ID
+ * @return IntVect&    the objects sharing the key with the object, in the increasing order of IDs; empty if the object is not indexed
+ */
+const IntVect& SigIndex::GetClass(int id) const {
+    static const IntVect EMPTY;
+    auto it = classes.find(keys[id]);
+    if (it == classes.end())
+        return EMPTY;
+    return it->second;
+}
+
+
+/**
+ * @brief Generate the LACs of the target nodes in parallel
+ * @brief The targets are split into blocks, which the threads take in turn; each block has its own buffer, and the buffers are merged in the order of the blocks
+ * @brief Hence the generated LACs are the same as the serial generation, regardless of the number of threads
+ * 
+ * @param targIds       the target node IDs
+ * @param nThread       number of threads
+ * @param genLacs4Targ  genLacs4Targ(targId, buf, nDeref) appends the LACs of targId to buf; nDeref is the scratch of GetSizeGainReadOnly of the thread
+ * @param lacs          the LAC pool
+ * @retval lacs         appended with the generated LACs
+ * @return void
+ */
+template <typename Func>
+static void GenLacs4TargsInParallel(const IntVect& targIds, int nThread, Func&& genLacs4Targ, LACVect& lacs) {
+    const int BLOCK_SIZE = 64;
+    int nBlock = (static_cast<int>(targIds.size()) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    vector<LACVect> bufs(nBlock);
+    atomic<int> nextBlock(0);
+    auto worker = [&](int) {
+        unordered_map<int, int> nDeref;
+        for (int iBlock = nextBlock++; iBlock < nBlock; iBlock = nextBlock++) {
+            int end = min(static_cast<int>(targIds.size()), (iBlock + 1) * BLOCK_SIZE);
+            for (int i = iBlock * BLOCK_SIZE; i < end; ++i)
+                genLacs4Targ(targIds[i], bufs[iBlock], nDeref);
+        }
+    };
+    nThread = max(1, min(nThread, nBlock));
+    if (nThread == 1)
+        worker(0);
+    else
+        RunJobsInParallel(nThread, worker);
+    size_t nLac = lacs.size();
+    for (const auto& buf: bufs)
+        nLac += buf.size();
+    lacs.reserve(nLac);
+    for (const auto& buf: bufs)
+        lacs.insert(lacs.end(), buf.begin(), buf.end());
 }
 
 
@@ -42,24 +133,29 @@ void LACMan::GenConstLACs(const NetMan& net) {
  * @brief Generate SASIMI LACs: Venkataramani, Swagath, Kaushik Roy, and Anand Raghunathan. "Substitute-and-simplify: A unified design paradigm for approximate and quality configurable circuits." 2013 Design, Automation & Test in Europe Conference & Exhibition (DATE). IEEE, 2013.
  * 
  * @param net     the network
- * @retval pLacs  generated LACs
+ * @param pTargs  if not nullptr, only generate the LACs of these target nodes; the budget per node is still computed on all nodes
+ * @param nThread number of threads; the generated LACs do not depend on it
+ * @retval lacs   generated LACs
  * @return void
  */
-void LACMan::GenSasimiLACs(const NetMan& net, int maxCandResub, bool inclConst) {
+void LACMan::GenSasimiLACs(const NetMan& net, int maxCandResub, bool inclConst, const IntSet* pTargs, int nThread) {
     // prepare
-    if (net.GetNetType() != NET_TYPE::SOP) {
-        fmt::print(stderr, "Error: only support generating LACs on SOP network.\n");
+    if (net.GetNetType() != NET_TYPE::SOP && !net.IsStrash()) {
+        fmt::print(stderr, "Error: only support generating LACs on SOP or strashed network.\n");
         assert(0);
     }
-    pLacs.clear();
+    lacs.clear();
+    node2Lacs.clear();
 
     // special case: constant replacement
     if (inclConst) {
     for (int nodeId = 0; nodeId < net.GetIdMaxPlus1(); ++nodeId) {
+        if (pTargs != nullptr && !pTargs->count(nodeId))
+            continue;
         if (net.IsNode(nodeId) && !net.IsConst(nodeId)) {
             int sizeGain = net.GetSizeGain(nodeId, IntVect{});
-            pLacs.emplace_back(make_shared<LAC>(nodeId, sizeGain, IntVect{}, string(" 1\n")));
-            pLacs.emplace_back(make_shared<LAC>(nodeId, sizeGain, IntVect{}, string(" 0\n")));
+            lacs.emplace_back(nodeId, sizeGain, std::span<const int>(), LAC_SOP_CONST1);
+            lacs.emplace_back(nodeId, sizeGain, std::span<const int>(), LAC_SOP_CONST0);
         }
     }
     }
@@ -77,24 +173,29 @@ void LACMan::GenSasimiLACs(const NetMan& net, int maxCandResub, bool inclConst)
     }
     net.GetLev();
     const int MAX_LAC_PER_NODE = std::max(1, static_cast<int>(maxCandResub / targIds.size()));
-    for (int targId: targIds) {
+    if (pTargs != nullptr)
+        targIds.erase(std::remove_if(targIds.begin(), targIds.end(), [pTargs](int targId) {return !pTargs->count(targId);}), targIds.end());
+    auto genLacs4Targ = [&](int targId, LACVect& buf, unordered_map<int, int>& nDeref) {
         int lacNum = 0;
+        IntVect divIds{-1};
         for (int subId = 0; subId < net.GetIdMaxPlus1(); ++subId) {
             if (!net.IsObj(subId) || net.IsObjPo(subId) || net.IsConst(subId) || targId == subId)
                 continue;
             if (net.GetObjLev(subId) < net.GetObjLev(targId)) {
-                int sizeGain = net.GetSizeGain(targId, IntVect{subId});
-                pLacs.emplace_back(make_shared<LAC>(targId, sizeGain, IntVect{subId}, string("1 1\n")));
-                pLacs.emplace_back(make_shared<LAC>(targId, sizeGain, IntVect{subId}, string("0 1\n")));
+                divIds[0] = subId;
+                int sizeGain = net.GetSizeGainReadOnly(targId, divIds, nDeref);
+                buf.emplace_back(targId, sizeGain, std::span<const int>(&subId, 1), LAC_SOP_BUF);
+                buf.emplace_back(targId, sizeGain, std::span<const int>(&subId, 1), LAC_SOP_INV);
                 lacNum += 2;
                 if (lacNum >= MAX_LAC_PER_NODE)
                     break;
             }
         }
-    }
+    };
+    GenLacs4TargsInParallel(targIds, nThread, genLacs4Targ, lacs);
 
     // print
-    fmt::print("generated {} SASIMI LACs\n", pLacs.size());
+    fmt::print("generated {} SASIMI LACs\n", lacs.size());
 }
 
 
@@ -105,24 +206,27 @@ void LACMan::GenSasimiLACs(const NetMan& net, int maxCandResub, bool inclConst)
  * @param seed             random seed
  * @param nFrame4ResubGen  number of simulation frames for approximate resubstitution generation
  * @param maxLevelDiff     maximum level difference when generating approximate resubstitutions
- * @param maxCandResub     maximum number of candidate approximate resubstitutions
- * @retval pLacs           generated LACs
+ * @param maxCandResub     maximum number of candidate approximate resubstitutions, evenly split into a budget per node
+ * @param pTargs           if not nullptr, only generate the LACs of these target nodes; the network is still simulated, and the budget per node is still computed, on all nodes
+ * @param nThread          number of threads; the generated LACs do not depend on it
+ * @retval lacs            generated LACs
  * @return void
  */
-void LACMan::GenResubLACs(const NetMan& net, unsigned seed, int nFrame4ResubGen, int maxLevelDiff, int maxCandResub, bool inclConst) {
+void LACMan::GenResubLACs(const NetMan& net, unsigned seed, int nFrame4ResubGen, int maxLevelDiff, int maxCandResub, bool inclConst, const IntSet* pTargs, int nThread) {
     fmt::print("generating resubstitution-based LACs\n");
     // initialize
     int simulationFrame = nFrame4ResubGen;
     int halfFrame = simulationFrame >> 1;
-    int LAC_NUM_LIMIT = maxCandResub;
     assert(net.GetNetType() == NET_TYPE::SOP);
-    pLacs.clear();
+    lacs.clear();
+    node2Lacs.clear();
     net.GetLev();
     Abc_NtkStartReverseLevels(net.GetNet(), 0);
 
-    // simulate
+    // simulate, and index the signatures
     Simulator smlt(net, seed, simulationFrame, DISTR_TYPE::UNIF);
-    smlt.LogicSim();
+    smlt.LogicSim(nThread);
+    SigIndex sigIndex(smlt);
 
     // collect target nodes
     IntVect targIds;
@@ -131,8 +235,11 @@ void LACMan::GenResubLACs(const NetMan& net, unsigned seed, int nFrame4ResubGen,
         if (net.IsNode(nodeId) && !net.IsConst(nodeId) && net.GetFaninNum(nodeId) > 1)
             targIds.emplace_back(nodeId);
     }
+    const int MAX_LAC_PER_NODE = std::max(1, static_cast<int>(maxCandResub / std::max(static_cast<size_t>(1), targIds.size())));
+    if (pTargs != nullptr)
+        targIds.erase(std::remove_if(targIds.begin(), targIds.end(), [pTargs](int targId) {return !pTargs->count(targId);}), targIds.end());
 
-    // collect divisors
+    // collect divisors; serial, since GetDivs uses the traversal IDs of ABC
     vector<IntVect> divs4Nodes;
     divs4Nodes.resize(net.GetIdMaxPlus1());
     boost::timer::progress_display pd(targIds.size());
@@ -145,43 +252,39 @@ void LACMan::GenResubLACs(const NetMan& net, unsigned seed, int nFrame4ResubGen,
     if (inclConst) {
     for (int targId: targIds) {
         int sizeGain = net.IsTheOnlyPoDriver(targId)? net.GetSizeGain(targId, IntVect{}): net.GetSizeGain(targId, IntVect{}) + 1;
-        if (static_cast<int>(smlt.GetDat(targId).count()) <= halfFrame)
-            pLacs.emplace_back(make_shared<LAC>(targId, sizeGain, IntVect{}, string(" 0\n")));
+        if (smlt.GetDat(targId).Count() <= halfFrame)
+            lacs.emplace_back(targId, sizeGain, std::span<const int>(), LAC_SOP_CONST0);
         else
-            pLacs.emplace_back(make_shared<LAC>(targId, sizeGain, IntVect{}, string(" 1\n")));
+            lacs.emplace_back(targId, sizeGain, std::span<const int>(), LAC_SOP_CONST1);
     }
-    fmt::print("generated 0-resubs (constant LACs), total #lacs = {}\n", pLacs.size());
+    fmt::print("generated 0-resubs (constant LACs), total #lacs = {}\n", lacs.size());
     }
-    // generate 1 resubstitution
-    for (int targId: targIds) {
+    // generate 1 resubstitution and 2 resubstitution of each target, at most MAX_LAC_PER_NODE ones
+    // the 1-resubs are tried first; the 2-resubs try replacing the i-th fanin with another divisor
+    int nConstLac = static_cast<int>(lacs.size());
+    auto genLacs4Targ = [&](int targId, LACVect& buf, unordered_map<int, int>& nDeref) {
+        int lacNum = 0;
         auto& divs = divs4Nodes[targId];
+        IntVect divIds{-1};
+        // 1-resub: only the divisors in the equivalence class of the target can match, so skip the divisors with other keys
+        if (sigIndex.GetClass(targId).size() > 1) {
         for (int div: divs) {
-            auto diff = (smlt.GetDat(div) ^ smlt.GetDat(targId)).count();
-            if (diff == 0) {
-                int sizeGain = net.GetSizeGain(targId, IntVect{div});
-                pLacs.emplace_back(make_shared<LAC>(targId, sizeGain, IntVect{div}, string("1 1\n")));
-                if (static_cast<int>(pLacs.size()) > LAC_NUM_LIMIT)
-                    break;
-            }
-            else if (static_cast<int>(diff) == simulationFrame) {
-                int sizeGain = net.GetSizeGain(targId, IntVect{div});
-                pLacs.emplace_back(make_shared<LAC>(targId, sizeGain, IntVect{div}, string("0 1\n")));
-                if (static_cast<int>(pLacs.size()) > LAC_NUM_LIMIT)
-                    break;
+            if (lacNum >= MAX_LAC_PER_NODE)
+                return;
+            if (!sigIndex.IsSameClass(div, targId))
+                continue;
+            auto diff = CountXor(smlt.GetDat(div), smlt.GetDat(targId));
+            if (diff == 0 || static_cast<int>(diff) == simulationFrame) {
+                divIds[0] = div;
+                int sizeGain = net.GetSizeGainReadOnly(targId, divIds, nDeref);
+                buf.emplace_back(targId, sizeGain, std::span<const int>(&div, 1), diff == 0? LAC_SOP_BUF: LAC_SOP_INV);
+                ++lacNum;
             }
         }
-    }
-    fmt::print("generated 1-resubs, total #lacs = {}\n", pLacs.size());
-    // generate 2 resubstitution: try replacing the i-th fanin with another divisor
-    if (static_cast<int>(pLacs.size()) <= LAC_NUM_LIMIT) {
-    bool _break = false;
-    for (int targId: targIds) {
-        if (_break)
-            break;
+        }
         int nFanin = net.GetFaninNum(targId);
         assert(nFanin == 2);
         int fanin0 = net.GetFaninId(targId, 0), fanin1 = net.GetFaninId(targId, 1);
-        auto& divs = divs4Nodes[targId];
         for (int i = 0; i < nFanin; ++i) {
             int remainedFanin = (i == 0)? fanin1: fanin0;
             int replacedFanin = net.GetFaninId(targId, i);
@@ -189,32 +292,41 @@ void LACMan::GenResubLACs(const NetMan& net, unsigned seed, int nFrame4ResubGen,
             for (int div: divs) {
                 if (div == replacedFanin || div == remainedFanin)
                     continue;
-                if (_break)
-                    break;
                 faninIds[1] = div;
-                int sizeGain = net.GetSizeGain(targId, faninIds) - 1;
+                // prefilter the cubes with the partial signatures, before the costly size gain
+                int combs = 0;
+                for (int comb = 0; comb < 4; ++comb) {
+                    ull maskA = ((comb >> 1) & 1)? 0ull: ~0ull, maskB = (comb & 1)? 0ull: ~0ull;
+                    ull diff = (((sigIndex.GetPartSig(remainedFanin) ^ maskA) & (sigIndex.GetPartSig(div) ^ maskB)) ^ sigIndex.GetPartSig(targId)) & sigIndex.GetPartMask();
+                    if (diff == 0 || diff == sigIndex.GetPartMask())
+                        combs |= 1 << comb;
+                }
+                if (combs == 0)
+                    continue;
+                int sizeGain = net.GetSizeGainReadOnly(targId, faninIds, nDeref) - 1;
                 if (sizeGain >= 1) {
                     for (int comb = 0; comb < 4; ++comb) {
+                        if (lacNum >= MAX_LAC_PER_NODE)
+                            return;
+                        if (!((combs >> comb) & 1))
+                            continue;
                         int var0 = (comb >> 1) & 1, var1 = comb & 1;
-                        auto dat0 = var0? smlt.GetDat(faninIds[0]): ~(smlt.GetDat(faninIds[0]));
-                        auto dat1 = var1? smlt.GetDat(faninIds[1]): ~(smlt.GetDat(faninIds[1]));
-                        auto res = dat0 & dat1;
-                        auto diff = (res ^ smlt.GetDat(targId)).count();
+                        auto diff = CountAndXor(smlt.GetDat(faninIds[0]), !var0, smlt.GetDat(faninIds[1]), !var1, smlt.GetDat(targId));
                         if (diff == 0) {
-                            pLacs.emplace_back(make_shared<LAC>(targId, sizeGain, faninIds, to_string(var0) + to_string(var1) + string(" 1\n")));
-                            _break = (static_cast<int>(pLacs.size()) > LAC_NUM_LIMIT);
+                            buf.emplace_back(targId, sizeGain, faninIds, LAC_SOP_CUBE + comb);
+                            ++lacNum;
                         }
                         else if (static_cast<int>(diff) == simulationFrame) {
-                            pLacs.emplace_back(make_shared<LAC>(targId, sizeGain, faninIds, to_string(var0) + to_string(var1) + string(" 0\n")));
-                            _break = (static_cast<int>(pLacs.size()) > LAC_NUM_LIMIT);
+                            buf.emplace_back(targId, sizeGain, faninIds, LAC_SOP_CUBE_COMPL + comb);
+                            ++lacNum;
                         }
                     }
                 }
             }
         }
-    }
-    fmt::print("generated 2-resubs, total #lacs = {}\n", pLacs.size());
-    }
+    };
+    GenLacs4TargsInParallel(targIds, nThread, genLacs4Targ, lacs);
+    fmt::print("generated {} 1-resubs and 2-resubs, at most {} per node, total #lacs = {}\n", GetLacNum() - nConstLac, MAX_LAC_PER_NODE, lacs.size());
     // for efficiency issues, do not generate LACs that replaces both fanins with new divisors
     // generate 2 resubstitution: try replacing both fanins with new divisors, using AND-based functions
     // if (static_cast<int>(pLacs.size()) <= LAC_NUM_LIMIT) {
@@ -362,7 +474,7 @@ void LACMan::GenResubLACs(const NetMan& net, unsigned seed, int nFrame4ResubGen,
 /**
  * @brief Re-group LACs by node if not done
  * 
- * @retval node2Lacs    node2Lacs[nodeId] = LACs of the node
+ * @retval node2Lacs    node2Lacs[nodeId] = indices of the LACs of the node
  * @return void
  */
 void LACMan::RegroupLACsByNode(bool forceUpd) {
@@ -372,12 +484,8 @@ void LACMan::RegroupLACsByNode(bool forceUpd) {
         return;
     }
     node2Lacs.clear();
-    for (const auto& pLac: pLacs) {
-        int targId = pLac->GetTargId();
-        if (node2Lacs.count(targId) == 0)
-            node2Lacs[targId] = LACPtrVect{};
-        node2Lacs[targId].emplace_back(pLac);
-    }
+    for (int iLac = 0; iLac < static_cast<int>(lacs.size()); ++iLac)
+        node2Lacs[lacs[iLac].GetTargId()].emplace_back(iLac);
 }
 
 
@@ -506,11 +614,11 @@ void LACMan::GetDivs(Abc_Obj_t * pNode, int nLevDivMax, IntVect& divs) {
  * @return void
  */
 void LACMan::PrintLACs(int firstK) const {
-    if (firstK == -1 || firstK > static_cast<int>(pLacs.size()))
-        firstK = pLacs.size();
+    if (firstK == -1 || firstK > static_cast<int>(lacs.size()))
+        firstK = lacs.size();
     fmt::print("{}first {} LACs{}\n", HALF_DASH_LINE, firstK, HALF_DASH_LINE);
     for (int i = 0; i < firstK; ++i)
-        fmt::print("{}\n", pLacs[i]->ToStr());
+        fmt::print("{}\n", lacs[i].ToStr());
     fmt::print("{}\n", DASH_LINE);
 }
 
@@ -518,26 +626,22 @@ void LACMan::PrintLACs(int firstK) const {
 /**
  * @brief Get the best LAC
  * 
- * @return the best LAC; nullptr if no LAC is found
+ * @return the index of the best LAC; -1 if no LAC is found
  */
-shared_ptr<LAC> LACMan::GetBestLac(double errUppBound) const {
+int LACMan::GetBestLac(double errUppBound) const {
     // special case: no LAC
-    if (pLacs.empty())
-        return nullptr;
-    // special case: only one LAC
-    if (pLacs.size() == 1)
-        return pLacs[0];
+    if (lacs.empty())
+        return -1;
     // general case
-    shared_ptr<LAC> pBestLac = pLacs[0];
-    for (int i = 1; i < static_cast<int>(pLacs.size()); ++i) {
-        auto pLac = pLacs[i];
-        double err = pLac->GetErr();
+    int iBestLac = 0;
+    for (int i = 1; i < static_cast<int>(lacs.size()); ++i) {
+        double err = lacs[i].GetErr();
         if (DoubleGreat(err, errUppBound))
             continue;
-        if (Lac0BetterThanLac1(pLac, pBestLac))
-            pBestLac = pLac;
+        if (Lac0BetterThanLac1(lacs[i], lacs[iBestLac]))
+            iBestLac = i;
     }
-    return pBestLac;
+    return iBestLac;
 }
 
 
@@ -545,7 +649,7 @@ shared_ptr<LAC> LACMan::GetBestLac(double errUppBound) const {
  * @brief Sort and keep the top k LACs
  * 
  * @param  k      the number of LACs to keep; if k = -1, keep all LACs
- * @retval pLacs  the top k LACs
+ * @retval lacs   the top k LACs
  * @return void
  */
 void LACMan::SortAndKeepTopKLACs(int k) {
@@ -554,54 +658,310 @@ void LACMan::SortAndKeepTopKLACs(int k) {
         assert(0);
         return;
     }
-    // sort the LACs
-    // std::sort(pLacs.begin(), pLacs.end(), LacBetterThanUsingErr2);
-    std::sort(pLacs.begin(), pLacs.end(), Lac0BetterThanLac1);
+    // sort the indices of the LACs, then gather the kept LACs
+    int nLac = static_cast<int>(lacs.size());
+    IntVect order(nLac);
+    std::iota(order.begin(), order.end(), 0);
+    // std::sort(order.begin(), order.end(), [this](int i, int j) {return LacBetterThanUsingErr2(lacs[i], lacs[j]);});
+    std::sort(order.begin(), order.end(), [this](int i, int j) {return Lac0BetterThanLac1(lacs[i], lacs[j]);});
     // if k is larger than the number of LACs, keep all LACs
-    if (k >= static_cast<int>(pLacs.size()))
-        return;
-    // keep the top k LACs
-    if (k != -1)
-        pLacs.resize(k);
+    if (k != -1 && k < nLac)
+        order.resize(k);
+    LACVect sorted;
+    sorted.reserve(order.size());
+    for (int i: order)
+        sorted.emplace_back(lacs[i]);
+    lacs.swap(sorted);
+    node2Lacs.clear();
 }
 
 
 /**
- * @brief Remove LACs with the given representative strings
+ * @brief Remove LACs with the given hash keys
  * 
- * @param blackList     a black list of LACs
- * @retval pLacs        the LACs after removal
+ * @param blackList     a black list of LACs, indexed by LAC::GetKey()
+ * @retval lacs         the LACs after removal
  * @return void
  */
-void LACMan::RemLacsFromBlackList(std::unordered_set<std::string>& blackList) {
+void LACMan::RemLacsFromBlackList(const LacBlackList& blackList) {
     if (blackList.empty())
         return;
-    pLacs.erase(
-        std::remove_if(pLacs.begin(), pLacs.end(),
-            [&blackList](const LACPtr& pLac) {
-                return blackList.count(pLac->ToStrShort());
+    lacs.erase(
+        std::remove_if(lacs.begin(), lacs.end(),
+            [&blackList](const LAC& lac) {
+                return blackList.count(lac.GetKey());
             }
         ),
-        pLacs.end()
+        lacs.end()
     );
+    node2Lacs.clear();
 }
 
 /**
  * @brief Remove LACs with error larger than the given upper bound
  * 
  * @param errUppBound     the upper bound of the error
- * @retval pLacs           the LACs after removal
+ * @retval lacs            the LACs after removal
  * @return void
  */
 void LACMan::RemLargeErrLacs(double errUppBound) {
-    pLacs.erase(
-        std::remove_if(pLacs.begin(), pLacs.end(),
-            [errUppBound](const LACPtr& pLac) {
-                return DoubleGreat(pLac->GetErr(), errUppBound);
+    lacs.erase(
+        std::remove_if(lacs.begin(), lacs.end(),
+            [errUppBound](const LAC& lac) {
+                return DoubleGreat(lac.GetErr(), errUppBound);
             }
         ),
-        pLacs.end()
+        lacs.end()
     );
+    node2Lacs.clear();
+}
+
+
+/**
+ * @brief Compute the size gain of a LAC in the same way as its generator
+ * 
+ * @param net       the network
+ * @param lac       the LAC
+ * @param lacType   the type of the generator
+ * @return int      the size gain
+ */
+static int CalcLacSizeGain(const NetMan& net, const LAC& lac, LAC_TYPE lacType) {
+    int targId = lac.GetTargId();
+    int sizeGain = net.GetSizeGain(targId, lac.GetDivVect());
+    if (lacType == LAC_TYPE::RESUB) {
+        if (lac.IsConst() && !net.IsTheOnlyPoDriver(targId))
+            ++sizeGain;
+        else if (lac.GetDivIds().size() == 2)
+            --sizeGain;
+    }
+    return sizeGain;
+}
+
+
+/**
+ * @brief Get the hash of the fanins and the function of a node
+ * 
+ * @param net     the network
+ * @param id      the node ID
+ * @return ull    the hash, which is never 0
+ */
+static ull CalcNodeStamp(const NetMan& net, int id) {
+    size_t stamp = 0;
+    boost::hash_combine(stamp, net.GetSop(id));
+    for (int i = 0; i < net.GetFaninNum(id); ++i)
+        boost::hash_combine(stamp, net.GetFaninId(id, i));
+    return static_cast<ull>(stamp) | 1;
+}
+
+
+/**
+ * @brief Collect the nodes affected by the changes since the last generation
+ * @brief The changed nodes are the nodes whose fanins or functions differ from the snapshot, the created nodes, and the old fanins of the deleted nodes;
+ * @brief the affected nodes are the changed nodes together with their TFIs (observability cones) and TFOs (functions and levels)
+ * 
+ * @param net       the network
+ * @return IntSet   the affected nodes
+ */
+IntSet LACMan::CollDirtyNodes(const NetMan& net) const {
+    // collect the changed nodes
+    IntVect seeds;
+    int nId = max(net.GetIdMaxPlus1(), static_cast<int>(prevStamps.size()));
+    for (int id = 0; id < nId; ++id) {
+        bool isNode = id < net.GetIdMaxPlus1() && net.IsNode(id);
+        ull stamp = isNode? CalcNodeStamp(net, id): 0;
+        ull prevStamp = id < static_cast<int>(prevStamps.size())? prevStamps[id]: 0;
+        if (stamp == prevStamp)
+            continue;
+        if (isNode)
+            seeds.emplace_back(id);
+        else if (prevStamp != 0) {
+            for (int faninId: prevFanins[id]) {
+                if (net.IsNode(faninId))
+                    seeds.emplace_back(faninId);
+            }
+        }
+    }
+    // expand the changed nodes to their TFIs and TFOs
+    IntSet dirtyNodes(seeds.begin(), seeds.end());
+    for (int fFanout = 0; fFanout < 2; ++fFanout) {
+        BitVect visited(net.GetIdMaxPlus1(), 0);
+        IntVect stack(seeds);
+        for (int id: seeds)
+            visited[id] = 1;
+        while (!stack.empty()) {
+            int id = stack.back();
+            stack.pop_back();
+            dirtyNodes.emplace(id);
+            int nNext = fFanout? net.GetFanoutNum(id): net.GetFaninNum(id);
+            for (int i = 0; i < nNext; ++i) {
+                int nextId = fFanout? net.GetFanoutId(id, i): net.GetFaninId(id, i);
+                if (!net.IsNode(nextId) || visited[nextId])
+                    continue;
+                visited[nextId] = 1;
+                stack.emplace_back(nextId);
+            }
+        }
+    }
+    return dirtyNodes;
+}
+
+
+/**
+ * @brief Record the fanins and the functions of the nodes, which the cached LACs are generated on
+ * 
+ * @param net      the network
+ * @param depth    the depth of the network
+ * @return void
+ */
+void LACMan::TakeSnapshot(const NetMan& net, int depth) {
+    prevStamps.assign(net.GetIdMaxPlus1(), 0);
+    prevFanins.assign(net.GetIdMaxPlus1(), IntVect());
+    for (int id = 0; id < net.GetIdMaxPlus1(); ++id) {
+        if (!net.IsNode(id))
+            continue;
+        prevStamps[id] = CalcNodeStamp(net, id);
+        prevFanins[id].reserve(net.GetFaninNum(id));
+        for (int i = 0; i < net.GetFaninNum(id); ++i)
+            prevFanins[id].emplace_back(net.GetFaninId(id, i));
+    }
+    prevDepth = depth;
+}
+
+
+/**
+ * @brief Generate LACs incrementally: only the LACs of the nodes affected since the last call are regenerated
+ * @brief A cached LAC is dropped if its target or one of its divisors is affected or deleted; the size gains of the kept LACs are recomputed, because the MFFCs may change
+ * @brief Everything is regenerated at the first call, and for resubstitution when the depth changes, since the divisors depend on the required levels
+ * @brief Call CacheLacs() after the simulation stage, so that the LACs pruned by simulation are not regenerated until their cones change
+ * 
+ * @param lacType          the type of LACs
+ * @param net              the network
+ * @param seed             random seed
+ * @param nFrame4ResubGen  number of simulation frames for approximate resubstitution generation
+ * @param maxLevelDiff     maximum level difference when generating approximate resubstitutions
+ * @param maxCandResub     maximum number of candidate LACs
+ * @param inclConst        whether to include constant LACs
+ * @param nThread          number of threads for the regeneration
+ * @retval lacs            the cached LACs, with the errors of the last round as priors, followed by the regenerated LACs
+ * @return void
+ */
+void LACMan::GenLACsInc(LAC_TYPE lacType, const NetMan& net, unsigned seed, int nFrame4ResubGen, int maxLevelDiff, int maxCandResub, bool inclConst, int nThread) {
+    assert(net.GetNetType() == NET_TYPE::SOP);
+    int depth = net.GetLev();
+    bool fAll = prevDepth == -1 || (lacType == LAC_TYPE::RESUB && depth != prevDepth);
+    IntSet dirtyNodes;
+    if (fAll)
+        targ2Lacs.clear();
+    else
+        dirtyNodes = CollDirtyNodes(net);
+
+    // drop the stale cached LACs, and refresh the size gains of the others
+    int nKeep = 0;
+    for (auto it = targ2Lacs.begin(); it != targ2Lacs.end(); ) {
+        if (!net.IsNode(it->first) || dirtyNodes.count(it->first)) {
+            it = targ2Lacs.erase(it);
+            continue;
+        }
+        auto& cands = it->second;
+        for (auto& lac: cands)
+            lac.SetSizeGain(CalcLacSizeGain(net, lac, lacType));
+        cands.erase(
+            std::remove_if(cands.begin(), cands.end(),
+                [&](const LAC& lac) {
+                    for (int divId: lac.GetDivIds()) {
+                        if (!net.IsObj(divId) || dirtyNodes.count(divId))
+                            return true;
+                    }
+                    return lac.GetDivIds().size() == 2 && lac.GetSizeGain() < 1;
+                }
+            ),
+            cands.end()
+        );
+        nKeep += static_cast<int>(cands.size());
+        ++it;
+    }
+
+    // regenerate the LACs of the affected targets
+    const IntSet* pTargs = fAll? nullptr: &dirtyNodes;
+    if (lacType == LAC_TYPE::CONSTANT)
+        GenConstLACs(net, pTargs);
+    else if (lacType == LAC_TYPE::SASIMI)
+        GenSasimiLACs(net, maxCandResub, inclConst, pTargs, nThread);
+    else if (lacType == LAC_TYPE::RESUB)
+        GenResubLACs(net, seed, nFrame4ResubGen, maxLevelDiff, maxCandResub, inclConst, pTargs, nThread);
+    else {
+        fmt::print(stderr, "Error: unsupported LAC type\n");
+        assert(0);
+    }
+    int nNew = GetLacNum();
+    for (const auto& lac: lacs)
+        targ2Lacs[lac.GetTargId()].emplace_back(lac);
+
+    // rebuild the pool in the order of the target IDs
+    IntVect targIds;
+    targIds.reserve(targ2Lacs.size());
+    for (const auto& [targId, _]: targ2Lacs)
+        targIds.emplace_back(targId);
+    sort(targIds.begin(), targIds.end());
+    lacs.clear();
+    lacs.reserve(nKeep + nNew);
+    for (int targId: targIds)
+        lacs.insert(lacs.end(), targ2Lacs[targId].begin(), targ2Lacs[targId].end());
+    node2Lacs.clear();
+    TakeSnapshot(net, depth);
+    fmt::print("incremental generation: {} affected nodes, reused {} LACs, regenerated {} LACs\n", fAll? net.GetNodeNum(): static_cast<int>(dirtyNodes.size()), nKeep, nNew);
+}
+
+
+/**
+ * @brief Replace the cached LACs with the LACs in the pool, e.g., the LACs that survive the simulation stage
+ * @brief The errors of the LACs are kept as priors for the next round
+ * 
+ * @return void
+ */
+void LACMan::CacheLacs() {
+    for (auto& [_, cands]: targ2Lacs)
+        cands.clear();
+    for (const auto& lac: lacs)
+        targ2Lacs[lac.GetTargId()].emplace_back(lac);
+}
+
+
+/**
+ * @brief Apply the LAC to a structurally hashed network with AIG operations, without converting it to SOP
+ * @brief The new function is built by Abc_AigAnd on the divisors, and the target is replaced by Abc_AigReplace, which also deletes the dangling nodes
+ * @brief The replacement merges structurally equal nodes and cannot be undone by RecovNet, so the v2 flow keeps applying LACs on SOP
+ * 
+ * @param net     the strashed network
+ * @param lac     the LAC
+ * @return void
+ */
+static void ApplyLacToAig(NetMan& net, const LAC& lac) {
+    assert(net.IsStrash());
+    auto pNtk = net.GetNet();
+    auto pMan = static_cast<Abc_Aig_t*>(pNtk->pManFunc);
+    auto divIds = lac.GetDivIds();
+    int sopId = lac.GetSopId();
+    Abc_Obj_t* pNew = nullptr;
+    if (sopId == LAC_SOP_CONST0)
+        pNew = Abc_ObjNot(Abc_AigConst1(pNtk));
+    else if (sopId == LAC_SOP_CONST1)
+        pNew = Abc_AigConst1(pNtk);
+    else if (sopId == LAC_SOP_BUF || sopId == LAC_SOP_INV) {
+        assert(divIds.size() == 1);
+        pNew = Abc_ObjNotCond(net.GetObj(divIds[0]), sopId == LAC_SOP_INV);
+    }
+    else {
+        // "ab 1" is the cube on the divisors with the polarities a and b; "ab 0" is its complement
+        assert(divIds.size() == 2 && sopId >= LAC_SOP_CUBE);
+        int comb = (sopId - LAC_SOP_CUBE) & 3;
+        int var0 = (comb >> 1) & 1, var1 = comb & 1;
+        pNew = Abc_AigAnd(pMan, Abc_ObjNotCond(net.GetObj(divIds[0]), !var0), Abc_ObjNotCond(net.GetObj(divIds[1]), !var1));
+        pNew = Abc_ObjNotCond(pNew, sopId >= LAC_SOP_CUBE_COMPL);
+    }
+    Abc_AigReplace(pMan, net.GetObj(lac.GetTargId()), pNew, 0);
+    Abc_AigCleanup(pMan);
+    net.IncStructVer();
 }
 
 
@@ -615,11 +975,11 @@ void LACMan::RemLargeErrLacs(double errUppBound) {
  */
 void ApplyLac(NetMan& net, const LAC& lac) {
     // prepare
-    assert(net.GetNetType() == NET_TYPE::SOP);
+    assert(net.GetNetType() == NET_TYPE::SOP || net.IsStrash());
     net.GetLev();
     auto targId = lac.GetTargId();
-    auto faninIds = lac.GetDivIds();
-    auto sop = lac.GetSop();
+    auto faninIds = lac.GetDivVect();
+    const auto& sop = lac.GetSop();
     auto _sop = sop;
     replace(_sop.begin(), _sop.end(), '\n', ';');
     fmt::print("replace {}(l={}) with old fanins [", *net.GetObj(targId), net.GetObjLev(targId));
@@ -633,6 +993,10 @@ void ApplyLac(NetMan& net, const LAC& lac) {
     fmt::print("estimated size gain = {}\n", lac.GetSizeGain());
 
     // perform replacement
+    if (net.IsStrash()) {
+        ApplyLacToAig(net, lac);
+        return;
+    }
     auto consts = net.CreateConstsIfNotExist();
     if (sop == " 0\n") {
         net.Replace(targId, consts.first);
@@ -679,7 +1043,7 @@ int TempApplyLac(NetMan& net, const LAC& lac, IntVect& replTrace, bool fVerb) {
         net.TempRepl_v2(lac.GetTargId(), ssId, replTrace, fVerb);
     }
     else {
-        ssId = net.CreateNode(lac.GetDivIds(), lac.GetSop());
+        ssId = net.CreateNode(lac.GetDivVect(), lac.GetSop());
         net.TempRepl_v2(lac.GetTargId(), ssId, replTrace, fVerb);
         replTrace.emplace_back(-1);
         replTrace.emplace_back(ssId);
@@ -705,7 +1069,7 @@ void TempApplyLacWithController(NetMan& net, const LAC& lac, int ctrlId, IntVect
     // fmt::print("Temprarily apply LAC: {}\n", lac);
     // create a new node for substitution
     int tsId = lac.GetTargId();
-    int ssId = net.CreateNode(lac.GetDivIds(), lac.GetSop());
+    int ssId = net.CreateNode(lac.GetDivVect(), lac.GetSop());
     // create a controlling signal
     auto pControl = net.CreatePi(fmt::format("ctrl_{}", ctrlId).c_str());
     // create a MUX
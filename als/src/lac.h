@@ -43,22 +43,65 @@ static inline LAC_TYPE Str2LacType(const std::string& str) {
 }
 
 
+/**
+ * @brief Canonical functions of the LACs in SOP form, interned as small IDs
+ * @brief 0: constant 0, 1: constant 1, 2: buffer, 3: inverter, 4~7: single cube "ab 1" on two divisors, 8~11: complemented single cube "ab 0" on two divisors
+ */
+inline const std::array<std::string, 12> LAC_SOPS = {
+    " 0\n", " 1\n", "1 1\n", "0 1\n",
+    "00 1\n", "01 1\n", "10 1\n", "11 1\n",
+    "00 0\n", "01 0\n", "10 0\n", "11 0\n"
+};
+const int LAC_SOP_CONST0 = 0;
+const int LAC_SOP_CONST1 = 1;
+const int LAC_SOP_BUF = 2;
+const int LAC_SOP_INV = 3;
+const int LAC_SOP_CUBE = 4;
+const int LAC_SOP_CUBE_COMPL = 8;
+
+
+/**
+ * @brief Get the interned ID of a canonical LAC function
+ * 
+ * @param sop    the function in SOP form
+ * @return int   the ID in LAC_SOPS
+ */
+static inline int InternLacSop(const std::string& sop) {
+    for (int i = 0; i < static_cast<int>(LAC_SOPS.size()); ++i) {
+        if (LAC_SOPS[i] == sop)
+            return i;
+    }
+    fmt::print(stderr, "Error: unsupported LAC function {}\n", sop);
+    assert(0);
+    return -1;
+}
+
+
 /**
  * @brief local approximate change (LAC)
+ * @brief A LAC is a trivially copyable record: the divisors are stored inline, and the function is an interned ID in LAC_SOPS
  */
 class LAC {
+public:
+    static const int MAX_DIV = 2;    // maximum number of divisors
+
 private:
-    int targId;        // target node ID
-    int sizeGain;      // (estimated) size reduction after applying the LAC
-    double err;        // (estimated) error after applying the LAC
-    double err2;       // (estimated) error 2 after applying the LAC
-    IntVect divs;      // divisors used to construct the new function
-    std::string sop;   // new function in SOP form on the divisors
+    int targId;                      // target node ID
+    int sizeGain;                    // (estimated) size reduction after applying the LAC
+    double err;                      // (estimated) error after applying the LAC
+    double err2;                     // (estimated) error 2 after applying the LAC
+    std::array<int, MAX_DIV> divs;   // divisors used to construct the new function; the first nDiv ones are valid
+    uint8_t nDiv;                    // number of divisors
+    uint8_t sopId;                   // new function in SOP form on the divisors, interned in LAC_SOPS
 
 public:
-    explicit LAC(): targId(-1), sizeGain(-1), err(DBL_MAX), err2(DBL_MAX) {}
-    explicit LAC(int targ_node_id, int gain, const IntVect& _divs, const std::string & _sop): targId(targ_node_id), sizeGain(gain), err(DBL_MAX), err2(DBL_MAX), divs(_divs), sop(_sop) {}
-    virtual ~LAC() = default;
+    explicit LAC(): targId(-1), sizeGain(-1), err(DBL_MAX), err2(DBL_MAX), divs{-1, -1}, nDiv(0), sopId(LAC_SOP_CONST0) {}
+    explicit LAC(int targ_node_id, int gain, std::span<const int> _divs, int sop_id): targId(targ_node_id), sizeGain(gain), err(DBL_MAX), err2(DBL_MAX), divs{-1, -1}, nDiv(static_cast<uint8_t>(_divs.size())), sopId(static_cast<uint8_t>(sop_id)) {
+        assert(static_cast<int>(_divs.size()) <= MAX_DIV && sop_id >= 0 && sop_id < static_cast<int>(LAC_SOPS.size()));
+        std::copy(_divs.begin(), _divs.end(), divs.begin());
+    }
+    explicit LAC(int targ_node_id, int gain, std::span<const int> _divs, const std::string& _sop): LAC(targ_node_id, gain, _divs, InternLacSop(_sop)) {}
+    ~LAC() = default;
     LAC(const LAC & oth_lac) = default;
     LAC(LAC &&) = default;
     LAC & operator = (const LAC & oth_lac) = default;
@@ -67,105 +110,157 @@ public:
     inline int GetTargId() const {return targId;}
     inline void SetTargId(ll targ_node_id) {targId = targ_node_id;}
     inline int GetSizeGain() const {return sizeGain;}
+    inline void SetSizeGain(int gain) {sizeGain = gain;}
     inline double GetErr() const {return err;}
     inline void SetErr(double _err) {err = _err;}
     inline double GetErr2() const {return err2;}
     inline void SetErr2(double _err) {err2 = _err;}
-    inline const IntVect& GetDivIds() const {return divs;}
-    inline const std::string& GetSop() const {return sop;}
-    inline std::string ToStrShort() const {return fmt::format("n{}d{}f{}", targId, fmt::join(divs, ","), sop);}
-    inline std::string ToStr() const {auto _sop = sop; std::replace(_sop.begin(), _sop.end(), '\n', ';'); return fmt::format("node {}, sizeGain = {}, err = {}, err2 = {}, divs = [{}], sop = [{}]", targId, sizeGain, err, err2, fmt::join(divs, ", "), _sop);}
-    inline bool IsConst0() const {return divs.empty() && sop == " 0\n";}
-    inline bool IsConst1() const {return divs.empty() && sop == " 1\n";}
-    inline bool IsConst() const {return divs.empty() && (sop == " 0\n" || sop == " 1\n");}
-
+    inline std::span<const int> GetDivIds() const {return std::span<const int>(divs.data(), nDiv);}
+    inline IntVect GetDivVect() const {return IntVect(divs.begin(), divs.begin() + nDiv);}
+    inline int GetSopId() const {return sopId;}
+    inline const std::string& GetSop() const {return LAC_SOPS[sopId];}
+    inline std::string ToStr() const {auto _sop = GetSop(); std::replace(_sop.begin(), _sop.end(), '\n', ';'); return fmt::format("node {}, sizeGain = {}, err = {}, err2 = {}, divs = [{}], sop = [{}]", targId, sizeGain, err, err2, fmt::join(GetDivIds(), ", "), _sop);}
+    inline bool IsConst0() const {return sopId == LAC_SOP_CONST0;}
+    inline bool IsConst1() const {return sopId == LAC_SOP_CONST1;}
+    inline bool IsConst() const {return sopId == LAC_SOP_CONST0 || sopId == LAC_SOP_CONST1;}
+    /**
+     * @brief Get the hash key of the LAC, used by the black list instead of a string
+     * @brief Different LACs share a key with a negligible probability, which only skips a LAC
+     */
+    inline ull GetKey() const {
+        const ull MUL = 0x9e3779b97f4a7c15ull;
+        ull key = (static_cast<ull>(static_cast<uint32_t>(targId)) << 8) | sopId;
+        for (int i = 0; i < nDiv; ++i)
+            key = (key ^ static_cast<uint32_t>(divs[i])) * MUL + i;
+        return (key ^ (key >> 31)) * MUL;
+    }
 };
-using LACPtr = std::shared_ptr<LAC>;
-using LACPtrVect = std::vector<LACPtr>;
+using LACVect = std::vector<LAC>;
+using LacBlackList = std::unordered_map<ull, LAC>;   // black list of LACs indexed by their keys (LAC::GetKey()); the records are kept for the checkpoints
 
 
 /**
- * @brief Compare two LACs; define the order of pLac0 < pLac1
+ * @brief Compare two LACs; define the order of lac0 < lac1
  * @brief primary key: smaller error; secondary key: larger size gain; third key: smaller target node ID
  * 
- * @param pLac0     the first LAC
- * @param pLac1     the second LAC
- * @return bool     true if pLac0 < pLac1
+ * @param lac0      the first LAC
+ * @param lac1      the second LAC
+ * @return bool     true if lac0 < lac1
  */
-static inline bool Lac0BetterThanLac1(const std::shared_ptr<LAC>& pLac0, const std::shared_ptr<LAC>& pLac1) {
-    if (DoubleLess(pLac0->GetErr(), pLac1->GetErr()))
+static inline bool Lac0BetterThanLac1(const LAC& lac0, const LAC& lac1) {
+    if (DoubleLess(lac0.GetErr(), lac1.GetErr()))
         return true;
-    if (DoubleEqual(pLac0->GetErr(), pLac1->GetErr())) {
-        if (pLac0->GetSizeGain() > pLac1->GetSizeGain())
+    if (DoubleEqual(lac0.GetErr(), lac1.GetErr())) {
+        if (lac0.GetSizeGain() > lac1.GetSizeGain())
             return true;
-        // if (pLac0->GetSizeGain() == pLac1->GetSizeGain())
-        //     return pLac0->GetTargId() < pLac1->GetTargId();
+        // if (lac0.GetSizeGain() == lac1.GetSizeGain())
+        //     return lac0.GetTargId() < lac1.GetTargId();
     }
     return false;
 }
 
 
 /**
- * @brief Compare two LACs; define the order of pLac0 < pLac1
+ * @brief Compare two LACs; define the order of lac0 < lac1
  * @brief primary key: smaller err2; secondary key: smaller err; third key: larger size gain; fourth key: smaller target node ID
  * 
- * @param pLac0     the first LAC
- * @param pLac1     the second LAC
- * @return bool     true if pLac0 < pLac1
+ * @param lac0      the first LAC
+ * @param lac1      the second LAC
+ * @return bool     true if lac0 < lac1
  */
-static inline bool LacBetterThanUsingErr2(const std::shared_ptr<LAC>& pLac0, const std::shared_ptr<LAC>& pLac1) {
+static inline bool LacBetterThanUsingErr2(const LAC& lac0, const LAC& lac1) {
     // primary key: smaller err2
-    if (DoubleLess(pLac0->GetErr2(), pLac1->GetErr2()))
+    if (DoubleLess(lac0.GetErr2(), lac1.GetErr2()))
         return true;
-    if (DoubleEqual(pLac0->GetErr2(), pLac1->GetErr2())) {
+    if (DoubleEqual(lac0.GetErr2(), lac1.GetErr2())) {
         // secondary key: smaller err
-        if (DoubleLess(pLac0->GetErr(), pLac1->GetErr()))
+        if (DoubleLess(lac0.GetErr(), lac1.GetErr()))
             return true;
-        if (DoubleEqual(pLac0->GetErr(), pLac1->GetErr())) {
+        if (DoubleEqual(lac0.GetErr(), lac1.GetErr())) {
             // third key: larger size gain
-            if (pLac0->GetSizeGain() > pLac1->GetSizeGain())
+            if (lac0.GetSizeGain() > lac1.GetSizeGain())
                 return true;
-            // if (pLac0->GetSizeGain() == pLac1->GetSizeGain())
+            // if (lac0.GetSizeGain() == lac1.GetSizeGain())
             //     // fourth key: smaller target node ID
-            //     return pLac0->GetTargId() < pLac1->GetTargId();
+            //     return lac0.GetTargId() < lac1.GetTargId();
         }
     }
     return false;
 }
 
 
+/**
+ * @brief Index of the simulation signatures of the objects, for matching the divisors of the resubstitutions
+ * @brief A signature and its complement share one key: the row is complemented first if its first bit is one
+ * @brief The objects with the same key form an equivalence class; a shared key is only a candidate match, to be confirmed by the full rows
+ */
+class SigIndex {
+private:
+    std::vector<ull> keys;                               // keys[id], phase-free hash of the signature of object id
+    std::vector<ull> partSigs;                           // partSigs[id], the first word of the signature of object id, i.e., its first 64 patterns
+    std::unordered_map<ull, IntVect> classes;            // the objects grouped by key
+    ull partMask;                                        // mask of the valid bits of the partial signatures
+
+public:
+    explicit SigIndex(const Simulator& smlt);
+    ~SigIndex() = default;
+    SigIndex(const SigIndex&) = delete;
+    SigIndex(SigIndex&&) = delete;
+    SigIndex& operator = (const SigIndex&) = delete;
+    SigIndex& operator = (SigIndex&&) = delete;
+
+    const IntVect& GetClass(int id) const;
+
+    inline ull GetKey(int id) const {return keys[id];}
+    inline bool IsSameClass(int id0, int id1) const {return keys[id0] == keys[id1];}
+    inline ull GetPartSig(int id) const {return partSigs[id];}
+    inline ull GetPartMask() const {return partMask;}
+};
+
+
 /**
  * @brief LAC manager
+ * @brief The LACs are kept by value in one pool; sorting and grouping work on indices into the pool
+ * @brief For the incremental generation across rounds, the manager also caches the LACs per target node, and a snapshot of the network they were generated on
  */
 class LACMan {
 private:
-    LACPtrVect pLacs;                        // Local approximate changes
-    std::unordered_map<int, LACPtrVect> node2Lacs;    // LACs grouped by node ID
+    LACVect lacs;                                    // pool of local approximate changes
+    std::unordered_map<int, IntVect> node2Lacs;      // indices of the LACs grouped by node ID; cleared whenever the pool changes
+    std::unordered_map<int, LACVect> targ2Lacs;      // cached LACs grouped by target node ID, with the errors of the last round as priors
+    std::vector<ull> prevStamps;                     // prevStamps[i], hash of the fanins and the function of node i at the last generation; 0 if it was not a node
+    Int2DVect prevFanins;                            // prevFanins[i], fanin IDs of node i at the last generation
+    int prevDepth;                                   // depth of the network at the last generation; -1 if never generated
+
+    IntSet CollDirtyNodes(const NetMan& net) const;
+    void TakeSnapshot(const NetMan& net, int depth);
 
 public:
-    explicit LACMan() = default;
+    explicit LACMan(): prevDepth(-1) {}
     ~LACMan() = default;
     LACMan(const LACMan &) = delete;
     LACMan(LACMan &&) = delete;
     LACMan & operator = (const LACMan &) = delete;
     LACMan & operator = (LACMan &&) = delete;
-    void GenConstLACs(const NetMan& net);
-    void GenSasimiLACs(const NetMan& net, int maxCandResub, bool inclConst = true);
-    void GenResubLACs(const NetMan& net, unsigned seed, int maxLevelDiff, int nFrame4ResubGen, int maxCandResub, bool inclConst = true);
+    void GenConstLACs(const NetMan& net, const IntSet* pTargs = nullptr);
+    void GenSasimiLACs(const NetMan& net, int maxCandResub, bool inclConst = true, const IntSet* pTargs = nullptr, int nThread = 1);
+    void GenResubLACs(const NetMan& net, unsigned seed, int maxLevelDiff, int nFrame4ResubGen, int maxCandResub, bool inclConst = true, const IntSet* pTargs = nullptr, int nThread = 1);
+    void GenLACsInc(LAC_TYPE lacType, const NetMan& net, unsigned seed, int nFrame4ResubGen, int maxLevelDiff, int maxCandResub, bool inclConst = true, int nThread = 1);
+    void CacheLacs();
     void RegroupLACsByNode(bool forceUpd = false);
     void GetDivs(abc::Abc_Obj_t* pNode, int nLevDivMax, IntVect& divs);
     void PrintLACs(int firstK = -1) const;
-    std::shared_ptr<LAC> GetBestLac(double errUppBound = DBL_MAX) const;
+    int GetBestLac(double errUppBound = DBL_MAX) const;
     void SortAndKeepTopKLACs(int k);
-    void RemLacsFromBlackList(std::unordered_set<std::string>& blackList);
+    void RemLacsFromBlackList(const LacBlackList& blackList);
     void RemLargeErrLacs(double errUppBound);
 
-    inline int GetLacNum() const {return static_cast<int> (pLacs.size());}
-    inline std::shared_ptr<LAC> GetLac(int i) const {return pLacs[i];}
-    inline const LACPtrVect& GetLacs() const {return pLacs;}
-    inline LACPtrVect GetLacsCopy() const {return pLacs;}
-    inline const std::unordered_map<int, LACPtrVect>& GetNode2Lacs() const {return node2Lacs;}
-    inline void ReplLacs(const LACPtrVect& newlacs) {pLacs.clear(); pLacs.assign(newlacs.begin(), newlacs.end());}
+    inline int GetLacNum() const {return static_cast<int> (lacs.size());}
+    inline const LAC& GetLac(int i) const {return lacs[i];}
+    inline LAC& GetLac(int i) {return lacs[i];}
+    inline const LACVect& GetLacs() const {return lacs;}
+    inline const std::unordered_map<int, IntVect>& GetNode2Lacs() const {return node2Lacs;}
+    inline void ReplLacs(const LACVect& newlacs) {lacs.assign(newlacs.begin(), newlacs.end()); node2Lacs.clear();}
 };
 
 
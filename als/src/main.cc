@@ -5,6 +5,7 @@
  * @date 2025-01-07
  * 
  */
+#include <fstream>
 #include "cmdline.hpp"
 #include "als.h"
 
@@ -32,6 +33,22 @@ parser CommPars(int argc, char * argv[]) {
     option.add<int>("fFastFlow", '\0', "use fast flow for EPFL large benchmarks", false, 0);
     option.add<double>("exactPBDPerc", 'p', "proportion of exact PBD (only used in MECALS 1.0)", false, 1.0);
     option.add<ll>("errUppBound", 'e', "upper bound of maximum error", false, 64);
+    option.add<int>("fIncSat", '\0', "check LACs with one incremental SAT solver per round", false, 0);
+    option.add<int>("nThread", 't', "number of threads for generating, pruning, and checking LACs", false, 1);
+    option.add<int>("nPattBank", '\0', "capacity of the counter-example pattern bank", false, 1024);
+    option.add<int>("topK", '\0', "number of the best LACs checked by SAT in each round", false, 100);
+    option.add<int>("fLazyTopK", '\0', "finely simulate the LACs only until the top-K LACs are certain", false, 0);
+    option.add<int>("fIncLacGen", '\0', "generate the LACs incrementally across rounds, only for the nodes affected by the applied LACs", false, 0);
+    option.add<int>("fQuiet", '\0', "suppress the per-LAC console output", false, 0);
+    option.add<string>("profPath", '\0', "path of the JSON Lines profiling trace, one record per round; empty if no trace", false, "");
+    option.add<int>("fCkpt", '\0', "write a checkpoint <outpPath><circuit>_ckpt.txt at the beginning of each round", false, 0);
+    option.add<int>("satInitConfl", '\0', "conflict budget of the first SAT check of a LAC", false, 1 << 12);
+    option.add<int>("satMaxConfl", '\0', "largest conflict budget of the retries of the undecided LACs", false, 1 << 20);
+    option.add<int>("nSatThread", '\0', "number of threads of each SAT solver, more than one runs a portfolio", false, 1);
+    option.add<int>("nMaxGroup", '\0', "maximum number of non-overlapping LACs verified together by one SAT check, bisected on failure; 1 checks each LAC on its own", false, 1);
+    option.add<double>("timeLimit", '\0', "time limit of an ALS run in seconds, within which the undecided LACs are retried; 0 if unlimited", false, 0);
+    option.add<string>("errUppBounds", '\0', "sweep mode: comma-separated error upper bounds, run in increasing order with warm starts; accCirc may be a comma-separated list", false, "");
+    option.add<string>("resume", '\0', "resume from a checkpoint, whose options replace the given ones except nThread, nSatThread, timeLimit, fQuiet, fCkpt, and profPath", false, "");
     option.parse_check(argc, argv);
     return option;
 }
@@ -50,7 +67,7 @@ void ALS(const parser& option) {
     fmt::print("Current date and time: {}\n", std::ctime(&now_time));
 
     // load configurations
-    auto accCirc = option.get<string>("accCirc");
+    auto accCircList = option.get<string>("accCirc");
     auto standCellLib = option.get<string>("standCellLib");
     auto outpPath = option.get<string>("outpPath");
     // auto lacType = option.get<string>("lacType");
@@ -61,43 +78,138 @@ void ALS(const parser& option) {
     auto fFastFlow = option.get<int>("fFastFlow");
     auto exactPBDPerc = option.get<double>("exactPBDPerc");
     auto errUppBound = option.get<ll>("errUppBound");
+    auto fIncSat = option.get<int>("fIncSat");
+    auto nThread = option.get<int>("nThread");
+    auto nPattBank = option.get<int>("nPattBank");
+    auto topK = option.get<int>("topK");
+    auto fLazyTopK = option.get<int>("fLazyTopK");
+    auto fIncLacGen = option.get<int>("fIncLacGen");
+    auto fQuiet = option.get<int>("fQuiet");
+    auto profPath = option.get<string>("profPath");
+    auto fCkpt = option.get<int>("fCkpt");
+    auto satInitConfl = option.get<int>("satInitConfl");
+    auto satMaxConfl = option.get<int>("satMaxConfl");
+    auto nSatThread = option.get<int>("nSatThread");
+    auto timeLimit = option.get<double>("timeLimit");
+    auto nMaxGroup = option.get<int>("nMaxGroup");
+    auto resume = option.get<string>("resume");
+    auto errUppBounds = option.get<string>("errUppBounds");
 
-    // extract circuit name
-    if (!accCirc.ends_with(".blif") && !accCirc.ends_with(".aig")) {
-        fmt::print(stderr, "Error: the accurate circuit should be in BLIF or AIG format.\n");
+    // circuits and error upper bounds; the sweep mode accepts a comma-separated list of circuits
+    auto accCircs = SplitStr(accCircList, ',');
+    LLVect sweepBounds;
+    for (const auto& str: SplitStr(errUppBounds, ','))
+        sweepBounds.emplace_back(std::stoll(str));
+    bool fSweep = !sweepBounds.empty();
+    if (!fSweep && accCircs.size() != 1) {
+        fmt::print(stderr, "Error: multiple accurate circuits are only supported in the sweep mode.\n");
         assert(0);
     }
-    if (!IsPathExist(accCirc)) {
-        fmt::print(stderr, "Error: the accurate circuit file {} does not exist.\n", accCirc);
+    if (fSweep && (!resume.empty() || fUseMecals1_0)) {
+        fmt::print(stderr, "Error: the sweep mode does not support resuming or MECALS 1.0.\n");
         assert(0);
     }
-    std::filesystem::path accCircPath(accCirc);
-    string accCircName = accCircPath.stem().string();
-    fmt::print("accurate circuit: {}\n", accCirc);
+    if (fSweep)
+        errUppBound = *std::ranges::min_element(sweepBounds);
 
     // fix & create output path
     FixPath(outpPath);
     CreateDir(outpPath);
-    outpPath += accCircName + "_";
 
-    // set ALS options
-    ALSOpt alsOpt(metrType, seed, nFrame, fUseMecals1_0, exactPBDPerc, errUppBound, outpPath);
-    alsOpt.ProcSeed();
-    fmt::print("{}", alsOpt);
-
-    // read standard cell library and accurate circuit
+    // read standard cell library, shared by the circuits
     AbcMan abc;
     abc.ReadStandCell(standCellLib);
-    NetMan accNet(accCirc);
-
-    // approximate logic synthesis
-    ALSMan alsMan(accNet, alsOpt);
-    if (alsOpt.fUseMecals1_0) 
-        alsMan.Run_v1(); 
-    else if (fFastFlow)
-        alsMan.Run_FastFlow();
-    else
-        alsMan.Run_v2();
+
+    for (const auto& accCirc: accCircs) {
+        // extract circuit name
+        if (!accCirc.ends_with(".blif") && !accCirc.ends_with(".aig")) {
+            fmt::print(stderr, "Error: the accurate circuit should be in BLIF or AIG format.\n");
+            assert(0);
+        }
+        if (!IsPathExist(accCirc)) {
+            fmt::print(stderr, "Error: the accurate circuit file {} does not exist.\n", accCirc);
+            assert(0);
+        }
+        std::filesystem::path accCircPath(accCirc);
+        string accCircName = accCircPath.stem().string();
+        fmt::print("accurate circuit: {}\n", accCirc);
+
+        // set ALS options
+        ALSOpt alsOpt(metrType, seed, nFrame, fUseMecals1_0, exactPBDPerc, errUppBound, outpPath + accCircName + "_");
+        alsOpt.fIncSat = fIncSat;
+        if (nThread < 1) {
+            fmt::print(stderr, "Error: nThread should be positive.\n");
+            assert(0);
+        }
+        alsOpt.nThread = nThread;
+        if (nPattBank < 0) {
+            fmt::print(stderr, "Error: nPattBank should be non-negative.\n");
+            assert(0);
+        }
+        alsOpt.nPattBank = nPattBank;
+        if (topK < 1) {
+            fmt::print(stderr, "Error: topK should be positive.\n");
+            assert(0);
+        }
+        alsOpt.topK = topK;
+        alsOpt.fLazyTopK = fLazyTopK;
+        alsOpt.fIncLacGen = fIncLacGen;
+        alsOpt.fQuiet = fQuiet;
+        alsOpt.profPath = profPath;
+        alsOpt.fFastFlow = fFastFlow;
+        alsOpt.fCkpt = fCkpt;
+        if (satInitConfl < 1 || satMaxConfl < satInitConfl) {
+            fmt::print(stderr, "Error: satInitConfl should be positive and no more than satMaxConfl.\n");
+            assert(0);
+        }
+        alsOpt.satInitConfl = satInitConfl;
+        alsOpt.satMaxConfl = satMaxConfl;
+        if (nSatThread < 1) {
+            fmt::print(stderr, "Error: nSatThread should be positive.\n");
+            assert(0);
+        }
+        alsOpt.nSatThread = nSatThread;
+        alsOpt.timeLimit = timeLimit;
+        if (nMaxGroup < 1) {
+            fmt::print(stderr, "Error: nMaxGroup should be positive.\n");
+            assert(0);
+        }
+        alsOpt.nMaxGroup = nMaxGroup;
+        if (!resume.empty()) {
+            if (!IsPathExist(resume)) {
+                fmt::print(stderr, "Error: the checkpoint {} does not exist.\n", resume);
+                assert(0);
+            }
+            // skip the header line of the checkpoint
+            std::ifstream fin(resume);
+            std::string header;
+            std::getline(fin, header);
+            alsOpt.Load(fin);
+            if (alsOpt.fUseMecals1_0) {
+                fmt::print(stderr, "Error: MECALS 1.0 does not support checkpoints.\n");
+                assert(0);
+            }
+        }
+        alsOpt.ProcSeed();
+        fmt::print("{}", alsOpt);
+
+        // read accurate circuit
+        NetMan accNet(accCirc);
+
+        // approximate logic synthesis
+        ALSMan alsMan(accNet, alsOpt);
+        if (!resume.empty())
+            alsMan.LoadCkpt(resume);
+        if (fSweep)
+            alsMan.RunSweep(sweepBounds);
+        else if (alsOpt.fUseMecals1_0) 
+            alsMan.Run_v1(); 
+        else if (alsOpt.fFastFlow)
+            alsMan.Run_FastFlow();
+        else
+            alsMan.Run_v2();
+    }
+    Profiler::Get().PrintTotal();
 }
 
 
@@ -700,11 +700,11 @@ static Abc_Ntk_t * Abc_NtkDup_KeepName( Abc_Ntk_t * pNtk ) {
 }
 
 
-NetMan::NetMan(): AbcMan(), pNtk(nullptr), isDupl(true) {
+NetMan::NetMan(): AbcMan(), pNtk(nullptr), isDupl(true), pStructVer(std::make_shared<ull>(0)) {
 }
 
 
-NetMan::NetMan(Abc_Ntk_t * p_ntk, bool is_dupl): AbcMan(), isDupl(is_dupl) {
+NetMan::NetMan(Abc_Ntk_t * p_ntk, bool is_dupl): AbcMan(), isDupl(is_dupl), pStructVer(std::make_shared<ull>(0)) {
     if (is_dupl)
         pNtk = Abc_NtkDup_KeepName(p_ntk);
     else
@@ -712,7 +712,7 @@ NetMan::NetMan(Abc_Ntk_t * p_ntk, bool is_dupl): AbcMan(), isDupl(is_dupl) {
 }
 
 
-NetMan::NetMan(const std::string& fileName): AbcMan(), isDupl(true) {
+NetMan::NetMan(const std::string& fileName): AbcMan(), isDupl(true), pStructVer(std::make_shared<ull>(0)) {
     AbcMan::ReadNet(fileName);
     pNtk = Abc_NtkDup_KeepName(AbcMan::GetNet());
 }
@@ -728,14 +728,15 @@ NetMan::~NetMan() {
 }
 
 
-NetMan::NetMan(const NetMan& net_man): AbcMan(), isDupl(true) {
+NetMan::NetMan(const NetMan& net_man): AbcMan(), isDupl(true), pStructVer(std::make_shared<ull>(0)) {
     pNtk = Abc_NtkDup_KeepName(net_man.pNtk);
 }
 
 
-NetMan::NetMan(NetMan&& net_man): AbcMan(), pNtk(net_man.pNtk), isDupl(net_man.isDupl) {
+NetMan::NetMan(NetMan&& net_man): AbcMan(), pNtk(net_man.pNtk), isDupl(net_man.isDupl), pStructVer(std::move(net_man.pStructVer)) {
     net_man.isDupl = false;
     net_man.pNtk = nullptr;
+    net_man.pStructVer = std::make_shared<ull>(0);
 }
 
 
@@ -746,6 +747,7 @@ NetMan& NetMan::operator = (const NetMan& net_man) {
         Abc_NtkDelete(pNtk);
     pNtk = Abc_NtkDup_KeepName(net_man.GetNet());
     isDupl = true;
+    IncStructVer();
     return *this;
 }
 
@@ -760,6 +762,7 @@ NetMan& NetMan::operator = (NetMan&& net_man) {
     isDupl = net_man.isDupl;
     net_man.isDupl = false;
     net_man.pNtk = nullptr;
+    IncStructVer();
     return *this;
 }
 
@@ -822,6 +825,7 @@ IntPair NetMan::GetConstIds(bool fVerb) {
  * @return The constant node IDs.
  */
 IntPair NetMan::CreateConstsIfNotExist(bool fVerb) {
+    IncStructVer();
     auto consts = GetConstIds(fVerb);
     IntPair ret(consts);
     if (ret.first == -1) {
@@ -845,6 +849,7 @@ IntPair NetMan::CreateConstsIfNotExist(bool fVerb) {
  * @return void
  */
 void NetMan::MergeConst(bool fVerb) {
+    IncStructVer();
     IntPair ret(-1, -1);
     auto type = GetNetType();
     AbcObj* pObj = nullptr;
@@ -1075,6 +1080,7 @@ void NetMan::GetTFORec(AbcObj* pObj, IntVect& objs, const set <int>& critGraph)
 
 
 void NetMan::Comm(const std::string& cmd, bool fVerb) {
+    IncStructVer();
     assert(isDupl == true);
     AbcMan::SetMainNet(pNtk); // abc manage the memory of the old network
     AbcMan::Comm(cmd, fVerb);
@@ -1083,6 +1089,7 @@ void NetMan::Comm(const std::string& cmd, bool fVerb) {
 
 
 void NetMan::Synth(ORIENT orient, bool fVerb) {
+    IncStructVer();
     assert(isDupl == true);
     AbcMan::SetMainNet(pNtk); // abc manage the memory of the old network
     AbcMan::Synth(orient, fVerb);
@@ -1091,6 +1098,7 @@ void NetMan::Synth(ORIENT orient, bool fVerb) {
 
 
 void NetMan::SynthAndMap(double maxDelay, bool fVerb) {
+    IncStructVer();
     assert(isDupl == true);
     AbcMan::SetMainNet(pNtk); // abc manage the memory of the old network
     AbcMan::SynthAndMap(maxDelay, fVerb);
@@ -1710,6 +1718,7 @@ static void Abc_ObjTransferFanout_v2(const AbcObjVect& pFanouts, AbcObj* pNodeFr
  * @return void
  */
 void NetMan::TempRepl_v2(int tsId, int ssId, IntVect& replTrace, bool fVerb) {
+    IncStructVer();
     // check
     auto pTS = GetObj(tsId), pSS = GetObj(ssId);
     if (fVerb)
@@ -1779,6 +1788,7 @@ void NetMan::TempRepl_v2(int tsId, int ssId, IntVect& replTrace, bool fVerb) {
  * @return void
  */
 void NetMan::Recov_v2(const IntVect& replTrace, bool fVerb) {
+    IncStructVer();
     // prepare
     assert(replTrace.size() > 2);
     auto itDelObj = std::ranges::find(replTrace, -1);
@@ -1873,6 +1883,7 @@ static inline void Vec_IntPushMem( Mem_Step_t * pMemMan, Vec_Int_t * p, int Entr
 
 
 void NetMan::PatchFanin( AbcObj* pObj, int iFanin, AbcObj* pFaninOld, AbcObj* pFaninNew ) {
+    IncStructVer();
     AbcObj* pFaninNewR = Abc_ObjRegular(pFaninNew);
     assert( !Abc_ObjIsComplement(pObj) );
     assert( !Abc_ObjIsComplement(pFaninOld) );
@@ -1896,6 +1907,7 @@ void NetMan::PatchFanin( AbcObj* pObj, int iFanin, AbcObj* pFaninOld, AbcObj* pF
 
 
 void NetMan::Trunc(int truncBit) {
+    IncStructVer();
     cout << "***** truncate " << truncBit << " bits" << endl;
     // truncation
     auto consts = CreateConstsIfNotExist();
@@ -2082,6 +2094,7 @@ void NetMan::Trunc(int truncBit) {
 
 
 AbcObj* NetMan::CreateNode(const AbcObjVect& pFanins, const std::string& sop) {
+    IncStructVer();
     auto pNewNode = abc::Abc_NtkCreateNode(GetNet());
     for (const auto& pFanin: pFanins)
         Abc_ObjAddFanin(pNewNode, pFanin);
@@ -2099,6 +2112,7 @@ AbcObj* NetMan::CreateNode(const AbcObjVect& pFanins, const std::string& sop) {
  * @return int       id of the created node 
  */
 int NetMan::CreateNode(const IntVect& faninIds, const std::string& sop) {
+    IncStructVer();
     auto pNewNode = abc::Abc_NtkCreateNode(GetNet());
     for (const auto& faninId: faninIds)
         Abc_ObjAddFanin(pNewNode, GetObj(faninId));
@@ -2116,6 +2130,7 @@ int NetMan::CreateNode(const IntVect& faninIds, const std::string& sop) {
  * @return int      the id of the created node
  */
 int NetMan::CreateAIGStyleNodes(const IntVect& faninIds, const std::string& sop) {
+    IncStructVer();
     assert(GetNetType() == NET_TYPE::SOP);
     if (sop == "01 1\n10 1\n" || sop == "10 1\n01 1\n" || sop == "00 0\n11 0\n" || sop == "11 0\n00 0\n") { // xor
         auto and0 = CreateNode(faninIds, "01 1\n");
@@ -2189,6 +2204,7 @@ int NetMan::CreateAIGStyleNodes(const IntVect& faninIds, const std::string& sop)
 
 
 AbcObj* NetMan::CreateGate(AbcObjVect&& fanins, const std::string& gateName) {
+    IncStructVer();
     auto pLib = (Mio_Library_t *)Abc_FrameReadLibGen();
     auto pGate = Mio_LibraryReadGateByName(pLib, const_cast <char *> (gateName.c_str()), nullptr);
     assert(pGate != nullptr);
@@ -2201,6 +2217,7 @@ AbcObj* NetMan::CreateGate(AbcObjVect&& fanins, const std::string& gateName) {
 
 
 AbcObj* NetMan::DupObj(AbcObj* pObj, const char* pSuff) {
+    IncStructVer();
     AbcObj* pObjNew;
     // create the new object
     pObjNew = Abc_NtkCreateObj( pNtk, (Abc_ObjType_t)pObj->Type );
@@ -2241,6 +2258,7 @@ AbcObj* NetMan::DupObj(AbcObj* pObj, const char* pSuff) {
 
 
 void NetMan::LimFanout() {
+    IncStructVer();
     assert(GetNetType() == NET_TYPE::SOP);
     auto nodes = CalcTopoOrdOfIds();
     for (int id: nodes) {
@@ -2272,6 +2290,7 @@ void NetMan::LimFanout() {
  * @return void
  */
 void NetMan::ReplaceByComplementedObj(int targId, int subId) {
+    IncStructVer();
     assert(GetNetType() == NET_TYPE::SOP);
     auto pTarg = GetObj(targId);
     auto pSub = GetObj(subId);
@@ -2398,6 +2417,7 @@ static void SetConstInput(AbcObj* pNode, AbcObj* pFanin, int fConst0) {
  * @return void
  */
 void NetMan::PropConst(int startId, bool fKeepDanglNodes, bool fVerb) {
+    IncStructVer();
     // check & print
     assert(GetNetType() == NET_TYPE::SOP);
     assert(IsConst(startId));
@@ -2453,6 +2473,7 @@ void NetMan::PropConst(int startId, bool fKeepDanglNodes, bool fVerb) {
  * @return void
  */
 void NetMan::PropConst(bool fVerb) {
+    IncStructVer();
     // merge constant nodes
     MergeConst(fVerb);
 
@@ -2625,5 +2646,45 @@ int NetMan::GetSizeGain(const IntVect& targetIds, const IntVect& divIds) const {
 }
 
 
+/**
+ * @brief Recursively dereference the node nodeId and its MFFCs without modifying the network
+ * @brief The same as NodeDeref_rec, but the dereferenced fanouts are counted in nDeref instead of the fanout arrays of ABC
+ * 
+ * @param rootId    the source node of the dereference
+ * @param nodeId    the current node to be dereferenced
+ * @param divIds    the nodes should be kept
+ * @param nDeref    nDeref[id], number of the dereferenced fanouts of node id
+ * @retval nDeref   updated with the fanouts dereferenced by nodeId
+ * @return int      the number of nodes dereferenced
+ */
+int NetMan::NodeDerefReadOnly_rec(int rootId, int nodeId, const IntVect& divIds, unordered_map<int, int>& nDeref) const {
+    int count = 1;
+    if (Abc_ObjIsCi(GetObj(nodeId)) || find(divIds.begin(), divIds.end(), nodeId) != divIds.end() || (rootId != nodeId && IsPoDriver(nodeId)))
+        return 0;
+    for (int i = 0; i < GetFaninNum(nodeId); ++i) {
+        int faninId = GetFaninId(nodeId, i);
+        if (++nDeref[faninId] == GetFanoutNum(faninId))
+            count += NodeDerefReadOnly_rec(rootId, faninId, divIds, nDeref);
+    }
+    return count;
+}
+
+
+/**
+ * @brief Get the size gain of replacing rootId with a function of divIds, i.e., the size of the MFFC of rootId that excludes divIds
+ * @brief The same result as GetSizeGain, but the network is only read, so several threads can call it on one network
+ * 
+ * @param rootId    the root node
+ * @param divIds    the divisors
+ * @param nDeref    scratch map of the caller, cleared in this function; one per thread
+ * @return int      the size gain
+ */
+int NetMan::GetSizeGainReadOnly(int rootId, const IntVect& divIds, unordered_map<int, int>& nDeref) const {
+    assert(IsNode(rootId));
+    nDeref.clear();
+    return NodeDerefReadOnly_rec(rootId, rootId, divIds, nDeref);
+}
+
+
 
 
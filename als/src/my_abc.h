@@ -185,6 +185,7 @@ class NetMan: public AbcMan {
 private:
     abc::Abc_Ntk_t* pNtk;         // ABC network
     bool isDupl;                  // who manages the memory of the ABC network pNtk; if true, NetMan manages; if false, ABC global frame manages
+    std::shared_ptr<ull> pStructVer; // version of the structure of pNtk, increased by each change through NetMan; shared with the simulators of pNtk
 
 public:
     explicit NetMan();
@@ -241,7 +242,7 @@ public:
     void PropConst(int startId, bool fKeepDanglNodes, bool fVerb);
     void PropConst(bool fVerb = false);
 
-    inline int CleanUp(bool fVerb = false) {return abc::Abc_NtkCleanup(pNtk, fVerb);}
+    inline int CleanUp(bool fVerb = false) {IncStructVer(); return abc::Abc_NtkCleanup(pNtk, fVerb);}
     inline void Sweep(bool fVerb = false) {CleanUp(fVerb); PropConst(fVerb);}
     
     // get properties of network
@@ -251,8 +252,13 @@ public:
     int NodeRef_rec_v2(int rootId, int nodeId) const;
     int GetSizeGain(int rootId, const IntVect& divIds) const;
     int GetSizeGain(const IntVect& targetIds, const IntVect& divIds) const;
+    int NodeDerefReadOnly_rec(int rootId, int nodeId, const IntVect& divIds, std::unordered_map<int, int>& nDeref) const;
+    int GetSizeGainReadOnly(int rootId, const IntVect& divIds, std::unordered_map<int, int>& nDeref) const;
 
     inline abc::Abc_Ntk_t* GetNet() const {return pNtk;}
+    inline ull GetStructVer() const {return *pStructVer;}
+    inline void IncStructVer() {++*pStructVer;} // call it after changing pNtk directly with ABC
+    inline void ShareStructVer(const NetMan& net_man) {pStructVer = net_man.pStructVer;}
     inline std::string GetNetName() const {if (pNtk->pName != nullptr) return std::string(pNtk->pName); else return "(null)";}
     inline NET_TYPE GetNetType() const {return AbcMan::GetNetType(pNtk);}
     inline bool IsStrash() const {return GetNetType() == NET_TYPE::STRASH;}
@@ -268,8 +274,8 @@ public:
     inline void CollMffc(int rootId, IntVect& mffcNodes) const {mffcNodes.clear(); int count0 = NodeDeref_rec_v2(rootId, rootId, mffcNodes); int count1 = NodeRef_rec_v2(rootId, rootId); assert(count0 == count1);}
 
     // convert network representation
-    inline void ConvToSop() {abc::Abc_NtkToSop(pNtk, -1, ABC_INFINITY);}
-    inline void Strash() {assert(isDupl); auto pNtkAig = abc::Abc_NtkStrash(pNtk, 0, 1, 0); abc::Abc_NtkDelete(pNtk); pNtk = pNtkAig;}
+    inline void ConvToSop() {IncStructVer(); abc::Abc_NtkToSop(pNtk, -1, ABC_INFINITY);}
+    inline void Strash() {assert(isDupl); IncStructVer(); auto pNtkAig = abc::Abc_NtkStrash(pNtk, 0, 1, 0); abc::Abc_NtkDelete(pNtk); pNtk = pNtkAig;}
 
     // get PIs & POs & nodes
     inline int GetPiNum() const {return abc::Abc_NtkPiNum(pNtk);}
@@ -309,6 +315,8 @@ public:
     inline bool IsPoDriver(ll id) const {return IsPoDriver(GetObj(id));}
     inline bool IsTheOnlyPoDriver(AbcObj* pObj) const {return GetFanoutNum(pObj) == 1 && IsObjPo(GetFanout(pObj, 0));}
     inline bool IsTheOnlyPoDriver(ll id) const {return IsTheOnlyPoDriver(GetObj(id));}
+    inline AbcObj* GetFfrRoot(AbcObj* pNode) const {assert(IsNode(pNode)); while (GetFanoutNum(pNode) == 1 && IsNode(GetFanout(pNode, 0))) pNode = GetFanout(pNode, 0); return pNode;}
+    inline int GetFfrRoot(int id) const {return GetId(GetFfrRoot(GetObj(id)));}
     inline std::string GetName(AbcObj* pObj) const {return std::string(abc::Abc_ObjName(pObj));}
     inline std::string GetName(int i) const {return GetName(GetObj(i));}
     inline std::string GetPiName(int i) const {return std::string(abc::Abc_ObjName(GetPi(i)));}
@@ -353,20 +361,20 @@ public:
     inline std::string GetGateName(AbcObj* pNode) const {assert(NetMan::GetNetType() == NET_TYPE::GATE); if (IsNode(pNode)) return std::string(abc::Mio_GateReadName(static_cast <abc::Mio_Gate_t *> (pNode->pData))); else return std::string("");}
 
     // modify network
-    inline abc::Abc_Ntk_t* StartSopNet() {pNtk = abc::Abc_NtkAlloc(abc::ABC_NTK_LOGIC, abc::ABC_FUNC_SOP, 1); return pNtk;}
-    inline abc::Abc_Ntk_t* StartStrashNet() {pNtk = abc::Abc_NtkAlloc(abc::ABC_NTK_STRASH, abc::ABC_FUNC_AIG, 1); return pNtk;}
-    inline void AddFanin(AbcObj* pObj, AbcObj* pFanin) {abc::Abc_ObjAddFanin(pObj, pFanin);}
-    inline void Replace(AbcObj* pTS, AbcObj* pSS) {abc::Abc_ObjReplace(pTS, pSS);}
+    inline abc::Abc_Ntk_t* StartSopNet() {IncStructVer(); pNtk = abc::Abc_NtkAlloc(abc::ABC_NTK_LOGIC, abc::ABC_FUNC_SOP, 1); return pNtk;}
+    inline abc::Abc_Ntk_t* StartStrashNet() {IncStructVer(); pNtk = abc::Abc_NtkAlloc(abc::ABC_NTK_STRASH, abc::ABC_FUNC_AIG, 1); return pNtk;}
+    inline void AddFanin(AbcObj* pObj, AbcObj* pFanin) {IncStructVer(); abc::Abc_ObjAddFanin(pObj, pFanin);}
+    inline void Replace(AbcObj* pTS, AbcObj* pSS) {IncStructVer(); abc::Abc_ObjReplace(pTS, pSS);}
     inline void Replace(int tsId, int ssId) {Replace(GetObj(tsId), GetObj(ssId));}
-    inline void TransfFanout(AbcObj* pTS, AbcObj* pSS) {abc::Abc_ObjTransferFanout(pTS, pSS);}
+    inline void TransfFanout(AbcObj* pTS, AbcObj* pSS) {IncStructVer(); abc::Abc_ObjTransferFanout(pTS, pSS);}
     inline void TransfFanout(int tsId, int ssId) {TransfFanout(GetObj(tsId), GetObj(ssId));}
-    inline void DelObj(AbcObj* pObj) {abc::Abc_NtkDeleteObj(pObj);}
+    inline void DelObj(AbcObj* pObj) {IncStructVer(); abc::Abc_NtkDeleteObj(pObj);}
     inline void DelObj(int id) {DelObj(GetObj(id));}
-    inline void DelObjRec(AbcObj* pObj) {abc::Abc_NtkDeleteObj_rec(pObj, 1);}
+    inline void DelObjRec(AbcObj* pObj) {IncStructVer(); abc::Abc_NtkDeleteObj_rec(pObj, 1);}
     inline void DelObjRec(int id) {DelObjRec(GetObj(id));}
-    inline AbcObj* CreateInv(AbcObj* pFanin) {assert(pFanin->pNtk == pNtk); return Abc_NtkCreateNodeInv(pNtk, pFanin);}
+    inline AbcObj* CreateInv(AbcObj* pFanin) {IncStructVer(); assert(pFanin->pNtk == pNtk); return Abc_NtkCreateNodeInv(pNtk, pFanin);}
     inline int CreateInv(int faninId) {return GetId(CreateInv(GetObj(faninId)));}
-    inline AbcObj* CreateBuf(AbcObj* pFanin) {assert(pFanin->pNtk == pNtk); return Abc_NtkCreateNodeBuf(pNtk, pFanin);}
+    inline AbcObj* CreateBuf(AbcObj* pFanin) {IncStructVer(); assert(pFanin->pNtk == pNtk); return Abc_NtkCreateNodeBuf(pNtk, pFanin);}
     inline int CreateBuf(int faninId) {return GetId(CreateBuf(GetObj(faninId)));}
     inline AbcObj* CreateAnd(AbcObj* pA, AbcObj* pB) {assert(pA->pNtk == pNtk && pB->pNtk == pNtk); return CreateNode(AbcObjVect({pA, pB}), "11 1\n");}
     inline int CreateAnd(int a, int b) {return GetId(CreateAnd(GetObj(a), GetObj(b)));}
@@ -374,8 +382,9 @@ public:
     inline int CreateOr(int a, int b) {return GetId(CreateOr(GetObj(a), GetObj(b)));}
     inline AbcObj* CreateXor(AbcObj* pA, AbcObj* pB) {assert(pA->pNtk == pNtk && pB->pNtk == pNtk); return CreateNode(AbcObjVect({pA, pB}), "01 1\n10 1\n");}
     inline int CreateXor(int a, int b) {return GetId(CreateXor(GetObj(a), GetObj(b)));}
-    inline AbcObj* CreatePo(AbcObj* pFanin, const char* pName) {auto pPo = abc::Abc_NtkCreatePo(pNtk); AddFanin(pPo, pFanin); Abc_ObjAssignName(pPo, const_cast<char*>(pName), nullptr); return pPo;}
-    inline AbcObj* CreatePi(const char* pName) {auto pPi = abc::Abc_NtkCreatePi(pNtk); Abc_ObjAssignName(pPi, const_cast<char*>(pName), nullptr); return pPi;}
+    inline AbcObj* CreatePo(AbcObj* pFanin, const char* pName) {IncStructVer(); auto pPo = abc::Abc_NtkCreatePo(pNtk); AddFanin(pPo, pFanin); Abc_ObjAssignName(pPo, const_cast<char*>(pName), nullptr); return pPo;}
+    inline AbcObj* CreatePo(AbcObj* pFanin) {IncStructVer(); auto pPo = abc::Abc_NtkCreatePo(pNtk); AddFanin(pPo, pFanin); return pPo;} // unnamed; ABC names it lazily on demand
+    inline AbcObj* CreatePi(const char* pName) {IncStructVer(); auto pPi = abc::Abc_NtkCreatePi(pNtk); Abc_ObjAssignName(pPi, const_cast<char*>(pName), nullptr); return pPi;}
     inline void RenameNet(const std::string& name) {if (pNtk->pName != nullptr) ABC_FREE(pNtk->pName); pNtk->pName = abc::Extra_UtilStrsav(name.c_str());}
     inline void Rename(AbcObj* pObj, const char* pName) {Abc_ObjAssignName(pObj, const_cast<char*>(pName), nullptr);}
     inline void Rename(int id, const char* pName) {Rename(GetObj(id), pName);}
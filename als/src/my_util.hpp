@@ -59,6 +59,25 @@ static inline void FixPath(std::string& _path) {
 }
 
 
+/**
+ * @brief Split a string by a delimiter; the empty fields are dropped
+ * 
+ * @param str     the string
+ * @param delim   the delimiter
+ * @return std::vector<std::string>  the fields
+ */
+static inline std::vector<std::string> SplitStr(const std::string& str, char delim) {
+    std::vector<std::string> fields;
+    std::istringstream iss(str);
+    std::string field;
+    while (std::getline(iss, field, delim)) {
+        if (!field.empty())
+            fields.emplace_back(field);
+    }
+    return fields;
+}
+
+
 // util of float-point numbers
 static inline bool DoubleEqual     (const double a, const double b, double epsilon = EPSILON) {return fabs(a - b) < epsilon;}
 static inline bool DoubleGreat     (const double a, const double b, double epsilon = EPSILON) {return a - b >= epsilon;}
@@ -179,3 +198,74 @@ static inline void PrintRuntime(const std::chrono::time_point<std::chrono::high_
     auto currTime = std::chrono::high_resolution_clock::now();
     fmt::print("{} runtime = {}ms\n", info, std::chrono::duration_cast<std::chrono::milliseconds>(currTime - startTime).count());
 }
+
+
+/**
+ * @brief Run jobs in parallel, one thread per job
+ * 
+ * @param nJob    the number of jobs
+ * @param func    the job function, called as func(iJob)
+ * @return void
+ */
+template <typename Func>
+static inline void RunJobsInParallel(int nJob, Func&& func) {
+    std::vector<std::thread> threads;
+    threads.reserve(nJob);
+    for (int iJob = 0; iJob < nJob; ++iJob)
+        threads.emplace_back(func, iJob);
+    for (auto& thread: threads)
+        thread.join();
+}
+
+
+/**
+ * @brief xoshiro256++ pseudo-random generator (D. Blackman and S. Vigna), seeded by SplitMix64
+ * @brief Jump() advances the state by 2^128 draws, so the streams split by successive jumps never overlap
+ */
+class Xoshiro256pp {
+private:
+    std::array<ull, 4> s;   // the state
+
+public:
+    using result_type = ull;
+
+    explicit Xoshiro256pp(ull seed) {
+        for (auto& word: s) {
+            seed += 0x9e3779b97f4a7c15ull;
+            ull z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr ull min() {return 0;}
+    static constexpr ull max() {return ~0ull;}
+
+    inline ull operator () () {
+        ull res = std::rotl(s[0] + s[3], 23) + s[0];
+        ull t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = std::rotl(s[3], 45);
+        return res;
+    }
+
+    inline void Jump() {
+        const ull JUMP[4] = {0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+        std::array<ull, 4> t = {0, 0, 0, 0};
+        for (ull jump: JUMP) {
+            for (int b = 0; b < 64; ++b) {
+                if ((jump >> b) & 1) {
+                    for (int i = 0; i < 4; ++i)
+                        t[i] ^= s[i];
+                }
+                (*this)();
+            }
+        }
+        s = t;
+    }
+};
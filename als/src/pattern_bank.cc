@@ -0,0 +1,188 @@
+/**
+ * @file pattern_bank.cc
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief Bank of counter-example simulation patterns
+ *
+ */
+#include "pattern_bank.h"
+
+
+using namespace std;
+
+
+/**
+ * @brief Constructor of the pattern bank
+ *
+ * @param n_pi        the number of PIs
+ * @param _capacity   the maximum number of patterns
+ */
+PatternBank::PatternBank(int n_pi, int _capacity): nPi(n_pi), capacity(_capacity), nAdd(0) {
+    if (nPi <= 0 || capacity < 0) {
+        fmt::print(stderr, "Error: invalid pattern bank, #PI = {}, capacity = {}\n", nPi, capacity);
+        assert(0);
+    }
+    patts.reserve(capacity);
+    scores.reserve(capacity);
+    stamps.reserve(capacity);
+}
+
+
+/**
+ * @brief Add a counter example, which has rejected one LAC
+ * @brief A duplicated counter example only increases the score of the existing one
+ *
+ * @param piVals   the PI values of the counter example
+ * @return bool    true if the counter example is new
+ */
+bool PatternBank::Add(const IntVect& piVals) {
+    assert(static_cast<int>(piVals.size()) == nPi);
+    if (capacity == 0)
+        return false;
+    BitVect patt(nPi, 0);
+    for (int iPi = 0; iPi < nPi; ++iPi) {
+        assert(piVals[iPi] == 0 || piVals[iPi] == 1);
+        patt[iPi] = piVals[iPi];
+    }
+    // deduplicate
+    auto it = patt2Idx.find(patt);
+    if (it != patt2Idx.end()) {
+        ++scores[it->second];
+        return false;
+    }
+    // append, or replace the lowest-scored and then the oldest pattern
+    int iPatt = GetPattNum();
+    if (iPatt < capacity) {
+        patts.emplace_back(patt);
+        scores.emplace_back(1);
+        stamps.emplace_back(nAdd);
+    }
+    else {
+        iPatt = 0;
+        for (int i = 1; i < GetPattNum(); ++i) {
+            if (scores[i] < scores[iPatt] || (scores[i] == scores[iPatt] && stamps[i] < stamps[iPatt]))
+                iPatt = i;
+        }
+        patt2Idx.erase(patts[iPatt]);
+        patts[iPatt] = patt;
+        scores[iPatt] = 1;
+        stamps[iPatt] = nAdd;
+    }
+    patt2Idx.emplace(std::move(patt), iPatt);
+    ++nAdd;
+    return true;
+}
+
+
+/**
+ * @brief Credit the patterns with the LACs that they reject in simulation
+ *
+ * @param kills   kills[i] is the number of LACs rejected by the i-th pattern; may be shorter than the bank
+ * @return void
+ */
+void PatternBank::AddScores(const LLVect& kills) {
+    assert(static_cast<int>(kills.size()) <= GetPattNum());
+    for (int i = 0; i < static_cast<int>(kills.size()); ++i)
+        scores[i] += kills[i];
+}
+
+
+/**
+ * @brief Halve the scores (rounding up), so that the patterns that stop rejecting LACs are evicted first
+ *
+ * @return void
+ */
+void PatternBank::Decay() {
+    for (auto& score: scores)
+        score -= score / 2;
+}
+
+
+/**
+ * @brief Overwrite the first frames of the simulator with the patterns; the other frames are kept
+ * @brief The overwritten words are marked dirty; call UpdNodeAndPoPatts() or UpdDirtyPatts() afterwards
+ *
+ * @param smlt     the simulator
+ * @retval smlt    the simulator with the i-th pattern in the i-th frame
+ * @return int     the number of loaded patterns
+ */
+int PatternBank::LoadInto(Simulator& smlt) const {
+    assert(smlt.GetPiNum() == nPi);
+    int nLoad = min(GetPattNum(), smlt.GetFrameNumb());
+    IntVect piVals(nPi, 0);
+    for (int iPatt = 0; iPatt < nLoad; ++iPatt) {
+        for (int iPi = 0; iPi < nPi; ++iPi)
+            piVals[iPi] = patts[iPatt][iPi];
+        smlt.ReplInp(iPatt, piVals);
+    }
+    return nLoad;
+}
+
+
+/**
+ * @brief Save the pattern bank in text: a header line "bank <#PI> <capacity> <#added> <#patterns>", then one line "<PI values> <score> <stamp>" per pattern
+ *
+ * @param fout   the output stream
+ * @return void
+ */
+void PatternBank::Save(ostream& fout) const {
+    fout << fmt::format("bank {} {} {} {}\n", nPi, capacity, nAdd, GetPattNum());
+    string bits(nPi, '0');
+    for (int iPatt = 0; iPatt < GetPattNum(); ++iPatt) {
+        for (int iPi = 0; iPi < nPi; ++iPi)
+            bits[iPi] = patts[iPatt][iPi]? '1': '0';
+        fout << fmt::format("{} {} {}\n", bits, scores[iPatt], stamps[iPatt]);
+    }
+}
+
+
+/**
+ * @brief Load the pattern bank saved by Save(); the bank must have the same #PI and capacity
+ *
+ * @param fin    the input stream
+ * @retval this  the pattern bank with the loaded patterns, scores, and stamps
+ * @return void
+ */
+void PatternBank::Load(istream& fin) {
+    string tag;
+    int _nPi = -1, _capacity = -1, nPatt = -1;
+    fin >> tag >> _nPi >> _capacity >> nAdd >> nPatt;
+    if (!fin || tag != "bank" || _nPi != nPi || _capacity != capacity || nPatt < 0 || nPatt > capacity) {
+        fmt::print(stderr, "Error: invalid pattern bank in the checkpoint, #PI = {}, capacity = {}, #patterns = {}\n", _nPi, _capacity, nPatt);
+        assert(0);
+    }
+    patts.clear();
+    scores.clear();
+    stamps.clear();
+    patt2Idx.clear();
+    string bits;
+    for (int iPatt = 0; iPatt < nPatt; ++iPatt) {
+        ll score = 0, stamp = 0;
+        fin >> bits >> score >> stamp;
+        if (!fin || static_cast<int>(bits.size()) != nPi) {
+            fmt::print(stderr, "Error: invalid {}-th pattern in the checkpoint\n", iPatt);
+            assert(0);
+        }
+        BitVect patt(nPi, 0);
+        for (int iPi = 0; iPi < nPi; ++iPi)
+            patt[iPi] = (bits[iPi] == '1');
+        patt2Idx.emplace(patt, iPatt);
+        patts.emplace_back(std::move(patt));
+        scores.emplace_back(score);
+        stamps.emplace_back(stamp);
+    }
+}
+
+
+/**
+ * @brief Print the summary of the pattern bank
+ *
+ * @return void
+ */
+void PatternBank::Print() const {
+    ll maxScore = 0, totScore = 0;
+    for (auto score: scores) {
+        maxScore = max(maxScore, score);
+        totScore += score;
+    }
+    fmt::print("pattern bank: #patterns = {}/{}, #added = {}, total score = {}, max score = {}\n", GetPattNum(), capacity, nAdd, totScore, maxScore);
+}
@@ -0,0 +1,49 @@
+/**
+ * @file pattern_bank.h
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief Bank of counter-example simulation patterns
+ *
+ */
+#pragma once
+
+
+#include <boost/functional/hash.hpp>
+#include "header.h"
+#include "simulator.h"
+
+
+/**
+ * @brief Bounded bank of deduplicated counter examples, kept across rounds and LAC types
+ * @brief Each pattern is scored by the number of LACs it rejects; when the bank is full, the lowest-scored (then the oldest) pattern is evicted
+ * @brief The patterns are loaded into the first frames of the simulators, so that bad LACs are rejected by simulation instead of SAT
+ */
+class PatternBank {
+private:
+    int nPi;                                                          // number of PIs
+    int capacity;                                                     // maximum number of patterns
+    ll nAdd;                                                          // number of added patterns, used as the insertion time
+    std::vector<BitVect> patts;                                       // patts[i], PI values of the i-th pattern
+    LLVect scores;                                                    // scores[i], number of LACs rejected by the i-th pattern
+    LLVect stamps;                                                    // stamps[i], insertion time of the i-th pattern
+    std::unordered_map<BitVect, int, boost::hash<BitVect>> patt2Idx; // the index of each pattern
+
+public:
+    explicit PatternBank(int n_pi, int _capacity);
+    ~PatternBank() = default;
+    PatternBank(const PatternBank&) = delete;
+    PatternBank(PatternBank&&) = delete;
+    PatternBank& operator = (const PatternBank&) = delete;
+    PatternBank& operator = (PatternBank&&) = delete;
+
+    bool Add(const IntVect& piVals);
+    void AddScores(const LLVect& kills);
+    void Decay();
+    int LoadInto(Simulator& smlt) const;
+    void Save(std::ostream& fout) const;
+    void Load(std::istream& fin);
+    void Print() const;
+
+    inline int GetPattNum() const {return static_cast<int>(patts.size());}
+    inline int GetCapacity() const {return capacity;}
+    inline ll GetScore(int iPatt) const {return scores[iPatt];}
+};
@@ -8,6 +8,7 @@
 
 
 #include "pbd.h"
+#include "my_util.hpp"
 #include "simulator.h"
 
 
@@ -33,6 +34,10 @@ void PBDMan::BuildMit(const NetMan& accNet, NetMan& appNet, NetMan& mitNet) {
     // init
     assert(accNet.IsStrash() && appNet.IsStrash() && mitNet.IsStrash());
     assert(accNet.IsPIOSame(appNet));
+    // release the miter of the previous round; the other buffers keep their capacity
+    net = NetMan();
+    isAppNode.clear();
+    targPos.clear();
     net.StartStrashNet();
     // copy accNet
     auto pNet = net.GetNet();
@@ -41,34 +46,30 @@ void PBDMan::BuildMit(const NetMan& accNet, NetMan& appNet, NetMan& mitNet) {
     int i = 0;
     Abc_NtkCleanCopy(pAccNet);
     Abc_AigConst1(pAccNet)->pCopy = Abc_AigConst1(pNet);
-    Abc_NtkForEachPi(pAccNet, pObj, i) {
+    Abc_NtkForEachPi(pAccNet, pObj, i)
         Abc_NtkDupObj(pNet, pObj, 0);
-        RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)) + "_acc");
-    }
-    Abc_AigForEachAnd(pAccNet, pObj, i) {
+    Abc_AigForEachAnd(pAccNet, pObj, i)
         pObj->pCopy = Abc_AigAnd((Abc_Aig_t *)pNet->pManFunc, Abc_ObjChild0Copy(pObj), Abc_ObjChild1Copy(pObj));
-        RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)) + "_acc");
-    }
-    // copy appNet
+    // copy appNet, keeping its PI and PO names; its nodes are recorded by ID, and each one drives a PO
     auto pAppNet = appNet.GetNet();
     Abc_NtkCleanCopy(pAppNet);
     Abc_AigConst1(pAppNet)->pCopy = Abc_AigConst1(pNet);
-    Abc_NtkForEachPi(pAppNet, pObj, i) {
-        Abc_NtkDupObj(pNet, pObj, 0);
-        RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)) + "_app");
-    }
+    Abc_NtkForEachPi(pAppNet, pObj, i)
+        Abc_NtkDupObj(pNet, pObj, 1);
     Abc_AigForEachAnd(pAppNet, pObj, i) {
         pObj->pCopy = Abc_AigAnd((Abc_Aig_t *)pNet->pManFunc, Abc_ObjChild0Copy(pObj), Abc_ObjChild1Copy(pObj));
-        RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)) + "_app");
-        auto pPo = Abc_NtkCreatePo(pNet);
         assert(!Abc_ObjIsComplement(pObj->pCopy));
-        Abc_ObjAddFanin(pPo, pObj->pCopy);
-        RenameAbcObj(pPo, string(Abc_ObjName(pObj)) + "_app");
+        int id = pObj->pCopy->Id;
+        if (id >= static_cast<int>(isAppNode.size()))
+            isAppNode.resize(id + 1, 0);
+        isAppNode[id] = 1;
+        net.CreatePo(pObj->pCopy);
     }
+    outPoBeg = net.GetPoNum();
+    nOutPo = appNet.GetPoNum();
     Abc_NtkForEachPo(pAppNet, pObj, i) {
-        Abc_NtkDupObj(pNet, pObj, 0);
+        Abc_NtkDupObj(pNet, pObj, 1);
         Abc_ObjAddFanin(pObj->pCopy, Abc_ObjChild0Copy(pObj));
-        RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)) + "_po");
     }
     // copy miter
     auto pMitNet = mitNet.GetNet();
@@ -87,9 +88,10 @@ void PBDMan::BuildMit(const NetMan& accNet, NetMan& appNet, NetMan& mitNet) {
         //     RenameAbcObj(pObj->pCopy, string(Abc_ObjName(pObj)) + "_mit");
     }
     Abc_NtkForEachPo(pMitNet, pObj, i)
-        Abc_NtkDupObj(pNet, pObj, 1);
+        Abc_NtkDupObj(pNet, pObj, 0);
     Abc_NtkForEachPo(pMitNet, pObj, i)
         Abc_ObjAddFanin(pObj->pCopy, Abc_ObjChild0Copy(pObj));
+    isAppNode.resize(net.GetIdMaxPlus1(), 0);
     // cout << "miter net" << endl;
     // net.PrintStat();
     // net.Print(true); cout << endl;
@@ -99,19 +101,30 @@ void PBDMan::BuildMit(const NetMan& accNet, NetMan& appNet, NetMan& mitNet) {
 void PBDMan::BuildPBD(double exactPBDPerc) {
     assert(net.IsStrash());
 
-    // update fanout information
+    // update fanout information, in flat tables indexed by the node IDs
     auto pNodes = net.CalcTopoOrd();
-    oldFos.resize(net.GetIdMaxPlus1());
-    appFos.resize(net.GetIdMaxPlus1());
+    int idMaxPlus1 = net.GetIdMaxPlus1();
+    oldFoBeg.assign(idMaxPlus1 + 1, 0);
+    appFoBeg.assign(idMaxPlus1 + 1, 0);
+    auto isAppFanout = [&](AbcObj* pFanout) {return !net.IsObjPo(pFanout) && isAppNode[pFanout->Id];};
     for (auto pNode: pNodes) {
-        for (int i = 0; i < net.GetFanoutNum(pNode); ++i)
-            oldFos[pNode->Id].emplace_back(net.GetFanout(pNode, i));
-        if (net.GetName(pNode).ends_with("_app")) {
-            for (int i = 0; i < net.GetFanoutNum(pNode); ++i) {
-                auto pFanout = net.GetFanout(pNode, i);
-                if (!net.IsObjPo(pFanout) && net.GetName(pFanout).ends_with("_app"))
-                    appFos[pNode->Id].emplace_back(pFanout);
-            }
+        oldFoBeg[pNode->Id + 1] = net.GetFanoutNum(pNode);
+        if (isAppNode[pNode->Id]) {
+            for (int i = 0; i < net.GetFanoutNum(pNode); ++i)
+                appFoBeg[pNode->Id + 1] += isAppFanout(net.GetFanout(pNode, i));
+        }
+    }
+    std::partial_sum(oldFoBeg.begin(), oldFoBeg.end(), oldFoBeg.begin());
+    std::partial_sum(appFoBeg.begin(), appFoBeg.end(), appFoBeg.begin());
+    oldFos.assign(oldFoBeg.back(), nullptr);
+    appFos.assign(appFoBeg.back(), nullptr);
+    for (auto pNode: pNodes) {
+        int iOld = oldFoBeg[pNode->Id], iApp = appFoBeg[pNode->Id];
+        for (int i = 0; i < net.GetFanoutNum(pNode); ++i) {
+            auto pFanout = net.GetFanout(pNode, i);
+            oldFos[iOld++] = pFanout;
+            if (isAppNode[pNode->Id] && isAppFanout(pFanout))
+                appFos[iApp++] = pFanout;
         }
     }
 
@@ -120,10 +133,9 @@ void PBDMan::BuildPBD(double exactPBDPerc) {
     int countNodes = 0;
     for (auto it = pNodes.rbegin(); it != pNodes.rend(); ++it) {
         auto pNode = *it;
-        if (!net.GetName(pNode).ends_with("_app"))
+        if (!isAppNode[pNode->Id])
             continue;
-        auto& pFanouts = appFos[pNode->Id];
-        int nFo = pFanouts.size();
+        int nFo = static_cast<int>(GetAppFos(pNode).size());
         if (!nFanouts.count(nFo))
             nFanouts[nFo] = 1;
         else
@@ -140,50 +152,84 @@ void PBDMan::BuildPBD(double exactPBDPerc) {
     cout << "#internal nodes = " << nodeIdAndFoNumb.size() << endl;
     cout << "#internal nodes using exact PBDs = " << nodeIdAndFoNumb.size() * exactPBDPerc << endl;
 
-    IntVect useAccPBD(net.GetIdMaxPlus1(), 0);
+    IntVect useAccPBD(idMaxPlus1, 0);
     for (int i = 0; i < nodeIdAndFoNumb.size() * exactPBDPerc; ++i)
         useAccPBD[nodeIdAndFoNumb[i].first] = 1;
 
+    // the nodes using exact PBDs, in the order of the construction; their TFOs only read the fanout tables, so they are collected in parallel, batch by batch
+    AbcObjVect exactNodes;
+    for (auto it = pNodes.rbegin(); it != pNodes.rend(); ++it) {
+        auto pNode = *it;
+        if (isAppNode[pNode->Id] && (GetAppFos(pNode).empty() || useAccPBD[pNode->Id]))
+            exactNodes.emplace_back(pNode);
+    }
+    int nJob = std::max(1, std::min(nThread, static_cast<int>(exactNodes.size())));
+    const int BATCH_PER_JOB = 4;
+    int batchSize = nJob * BATCH_PER_JOB;
+    std::vector<AbcObjVect> tfos(batchSize);
+    std::vector<std::vector<uint8_t>> visiteds(nJob, std::vector<uint8_t>(idMaxPlus1, 0));
+    int iExact = 0, batchBeg = 0, batchEnd = 0;
+    auto collNextBatch = [&]() {
+        batchBeg = batchEnd;
+        batchEnd = std::min(batchBeg + batchSize, static_cast<int>(exactNodes.size()));
+        auto collTFOs = [&](int iJob) {
+            for (int i = batchBeg + iJob; i < batchEnd; i += nJob)
+                CollTFO(exactNodes[i], visiteds[iJob], tfos[i - batchBeg]);
+        };
+        if (nJob > 1)
+            RunJobsInParallel(nJob, collTFOs);
+        else
+            collTFOs(0);
+    };
+
     // add PBD skeleton 
+    assert(net.GetPoNum() == outPoBeg + nOutPo + 1);
     auto pFPo = net.GetPo(net.GetPoNum() - 1);
     auto pF = net.GetFanin(pFPo, 0);
-    assert(string(Abc_ObjName(pFPo)) == "f");
+    IntVect node2Po(net.GetIdMaxPlus1(), -1);
+    for (int i = 0; i < outPoBeg; ++i)
+        node2Po[net.GetFanin(net.GetPo(i), 0)->Id] = i;
+    targPos.clear(); targPos.reserve(outPoBeg);
     auto pManFunc = (Abc_Aig_t *)(net.GetNet()->pManFunc);
     auto pConst1 = Abc_AigConst1(net.GetNet());
     auto pConst0 = Abc_ObjNot(pConst1);
-    unordered_map<AbcObj*, AbcObj*> n2DFN;
+    AbcObjVect n2DFN(idMaxPlus1, nullptr);
+    AbcObjVect old2New(idMaxPlus1, nullptr); // old2New[id], the copy of the old node id with the flipped node; only the original nodes are indexed
     for (auto it = pNodes.rbegin(); it != pNodes.rend(); ++it) {
         auto pNode = *it;
-        if (!net.GetName(pNode).ends_with("_app"))
+        if (!isAppNode[pNode->Id])
             continue;
-        auto& pFanouts = appFos[pNode->Id];
-        int nFo = pFanouts.size();
+        auto pFanouts = GetAppFos(pNode);
+        int nFo = static_cast<int>(pFanouts.size());
         AbcObj* pDFN = nullptr;
         if (nFo == 0 || useAccPBD[pNode->Id]) { // if pNode is a PO; or pNode is an internal node, and pNode uses accurate PBD
-            unordered_map<AbcObj*, AbcObj*> old2New;
-            old2New[pNode] = Abc_ObjNot(pNode);
-            auto tfo = GetTFO(pNode);
+            if (iExact == batchEnd)
+                collNextBatch();
+            assert(exactNodes[iExact] == pNode);
+            auto& tfo = tfos[iExact - batchBeg];
+            ++iExact;
+            auto getNew = [&](AbcObj* pOld) {return (pOld->Id < idMaxPlus1 && old2New[pOld->Id] != nullptr)? old2New[pOld->Id]: pOld;};
+            old2New[pNode->Id] = Abc_ObjNot(pNode);
             for (auto pTfoNode: tfo) {
-                auto fi0 = Abc_ObjFanin0(pTfoNode);
-                if (old2New.count(fi0))
-                    fi0 = old2New[fi0];
-                auto fi1 = Abc_ObjFanin1(pTfoNode);
-                if (old2New.count(fi1))
-                    fi1 = old2New[fi1];
-                old2New[pTfoNode] = Abc_AigAnd(pManFunc, Abc_ObjNotCond(fi0, Abc_ObjFaninC0(pTfoNode)), Abc_ObjNotCond(fi1, Abc_ObjFaninC1(pTfoNode)));
-                if (!Abc_ObjIsComplement(old2New[pTfoNode]))
-                    RenameAbcObj(old2New[pTfoNode], string(Abc_ObjName(pNode)) + "_tfo_" + string(Abc_ObjName(pTfoNode)) + "_tfo");
+                auto fi0 = getNew(Abc_ObjFanin0(pTfoNode));
+                auto fi1 = getNew(Abc_ObjFanin1(pTfoNode));
+                old2New[pTfoNode->Id] = Abc_AigAnd(pManFunc, Abc_ObjNotCond(fi0, Abc_ObjFaninC0(pTfoNode)), Abc_ObjNotCond(fi1, Abc_ObjFaninC1(pTfoNode)));
             }
-            if (!old2New.count(pF)) {
+            if (old2New[pF->Id] == nullptr) {
                 cout << Abc_ObjName(pNode) << endl;
                 assert(0);
             }
-            pDFN = Abc_AigXor(pManFunc, pF, old2New[pF]);
+            pDFN = Abc_AigXor(pManFunc, pF, old2New[pF->Id]);
+            // reset the copies, and release the TFO
+            old2New[pNode->Id] = nullptr;
+            for (auto pTfoNode: tfo)
+                old2New[pTfoNode->Id] = nullptr;
+            AbcObjVect().swap(tfo);
         }
         else if (nFo == 1)  { // if pNode is an internal node, and pNode uses approximate PBD, and #fanout = 1
             assert(pFanouts[0] != nullptr && !Abc_ObjIsPo(pFanouts[0]));
-            assert(n2DFN.count(pFanouts[0]));
-            pDFN = n2DFN[pFanouts[0]];
+            assert(n2DFN[pFanouts[0]->Id] != nullptr);
+            pDFN = n2DFN[pFanouts[0]->Id];
         }
         else { // if pNode is an internal node, and pNode uses approximate PBD, and #fanout > 1
             AbcObjVect dVNs(nFo, nullptr);
@@ -191,8 +237,8 @@ void PBDMan::BuildPBD(double exactPBDPerc) {
                 dVNs[i] = GetLocPBD(pFanouts[i], pNode);
             AbcObjVect dFVs(nFo, nullptr);
             for (int i = 0; i < nFo; ++i) {
-                assert(n2DFN.count(pFanouts[i]));
-                dFVs[i] = n2DFN[pFanouts[i]];
+                assert(n2DFN[pFanouts[i]->Id] != nullptr);
+                dFVs[i] = n2DFN[pFanouts[i]->Id];
             }
             auto pPart0 = pConst0;
             AbcObjVect bets(nFo, nullptr);
@@ -210,10 +256,16 @@ void PBDMan::BuildPBD(double exactPBDPerc) {
                 pPart1 = Abc_AigOr(pManFunc, pPart1, bets[i]);
             pDFN = Abc_AigOr(pManFunc, pPart0, Abc_ObjNot(pPart1));
         }
-        n2DFN[pNode] = pDFN;
-        net.CreatePo(pDFN, ("dF_" + net.GetName(pNode)).c_str());
+        n2DFN[pNode->Id] = pDFN;
+        assert(node2Po[pNode->Id] != -1);
+        targPos.emplace_back(node2Po[pNode->Id], net.GetPoNum());
+        net.CreatePo(pDFN);
     }
+    // the PBD POs shift by one after the miter PO is deleted
     Abc_NtkDeleteObj(pFPo);
+    for (auto& targPo: targPos)
+        --targPo.second;
+    std::sort(targPos.begin(), targPos.end());
 
     // merge PIs
     int nPo = net.GetPiNum() / 2;
@@ -237,20 +289,60 @@ void PBDMan::BuildPBD(double exactPBDPerc) {
 }
 
 
+/**
+ * @brief Simulate the miter with the kept random input patterns, and save the PO patterns
+ * @brief The PO and PI indices survive resynthesis, so the saved patterns serve all checks of the round
+ * @brief The simulator is kept across rounds, so its pattern buffers are allocated once
+ * 
+ * @retval piPatts   the PI patterns, generated in the first round
+ * @retval poPatts   the PO patterns
+ * @return void
+ */
+void PBDMan::SimPos() {
+    if (pSmlt == nullptr)
+        pSmlt = std::make_shared<Simulator>(net, 19960822, 1 << 16);
+    else
+        pSmlt->Rebind(net);
+    auto& smlt = *pSmlt;
+    int nPi = net.GetPiNum(), nFrame = smlt.GetFrameNumb();
+    if (!piPatts.IsShape(nPi, nFrame)) {
+        smlt.GenInpUnifFast();
+        piPatts.Resize(nPi, nFrame);
+        for (int i = 0; i < nPi; ++i)
+            piPatts[i].Assign(smlt.GetDat(net.GetPiId(i)));
+    }
+    else {
+        for (int i = 0; i < nPi; ++i)
+            smlt.SetInp(i, piPatts[i]);
+        smlt.InitConstNodes();
+    }
+    smlt.UpdNodeAndPoPatts();
+    poPatts.Resize(net.GetPoNum(), nFrame);
+    for (int i = 0; i < net.GetPoNum(); ++i)
+        poPatts[i].Assign(smlt.GetDat(net.GetPo(i)->Id));
+}
+
+
 int PBDMan::Synth(int fSASIMI) {
+    // the candidates are recorded by PO indices, which are kept by resynthesis
+    vector<std::tuple<int, int, bool>> verPos;   // (PO of the check, PO of the target node, whether to replace by constant 1)
+    struct SaPo {
+        int saPo;    // PO of the check
+        int nPo;     // PO of the target node
+        int cIdx;    // PI or PO index of the substitute
+        bool fCPi;   // whether the substitute is a PI
+        bool fInv;   // whether to substitute by the inverted signal
+    };
+    vector<SaPo> saPos;
     {
     // test trivial cases, $\Delta f(n) \equiv 0$
     auto pNet = net.GetNet();
     auto pManFunc = (Abc_Aig_t *)(pNet->pManFunc);
     auto pConst1 = Abc_AigConst1(net.GetNet());
     auto pConst0 = Abc_ObjNot(pConst1);
-    for (int i = 0; i < net.GetPoNum(); ++i) {
-        auto pN = net.GetPo(i);
-        auto name = net.GetName(pN);
-        if (!name.ends_with("_app") || name.starts_with("dF_"))
-            continue;
-        auto pDFN = Abc_NtkFindCo(pNet, const_cast<char*>(("dF_" + net.GetName(pN)).c_str()));
-        assert(pDFN != nullptr);
+    for (const auto& [nPo, dFPo]: targPos) {
+        auto pN = net.GetPo(nPo);
+        auto pDFN = net.GetPo(dFPo);
         auto pDFNDriv = Abc_ObjFanin0(pDFN); assert(!Abc_ObjIsComplement(pDFNDriv));
         if (pDFNDriv == pConst1 && Abc_ObjFaninC0(pDFN)) {
             auto pNDriv = Abc_ObjFanin0(pN); assert(!Abc_ObjIsComplement(pNDriv));
@@ -262,42 +354,31 @@ int PBDMan::Synth(int fSASIMI) {
     }
 
     {
-    // get target nodes for constant
+    // test constant by simulation
     auto pNet = net.GetNet();
     auto pManFunc = (Abc_Aig_t *)(pNet->pManFunc);
-    vector<std::pair<AbcObj*, AbcObj*>> targNodes; targNodes.reserve(net.GetPoNum() / 2);
-    for (int i = 0; i < net.GetPoNum(); ++i) {
-        auto pN = net.GetPo(i);
-        auto name = net.GetName(pN);
-        if (!name.ends_with("_app") || name.starts_with("dF_"))
-            continue;
-        auto pDFN = Abc_NtkFindCo(pNet, const_cast<char*>(("dF_" + net.GetName(pN)).c_str())); assert(pDFN != nullptr);
-        auto pDFNDriv = Abc_ObjFanin0(pDFN); assert(!Abc_ObjIsComplement(pDFNDriv));
-        targNodes.emplace_back(pN, pDFN);
-    }
-    // test constant by simulation
-    Simulator smlt(net, 19960822, 1 << 16);
-    smlt.GenInpUnifFast();
-    smlt.UpdNodeAndPoPatts();
-    for (auto& targNode: targNodes) {
-        auto pN = targNode.first, pDFN = targNode.second;
+    SimPos();
+    for (const auto& [nPo, dFPo]: targPos) {
+        auto pN = net.GetPo(nPo), pDFN = net.GetPo(dFPo);
         auto pNDriv = Abc_ObjFanin0(pN); assert(!Abc_ObjIsComplement(pNDriv));
         auto pDFNDriv = Abc_ObjFanin0(pDFN); assert(!Abc_ObjIsComplement(pDFNDriv));
-        const auto &nDat = smlt.GetDat(pN->Id), dFNDat = smlt.GetDat(pDFN->Id);
+        ConstBitSpan nDat = poPatts[nPo], dFNDat = poPatts[dFPo];
         // try constant
-        if ((nDat & dFNDat).none()) {
+        if (IsAndNone(nDat, false, dFNDat)) {
             auto pFi0 = Abc_ObjFaninC0(pN)? Abc_ObjNot(pNDriv): pNDriv;
             auto pFi1 = Abc_ObjFaninC0(pDFN)? Abc_ObjNot(pDFNDriv): pDFNDriv;
             auto pDFS = Abc_AigAnd(pManFunc, pFi0, pFi1);
             cout << Abc_ObjName(pN) << ", const0 (simulation)" << endl;
-            net.CreatePo(pDFS, ("ver_" + net.GetName(pDFN) + "*const0").c_str());
+            verPos.emplace_back(net.GetPoNum(), nPo, false);
+            net.CreatePo(pDFS);
         }
-        else if ((~nDat & dFNDat).none()) {
+        else if (IsAndNone(nDat, true, dFNDat)) {
             auto pFi0 = Abc_ObjFaninC0(pN)? pNDriv: Abc_ObjNot(pNDriv);
             auto pFi1 = Abc_ObjFaninC0(pDFN)? Abc_ObjNot(pDFNDriv): pDFNDriv;
             auto pDFS = Abc_AigAnd(pManFunc, pFi0, pFi1);
             cout << Abc_ObjName(pN) << ", const1 (simulation)" << endl;
-            net.CreatePo(pDFS, ("ver_" + net.GetName(pDFN) + "*const1").c_str());
+            verPos.emplace_back(net.GetPoNum(), nPo, true);
+            net.CreatePo(pDFS);
         }
     }
     }
@@ -309,28 +390,22 @@ int PBDMan::Synth(int fSASIMI) {
     auto pManFunc = (Abc_Aig_t *)(pNet->pManFunc);
     auto pConst1 = Abc_AigConst1(net.GetNet());
     auto pConst0 = Abc_ObjNot(pConst1);
-    for (int i = 0; i < net.GetPoNum(); ++i) {
-        auto pDFS = net.GetPo(i);
-        auto name = net.GetName(pDFS);
-        if (!name.starts_with("ver_"))
-            continue;
+    for (const auto& [verPo, nPo, fConst1]: verPos) {
+        auto pDFS = net.GetPo(verPo);
         auto pDFSDriv = Abc_ObjFanin0(pDFS); assert(!Abc_ObjIsComplement(pDFSDriv));
         if (!(pDFSDriv == pConst1 && Abc_ObjFaninC0(pDFS)))
             continue;
         net.PrintObj(pDFS, true);
-        auto pos0 = name.find("ver_dF_"), pos1 = name.find("*");
-        assert(pos0 != std::string::npos && pos1 != std::string::npos);
-        auto nName = name.substr(pos0 + 7, pos1 - pos0 - 7);
-        auto pN = Abc_NtkFindCo(pNet, const_cast<char*>(nName.c_str())); assert(pN != nullptr);
+        auto pN = net.GetPo(nPo);
         auto pNDriv = Abc_ObjFanin0(pN); assert(!Abc_ObjIsComplement(pNDriv));
-        if (name.ends_with("const0")) {
+        if (!fConst1) {
             cout << Abc_ObjName(pN) << ", replace it by constant 0" << endl;
             if (!Abc_ObjFaninC0(pN))
                 Abc_AigReplace(pManFunc, pNDriv, pConst0, 0);
             else
                 Abc_AigReplace(pManFunc, pNDriv, pConst1, 0);
         }
-        else if (name.ends_with("const1")) {
+        else {
             cout << Abc_ObjName(pN) << ", replace it by constant 1" << endl;
             if (!Abc_ObjFaninC0(pN))
                 Abc_AigReplace(pManFunc, pNDriv, pConst1, 0);
@@ -344,86 +419,50 @@ int PBDMan::Synth(int fSASIMI) {
     if (!fSASIMI)
         return -1;
     {
-    // get target nodes for SASIMI
+    // get target nodes for SASIMI; the substitutes are the copied approximate nodes (by PO index) and the PIs, which all come from the approximate network after merging
     auto pNet = net.GetNet();
     auto pManFunc = (Abc_Aig_t *)(pNet->pManFunc);
-    vector<std::pair<AbcObj*, AbcObj*>> targNodes; targNodes.reserve(net.GetPoNum() / 2);
-    AbcObjVect subNodes; subNodes.reserve(net.GetPoNum() / 2);
-    for (int i = 0; i < net.GetPoNum(); ++i) {
-        auto pN = net.GetPo(i);
-        auto name = net.GetName(pN);
-        if (!name.ends_with("_app") || name.starts_with("dF_"))
-            continue;
-        auto pDFN = Abc_NtkFindCo(pNet, const_cast<char*>(("dF_" + net.GetName(pN)).c_str())); assert(pDFN != nullptr);
-        auto pDFNDriv = Abc_ObjFanin0(pDFN); assert(!Abc_ObjIsComplement(pDFNDriv));
-        targNodes.emplace_back(pN, pDFN);
-        subNodes.emplace_back(pN);
-    }
-    for (int i = 0; i < net.GetPiNum(); ++i) {
-        if (net.GetPiName(i).ends_with("_app"))
-            subNodes.emplace_back(net.GetPi(i));
-    }
-    // test SASIMI by simulation
+    // test SASIMI by simulation, reusing the PO patterns of the constant test
     net.GetLev();
-    Simulator smlt(net, 19960822, 1 << 16);
-    smlt.GenInpUnifFast();
-    smlt.UpdNodeAndPoPatts();
-    boost::timer::progress_display pd(targNodes.size());
+    boost::timer::progress_display pd(targPos.size());
     const int LAC_LIMIT_ON_NODE = 64;
     // const int LAC_LIMIT_ON_NODE = 16;
     int nLacs = 0;
-    for (const auto& targNode: targNodes) {
-        auto pN = targNode.first, pDFN = targNode.second;
+    int nSub = static_cast<int>(targPos.size()) + net.GetPiNum();
+    for (const auto& [nPo, dFPo]: targPos) {
+        auto pN = net.GetPo(nPo), pDFN = net.GetPo(dFPo);
         auto pNDriv = Abc_ObjFanin0(pN), pDFNDriv = Abc_ObjFanin0(pDFN);
-        const auto &nDat = smlt.GetDat(pN->Id), dFNDat = smlt.GetDat(pDFN->Id);
+        ConstBitSpan nDat = poPatts[nPo], dFNDat = poPatts[dFPo];
         int lacCount = 0;
-        for (const auto& pC: subNodes) {
-            if (Abc_ObjIsPo(pC)) {
+        for (int iSub = 0; iSub < nSub; ++iSub) {
+            bool fCPi = iSub >= static_cast<int>(targPos.size());
+            int cIdx = fCPi? iSub - static_cast<int>(targPos.size()): targPos[iSub].first;
+            auto pC = fCPi? net.GetPi(cIdx): net.GetPo(cIdx);
+            if (!fCPi) {
                 auto pCDriv = Abc_ObjFanin0(pC);
                 if (pCDriv->Level > pNDriv->Level || pCDriv == pNDriv)
                     continue;
             }
-            else
-                assert(Abc_ObjIsPi(pC));
-            const auto &cDat = smlt.GetDat(pC->Id);
-            if (((nDat ^ cDat) & dFNDat).none()) {
-                // cout << pN << "," << pC << " buf (simulation)" << endl;
-                AbcObj* pFi0 = Abc_ObjFaninC0(pN)? Abc_ObjNot(pNDriv): pNDriv;
-                AbcObj* pFi1 = nullptr;
-                if (Abc_ObjIsPo(pC)) {
-                    auto pCDriv = Abc_ObjFanin0(pC);
-                    pFi1 = Abc_ObjFaninC0(pC)? Abc_ObjNot(pCDriv): pCDriv;
-                }
-                else if (Abc_ObjIsPi(pC))
-                    pFi1 = pC;
-                else
-                    assert(0);
-                AbcObj* pFi2 = Abc_ObjFaninC0(pDFN)? Abc_ObjNot(pDFNDriv): pDFNDriv;
-                auto pXor = Abc_AigXor(pManFunc, pFi0, pFi1);
-                auto pDFS = Abc_AigAnd(pManFunc, pXor, pFi2);
-                net.CreatePo(pDFS, ("sab_" + net.GetName(pDFN) + "*" + net.GetName(pC)).c_str());
-                ++lacCount;
-                ++nLacs;
-            }
-            else if (((nDat ^ ~cDat) & dFNDat).none()) {
-                // cout << pN << "," << pC << " inv (simulation)" << endl;
-                AbcObj* pFi0 = Abc_ObjFaninC0(pN)? Abc_ObjNot(pNDriv): pNDriv;
-                AbcObj* pFi1 = nullptr;
-                if (Abc_ObjIsPo(pC)) {
-                    auto pCDriv = Abc_ObjFanin0(pC);
-                    pFi1 = Abc_ObjFaninC0(pC)? pCDriv: Abc_ObjNot(pCDriv);
-                }
-                else if (Abc_ObjIsPi(pC))
-                    pFi1 = Abc_ObjNot(pC);
-                else
-                    assert(0);
-                AbcObj* pFi2 = Abc_ObjFaninC0(pDFN)? Abc_ObjNot(pDFNDriv): pDFNDriv;
-                auto pXor = Abc_AigXor(pManFunc, pFi0, pFi1);
-                auto pDFS = Abc_AigAnd(pManFunc, pXor, pFi2);
-                net.CreatePo(pDFS, ("sai_" + net.GetName(pDFN) + "*" + net.GetName(pC)).c_str());
-                ++lacCount;
-                ++nLacs;
+            ConstBitSpan cDat = fCPi? piPatts[cIdx]: poPatts[cIdx];
+            bool fBuf = IsXorAndNone(nDat, cDat, false, dFNDat);
+            if (!fBuf && !IsXorAndNone(nDat, cDat, true, dFNDat))
+                continue;
+            // cout << pN << "," << pC << (fBuf? " buf": " inv") << " (simulation)" << endl;
+            AbcObj* pFi0 = Abc_ObjFaninC0(pN)? Abc_ObjNot(pNDriv): pNDriv;
+            AbcObj* pFi1 = nullptr;
+            if (!fCPi) {
+                auto pCDriv = Abc_ObjFanin0(pC);
+                pFi1 = Abc_ObjNotCond(pCDriv, Abc_ObjFaninC0(pC) == fBuf);
             }
+            else
+                pFi1 = Abc_ObjNotCond(pC, !fBuf);
+            AbcObj* pFi2 = Abc_ObjFaninC0(pDFN)? Abc_ObjNot(pDFNDriv): pDFNDriv;
+            auto pXor = Abc_AigXor(pManFunc, pFi0, pFi1);
+            auto pDFS = Abc_AigAnd(pManFunc, pXor, pFi2);
+            saPos.push_back(SaPo{net.GetPoNum(), nPo, cIdx, fCPi, !fBuf});
+            net.CreatePo(pDFS);
+            ++lacCount;
+            ++nLacs;
             if (lacCount > LAC_LIMIT_ON_NODE)
                 break;
         }
@@ -438,63 +477,19 @@ int PBDMan::Synth(int fSASIMI) {
     auto pNet = net.GetNet();
     auto pManFunc = (Abc_Aig_t *)(pNet->pManFunc);
     auto pConst1 = Abc_AigConst1(net.GetNet());
-    for (int i = 0; i < net.GetPoNum(); ++i) {
-        auto pDFS = net.GetPo(i);
-        auto name = net.GetName(pDFS);
-        if (!name.starts_with("sa"))
-            continue;
+    for (const auto& saPo: saPos) {
+        auto pDFS = net.GetPo(saPo.saPo);
         auto pDFSDriv = Abc_ObjFanin0(pDFS); assert(!Abc_ObjIsComplement(pDFSDriv));
         if (!(pDFSDriv == pConst1 && Abc_ObjFaninC0(pDFS)))
             continue;
         net.PrintObj(pDFS, true);
-        auto pos0 = name.find("sa"), pos1 = name.find("*");
-        assert(pos0 != std::string::npos && pos1 != std::string::npos);
-        auto nName = name.substr(pos0 + 7, pos1 - pos0 - 7);
-        auto pN = Abc_NtkFindCo(pNet, const_cast<char*>(nName.c_str())); assert(pN != nullptr);
+        auto pN = net.GetPo(saPo.nPo);
         auto pNDriv = Abc_ObjFanin0(pN); assert(!Abc_ObjIsComplement(pNDriv));
-        auto cName = name.substr(pos1 + 1);
-        auto pC = Abc_NtkFindCo(pNet, const_cast<char*>(cName.c_str()));
-        if (pC == nullptr) pC = Abc_NtkFindCi(pNet, const_cast<char*>(cName.c_str())); 
-        assert(pC != nullptr);
+        auto pC = saPo.fCPi? net.GetPi(saPo.cIdx): net.GetPo(saPo.cIdx);
         cout << Abc_ObjName(pN) << "," << Abc_ObjName(pC) << endl;
-        if (name.starts_with("sab")) {
-            if (Abc_ObjIsPi(pC)) {
-                if (!Abc_ObjFaninC0(pN))
-                    Abc_AigReplace(pManFunc, pNDriv, pC, 0);
-                else
-                    Abc_AigReplace(pManFunc, pNDriv, Abc_ObjNot(pC), 0);
-            }
-            else if (Abc_ObjIsPo(pC)) {
-                auto pCDriv = Abc_ObjFanin0(pC);
-                auto pSub = Abc_ObjFaninC0(pC)? Abc_ObjNot(pCDriv): pCDriv;
-                if (!Abc_ObjFaninC0(pN))
-                    Abc_AigReplace(pManFunc, pNDriv, pSub, 0);
-                else
-                    Abc_AigReplace(pManFunc, pNDriv, Abc_ObjNot(pSub), 0);
-            }
-            else
-                assert(0);
-        }
-        else if (name.starts_with("sai")) {
-            if (Abc_ObjIsPi(pC)) {
-                if (!Abc_ObjFaninC0(pN))
-                    Abc_AigReplace(pManFunc, pNDriv, Abc_ObjNot(pC), 0);
-                else
-                    Abc_AigReplace(pManFunc, pNDriv, pC, 0);
-            }
-            else if (Abc_ObjIsPo(pC)) {
-                auto pCDriv = Abc_ObjFanin0(pC);
-                auto pSub = Abc_ObjFaninC0(pC)? pCDriv: Abc_ObjNot(pCDriv);
-                if (!Abc_ObjFaninC0(pN))
-                    Abc_AigReplace(pManFunc, pNDriv, pSub, 0);
-                else
-                    Abc_AigReplace(pManFunc, pNDriv, Abc_ObjNot(pSub), 0);
-            }
-            else
-                assert(0);
-        }
-        else
-            assert(0);
+        AbcObj* pSub = saPo.fCPi? pC: Abc_ObjNotCond(Abc_ObjFanin0(pC), Abc_ObjFaninC0(pC));
+        pSub = Abc_ObjNotCond(pSub, saPo.fInv != static_cast<bool>(Abc_ObjFaninC0(pN)));
+        Abc_AigReplace(pManFunc, pNDriv, pSub, 0);
         return 1;
     }
     }
@@ -504,56 +499,52 @@ int PBDMan::Synth(int fSASIMI) {
 
 
 NetMan PBDMan::PostProc() {
+    // keep the POs copying the approximate network; they and the PIs still carry the names of the approximate network
     AbcObjVect delPos; delPos.reserve(net.GetPoNum());
     for (int i = 0; i < net.GetPoNum(); ++i) {
-        auto name = net.GetPoName(i);
-        if (!name.ends_with("_po") || name.starts_with("dF_") || name.starts_with("ver_") || name.starts_with("sa"))
+        if (i < outPoBeg || i >= outPoBeg + nOutPo)
             delPos.emplace_back(net.GetPo(i));
     }
     for (auto delPo: delPos)
         Abc_NtkDeleteObj(delPo);
-    for (int i = 0; i < net.GetPoNum(); ++i) {
-        auto name = net.GetPoName(i);
-        auto loc = name.find("_po");
-        assert(loc != name.npos);
-        name = name.erase(loc);
-        RenameAbcObj(net.GetPo(i), name);
-    }
-    for (int i = 0; i < net.GetPiNum(); ++i) {
-        auto name = net.GetPiName(i);
-        auto loc = name.find("_app");
-        assert(loc != name.npos);
-        name = name.erase(loc);
-        RenameAbcObj(net.GetPi(i), name);
-    }
+    assert(net.GetPoNum() == nOutPo);
     cout << "current approximate net" << endl;
     net.Synth(ORIENT::DELAY);
     // net.SATSweep();
     net.PrintStat();
-    return net;
+    // the miter is rebuilt in the next round, so the network is moved out
+    return std::move(net);
 }
 
 
-AbcObjVect PBDMan::GetTFO(AbcObj* pObj) const {
-    AbcObjVect nodes;
-    nodes.reserve(net.GetNodeNum());
-    net.SetNetNotTrav();
-    for (auto pFanout: oldFos[pObj->Id]) {
-        if (!net.GetObjTrav(pFanout))
-            GetTFORec(pFanout, nodes);
+/**
+ * @brief Collect the TFO nodes of a node in topological order over the fanout tables
+ * @brief It only reads the network, so different threads can collect TFOs with their own marks
+ * 
+ * @param pObj      the node
+ * @param visited   the visited marks, all zero; they are reset before returning
+ * @retval nodes    the TFO nodes, excluding the node itself
+ * @return void
+ */
+void PBDMan::CollTFO(AbcObj* pObj, std::vector<uint8_t>& visited, AbcObjVect& nodes) const {
+    nodes.clear();
+    for (auto pFanout: GetOldFos(pObj)) {
+        if (!visited[pFanout->Id])
+            CollTFORec(pFanout, visited, nodes);
     }
+    for (auto pNode: nodes)
+        visited[pNode->Id] = 0;
     reverse(nodes.begin(), nodes.end());
-    return nodes;
 }
 
 
-void PBDMan::GetTFORec(AbcObj* pObj, AbcObjVect& nodes) const {
+void PBDMan::CollTFORec(AbcObj* pObj, std::vector<uint8_t>& visited, AbcObjVect& nodes) const {
     if (!net.IsNode(pObj))
         return;
-    net.SetObjTrav(pObj);
-    for (auto pFanout: oldFos[pObj->Id]) {
-        if (!net.GetObjTrav(pFanout))
-            GetTFORec(pFanout, nodes);
+    visited[pObj->Id] = 1;
+    for (auto pFanout: GetOldFos(pObj)) {
+        if (!visited[pFanout->Id])
+            CollTFORec(pFanout, visited, nodes);
     }
     nodes.emplace_back(pObj);
 }
@@ -10,22 +10,45 @@
 #pragma once
 
 
+#include <memory>
 #include "my_abc.h"
+#include "bit_mat.h"
 // #include "lac.h"
 // #include "cut.h"
 
+class Simulator;
+
 namespace mecals_v1 {
+/**
+ * @brief PBD manager of MECALS 1.0, kept across rounds
+ * @brief The fanout tables are flat; the random input patterns are generated once, and the simulator and its buffers are reused by each round
+ */
 class PBDMan {
 private:
     NetMan net;
-    std::vector<AbcObjVect> oldFos;
-    std::vector<AbcObjVect> appFos;
+    IntVect oldFoBeg;                 // oldFos[oldFoBeg[id], oldFoBeg[id + 1]), fanouts of the miter node id
+    AbcObjVect oldFos;
+    IntVect appFoBeg;                 // appFos[appFoBeg[id], appFoBeg[id + 1]), fanouts of the copied approximate node id, which are also copied approximate nodes
+    AbcObjVect appFos;
     AbcObjVect oneCuts;
     std::vector<AbcObjVect> cutNtks;
     IntVect topoIds;
     DblVect flows;
+    std::vector<uint8_t> isAppNode;   // isAppNode[id], whether the miter node id copies a node of the approximate network; valid before the miter is resynthesized
+    std::vector<IntPair> targPos;     // pairs of PO indices, (PO of a copied approximate node, PO of its partial Boolean difference)
+    int outPoBeg;                     // index of the first PO copying a PO of the approximate network
+    int nOutPo;                       // number of POs of the approximate network
+    int nThread;                      // number of threads for collecting the TFOs of the nodes using exact PBDs
+    BitMat piPatts;                   // piPatts[i], random patterns of the i-th PI, generated in the first round
+    BitMat poPatts;                   // poPatts[i], patterns of the i-th PO in the current round, kept across resynthesis
+    std::shared_ptr<Simulator> pSmlt; // the simulator of the miter, rebound to the miter of each round
+
+    void SimPos();
+    void CollTFO(AbcObj* pObj, std::vector<uint8_t>& visited, AbcObjVect& nodes) const;
+    void CollTFORec(AbcObj* pObj, std::vector<uint8_t>& visited, AbcObjVect& nodes) const;
+
 public:
-    explicit PBDMan() = default;
+    explicit PBDMan(int _nThread = 1): outPoBeg(0), nOutPo(0), nThread(_nThread) {}
     ~PBDMan() = default;
     PBDMan(const PBDMan &) = delete;
     PBDMan(PBDMan &&) = delete;
@@ -38,9 +61,10 @@ public:
     // int CheckWithSweepSASIMI(std::vector<std::pair<std::string, std::string>> & lacNames);
     // std::vector<std::pair<std::string, std::string>> CheckWithSATSASIMI();
     NetMan PostProc();
-    AbcObjVect GetTFO(AbcObj* pObj) const;
-    void GetTFORec(AbcObj* pObj, AbcObjVect& nodes) const;
     AbcObj* GetLocPBD(AbcObj* pV, AbcObj* pU);
+
+    inline std::span<AbcObj* const> GetOldFos(AbcObj* pObj) const {return std::span<AbcObj* const>(oldFos.data() + oldFoBeg[pObj->Id], oldFoBeg[pObj->Id + 1] - oldFoBeg[pObj->Id]);}
+    inline std::span<AbcObj* const> GetAppFos(AbcObj* pObj) const {return std::span<AbcObj* const>(appFos.data() + appFoBeg[pObj->Id], appFoBeg[pObj->Id + 1] - appFoBeg[pObj->Id]);}
 };
 
 
@@ -0,0 +1,116 @@
+/**
+ * @file prof.cc
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief Scoped timers, counters, and per-round profiling report
+ *
+ */
+#include <fstream>
+#include "prof.h"
+
+
+using namespace std;
+
+
+static const array<const char*, N_PROF_PHASE> PHASE_NAMES = {"lac_gen", "rough_sim", "fine_sim", "miter_build", "cnf_map", "sat_solve", "cex_check", "resyn"};
+static const array<const char*, N_PROF_CNT> CNT_NAMES = {"n_lac_gen", "n_lac_check", "n_lac_apply", "n_cex_reject", "n_sat", "n_unsat", "n_undef", "n_conflict"};
+
+
+/**
+ * @brief Constructor of the profiler
+ */
+Profiler::Profiler(): fQuiet(false) {
+    for (auto& ns: phaseNs)
+        ns.store(0);
+    for (auto& cnt: cnts)
+        cnt.store(0);
+    totPhaseNs.fill(0);
+    totCnts.fill(0);
+}
+
+
+/**
+ * @brief Get the process-wide profiler
+ *
+ * @return Profiler&  the profiler
+ */
+Profiler& Profiler::Get() {
+    static Profiler prof;
+    return prof;
+}
+
+
+/**
+ * @brief Configure the profiler; the trace file is truncated when it is set, so the runs of one process share the trace
+ *
+ * @param _fQuiet      whether to suppress the per-LAC console output
+ * @param _tracePath   path of the JSON Lines trace; empty if no trace
+ * @return void
+ */
+void Profiler::Config(bool _fQuiet, const string& _tracePath) {
+    lock_guard<mutex> lock(mtx);
+    fQuiet = _fQuiet;
+    if (tracePath == _tracePath)
+        return;
+    tracePath = _tracePath;
+    if (!tracePath.empty()) {
+        ofstream fout(tracePath, ios::trunc);
+        if (!fout) {
+            fmt::print(stderr, "Error: cannot open the profiling trace {}\n", tracePath);
+            assert(0);
+        }
+    }
+}
+
+
+/**
+ * @brief End a round: print its summary, append it to the trace, and reset the round statistics
+ *
+ * @param round   the round
+ * @param tag     the tag of the round, e.g., the LAC type
+ * @return void
+ */
+void Profiler::EndRound(int round, const string& tag) {
+    lock_guard<mutex> lock(mtx);
+    array<ll, N_PROF_PHASE> ns;
+    array<ll, N_PROF_CNT> vals;
+    for (int i = 0; i < N_PROF_PHASE; ++i) {
+        ns[i] = phaseNs[i].exchange(0);
+        totPhaseNs[i] += ns[i];
+    }
+    for (int i = 0; i < N_PROF_CNT; ++i) {
+        vals[i] = cnts[i].exchange(0);
+        totCnts[i] += vals[i];
+    }
+    // console summary
+    string line = fmt::format("profile of round {} ({}):", round, tag);
+    for (int i = 0; i < N_PROF_PHASE; ++i)
+        line += fmt::format(" {} = {}ms,", PHASE_NAMES[i], ns[i] / 1000000);
+    for (int i = 0; i < N_PROF_CNT; ++i)
+        line += fmt::format(" {} = {}{}", CNT_NAMES[i], vals[i], i + 1 < N_PROF_CNT? ",": "");
+    fmt::print("{}\n", line);
+    // trace
+    if (tracePath.empty())
+        return;
+    string rec = fmt::format("{{\"round\": {}, \"tag\": \"{}\"", round, tag);
+    for (int i = 0; i < N_PROF_PHASE; ++i)
+        rec += fmt::format(", \"{}_ms\": {:.3f}", PHASE_NAMES[i], ns[i] / 1e6);
+    for (int i = 0; i < N_PROF_CNT; ++i)
+        rec += fmt::format(", \"{}\": {}", CNT_NAMES[i], vals[i]);
+    rec += "}\n";
+    ofstream fout(tracePath, ios::app);
+    fout << rec;
+}
+
+
+/**
+ * @brief Print the statistics over all rounds, including the phases outside of the rounds, e.g., the final resynthesis
+ *
+ * @return void
+ */
+void Profiler::PrintTotal() const {
+    fmt::print("profile of all rounds:\n");
+    for (int i = 0; i < N_PROF_PHASE; ++i)
+        fmt::print("  {:<12} {:>10}ms\n", PHASE_NAMES[i], (totPhaseNs[i] + phaseNs[i].load()) / 1000000);
+    for (int i = 0; i < N_PROF_CNT; ++i)
+        fmt::print("  {:<12} {:>10}\n", CNT_NAMES[i], totCnts[i] + cnts[i].load());
+}
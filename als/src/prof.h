@@ -0,0 +1,113 @@
+/**
+ * @file prof.h
+ * @author Chang Meng (chang.meng@epfl.ch)
+ * @brief Scoped timers, counters, and per-round profiling report
+ *
+ */
+#pragma once
+
+
+#include "header.h"
+
+
+/**
+ * @brief Profiled phases of the ALS flow
+ */
+enum class PROF_PHASE {
+    LAC_GEN, ROUGH_SIM, FINE_SIM, MITER_BUILD, CNF_MAP, SAT_SOLVE, CEX_CHECK, RESYN
+};
+const int N_PROF_PHASE = 8;
+
+
+/**
+ * @brief Profiled counters of the ALS flow
+ */
+enum class PROF_CNT {
+    LAC_GEN, LAC_CHECK, LAC_APPLY, CEX_REJECT, SAT_SAT, SAT_UNSAT, SAT_UNDEF, SAT_CONFL
+};
+const int N_PROF_CNT = 8;
+
+
+/**
+ * @brief Process-wide profiler
+ * @brief The phase times and the counters are accumulated with atomics, so the worker threads can report to it directly
+ * @brief Each round is summarized on the console and, if a trace path is set, appended to the trace file as one JSON line
+ */
+class Profiler {
+private:
+    std::array<std::atomic<ll>, N_PROF_PHASE> phaseNs;   // phaseNs[i], time of the i-th phase in the current round, in nanoseconds
+    std::array<std::atomic<ll>, N_PROF_CNT> cnts;        // cnts[i], value of the i-th counter in the current round
+    std::array<ll, N_PROF_PHASE> totPhaseNs;             // totPhaseNs[i], time of the i-th phase over all rounds
+    std::array<ll, N_PROF_CNT> totCnts;                  // totCnts[i], value of the i-th counter over all rounds
+    bool fQuiet;                                         // whether to suppress the per-LAC console output
+    std::string tracePath;                               // path of the JSON Lines trace; empty if no trace
+    std::mutex mtx;                                      // guards the round summary and the trace file
+
+    Profiler();
+
+public:
+    ~Profiler() = default;
+    Profiler(const Profiler&) = delete;
+    Profiler(Profiler&&) = delete;
+    Profiler& operator = (const Profiler&) = delete;
+    Profiler& operator = (Profiler&&) = delete;
+
+    static Profiler& Get();
+    void Config(bool _fQuiet, const std::string& _tracePath);
+    void EndRound(int round, const std::string& tag);
+    void PrintTotal() const;
+
+    inline bool IsQuiet() const {return fQuiet;}
+    inline void AddTime(PROF_PHASE phase, ll ns) {phaseNs[static_cast<int>(phase)].fetch_add(ns, std::memory_order_relaxed);}
+    inline void AddCnt(PROF_CNT cnt, ll n = 1) {cnts[static_cast<int>(cnt)].fetch_add(n, std::memory_order_relaxed);}
+};
+
+
+/**
+ * @brief Scoped timer, adding its lifetime to a phase of the profiler
+ */
+class ProfTimer {
+private:
+    PROF_PHASE phase;                                                   // the profiled phase
+    std::chrono::time_point<std::chrono::high_resolution_clock> start;   // the start time
+
+public:
+    explicit ProfTimer(PROF_PHASE _phase): phase(_phase), start(std::chrono::high_resolution_clock::now()) {}
+    ~ProfTimer() {Profiler::Get().AddTime(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count());}
+    ProfTimer(const ProfTimer&) = delete;
+    ProfTimer(ProfTimer&&) = delete;
+    ProfTimer& operator = (const ProfTimer&) = delete;
+    ProfTimer& operator = (ProfTimer&&) = delete;
+};
+
+
+/**
+ * @brief Scoped round, reporting the round to the profiler when it ends, including by break or continue
+ */
+class ProfRound {
+private:
+    int round;         // the round
+    std::string tag;   // the tag of the round, e.g., the LAC type
+
+public:
+    explicit ProfRound(int _round, std::string _tag): round(_round), tag(std::move(_tag)) {}
+    ~ProfRound() {Profiler::Get().EndRound(round, tag);}
+    ProfRound(const ProfRound&) = delete;
+    ProfRound(ProfRound&&) = delete;
+    ProfRound& operator = (const ProfRound&) = delete;
+    ProfRound& operator = (ProfRound&&) = delete;
+};
+
+
+/**
+ * @brief Print the per-LAC information, unless the profiler is in quiet mode
+ *
+ * @param fmtStr   the format string
+ * @param args     the arguments
+ * @return void
+ */
+template <typename... Args>
+static inline void PrintLacInfo(fmt::format_string<Args...> fmtStr, Args&&... args) {
+    if (!Profiler::Get().IsQuiet())
+        fmt::print(fmtStr, std::forward<Args>(args)...);
+}
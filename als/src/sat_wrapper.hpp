@@ -11,6 +11,7 @@
 
 #include <fmt/core.h>
 #include "cryptominisat.h"
+#include "prof.h"
 
 
 /**
@@ -58,6 +59,76 @@ struct fmt::formatter<std::vector<CMSat::Lit>> {
 };
 
 
+/**
+ * @brief Scheduler of the conflict budgets and the time limit of the SAT checks in an ALS run
+ * @brief A check first uses a small conflict budget; an undecided check is retried with a budget growing by growFact, up to maxConfl, only while the time limit allows
+ * @brief With more than one thread, each solver runs a CryptoMiniSat portfolio of differently configured threads, which stops at the first decisive answer
+ */
+class SatSched {
+private:
+    ll initConfl;                                                           // conflict budget of the first attempt
+    ll maxConfl;                                                            // largest conflict budget of the retries
+    ll growFact;                                                            // growth factor of the conflict budget at each retry
+    int nThread;                                                            // number of threads of each solver
+    double timeLimit;                                                       // time limit of the run in seconds; non-positive if unlimited
+    std::chrono::time_point<std::chrono::high_resolution_clock> startTime;   // start time of the run
+
+public:
+    explicit SatSched(ll _initConfl = 1ll << 18, ll _maxConfl = 1ll << 18, int _nThread = 1, double _timeLimit = 0, ll _growFact = 4):
+        initConfl(_initConfl), maxConfl(std::max(_initConfl, _maxConfl)), growFact(_growFact), nThread(_nThread), timeLimit(_timeLimit), startTime(std::chrono::high_resolution_clock::now()) {
+        assert(initConfl > 0 && growFact > 1 && nThread >= 1);
+    }
+    ~SatSched() = default;
+    SatSched(const SatSched&) = delete;
+    SatSched(SatSched&&) = delete;
+    SatSched& operator = (const SatSched&) = delete;
+    SatSched& operator = (SatSched&&) = delete;
+
+    inline void Restart() {startTime = std::chrono::high_resolution_clock::now();}
+    inline ll GetInitConfl() const {return initConfl;}
+    inline ll GetNextConfl(ll confl) const {return confl >= maxConfl? -1: std::min(maxConfl, confl * growFact);} // -1 if the budget cannot grow
+    inline int GetThreadNum() const {return nThread;}
+    inline double GetRemTime() const {return timeLimit - std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();}
+    inline bool IsTimeOut() const {return timeLimit > 0 && GetRemTime() <= 0;}
+
+    /**
+     * @brief Set the conflict budget of the next solve call, and bound its time by the rest of the time limit
+     * 
+     * @param solver   the SAT solver
+     * @param confl    the conflict budget
+     * @return void
+     */
+    inline void Config(CMSat::SATSolver& solver, ll confl) const {
+        solver.set_max_confl(confl);
+        if (timeLimit > 0)
+            solver.set_max_time(std::max(GetRemTime(), 1e-3));
+    }
+};
+
+
+/**
+ * @brief Solve the SAT problem under the assumptions, and report the runtime, the result, and the used conflicts to the profiler
+ * 
+ * @param solver         the SAT solver
+ * @param pAssumpts      the assumptions; nullptr if no assumption
+ * @return CMSat::lbool  the result of the SAT problem
+ */
+static inline CMSat::lbool ProfSolve_(CMSat::SATSolver& solver, const std::vector<CMSat::Lit>* pAssumpts = nullptr) {
+    ProfTimer timer(PROF_PHASE::SAT_SOLVE);
+    auto nConfl = solver.get_sum_conflicts();
+    auto res = solver.solve(pAssumpts);
+    auto& prof = Profiler::Get();
+    prof.AddCnt(PROF_CNT::SAT_CONFL, static_cast<ll>(solver.get_sum_conflicts() - nConfl));
+    if (res == CMSat::l_True)
+        prof.AddCnt(PROF_CNT::SAT_SAT);
+    else if (res == CMSat::l_False)
+        prof.AddCnt(PROF_CNT::SAT_UNSAT);
+    else
+        prof.AddCnt(PROF_CNT::SAT_UNDEF);
+    return res;
+}
+
+
 /**
  * @brief Solve the SAT problem defined by pSolver
  * 
@@ -65,7 +136,7 @@ struct fmt::formatter<std::vector<CMSat::Lit>> {
  */
 static inline CMSat::lbool SolveSat_(CMSat::SATSolver& solver, bool printTime = false) {
     auto startTime = std::chrono::high_resolution_clock::now();
-    auto res = solver.solve();
+    auto res = ProfSolve_(solver);
     if (printTime) 
         PrintRuntime(startTime, "SAT instance solving");
     return res;
@@ -86,9 +157,9 @@ static inline CMSat::lbool SolveSatAndGetCountEx(CMSat::SATSolver& solver, const
     auto startTime = std::chrono::high_resolution_clock::now();
     CMSat::lbool res;
     if (assumpts.empty())
-        res = solver.solve();
+        res = ProfSolve_(solver);
     else
-        res = solver.solve(&assumpts);
+        res = ProfSolve_(solver, &assumpts);
     if (printTime) 
         PrintRuntime(startTime, "SAT instance solving");
     if (res == CMSat::l_True) {
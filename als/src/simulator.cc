@@ -22,7 +22,7 @@ using namespace random;
  * @param n_frame       the number of simulation frames
  * @param distr_type    the distribution type
  */
-Simulator::Simulator(const NetMan& net_man, unsigned _seed, int n_frame, DISTR_TYPE distr_type): NetMan(net_man.GetNet(), false), seed(_seed), nFrame(n_frame), distrType(distr_type) {
+Simulator::Simulator(const NetMan& net_man, unsigned _seed, int n_frame, DISTR_TYPE distr_type): NetMan(net_man.GetNet(), false), seed(_seed), nFrame(n_frame), distrType(distr_type), dirtyW0(INT_MAX), dirtyW1(0), fDirtyAll(false), fUndoLog(false) {
     auto type = NetMan::GetNetType();
     assert(type == NET_TYPE::AIG || type == NET_TYPE::GATE || type == NET_TYPE::SOP || type == NET_TYPE::STRASH);
     if (distrType == DISTR_TYPE::ENUM) {
@@ -30,7 +30,31 @@ Simulator::Simulator(const NetMan& net_man, unsigned _seed, int n_frame, DISTR_T
         assert(nPi < 30);
         nFrame = 1 << nPi;
     }
-    dat.resize(NetMan::GetIdMaxPlus1(), BitVect(nFrame, 0));
+    dat.Resize(NetMan::GetIdMaxPlus1(), nFrame);
+    NetMan::ShareStructVer(net_man);
+}
+
+
+/**
+ * @brief Rebind the simulator to another network, keeping the seed, the number of frames, and the pattern buffers
+ * @brief The rows are resized without releasing their storage, and the compiled program is rebuilt on the next simulation
+ * @brief The structure version of net_man is shared from now on
+ * 
+ * @param net_man  the network to be simulated; it is shared, not duplicated
+ * @retval dat     the simulation patterns, whose contents are undefined until the inputs are set
+ * @return void
+ */
+void Simulator::Rebind(const NetMan& net_man) {
+    auto type = net_man.GetNetType();
+    assert(type == NET_TYPE::AIG || type == NET_TYPE::GATE || type == NET_TYPE::SOP || type == NET_TYPE::STRASH);
+    assert(distrType != DISTR_TYPE::ENUM || (1 << net_man.GetPiNum()) == nFrame);
+    NetMan::operator = (NetMan(net_man.GetNet(), false));
+    NetMan::ShareStructVer(net_man);
+    dat.Resize(NetMan::GetIdMaxPlus1(), nFrame);
+    InvalidateProg();
+    ResetDirty();
+    undoRecs.clear();
+    undoWords.clear();
 }
 
 
@@ -44,18 +68,19 @@ void Simulator::InitConstNodes() {
     if (!NetMan::IsStrash()) {
         for (int i = 0; i < NetMan::GetIdMaxPlus1(); ++i) {
             if (NetMan::IsConst0(i))
-                dat[i].reset();
+                dat[i].Fill(false);
             else if (NetMan::IsConst1(i))
-                dat[i].set();
+                dat[i].Fill(true);
         }
     }
     else
-        dat[NetMan::GetConst1IdInStrashNet()].set();
+        dat[NetMan::GetConst1IdInStrashNet()].Fill(true);
 }
 
 
 /**
  * @brief Generate random input patterns using the uniform distribution
+ * @brief Bit-by-bit reference version with mt19937; GenInpPatts() uses GenInpUnifFast()
  * 
  * @retval dat  the simulation patterns for each node
  * @return void
@@ -65,13 +90,13 @@ void Simulator::GenInpUnif() {
     uniform_int<> unif01(0, 1);
     random::mt19937 eng(seed);
     variate_generator < random::mt19937, uniform_int<> > rand01(eng, unif01);
-    assert(static_cast<int>(dat.size()) == NetMan::GetIdMaxPlus1());
+    assert(dat.GetRowNum() == NetMan::GetIdMaxPlus1());
     for (int i = 0; i < NetMan::GetPiNum(); ++i) {
-        auto piId = NetMan::GetPiId(i);
-        dat[piId].reset();
+        auto piDat = dat[NetMan::GetPiId(i)];
+        piDat.Fill(false);
         for (int j = 0; j < nFrame; ++j) {
             if (rand01())
-                dat[piId].set(j);
+                piDat.Set(j, true);
         }
     }
     // init the constant nodes
@@ -81,34 +106,46 @@ void Simulator::GenInpUnif() {
 
 /**
  * @brief Generate random input patterns using the uniform distribution
- * @brief Fast version
+ * @brief Fast version: each PI draws whole words from its own xoshiro256++ stream, split from the seed by jumps;
+ * @brief the words are written in place, the tail word is masked, and the PIs of large simulators are filled in parallel
+ * @brief The patterns only depend on the seed and the number of frames, not on the number of threads
  * 
- * @retval dat  the simulation patterns for each node
+ * @param nThread  the number of threads for filling the PIs, e.g., ALSOpt::nThread
+ * @retval dat     the simulation patterns for each node
  * @return void
  */
-void Simulator::GenInpUnifFast() {
-    // if the number of frames is not a multiple of 64, use the normal version
-    const int unitLength = 64;
-    if ((nFrame & (unitLength - 1)) != 0) {
-        GenInpUnif();
-        return;
+void Simulator::GenInpUnifFast(int nThread) {
+    // split one stream per PI
+    assert(dat.GetRowNum() == NetMan::GetIdMaxPlus1());
+    int nPi = NetMan::GetPiNum();
+    vector<Xoshiro256pp> engs;
+    engs.reserve(nPi);
+    Xoshiro256pp eng(seed);
+    for (int i = 0; i < nPi; ++i) {
+        engs.emplace_back(eng);
+        eng.Jump();
     }
 
-    // prepare
-    random::uniform_int_distribution <ull> unifUll;
-    random::mt19937 eng(seed);
-    variate_generator <random::mt19937, random::uniform_int_distribution <ull> > randUll(eng, unifUll);
-    int nUnit = nFrame / unitLength;
-
     // generate random input patterns
-    assert(static_cast<int>(dat.size()) == NetMan::GetIdMaxPlus1());
-    for (int i = 0; i < NetMan::GetPiNum(); ++i) {
-        auto piId = NetMan::GetPiId(i);
-        dat[piId].resize(0);
-        for (int j = 0; j < nUnit; ++j) {
-            ull numb = randUll();
-            dat[piId].append(numb);
-        }
+    int nWord = GetWordNumOfBits(nFrame);
+    auto genPi = [&](int i) {
+        auto pWords = dat[NetMan::GetPiId(i)].GetWords();
+        for (int j = 0; j < nWord; ++j)
+            pWords[j] = engs[i]();
+        if (nWord)
+            pWords[nWord - 1] &= GetTailMask(nFrame);
+    };
+    const ll MIN_WORD_PAR = 1ll << 20;
+    int nJob = std::min(nPi, nThread);
+    if (nJob > 1 && static_cast<ll>(nPi) * nWord >= MIN_WORD_PAR) {
+        RunJobsInParallel(nJob, [&](int iJob) {
+            for (int i = iJob; i < nPi; i += nJob)
+                genPi(i);
+        });
+    }
+    else {
+        for (int i = 0; i < nPi; ++i)
+            genPi(i);
     }
 
     // init the constant nodes
@@ -123,19 +160,41 @@ void Simulator::GenInpUnifFast() {
  * @return void
  */
 void Simulator::GenInpEnum() {
-    // Generate the input patterns for the PIs
     assert(GetPiNum() < 30);
     assert(1ll << GetPiNum() == nFrame);
-    assert(static_cast<int>(dat.size()) == NetMan::GetIdMaxPlus1());
+    GenInpEnumWindow(0);
+}
+
+
+/**
+ * @brief Generate a window of the enumerated input patterns: the j-th frame holds the (iFirstPatt + j)-th pattern, whose i-th bit is the value of the i-th PI
+ * @brief Streaming the windows bounds the memory by the window size instead of 2^#PI frames
+ * 
+ * @param iFirstPatt   the index of the first pattern in the window
+ * @retval dat         the simulation patterns for each node
+ * @return void
+ */
+void Simulator::GenInpEnumWindow(ll iFirstPatt) {
+    assert(GetPiNum() < 63);
+    assert(iFirstPatt >= 0 && iFirstPatt + nFrame <= (1ll << GetPiNum()));
+    assert(dat.GetRowNum() == NetMan::GetIdMaxPlus1());
+    // the i-th PI repeats a fixed word for i < 6; otherwise, each word is all zeros or all ones
+    const ull LOW_PI_WORDS[6] = {0xaaaaaaaaaaaaaaaaull, 0xccccccccccccccccull, 0xf0f0f0f0f0f0f0f0ull, 0xff00ff00ff00ff00ull, 0xffff0000ffff0000ull, 0xffffffff00000000ull};
+    bool fAligned = (iFirstPatt & 63) == 0 && (nFrame & 63) == 0;
     for (int i = 0; i < GetPiNum(); ++i) {
-        bool phase = 1;
-        auto piId = GetPiId(i);
-        dat[piId].reset();
-        for (int j = 0; j < nFrame; ++j) {
-            if (j % (1 << i) == 0)
-                phase = !phase;
-            if (phase)
-                dat[piId].set(j);
+        auto piDat = dat[GetPiId(i)];
+        if (fAligned) {
+            auto pWords = piDat.GetWords();
+            ll iFirstWord = iFirstPatt >> 6;
+            for (int w = 0; w < piDat.GetWordNum(); ++w)
+                pWords[w] = (i < 6)? LOW_PI_WORDS[i]: ((((iFirstWord + w) >> (i - 6)) & 1)? ~0ull: 0ull);
+        }
+        else {
+            piDat.Fill(false);
+            for (int j = 0; j < nFrame; ++j) {
+                if (((iFirstPatt + j) >> i) & 1)
+                    piDat.Set(j, true);
+            }
         }
     }
 
@@ -146,6 +205,7 @@ void Simulator::GenInpEnum() {
 
 /**
  * @brief Replace the iPatt-th simulation pattern of node objIds with the given values
+ * @brief The replaced word is marked dirty, so that UpdDirtyPatts() only resimulates it
  * 
  * @param iPatt    the pattern index
  * @param piVals   the PI values
@@ -154,18 +214,23 @@ void Simulator::GenInpEnum() {
  */
 void Simulator::ReplInp(int iPatt, const IntVect& piVals) {
     assert(NetMan::GetPiNum() == static_cast<int>(piVals.size()));
-    assert(static_cast<int>(dat.size()) == NetMan::GetIdMaxPlus1());
+    assert(dat.GetRowNum() == NetMan::GetIdMaxPlus1());
     for (int iPi = 0; iPi < NetMan::GetPiNum(); ++iPi) {
-        auto& piDat = dat[NetMan::GetPiId(iPi)];
-        assert(iPatt < static_cast<int>(piDat.size()));
+        auto piId = NetMan::GetPiId(iPi);
+        auto piDat = dat[piId];
+        assert(iPatt < piDat.Size());
         assert(piVals[iPi] == 0 || piVals[iPi] == 1);
-        dat[NetMan::GetPiId(iPi)][iPatt] = piVals[iPi];
+        if (fUndoLog)
+            SaveWords(piId, iPatt >> 6, (iPatt >> 6) + 1);
+        piDat.Set(iPatt, piVals[iPi]);
+        MarkDirty(piId, iPatt >> 6, (iPatt >> 6) + 1);
     }
 }
 
 
 /**
  * @brief Append the given values to the simulation patterns of the PI nodes
+ * @brief The new word is marked dirty for all objects, so that UpdDirtyPatts() only resimulates it
  * 
  * @param piVals  the PI values
  * @retval dat     the simulation patterns of the PI nodes
@@ -173,19 +238,27 @@ void Simulator::ReplInp(int iPatt, const IntVect& piVals) {
  */
 void Simulator::AppendInp(const IntVect& piVals) {
     assert(NetMan::GetPiNum() == static_cast<int>(piVals.size()));
-    assert(static_cast<int>(dat.size()) == NetMan::GetIdMaxPlus1());
+    assert(dat.GetRowNum() == NetMan::GetIdMaxPlus1());
+    assert(!fUndoLog);
     ++nFrame;
+    dat.ResizeBits(nFrame);
     for (int iPi = 0; iPi < NetMan::GetPiNum(); ++iPi) {
-        auto& piDat = dat[NetMan::GetPiId(iPi)];
+        auto piDat = dat[NetMan::GetPiId(iPi)];
         assert(piVals[iPi] == 0 || piVals[iPi] == 1);
-        piDat.push_back(piVals[iPi]);
-        assert(static_cast<int>(piDat.size()) == nFrame);
+        piDat.Set(nFrame - 1, piVals[iPi]);
+        assert(piDat.Size() == nFrame);
     }
+    InitConstNodes();
+    int iWord = (nFrame - 1) >> 6;
+    dirtyW0 = min(dirtyW0, iWord);
+    dirtyW1 = max(dirtyW1, iWord + 1);
+    fDirtyAll = true;
 }
 
 
 /**
  * @brief Initialize the PI patterns using those of the other simulator
+ * @brief If the other simulator has more frames, its first nFrame frames are copied
  * 
  * @param othSmlt    the other simulator
  * @retval dat       the simulation patterns of the PI objects
@@ -194,13 +267,16 @@ void Simulator::AppendInp(const IntVect& piVals) {
 void Simulator::GenInpFromOthSmlt(const Simulator& othSmlt) {
     // check
     assert(this->IsPIOSame(othSmlt));
-    assert(static_cast<int>(dat.size()) == NetMan::GetIdMaxPlus1());
+    assert(dat.GetRowNum() == NetMan::GetIdMaxPlus1());
     // copy the PI patterns
     for (int i = 0; i < NetMan::GetPiNum(); ++i) {
         auto piId = NetMan::GetPiId(i);
-        auto& piDat = othSmlt.GetDat(piId);
-        assert(static_cast<int>(piDat.size()) == nFrame);
-        dat[piId] = othSmlt.GetDat(piId);
+        auto piDat = othSmlt.GetDat(piId);
+        assert(piDat.Size() >= nFrame);
+        auto row = dat[piId];
+        row.Assign(ConstBitSpan(piDat.GetWords(), nFrame));
+        if (nFrame)
+            row.GetWords()[row.GetWordNum() - 1] &= GetTailMask(nFrame);
     }
     // // resize the PI patterns
     // if (nFrame != othSmlt.GetFrameNumb()) {
@@ -223,14 +299,16 @@ void Simulator::GenInpFromBitVects(const std::vector<BitVect>& piPatts) {
     // check
     int piPattSize = static_cast<int>(piPatts.size());
     assert(piPattSize <= NetMan::GetPiNum() && piPattSize > 0); // the number of PI patterns should be no more than the number of PIs
-    assert(static_cast<int>(dat.size()) == NetMan::GetIdMaxPlus1());
+    assert(dat.GetRowNum() == NetMan::GetIdMaxPlus1());
     // update the frame number
-    if (nFrame != static_cast<int>(piPatts[0].size()))
+    if (nFrame != static_cast<int>(piPatts[0].size())) {
         nFrame = static_cast<int>(piPatts[0].size());
+        dat.Resize(NetMan::GetIdMaxPlus1(), nFrame);
+    }
     // copy the PI patterns
     for (int i = 0; i < piPattSize; ++i) {
         assert(nFrame == static_cast<int>(piPatts[i].size()));
-        dat[NetMan::GetPiId(i)] = piPatts[i];
+        dat[NetMan::GetPiId(i)].AssignBitVect(piPatts[i]);
     }
     // init the constant nodes
     InitConstNodes();
@@ -243,7 +321,15 @@ void Simulator::GenInpFromBitVects(const std::vector<BitVect>& piPatts) {
  * @return void
  */
 void Simulator::UpdNodeAndPoPatts() {
+    ResetDirty();
     auto type = GetNetType();
+    // SOP, gate and strashed networks run the compiled program
+    if (type != NET_TYPE::AIG) {
+        if (!IsProgValid())
+            CompileProg();
+        RunProg();
+        return;
+    }
     auto nodes = CalcTopoOrd(false);
     for (const auto& pObj: nodes) {
         if (type == NET_TYPE::AIG)
@@ -262,9 +348,13 @@ void Simulator::UpdNodeAndPoPatts() {
         auto drivId = GetFaninId(pPo, 0);
         assert(!Abc_ObjIsComplement(pPo));
         if (type == NET_TYPE::AIG || type == NET_TYPE::GATE || type == NET_TYPE::SOP)
-            dat[GetId(pPo)] = dat[drivId];
-        else if (type == NET_TYPE::STRASH)
-            dat[GetId(pPo)] = Abc_ObjFaninC0(pPo)? ~dat[drivId]: dat[drivId];
+            dat[GetId(pPo)].Assign(dat[drivId]);
+        else if (type == NET_TYPE::STRASH) {
+            if (Abc_ObjFaninC0(pPo))
+                dat[GetId(pPo)].AssignNot(dat[drivId]);
+            else
+                dat[GetId(pPo)].Assign(dat[drivId]);
+        }
         else
             assert(0);
     }
@@ -272,70 +362,489 @@ void Simulator::UpdNodeAndPoPatts() {
 
 
 /**
- * @brief Simulate a node with the given sum-of-products (SOP) function
+ * @brief Evaluate an SOP on the fanin patterns with the word kernels
+ * @brief Only the member scratch row is used for the cubes, so no memory is allocated
  * 
- * @param faninIds      the fanin ids of the node
- * @param sop           the SOP of the node
- * @param res           the simulation result
+ * @param pSop          the SOP in ABC format
+ * @param getFaninDat   getFaninDat(i) returns the patterns of the i-th fanin
+ * @param res           the simulation result, which should not alias a fanin
  * @retval res          the simulation result
  * @return void
  */
-void Simulator::SimSop(const IntVect& faninIds, const std::string& sop, BitVect& res) {
-    if (sop == " 0\n") {
-        res.reset();
-        return;
-    }
-    if (sop == " 1\n") {
-        res.set();
-        return;
-    }
-    char* pSop = const_cast <char*> (sop.c_str());
+template <typename GetFaninDat>
+void Simulator::EvalSop(char* pSop, GetFaninDat&& getFaninDat, BitSpan res) {
+    if (!product.IsShape(1, nFrame))
+        product.Resize(1, nFrame);
+    auto prod = product[0];
     int nVars = Abc_SopGetVarNum(pSop);
-    assert(nVars == static_cast<int>(faninIds.size()));
-
-    BitVect product(nFrame, 0);
     for (char* pCube = pSop; *pCube; pCube += nVars + 3) {
         bool isFirst = true;
         for (int i = 0; pCube[i] != ' '; i++) {
-            int faninId = faninIds[i];
-            switch (pCube[i]) {
-                case '-':
-                    continue;
-                    break;
-                case '0':
-                    if (isFirst) {
-                        isFirst = false;
-                        product = ~dat[faninId];
-                    }
-                    else
-                        product &= ~dat[faninId];
-                    break;
-                case '1':
-                    if (isFirst) {
-                        isFirst = false;
-                        product = dat[faninId];
-                    }
-                    else
-                        product &= dat[faninId];
-                    break;
-                default:
-                    assert(0);
+            if (pCube[i] == '-')
+                continue;
+            assert(pCube[i] == '0' || pCube[i] == '1');
+            bool fCompl = (pCube[i] == '0');
+            if (isFirst) {
+                isFirst = false;
+                if (fCompl)
+                    prod.AssignNot(getFaninDat(i));
+                else
+                    prod.Assign(getFaninDat(i));
             }
+            else
+                prod.AndWith(getFaninDat(i), fCompl);
         }
         if (isFirst) {
             isFirst = false;
-            product.set();
+            prod.Fill(true);
         }
         assert(!isFirst);
         if (pCube == pSop)
-            res = product;
+            res.Assign(prod);
         else
-            res |= product;
+            res.OrWith(prod);
     }
 
     // complement
     if (Abc_SopIsComplement(pSop))
-        res.flip();
+        res.Flip();
+}
+
+
+/**
+ * @brief Execute an instruction of the compiled program on the words [w0, w1)
+ * @brief The bits beyond the frame number in the last word may become garbage; the caller clears them
+ * 
+ * @param prg       the program containing the instruction
+ * @param instr     the instruction
+ * @param getRow    getRow(id) returns the words of the object id
+ * @param pOut      the words of the output, which should not alias a fanin
+ * @param w0        the first word
+ * @param w1        the last word plus 1
+ * @retval pOut     the words [w0, w1) of the output
+ * @return void
+ */
+template <typename GetRow>
+void Simulator::ExecInstr(const SimProg& prg, const SimInstr& instr, GetRow&& getRow, ull* pOut, int w0, int w1) {
+    const ull outMask = instr.outMask;
+    if (instr.op == SIM_OP::SOP) {
+        const int WORD_PER_BLOCK = 32;
+        ull res[WORD_PER_BLOCK], prod[WORD_PER_BLOCK];
+        for (int b0 = w0; b0 < w1; b0 += WORD_PER_BLOCK) {
+            int nW = min(w1 - b0, WORD_PER_BLOCK);
+            fill_n(res, nW, 0ull);
+            for (int iCube = instr.iCube; iCube < instr.iCube + instr.nCube; ++iCube) {
+                fill_n(prod, nW, ~0ull);
+                for (int iLit = prg.cubes[iCube].first; iLit < prg.cubes[iCube].second; ++iLit) {
+                    const auto& lit = prg.lits[iLit];
+                    const ull* pFi = getRow(lit.id) + b0;
+                    for (int w = 0; w < nW; ++w)
+                        prod[w] &= pFi[w] ^ lit.complMask;
+                }
+                for (int w = 0; w < nW; ++w)
+                    res[w] |= prod[w];
+            }
+            for (int w = 0; w < nW; ++w)
+                pOut[b0 + w] = res[w] ^ outMask;
+        }
+        return;
+    }
+    const ull* p0 = getRow(instr.fanins[0]);
+    const ull c0 = instr.complMasks[0];
+    if (instr.op == SIM_OP::BUF) {
+        for (int w = w0; w < w1; ++w)
+            pOut[w] = p0[w] ^ c0 ^ outMask;
+        return;
+    }
+    const ull* p1 = getRow(instr.fanins[1]);
+    const ull c1 = instr.complMasks[1];
+    switch (instr.op) {
+        case SIM_OP::AND2:
+            for (int w = w0; w < w1; ++w)
+                pOut[w] = ((p0[w] ^ c0) & (p1[w] ^ c1)) ^ outMask;
+            break;
+        case SIM_OP::OR2:
+            for (int w = w0; w < w1; ++w)
+                pOut[w] = ((p0[w] ^ c0) | (p1[w] ^ c1)) ^ outMask;
+            break;
+        case SIM_OP::XOR2:
+            for (int w = w0; w < w1; ++w)
+                pOut[w] = p0[w] ^ p1[w] ^ c0 ^ c1 ^ outMask;
+            break;
+        default:
+            assert(0);
+    }
+}
+
+
+/**
+ * @brief Lower an SOP into an instruction appended to the program
+ * @brief Single cubes of one or two literals, two single-literal cubes, and two complementary two-literal cubes
+ * @brief become BUF, AND2, OR2, and XOR2; other SOPs keep their cubes in the literal pool
+ * 
+ * @param outId      the output object ID
+ * @param faninIds   the fanin object IDs
+ * @param pSop       the SOP in ABC format
+ * @param prg        the program
+ * @retval prg       the program with the new instruction
+ * @return void
+ */
+void Simulator::CompileSop(int outId, std::span<const int> faninIds, char* pSop, SimProg& prg) {
+    int nVars = Abc_SopGetVarNum(pSop);
+    assert(nVars == static_cast<int>(faninIds.size()));
+    SimInstr instr{SIM_OP::SOP, outId, {-1, -1}, {0, 0}, Abc_SopIsComplement(pSop)? ~0ull: 0ull, static_cast<int>(prg.cubes.size()), 0};
+    for (char* pCube = pSop; *pCube; pCube += nVars + 3) {
+        int iLitBeg = static_cast<int>(prg.lits.size());
+        for (int i = 0; pCube[i] != ' '; i++) {
+            if (pCube[i] == '-')
+                continue;
+            assert(pCube[i] == '0' || pCube[i] == '1');
+            prg.lits.emplace_back(SimLit{faninIds[i], pCube[i] == '0'? ~0ull: 0ull});
+        }
+        prg.cubes.emplace_back(iLitBeg, static_cast<int>(prg.lits.size()));
+        ++instr.nCube;
+    }
+    // recognize the common 2-input shapes
+    auto getCubeSize = [&](int iCube) {return prg.cubes[iCube].second - prg.cubes[iCube].first;};
+    auto getLit = [&](int iCube, int k) {return prg.lits[prg.cubes[iCube].first + k];};
+    int iCube0 = instr.iCube;
+    if (instr.nCube == 1 && getCubeSize(iCube0) == 1) {
+        instr.op = SIM_OP::BUF;
+        instr.fanins[0] = getLit(iCube0, 0).id;
+        instr.complMasks[0] = getLit(iCube0, 0).complMask;
+    }
+    else if (instr.nCube == 1 && getCubeSize(iCube0) == 2) {
+        instr.op = SIM_OP::AND2;
+        for (int k = 0; k < 2; ++k) {
+            instr.fanins[k] = getLit(iCube0, k).id;
+            instr.complMasks[k] = getLit(iCube0, k).complMask;
+        }
+    }
+    else if (instr.nCube == 2 && getCubeSize(iCube0) == 1 && getCubeSize(iCube0 + 1) == 1) {
+        instr.op = SIM_OP::OR2;
+        for (int k = 0; k < 2; ++k) {
+            instr.fanins[k] = getLit(iCube0 + k, 0).id;
+            instr.complMasks[k] = getLit(iCube0 + k, 0).complMask;
+        }
+    }
+    else if (instr.nCube == 2 && getCubeSize(iCube0) == 2 && getCubeSize(iCube0 + 1) == 2) {
+        // (a ^ m0) & (b ^ m1) | (a ^ ~m0) & (b ^ ~m1) = ~(a ^ b ^ m0 ^ m1)
+        auto a0 = getLit(iCube0, 0), b0 = getLit(iCube0, 1), a1 = getLit(iCube0 + 1, 0), b1 = getLit(iCube0 + 1, 1);
+        if (a0.id == a1.id && b0.id == b1.id && a0.complMask == ~a1.complMask && b0.complMask == ~b1.complMask) {
+            instr.op = SIM_OP::XOR2;
+            instr.fanins[0] = a0.id, instr.fanins[1] = b0.id;
+            instr.complMasks[0] = a0.complMask, instr.complMasks[1] = b0.complMask;
+            instr.outMask = ~instr.outMask;
+        }
+    }
+    if (instr.op != SIM_OP::SOP) {
+        // the cubes are not referenced
+        prg.lits.resize(prg.cubes[iCube0].first);
+        prg.cubes.resize(iCube0);
+        instr.nCube = 0;
+    }
+    prg.instrs.emplace_back(instr);
+}
+
+
+/**
+ * @brief Compile the nodes and POs of the network into the simulation program
+ * @brief The program is recompiled when the structure version of the network changes, i.e., after each change through NetMan,
+ * @brief including the fanout patching of TempApplyLac and RecovNet; changes made directly with ABC should call NetMan::IncStructVer()
+ * 
+ * @retval prog  the compiled program
+ * @return void
+ */
+void Simulator::CompileProg() {
+    auto type = GetNetType();
+    assert(type == NET_TYPE::SOP || type == NET_TYPE::GATE || type == NET_TYPE::STRASH);
+    prog.Clear();
+    prog.instrOfObj.assign(GetIdMaxPlus1(), -1);
+    if (dat.GetRowNum() < GetIdMaxPlus1())
+        dat.ResizeRows(GetIdMaxPlus1());
+    IntVect faninIds;
+    for (const auto& pObj: CalcTopoOrd(false)) {
+        assert(Abc_ObjIsNode(pObj));
+        if (type == NET_TYPE::STRASH) {
+            assert(Abc_ObjRegular(pObj) != Abc_AigConst1(GetNet()));
+            SimInstr instr{SIM_OP::AND2, pObj->Id, {Abc_ObjFanin0(pObj)->Id, Abc_ObjFanin1(pObj)->Id}, 
+                {Abc_ObjFaninC0(pObj)? ~0ull: 0ull, Abc_ObjFaninC1(pObj)? ~0ull: 0ull}, 0, 0, 0};
+            prog.instrs.emplace_back(instr);
+        }
+        else {
+            // skip constant node
+            if (Abc_NodeIsConst(pObj))
+                continue;
+            char* pSop = (type == NET_TYPE::SOP)? static_cast<char*>(pObj->pData): static_cast<char*>((static_cast<Mio_Gate_t*>(pObj->pData))->pSop);
+            faninIds.resize(GetFaninNum(pObj));
+            for (int i = 0; i < GetFaninNum(pObj); ++i)
+                faninIds[i] = GetFaninId(pObj, i);
+            CompileSop(pObj->Id, faninIds, pSop, prog);
+        }
+        prog.instrOfObj[pObj->Id] = static_cast<int>(prog.instrs.size()) - 1;
+    }
+    for (int i = 0; i < GetPoNum(); ++i) {
+        auto pPo = GetPo(i);
+        assert(!Abc_ObjIsComplement(pPo));
+        ull complMask = (type == NET_TYPE::STRASH && Abc_ObjFaninC0(pPo))? ~0ull: 0ull;
+        prog.instrs.emplace_back(SimInstr{SIM_OP::BUF, pPo->Id, {GetFaninId(pPo, 0), -1}, {complMask, 0}, 0, 0, 0});
+        prog.instrOfObj[pPo->Id] = static_cast<int>(prog.instrs.size()) - 1;
+    }
+    prog.fValid = true;
+    prog.structVer = GetStructVer();
+    prog.idMaxPlus1 = GetIdMaxPlus1();
+    prog.nObj = GetObjNum();
+}
+
+
+/**
+ * @brief Run the compiled program on the words [w0, w1)
+ * @brief The patterns are processed in blocks of words, so that the fanins of an instruction are likely in the cache
+ * 
+ * @param w0    the first word
+ * @param w1    the last word plus 1; -1 for the last word of the patterns
+ * @retval dat  the simulation patterns for each node and PO
+ * @return void
+ */
+void Simulator::RunProg(int w0, int w1) {
+    assert(IsProgValid());
+    assert(prog.idMaxPlus1 == GetIdMaxPlus1() && prog.nObj == GetObjNum());
+    const int WORD_PER_BLOCK = 64;
+    int nWord = GetWordNumOfBits(nFrame);
+    if (w1 == -1 || w1 > nWord)
+        w1 = nWord;
+    auto getRow = [&](int id) {return static_cast<const ull*>(dat[id].GetWords());};
+    for (int b0 = w0; b0 < w1; b0 += WORD_PER_BLOCK) {
+        int b1 = min(w1, b0 + WORD_PER_BLOCK);
+        for (const auto& instr: prog.instrs)
+            ExecInstr(prog, instr, getRow, dat[instr.outId].GetWords(), b0, b1);
+    }
+    // clear the bits beyond the frame number
+    if (w0 < w1 && w1 == nWord) {
+        ull tailMask = GetTailMask(nFrame);
+        for (const auto& instr: prog.instrs)
+            dat[instr.outId].GetWords()[nWord - 1] &= tailMask;
+    }
+}
+
+
+/**
+ * @brief Save the words [w0, w1) of the object id before overwriting them
+ * @brief The words go to the undo log if it is enabled, otherwise to a scratch buffer
+ * 
+ * @param id      the object ID
+ * @param w0      the first word
+ * @param w1      the last word plus 1
+ * @return const ull*   the saved words, valid until the next call
+ */
+const ull* Simulator::SaveWords(int id, int w0, int w1) {
+    const ull* pSrc = dat[id].GetWords() + w0;
+    if (!fUndoLog) {
+        oldWords.assign(pSrc, pSrc + (w1 - w0));
+        return oldWords.data();
+    }
+    ll iWord = static_cast<ll>(undoWords.size());
+    undoRecs.emplace_back(SimUndoRec{id, w0, w1, iWord});
+    undoWords.insert(undoWords.end(), pSrc, pSrc + (w1 - w0));
+    return undoWords.data() + iWord;
+}
+
+
+/**
+ * @brief Overwrite the patterns of the ithPi-th PI and mark them dirty
+ * 
+ * @param ithPi   the PI index
+ * @param src     the new patterns
+ * @retval dat    the patterns of the PI
+ * @return void
+ */
+void Simulator::SetInp(int ithPi, ConstBitSpan src) {
+    auto piId = GetPiId(ithPi);
+    int nWord = GetWordNumOfBits(nFrame);
+    if (fUndoLog)
+        SaveWords(piId, 0, nWord);
+    dat[piId].Assign(src);
+    MarkDirty(piId, 0, nWord);
+}
+
+
+/**
+ * @brief Mark the words [w0, w1) of the object id as changed
+ * @brief A node is resimulated from its fanins; the patterns of other objects are taken as they are
+ * 
+ * @param id      the object ID
+ * @param w0      the first word
+ * @param w1      the last word plus 1
+ * @return void
+ */
+void Simulator::MarkDirty(int id, int w0, int w1) {
+    dirtyIds.emplace_back(id);
+    dirtyW0 = min(dirtyW0, w0);
+    dirtyW1 = max(dirtyW1, w1);
+}
+
+
+/**
+ * @brief Resimulate the transitive fanout of the seed objects on the words [w0, w1)
+ * @brief Seed nodes (and POs) are recomputed from their fanins, e.g., a node whose fanins were patched;
+ * @brief seed constants are refilled; other seeds, e.g., PIs, are taken as changed.
+ * @brief An instruction is executed only if a fanin changed, and its output counts as changed only if its words differ
+ * 
+ * @param seedIds   the seed objects
+ * @param w0        the first word
+ * @param w1        the last word plus 1; -1 for the last word of the patterns
+ * @retval dat      the simulation patterns; the overwritten words are in the undo log if it is enabled
+ * @return void
+ */
+void Simulator::UpdTfoPatts(const IntVect& seedIds, int w0, int w1) {
+    const uint8_t CHANGED = 1, NEED_EVAL = 2;
+    if (!IsProgValid())
+        CompileProg();
+    assert(prog.idMaxPlus1 == GetIdMaxPlus1() && prog.nObj == GetObjNum());
+    int nWord = GetWordNumOfBits(nFrame);
+    if (w1 == -1 || w1 > nWord)
+        w1 = nWord;
+    if (w0 >= w1)
+        return;
+    ull tailMask = (w1 == nWord)? GetTailMask(nFrame): ~0ull;
+    objStates.assign(GetIdMaxPlus1(), 0);
+    for (int id: seedIds) {
+        if (prog.instrOfObj[id] != -1) {
+            objStates[id] |= NEED_EVAL;
+            continue;
+        }
+        if (!IsStrash() && IsNode(id) && (IsConst0(id) || IsConst1(id))) {
+            SaveWords(id, w0, w1);
+            auto pOut = dat[id].GetWords();
+            std::fill(pOut + w0, pOut + w1, IsConst1(id)? ~0ull: 0ull);
+            pOut[w1 - 1] &= tailMask;
+        }
+        objStates[id] |= CHANGED;
+    }
+    auto getRow = [&](int id) {return static_cast<const ull*>(dat[id].GetWords());};
+    for (const auto& instr: prog.instrs) {
+        bool fEval = objStates[instr.outId] & NEED_EVAL;
+        if (!fEval) {
+            if (instr.op == SIM_OP::SOP) {
+                for (int iCube = instr.iCube; iCube < instr.iCube + instr.nCube && !fEval; ++iCube) {
+                    for (int iLit = prog.cubes[iCube].first; iLit < prog.cubes[iCube].second && !fEval; ++iLit)
+                        fEval = objStates[prog.lits[iLit].id] & CHANGED;
+                }
+            }
+            else
+                fEval = (objStates[instr.fanins[0]] & CHANGED) || (instr.op != SIM_OP::BUF && (objStates[instr.fanins[1]] & CHANGED));
+        }
+        if (!fEval)
+            continue;
+        // keep the old words to detect the change and to roll back
+        auto pOld = SaveWords(instr.outId, w0, w1);
+        auto pOut = dat[instr.outId].GetWords();
+        ExecInstr(prog, instr, getRow, pOut, w0, w1);
+        pOut[w1 - 1] &= tailMask;
+        if (!std::equal(pOut + w0, pOut + w1, pOld))
+            objStates[instr.outId] |= CHANGED;
+        else if (fUndoLog) {
+            // nothing to roll back
+            undoWords.resize(undoRecs.back().iWord);
+            undoRecs.pop_back();
+        }
+    }
+}
+
+
+/**
+ * @brief Resimulate the objects affected by the dirty marks of ReplInp(), AppendInp(), SetInp(), and MarkDirty()
+ * 
+ * @retval dat    the simulation patterns
+ * @return void
+ */
+void Simulator::UpdDirtyPatts() {
+    if (dirtyW0 >= dirtyW1) {
+        ResetDirty();
+        return;
+    }
+    if (GetNetType() == NET_TYPE::AIG) {
+        UpdNodeAndPoPatts();
+        return;
+    }
+    if (fDirtyAll) {
+        assert(!fUndoLog);
+        if (!IsProgValid())
+            CompileProg();
+        RunProg(dirtyW0, dirtyW1);
+    }
+    else
+        UpdTfoPatts(dirtyIds, dirtyW0, dirtyW1);
+    ResetDirty();
+}
+
+
+/**
+ * @brief Start saving the overwritten words, so that the patterns can be rolled back
+ * 
+ * @return void
+ */
+void Simulator::StartUndoLog() {
+    assert(!fUndoLog);
+    undoRecs.clear();
+    undoWords.clear();
+    fUndoLog = true;
+}
+
+
+/**
+ * @brief Stop saving the overwritten words and keep the current patterns
+ * 
+ * @return void
+ */
+void Simulator::StopUndoLog() {
+    undoRecs.clear();
+    undoWords.clear();
+    fUndoLog = false;
+}
+
+
+/**
+ * @brief Restore the patterns saved since StartUndoLog() and stop saving
+ * 
+ * @retval dat    the simulation patterns before StartUndoLog()
+ * @return void
+ */
+void Simulator::RollBack() {
+    assert(fUndoLog);
+    for (auto it = undoRecs.rbegin(); it != undoRecs.rend(); ++it)
+        std::copy_n(undoWords.data() + it->iWord, it->w1 - it->w0, dat[it->id].GetWords() + it->w0);
+    StopUndoLog();
+}
+
+
+/**
+ * @brief Simulate a node with the given sum-of-products (SOP) function
+ * 
+ * @param faninIds      the fanin ids of the node
+ * @param sop           the SOP of the node
+ * @param res           the simulation result
+ * @param scratch       the scratch of the calling thread
+ * @retval res          the simulation result
+ * @return void
+ */
+void Simulator::SimSop(std::span<const int> faninIds, const std::string& sop, BitSpan res, BoolDiffScratch& scratch) const {
+    if (sop == " 0\n") {
+        res.Fill(false);
+        return;
+    }
+    if (sop == " 1\n") {
+        res.Fill(true);
+        return;
+    }
+    char* pSop = const_cast <char*> (sop.c_str());
+    auto& sopProg = scratch.sopProg;
+    sopProg.Clear();
+    CompileSop(-1, faninIds, pSop, sopProg);
+    int nWord = res.GetWordNum();
+    ExecInstr(sopProg, sopProg.instrs[0], [&](int id) {return static_cast<const ull*>(dat[id].GetWords());}, res.GetWords(), 0, nWord);
+    if (nWord)
+        res.GetWords()[nWord - 1] &= GetTailMask(res.Size());
 }
 
 
@@ -361,16 +870,16 @@ void Simulator::UpdAigNode(AbcObj* pObj) {
         maxHopId = max(maxHopId, pHopObj->Id);
     Vec_PtrForEachEntry( Hop_Obj_t *, pMan->vPis, pHopObj, i )
         maxHopId = max(maxHopId, pHopObj->Id);
-    vector < BitVect > interData(maxHopId + 1, BitVect (nFrame, 0));
-    unordered_map <int, BitVect *> hop2Data;
+    BitMat interData(maxHopId + 1, nFrame);
+    unordered_map <int, int> hop2ObjId;
     AbcObj* pFanin = nullptr;
     Abc_ObjForEachFanin(pObj, pFanin, i)
-        hop2Data[Hop_ManPi(pMan, i)->Id] = &dat[pFanin->Id];
+        hop2ObjId[Hop_ManPi(pMan, i)->Id] = pFanin->Id;
 
     // special case for inverter or buffer
     if (pRootR->Type == AIG_PI) {
         pFanin = Abc_ObjFanin0(pObj);
-        dat[pObj->Id] = dat[pFanin->Id];
+        dat[pObj->Id].Assign(dat[pFanin->Id]);
     }
 
     // simulate
@@ -380,24 +889,15 @@ void Simulator::UpdAigNode(AbcObj* pObj) {
         auto pHopFanin1 = Hop_ObjFanin1(pHopObj);
         assert(!Hop_ObjIsConst1(pHopFanin0));
         assert(!Hop_ObjIsConst1(pHopFanin1));
-        BitVect& data0 = Hop_ObjIsPi(pHopFanin0) ? *hop2Data[pHopFanin0->Id] : interData[pHopFanin0->Id];
-        BitVect& data1 = Hop_ObjIsPi(pHopFanin1) ? *hop2Data[pHopFanin1->Id] : interData[pHopFanin1->Id];
-        BitVect& out = (pHopObj == pRootR) ? dat[pObj->Id] : interData[pHopObj->Id];
-        bool isFanin0C = Hop_ObjFaninC0(pHopObj);
-        bool isFanin1C = Hop_ObjFaninC1(pHopObj);
-        if (!isFanin0C && !isFanin1C)
-            out = data0 & data1;
-        else if (!isFanin0C && isFanin1C)
-            out = data0 & ~data1;
-        else if (isFanin0C && !isFanin1C)
-            out = ~data0 & data1;
-        else if (isFanin0C && isFanin1C)
-            out = ~(data0 | data1);
+        auto data0 = Hop_ObjIsPi(pHopFanin0) ? dat[hop2ObjId[pHopFanin0->Id]] : interData[pHopFanin0->Id];
+        auto data1 = Hop_ObjIsPi(pHopFanin1) ? dat[hop2ObjId[pHopFanin1->Id]] : interData[pHopFanin1->Id];
+        auto out = (pHopObj == pRootR) ? dat[pObj->Id] : interData[pHopObj->Id];
+        out.AssignAnd(data0, Hop_ObjFaninC0(pHopObj), data1, Hop_ObjFaninC1(pHopObj));
     }
 
     // complement
     if (Hop_IsComplement(pRoot))
-        dat[pObj->Id].flip();
+        dat[pObj->Id].Flip();
 
     // recycle memory
     Vec_PtrFree(vHopNodes); 
@@ -438,57 +938,12 @@ void Simulator::UpdStrashNode(AbcObj* pObj) {
     assert(!Abc_ObjIsComplement(pObj));
     auto pFanin0 = Abc_ObjFanin0(pObj), pFanin1 = Abc_ObjFanin1(pObj);
     int compl0 = Abc_ObjFaninC0(pObj), compl1 = Abc_ObjFaninC1(pObj);
-    dynamic_bitset<ull> c0(nFrame, 0); if (compl0) c0.set();
-    dynamic_bitset<ull> c1(nFrame, 0); if (compl1) c1.set();
-    dat[pObj->Id] = (dat[pFanin0->Id] ^ c0) & (dat[pFanin1->Id] ^ c1);
+    dat[pObj->Id].AssignAnd(dat[pFanin0->Id], compl0, dat[pFanin1->Id], compl1);
 }
 
 
 void Simulator::UpdSop(AbcObj* pObj, char* pSop) {
-    int nVars = Abc_SopGetVarNum(pSop);
-    BitVect product(nFrame, 0);
-    for (char* pCube = pSop; *pCube; pCube += nVars + 3) {
-        bool isFirst = true;
-        for (int i = 0; pCube[i] != ' '; i++) {
-            AbcObj* pFanin = Abc_ObjFanin(pObj, i);
-            switch (pCube[i]) {
-                case '-':
-                    continue;
-                    break;
-                case '0':
-                    if (isFirst) {
-                        isFirst = false;
-                        product = ~dat[pFanin->Id];
-                    }
-                    else
-                        product &= ~dat[pFanin->Id];
-                    break;
-                case '1':
-                    if (isFirst) {
-                        isFirst = false;
-                        product = dat[pFanin->Id];
-                    }
-                    else
-                        product &= dat[pFanin->Id];
-                    break;
-                default:
-                    assert(0);
-            }
-        }
-        if (isFirst) {
-            isFirst = false;
-            product.set();
-        }
-        assert(!isFirst);
-        if (pCube == pSop)
-            dat[pObj->Id] = product;
-        else
-            dat[pObj->Id] |= product;
-    }
-
-    // complement
-    if (Abc_SopIsComplement(pSop))
-        dat[pObj->Id].flip();
+    EvalSop(pSop, [&](int i) {return ConstBitSpan(dat[Abc_ObjFanin(pObj, i)->Id]);}, dat[pObj->Id]);
 }
 
 
@@ -604,7 +1059,7 @@ ll Simulator::GetTempOutputFast(int iPatt) const {
     int ret = 0;
     for (int k = msb; k >= 0; --k) {
         ret <<= 1;
-        ret |= tempDat[NetMan::GetPoId(k)][iPatt];
+        ret |= bdScratch.tempDat[NetMan::GetPoId(k)][iPatt];
     }
     return ret;
 }
@@ -625,7 +1080,7 @@ void Simulator::PrintOutpStream(int iPatt) const {
 
 double Simulator::GetSignalProb(int objId) const {
     assert(objId < NetMan::GetIdMaxPlus1());
-    return dat[objId].count() / static_cast <double> (nFrame);
+    return dat[objId].Count() / static_cast <double> (nFrame);
 }
 
 
@@ -639,10 +1094,10 @@ void Simulator::PrintSignalProb() const {
 double Simulator::GetErrRate(const Simulator& oth_smlt, bool isCheck) const {
     if (isCheck)
         assert(NetMan::IsPIOSame(static_cast<const NetMan&>(oth_smlt)));
-    BitVect temp(nFrame, 0);
+    BitMat temp(1, nFrame);
     for (int i = 0; i < NetMan::GetPoNum(); ++i)
-        temp |= (this->dat[NetMan::GetPoId(i)] ^ oth_smlt.dat[oth_smlt.GetPoId(i)]);
-    return temp.count() / static_cast <double> (nFrame);
+        temp[0].OrXorWith(this->dat[NetMan::GetPoId(i)], oth_smlt.dat[oth_smlt.GetPoId(i)]);
+    return temp[0].Count() / static_cast <double> (nFrame);
 }
 
 
@@ -711,31 +1166,48 @@ void Simulator::GetMaxErrDist(const Simulator& oth_smlt, bool isCheck, BigInt& m
 }
 
 
+/**
+ * @brief Prepare the compiled program for computing Boolean differences
+ * @brief Should be called serially before the Boolean differences are computed by several threads
+ * 
+ * @return void
+ */
+void Simulator::PrepBoolDiff() {
+    assert(GetNetType() == NET_TYPE::SOP);
+    if (!IsProgValid())
+        CompileProg();
+}
+
+
 /**
  * @brief Calculate the Boolean difference of the POs with respect to the node topoNodes[i]
+ * @brief Only reads the simulator, so that several threads can call it with their own scratches; see PrepBoolDiff
  * 
  * @param  topoNodes             the nodes in topological order
  * @param  idx                   the index of the node to be flipped 
  * @param  bdPosWrtNode          the Boolean difference of the POs with respect to the node topoNodes[i]
+ * @param  scratch               the scratch of the calling thread
  * @retval bdPosWrtNode[poIdx]   Boolean difference of the poIdx-th PO w.r.t. the node topoNodes[idx]
  * @return void
  */
-void Simulator::CalcBoolDiff(const AbcObjVect& topoNodes, int idx, std::vector<BitVect>& bdPosWrtNode) {
+void Simulator::CalcBoolDiff(const AbcObjVect& topoNodes, int idx, BitMat& bdPosWrtNode, BoolDiffScratch& scratch) const {
     // check
     assert(GetNetType() == NET_TYPE::SOP);
     assert(idx < static_cast<int>(topoNodes.size()));
+    assert(IsProgValid());
 
     // initizalize tempDat
-    if (tempDat.size() != dat.size())
-        tempDat.resize(dat.size(), BitVect(nFrame, 0));
+    auto& tempDat = scratch.tempDat;
+    if (!tempDat.IsShape(dat.GetRowNum(), nFrame))
+        tempDat.Resize(dat.GetRowNum(), nFrame);
     
     // prepare traversal mark
     auto pTarg = topoNodes[idx];
-    SetNetNotTrav();   // mark all nodes as untraversed
-    SetObjTrav(pTarg); // mark the i-th node as traversed
+    scratch.StartTrav(GetIdMaxPlus1()); // mark all nodes as untraversed
+    scratch.SetTrav(pTarg->Id);         // mark the i-th node as traversed
 
     // flip the node
-    tempDat[pTarg->Id] = ~dat[pTarg->Id];
+    tempDat[pTarg->Id].AssignNot(dat[pTarg->Id]);
     // fmt::print("flip target {}: {}\n", *pTarg, tempDat[pTarg->Id]);
 
     // simulate from the i-th node
@@ -744,8 +1216,7 @@ void Simulator::CalcBoolDiff(const AbcObjVect& topoNodes, int idx, std::vector<B
         // get the traversing status of the fanins
         bool isOneFaninTrav = false;
         for (int iFanin = 0; iFanin < GetFaninNum(pObj); ++iFanin) {
-            auto pFanin = GetFanin(pObj, iFanin);
-            if (GetObjTrav(pFanin)) {
+            if (scratch.IsTrav(GetFaninId(pObj, iFanin))) {
                 isOneFaninTrav = true;
                 break;
             }
@@ -753,31 +1224,57 @@ void Simulator::CalcBoolDiff(const AbcObjVect& topoNodes, int idx, std::vector<B
         // only if one of the fanins are traversed, then we need to update the node
         // otherwise, it means the node does not depend on the flipped node
         if (isOneFaninTrav) {
-            UpdSopNodeForBoolDiff(pObj);
+            UpdObjForBoolDiff(pObj, scratch);
             // fmt::print("update node {}: {}\n", *pObj, tempDat[pObj->Id]);
         }
     }
     for (int i = 0; i < GetPoNum(); ++i) {
-        UpdSopNodeForBoolDiff(GetPo(i));
+        UpdObjForBoolDiff(GetPo(i), scratch);
         // fmt::print("update node {}: {}\n", *GetPo(i), tempDat[GetPoId(i)]);
     }
 
     // get Boolean difference
-    bdPosWrtNode.resize(GetPoNum());
+    if (!bdPosWrtNode.IsShape(GetPoNum(), nFrame))
+        bdPosWrtNode.Resize(GetPoNum(), nFrame);
     for (int i = 0; i < GetPoNum(); ++i) {
         int poId = GetPoId(i);
-        bdPosWrtNode[i] = dat[poId] ^ tempDat[poId];
+        bdPosWrtNode[i].AssignXor(dat[poId], tempDat[poId]);
         // fmt::print("po: {}, bdPosWrtNode[{}]: {}, dat[poId]: {}, tempDat[poId]: {}\n", *GetPo(i), i, bdPosWrtNode[i], dat[poId], tempDat[poId]);
     }
 }
 
 
-void Simulator::CalcLocBoolDiff(AbcObj* pObj, list <AbcObj*>& disjCut, vector <AbcObj*>& cutNtk, vector < BitVect >& bdCut2Node) {
+/**
+ * @brief Simulate the node or PO pObj with the compiled program
+ * @brief The fanins that are traversed read the temporary patterns, the others read dat; the result is stored in the temporary patterns
+ * @brief Auxiliary function for computing Boolean difference
+ * 
+ * @param pObj      the node or PO to be simulated
+ * @param scratch   the scratch of the calling thread
+ */
+void Simulator::UpdObjForBoolDiff(AbcObj* pObj, BoolDiffScratch& scratch) const {
+    int iInstr = prog.instrOfObj[pObj->Id];
+    assert(iInstr != -1);
+    auto& tempDat = scratch.tempDat;
+    auto getRow = [&](int id) {
+        return static_cast<const ull*>(scratch.IsTrav(id)? tempDat[id].GetWords(): dat[id].GetWords());
+    };
+    auto out = tempDat[pObj->Id];
+    int nWord = out.GetWordNum();
+    ExecInstr(prog, prog.instrs[iInstr], getRow, out.GetWords(), 0, nWord);
+    if (nWord)
+        out.GetWords()[nWord - 1] &= GetTailMask(nFrame);
+    // mark the node as traversed
+    scratch.SetTrav(pObj->Id);
+}
+
+
+void Simulator::CalcLocBoolDiff(AbcObj* pObj, list <AbcObj*>& disjCut, vector <AbcObj*>& cutNtk, BitMat& bdCut2Node) {
     assert(pObj->pNtk == GetNet());
-    if (tempDat.size() != dat.size())
-        tempDat.resize(dat.size(), BitVect(nFrame, 0));
+    if (!bdScratch.tempDat.IsShape(dat.GetRowNum(), nFrame))
+        bdScratch.tempDat.Resize(dat.GetRowNum(), nFrame);
     // flip the node
-    tempDat[pObj->Id] = ~dat[pObj->Id];
+    bdScratch.tempDat[pObj->Id].AssignNot(dat[pObj->Id]);
     // simulate
     Abc_NtkIncrementTravId(GetNet());
     Abc_NodeSetTravIdCurrent(pObj);
@@ -798,18 +1295,78 @@ void Simulator::CalcLocBoolDiff(AbcObj* pObj, list <AbcObj*>& disjCut, vector <A
     else
         assert(0);
     // get boolean difference from the node to its disjoint cuts
-    bdCut2Node.resize(disjCut.size(), BitVect(nFrame, 0));
+    if (!bdCut2Node.IsShape(static_cast<int>(disjCut.size()), nFrame))
+        bdCut2Node.Resize(static_cast<int>(disjCut.size()), nFrame);
     int i = 0;
     for (auto& pCut: disjCut) {
-        bdCut2Node[i] = dat[pCut->Id] ^ tempDat[pCut->Id];
+        bdCut2Node[i].AssignXor(dat[pCut->Id], bdScratch.tempDat[pCut->Id]);
         ++i;
     }
 }
 
 
+/**
+ * @brief Calculate the observability of the nodes in the fanout-free region (FFR) of pRoot at pRoot
+ * @brief Inside an FFR, a node reaches the POs only through its single fanout, so flipping the node changes the POs
+ * @brief exactly on obsFfr2Root[i] & (Boolean difference of the POs w.r.t. pRoot), see CalcBoolDiff;
+ * @brief each node costs one local simulation of its fanout, instead of simulating its whole TFO
+ *
+ * @param pRoot               the root of the FFR, e.g., from GetFfrRoot
+ * @param ffrNodes            the nodes in the FFR
+ * @retval ffrNodes           the nodes in the FFR, where ffrNodes[0] is pRoot and each fanout precedes its fanins
+ * @param obsFfr2Root         the observability of the nodes at pRoot
+ * @param scratch             the scratch of the calling thread
+ * @retval obsFfr2Root[i]     the patterns under which flipping ffrNodes[i] flips pRoot
+ * @return void
+ */
+void Simulator::CalcObsInFfr(AbcObj* pRoot, AbcObjVect& ffrNodes, BitMat& obsFfr2Root, BoolDiffScratch& scratch) const {
+    // check
+    assert(GetNetType() == NET_TYPE::SOP);
+    assert(IsNode(pRoot) && pRoot->pNtk == GetNet());
+    assert(IsProgValid());
+    auto& tempDat = scratch.tempDat;
+    if (!tempDat.IsShape(dat.GetRowNum(), nFrame))
+        tempDat.Resize(dat.GetRowNum(), nFrame);
+
+    // collect the FFR in breadth-first order, so that the fanout of a node is visited before the node
+    auto& ffrFanoutRows = scratch.ffrFanoutRows;
+    ffrNodes.assign(1, pRoot);
+    ffrFanoutRows.assign(1, -1);
+    for (int i = 0; i < static_cast<int>(ffrNodes.size()); ++i) {
+        auto pObj = ffrNodes[i];
+        for (int iFanin = 0; iFanin < GetFaninNum(pObj); ++iFanin) {
+            auto pFanin = GetFanin(pObj, iFanin);
+            if (IsNode(pFanin) && GetFanoutNum(pFanin) == 1) {
+                ffrNodes.emplace_back(pFanin);
+                ffrFanoutRows.emplace_back(i);
+            }
+        }
+    }
+
+    // compose the local Boolean differences from the root down to the leaves
+    int nFfr = static_cast<int>(ffrNodes.size());
+    if (obsFfr2Root.GetBitNum() != nFrame || obsFfr2Root.GetRowNum() < nFfr)
+        obsFfr2Root.Resize(nFfr, nFrame);
+    obsFfr2Root[0].Fill(true);
+    for (int i = 1; i < nFfr; ++i) {
+        auto pObj = ffrNodes[i];
+        auto pFanout = ffrNodes[ffrFanoutRows[i]];
+        // flip the node and simulate its fanout
+        scratch.StartTrav(GetIdMaxPlus1());
+        scratch.SetTrav(pObj->Id);
+        tempDat[pObj->Id].AssignNot(dat[pObj->Id]);
+        UpdObjForBoolDiff(pFanout, scratch);
+        // the node is observable at the root if it is observable at its fanout, and the fanout is observable at the root
+        auto obs = obsFfr2Root[i];
+        obs.AssignXor(dat[pFanout->Id], tempDat[pFanout->Id]);
+        obs.AndWith(obsFfr2Root[ffrFanoutRows[i]], false);
+    }
+}
+
+
 /**
  * @brief Simulate the node pObj with its sum-of-products (SOP) function
- * @brief The simulation result is stored in tempDat
+ * @brief The simulation result is stored in the temporary patterns
  * @brief Auxiliary function for computing Boolean difference
  * 
  * @param pObj   the node to be simulated
@@ -821,9 +1378,9 @@ void Simulator::UpdSopNodeForBoolDiff(AbcObj* pObj) {
         AbcObj* pDriver = Abc_ObjFanin0(pObj);
         assert(!Abc_ObjIsComplement(pObj));
         if (Abc_NodeIsTravIdCurrent(pDriver))
-            tempDat[pObj->Id] = tempDat[pDriver->Id];
+            bdScratch.tempDat[pObj->Id].Assign(bdScratch.tempDat[pDriver->Id]);
         else
-            tempDat[pObj->Id] = dat[pDriver->Id];
+            bdScratch.tempDat[pObj->Id].Assign(dat[pDriver->Id]);
         return;
     }
     UpdSopForBoolDiff(pObj, static_cast<char*>(pObj->pData));
@@ -836,9 +1393,9 @@ void Simulator::UpdGateNodeForBoolDiff(AbcObj* pObj) {
     if (Abc_ObjIsPo(pObj)) {
         AbcObj* pDriver = Abc_ObjFanin0(pObj);
         if (Abc_NodeIsTravIdCurrent(pDriver))
-            tempDat[pObj->Id] = tempDat[pDriver->Id];
+            bdScratch.tempDat[pObj->Id].Assign(bdScratch.tempDat[pDriver->Id]);
         else
-            tempDat[pObj->Id] = dat[pDriver->Id];
+            bdScratch.tempDat[pObj->Id].Assign(dat[pDriver->Id]);
         return;
     }
     // update sop
@@ -848,53 +1405,11 @@ void Simulator::UpdGateNodeForBoolDiff(AbcObj* pObj) {
 
 
 void Simulator::UpdSopForBoolDiff(AbcObj* pObj, char* pSop) {
-    int nVars = Abc_SopGetVarNum(pSop);
-    BitVect product(nFrame, 0);
-    for (char* pCube = pSop; *pCube; pCube += nVars + 3) {
-        bool isFirst = true;
-        for (int i = 0; pCube[i] != ' '; i++) {
-            AbcObj* pFanin = Abc_ObjFanin(pObj, i);
-            BitVect& datFi = Abc_NodeIsTravIdCurrent(pFanin)? tempDat[pFanin->Id]: dat[pFanin->Id];
-            // fmt::print("pObj: {}, pFanin: {}, datFi: {}\n", *pObj, *pFanin, datFi);
-            switch (pCube[i]) {
-                case '-':
-                    continue;
-                    break;
-                case '0':
-                    if (isFirst) {
-                        isFirst = false;
-                        product = ~datFi;
-                    }
-                    else
-                        product &= ~datFi;
-                    break;
-                case '1':
-                    if (isFirst) {
-                        isFirst = false;
-                        product = datFi;
-                    }
-                    else
-                        product &= datFi;
-                    break;
-                default:
-                    assert(0);
-            }
-        }
-        if (isFirst) {
-            isFirst = false;
-            product.set();
-        }
-        assert(!isFirst);
-        if (pCube == pSop) {
-            tempDat[pObj->Id] = product;
-        }
-        else
-            tempDat[pObj->Id] |= product;
-    }
-
-    // complement
-    if (Abc_SopIsComplement(pSop))
-        tempDat[pObj->Id].flip();
+    auto getFaninDat = [&](int i) {
+        AbcObj* pFanin = Abc_ObjFanin(pObj, i);
+        return Abc_NodeIsTravIdCurrent(pFanin)? ConstBitSpan(bdScratch.tempDat[pFanin->Id]): ConstBitSpan(dat[pFanin->Id]);
+    };
+    EvalSop(pSop, getFaninDat, bdScratch.tempDat[pObj->Id]);
 
     // mark the node as traversed
     Abc_NodeSetTravIdCurrent(pObj);
@@ -910,7 +1425,7 @@ void Simulator::PrintDat() const {
     fmt::print("{}Simulation patterns{}\n", HALF_DASH_LINE, HALF_DASH_LINE);
     for (int i = 0; i < GetIdMaxPlus1(); ++i) {
         if (IsObj(i))
-            fmt::print("{}:{}\n", *GetObj(i), dat[i]);
+            fmt::print("{}:{}\n", *GetObj(i), dat[i].ToBitVect());
     }
     fmt::print("{}\n", DASH_LINE);
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #pragma once
 
 
+#include "bit_mat.h"
 #include "header.h"
 #include "my_abc.h"
 
@@ -29,6 +30,7 @@ struct fmt::formatter<DISTR_TYPE> {
         return fmt::format_to(ctx.out(), "{}", strs[static_cast<int>(value)]);
     }
 };
+const int ENUM_WINDOW_FRAME = 1 << 16; // number of enumerated patterns simulated at a time, when the enumeration is streamed in windows
 
 
 /**
@@ -72,6 +74,104 @@ static inline void GetValue(const std::vector<BitVect>& dat, int iPatt, BigInt&
 }
 
 
+/**
+ * @brief Get the value encoded by the binary pattern dat[iPatt]
+ * @brief Assume the value is an unsigned integer
+ * 
+ * @param dat          the data, row k holds bit k of the value
+ * @param iPatt        the pattern index
+ * @param ret          the value
+ * @retval ret         the value
+ * @return void
+ */
+static inline void GetValue(const BitMat& dat, int iPatt, BigInt& ret) {
+    int msb = dat.GetRowNum() - 1;
+    assert(msb < 500);
+    ret = 0;
+    for (ll k = msb; k >= 0; --k) {
+        ret <<= 1;
+        ret |= static_cast<int>(dat[k][iPatt]);
+    }
+}
+
+
+/**
+ * @brief Operation of an instruction in the compiled simulation program
+ */
+enum class SIM_OP: uint8_t {
+    BUF, AND2, OR2, XOR2, SOP
+};
+
+
+/**
+ * @brief Literal of a cube in the compiled simulation program
+ */
+struct SimLit {
+    int id;            // the fanin object ID
+    ull complMask;     // ~0 if the fanin is complemented, 0 otherwise
+};
+
+
+/**
+ * @brief Instruction of the compiled simulation program
+ * @brief BUF/AND2/OR2/XOR2: out = op(fanins[0] ^ complMasks[0], fanins[1] ^ complMasks[1]) ^ outMask
+ * @brief SOP: out = OR of the cubes [iCube, iCube + nCube) in the cube pool, each being an AND of literals, then ^ outMask
+ */
+struct SimInstr {
+    SIM_OP op;          // the operation
+    int outId;          // the output object ID
+    int fanins[2];      // the fanin object IDs of BUF/AND2/OR2/XOR2
+    ull complMasks[2];  // the complement masks of the fanins of BUF/AND2/OR2/XOR2
+    ull outMask;        // the complement mask of the output
+    int iCube;          // the first cube of SOP
+    int nCube;          // the number of cubes of SOP
+};
+
+
+/**
+ * @brief Compiled simulation program: the nodes and POs lowered into a flat instruction stream in topological order
+ */
+struct SimProg {
+    std::vector<SimInstr> instrs;    // the instructions in topological order
+    std::vector<IntPair> cubes;      // cubes[i] = [begin, end) of the literals of the i-th cube
+    std::vector<SimLit> lits;        // the literal pool
+    IntVect instrOfObj;              // instrOfObj[id] is the instruction computing the object id; -1 if none
+    bool fValid = false;             // whether the program matches the network
+    ull structVer = 0;               // the structure version of the network when the program was compiled
+    int idMaxPlus1 = -1;             // the maximum object ID plus 1 when the program was compiled, to catch missed version updates
+    int nObj = -1;                   // the number of objects when the program was compiled, to catch missed version updates
+
+    inline void Clear() {instrs.clear(); cubes.clear(); lits.clear(); instrOfObj.clear(); fValid = false;}
+};
+
+
+/**
+ * @brief Record of the undo log: the words [w0, w1) of the object id before they were overwritten
+ */
+struct SimUndoRec {
+    int id;            // the object ID
+    int w0;            // the first word
+    int w1;            // the last word plus 1
+    ll iWord;          // the position of the saved words in the undo buffer
+};
+
+
+/**
+ * @brief Scratch of the Boolean-difference computation; each thread owns one, so that the computation only reads the simulator
+ */
+struct BoolDiffScratch {
+    BitMat tempDat;          // tempDat[id], patterns of the object id after flipping the node
+    IntVect travIds;         // travIds[id] == travId if the object id depends on the flipped node
+    int travId = 0;          // the current traversal ID
+    IntVect ffrFanoutRows;   // ffrFanoutRows[i] is the row of the fanout of the i-th node in the FFR
+    SimProg sopProg;         // the compiled program of SimSop
+
+    inline void StartTrav(int idMaxPlus1) {if (static_cast<int>(travIds.size()) < idMaxPlus1) travIds.resize(idMaxPlus1, 0); ++travId;}
+    inline bool IsTrav(int id) const {return travIds[id] == travId;}
+    inline void SetTrav(int id) {travIds[id] = travId;}
+};
+
+
 /**
  * @brief Simulator for a circuit network
  */
@@ -80,8 +180,30 @@ private:
     unsigned seed;                  // random seed for generating input patterns
     int nFrame;                     // number of simulation frames (patterns)
     DISTR_TYPE distrType;           // input distribution type
-    std::vector<BitVect> dat;       // dat[pObj->Id], simulation patterns for the node pObj
-    std::vector<BitVect> tempDat;   // tempDat[pObj->Id], temporary simulation patterns for the node pObj
+    BitMat dat;                     // dat[pObj->Id], simulation patterns for the node pObj
+    BitMat product;                 // scratch row for the cubes of SOPs
+    SimProg prog;                   // the compiled simulation program of the network
+    BoolDiffScratch bdScratch;      // scratch of the Boolean-difference computation of the calling thread
+    std::vector<uint8_t> objStates; // objStates[id], flags of incremental simulation
+    IntVect dirtyIds;               // the objects whose patterns were changed since the last incremental simulation
+    int dirtyW0;                    // the first dirty word
+    int dirtyW1;                    // the last dirty word plus 1
+    bool fDirtyAll;                 // whether all objects should be resimulated on the dirty words
+    bool fUndoLog;                  // whether the overwritten words are saved in the undo log
+    std::vector<SimUndoRec> undoRecs; // the undo log
+    std::vector<ull> undoWords;     // the saved words of the undo log
+    std::vector<ull> oldWords;      // scratch words for change detection
+
+    template <typename GetFaninDat>
+    void EvalSop(char* pSop, GetFaninDat&& getFaninDat, BitSpan res);
+    template <typename GetRow>
+    static void ExecInstr(const SimProg& prg, const SimInstr& instr, GetRow&& getRow, ull* pOut, int w0, int w1);
+    static void CompileSop(int outId, std::span<const int> faninIds, char* pSop, SimProg& prg);
+    void CompileProg();
+    void RunProg(int w0 = 0, int w1 = -1);
+    const ull* SaveWords(int id, int w0, int w1);
+    inline void ResetDirty() {dirtyIds.clear(); dirtyW0 = INT_MAX; dirtyW1 = 0; fDirtyAll = false;}
+    void UpdObjForBoolDiff(AbcObj* pObj, BoolDiffScratch& scratch) const;
 
 public:
     explicit Simulator(const NetMan& net_man, unsigned _seed, int n_frame, DISTR_TYPE distr_type = DISTR_TYPE::UNIF);
@@ -91,16 +213,18 @@ public:
     Simulator& operator = (const Simulator&) = delete;
     Simulator& operator = (Simulator&&) = delete;
 
+    void Rebind(const NetMan& net_man);
     void InitConstNodes();
     void GenInpUnif();
-    void GenInpUnifFast();
+    void GenInpUnifFast(int nThread = 1);
     void GenInpEnum();
+    void GenInpEnumWindow(ll iFirstPatt);
     void GenInpFromOthSmlt(const Simulator& othSmlt);
     void GenInpFromBitVects(const std::vector<BitVect>& piPatts);
     void ReplInp(int iPatt, const IntVect& piVals);
     void AppendInp(const IntVect& piVals);
     void UpdNodeAndPoPatts();
-    void SimSop(const IntVect& faninIds, const std::string& sop, BitVect& res);
+    void SimSop(std::span<const int> faninIds, const std::string& sop, BitSpan res, BoolDiffScratch& scratch) const;
     void UpdAigNode(AbcObj* pObj);
     void UpdSopNode(AbcObj* pObj);
     void UpdGateNode(AbcObj* pObj);
@@ -119,16 +243,30 @@ public:
     double GetMeanErrDist(const Simulator& oth_smlt, bool isCheck = false) const;
     ll GetMaxErrDistFast(const Simulator& oth_smlt, bool isCheck = false) const;
     void GetMaxErrDist(const Simulator& oth_smlt, bool isCheck, BigInt& maxErrLowBound) const;
-    void CalcBoolDiff(const AbcObjVect& topoNodes, int idx, std::vector<BitVect>& bdPosWrtNode);
-    void CalcLocBoolDiff(AbcObj* pObj, std::list <AbcObj*>& disjCut, std::vector <AbcObj*>& cutNtk, std::vector <BitVect>& bdCut2Node);
+    void PrepBoolDiff();
+    void CalcBoolDiff(const AbcObjVect& topoNodes, int idx, BitMat& bdPosWrtNode, BoolDiffScratch& scratch) const;
+    void CalcLocBoolDiff(AbcObj* pObj, std::list <AbcObj*>& disjCut, std::vector <AbcObj*>& cutNtk, BitMat& bdCut2Node);
+    void CalcObsInFfr(AbcObj* pRoot, AbcObjVect& ffrNodes, BitMat& obsFfr2Root, BoolDiffScratch& scratch) const;
     void UpdSopNodeForBoolDiff(AbcObj* pObj);
     void UpdGateNodeForBoolDiff(AbcObj* pObj);
     void UpdSopForBoolDiff(AbcObj* pObj, char* pSop);
     void PrintDat() const;
+    void SetInp(int ithPi, ConstBitSpan src);
+    void MarkDirty(int id, int w0, int w1);
+    void UpdTfoPatts(const IntVect& seedIds, int w0 = 0, int w1 = -1);
+    void UpdDirtyPatts();
+    void StartUndoLog();
+    void StopUndoLog();
+    void RollBack();
 
-    inline void GenInpPatts() {if (distrType == DISTR_TYPE::UNIF) GenInpUnifFast(); else if (distrType == DISTR_TYPE::ENUM) GenInpEnum(); else assert(0);}
+    inline void GenInpPatts(int nThread = 1) {if (distrType == DISTR_TYPE::UNIF) GenInpUnifFast(nThread); else if (distrType == DISTR_TYPE::ENUM) GenInpEnum(); else assert(0);}
     inline int GetFrameNumb() const {return nFrame;}
-    inline void LogicSim() {GenInpPatts(); UpdNodeAndPoPatts();}
-    inline const BitVect& GetDat(int id) const {return dat[id];}
-    inline void SetPiConst(int ithPi, int const1) {if (const1) dat[GetPiId(ithPi)].set(); else dat[GetPiId(ithPi)].reset();}
+    inline void LogicSim(int nThread = 1) {GenInpPatts(nThread); UpdNodeAndPoPatts();}
+    inline ConstBitSpan GetDat(int id) const {return dat[id];}
+    inline void SimSop(std::span<const int> faninIds, const std::string& sop, BitSpan res) {SimSop(faninIds, sop, res, bdScratch);}
+    inline void CalcBoolDiff(const AbcObjVect& topoNodes, int idx, BitMat& bdPosWrtNode) {PrepBoolDiff(); CalcBoolDiff(topoNodes, idx, bdPosWrtNode, bdScratch);}
+    inline void CalcObsInFfr(AbcObj* pRoot, AbcObjVect& ffrNodes, BitMat& obsFfr2Root) {PrepBoolDiff(); CalcObsInFfr(pRoot, ffrNodes, obsFfr2Root, bdScratch);}
+    inline bool IsProgValid() const {return prog.fValid && prog.structVer == GetStructVer();}
+    inline void InvalidateProg() {prog.fValid = false;}
+    inline void SetPiConst(int ithPi, int const1) {dat[GetPiId(ithPi)].Fill(const1);}
 };
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 #include <assert.h>
+#include <fstream>
 #include <vector>
 #include <cryptominisat.h>
+#include "als.h"
 #include "error.h"
 
 
@@ -108,6 +110,151 @@ TEST(ALSTest, LogicSimulator) {
 }
 
 
+/**
+ * @brief Test the windows of the enumerated patterns using a multiplier
+ * 
+ */
+TEST(ALSTest, EnumWindowSimulator) {
+    GlobStartAbc();
+
+    NetMan net("./als/tests/benchmarks/am8.blif");
+    // aligned windows use the word-level generation, the unaligned one is generated bit by bit
+    for (auto [nWinFrame, iFirstPatt]: {IntPair{4096, 0}, IntPair{4096, 1 << 15}, IntPair{1000, 12345}}) {
+        Simulator smlt(net, 0, nWinFrame);
+        smlt.GenInpEnumWindow(iFirstPatt);
+        smlt.UpdNodeAndPoPatts();
+        for (int i = 0; i < nWinFrame; ++i) {
+            int op0 = static_cast<int>(smlt.GetInput(i, 0, 7));
+            int op1 = static_cast<int>(smlt.GetInput(i, 8, 15));
+            EXPECT_EQ(op0 + (op1 << 8), iFirstPatt + i);
+            EXPECT_EQ(smlt.GetOutputFast(i), op0 * op1);
+        }
+    }
+
+    GlobStopAbc();
+}
+
+
+/**
+ * @brief Test the uniform input patterns: reproducible, with a masked tail, and each PI stream is independent of the number of frames
+ * 
+ */
+TEST(ALSTest, UnifInpGeneration) {
+    GlobStartAbc();
+
+    NetMan net("./als/tests/benchmarks/am8.blif");
+    Simulator smlt0(net, 7, 100), smlt1(net, 7, 100), smlt2(net, 7, 64);
+    smlt0.GenInpUnifFast();
+    smlt1.GenInpUnifFast();
+    smlt2.GenInpUnifFast();
+    for (int i = 0; i < net.GetPiNum(); ++i) {
+        auto piDat = smlt0.GetDat(net.GetPiId(i));
+        EXPECT_EQ(piDat.ToBitVect(), smlt1.GetDat(net.GetPiId(i)).ToBitVect());
+        EXPECT_EQ(piDat.GetWords()[1] >> 36, 0ull);
+        EXPECT_EQ(piDat.GetWords()[0], smlt2.GetDat(net.GetPiId(i)).GetWords()[0]);
+    }
+    EXPECT_NE(smlt0.GetDat(net.GetPiId(0)).GetWords()[0], smlt0.GetDat(net.GetPiId(1)).GetWords()[0]);
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, ProgRecompileTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan appNet("./als/tests/benchmarks/absdiff.blif");
+    // create the constants first, so that the LAC creates no object
+    appNet.CreateConstsIfNotExist();
+    Simulator smlt(appNet, 3, 1000);
+    smlt.LogicSim();
+    LACMan lacMan;
+    lacMan.GenConstLACs(appNet);
+    ASSERT_GT(lacMan.GetLacNum(), 0);
+    // a constant LAC only patches fanouts, keeping the object count and the maximum ID, yet the program follows it
+    auto expectSameAsFresh = [&]() {
+        smlt.UpdNodeAndPoPatts();
+        Simulator refSmlt(appNet, 3, 1000);
+        refSmlt.LogicSim();
+        for (int i = 0; i < 1000; ++i)
+            EXPECT_EQ(smlt.GetOutputFast(i), refSmlt.GetOutputFast(i));
+    };
+    // a LAC on a PO driver surely changes the outputs
+    int iLac = 0;
+    while (iLac + 1 < lacMan.GetLacNum() && !appNet.IsPoDriver(appNet.GetObj(lacMan.GetLac(iLac).GetTargId())))
+        ++iLac;
+    int nObj = appNet.GetObjNum(), idMaxPlus1 = appNet.GetIdMaxPlus1();
+    IntVect replTrace;
+    TempApplyLac(appNet, lacMan.GetLac(iLac), replTrace, false);
+    EXPECT_EQ(appNet.GetObjNum(), nObj);
+    EXPECT_EQ(appNet.GetIdMaxPlus1(), idMaxPlus1);
+    expectSameAsFresh();
+    RecovNet(appNet, {replTrace}, false);
+    expectSameAsFresh();
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, RebindSimulator) {
+    GlobStartAbc();
+
+    NetMan net("./als/tests/benchmarks/am8.blif");
+    auto strashNet = net;
+    strashNet.Comm("st");
+    ASSERT_TRUE(strashNet.IsStrash());
+    // a simulator rebound to the AIG reuses its buffers and gives the outputs of a fresh one
+    Simulator smlt(net, 7, 1000), refSmlt(strashNet, 7, 1000);
+    smlt.LogicSim();
+    smlt.Rebind(strashNet);
+    refSmlt.LogicSim();
+    for (int i = 0; i < strashNet.GetPiNum(); ++i)
+        smlt.SetInp(i, refSmlt.GetDat(strashNet.GetPiId(i)));
+    smlt.InitConstNodes();
+    smlt.UpdNodeAndPoPatts();
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(smlt.GetOutputFast(i), refSmlt.GetOutputFast(i));
+
+    GlobStopAbc();
+}
+
+
+/**
+ * @brief Test the Boolean difference composed inside fanout-free regions against the exact one
+ * 
+ */
+TEST(ALSTest, FfrBoolDiff) {
+    GlobStartAbc();
+
+    NetMan net("./als/tests/benchmarks/am8.blif");
+    Simulator smlt(net, 0, 1000);
+    smlt.LogicSim();
+    auto topoNodes = smlt.CalcTopoOrd(false);
+    IntVect topoIdx(smlt.GetIdMaxPlus1(), -1);
+    for (int i = 0; i < static_cast<int>(topoNodes.size()); ++i)
+        topoIdx[topoNodes[i]->Id] = i;
+    AbcObjVect ffrNodes;
+    BitMat obsFfr2Root, bdExact, bdRoot;
+    int nCheck = 0;
+    for (int i = 0; i < static_cast<int>(topoNodes.size()) && nCheck < 50; ++i) {
+        auto pRoot = smlt.GetFfrRoot(topoNodes[i]);
+        if (pRoot == topoNodes[i])
+            continue;
+        ++nCheck;
+        smlt.CalcBoolDiff(topoNodes, i, bdExact);
+        smlt.CalcBoolDiff(topoNodes, topoIdx[pRoot->Id], bdRoot);
+        smlt.CalcObsInFfr(pRoot, ffrNodes, obsFfr2Root);
+        auto it = std::ranges::find(ffrNodes, topoNodes[i]);
+        ASSERT_NE(it, ffrNodes.end());
+        auto obs = obsFfr2Root[static_cast<int>(it - ffrNodes.begin())].ToBitVect();
+        for (int j = 0; j < smlt.GetPoNum(); ++j)
+            EXPECT_EQ(bdExact[j].ToBitVect(), obs & bdRoot[j].ToBitVect());
+    }
+    EXPECT_GT(nCheck, 0);
+
+    GlobStopAbc();
+}
+
+
 /**
  * @brief Test error manager for measuring maximum error
  * 
@@ -282,3 +429,484 @@ TEST(ALSTest, ErrManTestAm8) {
     GlobStopAbc();
 }
 
+
+
+TEST(ALSTest, IncErrManTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan accNet("./als/tests/benchmarks/absdiff.blif");
+    NetMan appNet(accNet);
+    const ll bound = 3;
+    int nPo = accNet.GetPoNum();
+    auto pDevNet = GenDevCompNetEmbedErrBound(GenDevCompNet(METR_TYPE::MAXED, nPo), nPo, bound);
+    LACMan lacMan;
+    lacMan.GenConstLACs(appNet);
+    IncErrMan incErrMan(accNet, appNet, *pDevNet);
+    IntVect replTrace, counterEx;
+    for (const auto& lac: lacMan.GetLacs()) {
+        if (appNet.GetFanoutNum(lac.GetTargId()) == 0)
+            continue;
+        int ssId = TempApplyLac(appNet, lac, replTrace, false);
+        auto resInc = incErrMan.CheckCand(ssId, counterEx);
+        auto resRef = ErrMan(accNet, appNet, *pDevNet).SolveSat();
+        EXPECT_EQ(resInc, resRef);
+        if (resInc == CMSat::l_False)
+            incErrMan.CommitCand();
+        else {
+            incErrMan.RejectCand();
+            RecovNet(appNet, {replTrace}, false);
+        }
+    }
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, CexGroupCheckTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan accNet("./als/tests/benchmarks/absdiff.blif");
+    NetMan appNet(accNet);
+    const ll bound = 3;
+    const int nCex = 64;
+    int nPo = accNet.GetPoNum();
+    auto pDevNet = GenDevCompNetEmbedErrBound(GenDevCompNet(METR_TYPE::MAXED, nPo), nPo, bound);
+    // the counter examples are random patterns, and the reference simulates the whole network under them
+    Simulator accSmlt(accNet, 1, nCex);
+    accSmlt.LogicSim();
+    CexErrChecker cexChecker(accNet, appNet, *pDevNet);
+    IntVect piVals;
+    for (int iPatt = 0; iPatt < nCex; ++iPatt) {
+        accSmlt.GetInpVect(iPatt, piVals);
+        cexChecker.AddCounterEx(piVals);
+    }
+    auto exceedRef = [&]() {
+        Simulator appSmlt(appNet, 1, nCex);
+        appSmlt.LogicSim();
+        return appSmlt.GetMaxErrDistFast(accSmlt) > bound;
+    };
+    // the groups of consecutive constant LACs are checked together, and the passing groups are committed
+    LACMan lacMan;
+    lacMan.GenConstLACs(appNet);
+    const int GROUP_SIZE = 3;
+    int nCommit = 0;
+    for (int iBeg = 0; iBeg + GROUP_SIZE <= lacMan.GetLacNum(); iBeg += GROUP_SIZE) {
+        IntVect ssIds;
+        Int2DVect replTraces;
+        IntSet targIds;
+        for (int i = iBeg; i < iBeg + GROUP_SIZE; ++i) {
+            const auto& lac = lacMan.GetLac(i);
+            if (appNet.GetFanoutNum(lac.GetTargId()) == 0 || !targIds.insert(lac.GetTargId()).second)
+                continue;
+            replTraces.emplace_back();
+            ssIds.emplace_back(TempApplyLac(appNet, lac, replTraces.back(), false));
+        }
+        if (ssIds.empty())
+            continue;
+        bool fExceed = cexChecker.ExceedWithCands(ssIds, replTraces);
+        EXPECT_EQ(fExceed, exceedRef());
+        if (fExceed)
+            RecovNet(appNet, replTraces, false);
+        else {
+            cexChecker.CommitCands(ssIds, replTraces);
+            ++nCommit;
+        }
+    }
+    EXPECT_GT(nCommit, 0);
+    EXPECT_FALSE(exceedRef());
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, GroupVerifTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan accNet("./als/tests/benchmarks/absdiff.blif");
+    const ll bound = 3;
+    ALSOpt options("MAXED", 1, 1 << 10, 0, 0, bound, "./");
+    options.nMaxGroup = 8;
+    options.fQuiet = 1;
+    ALSMan alsMan(accNet, options);
+    // the group verification and the per-LAC verification start from the same network and LACs
+    NetMan grpNet(accNet), refNet(accNet);
+    LACMan grpLacMan, refLacMan;
+    grpLacMan.GenConstLACs(grpNet);
+    refLacMan.GenConstLACs(refNet);
+    LacBlackList grpBlackList, refBlackList;
+    bool fGrpValid = alsMan.ApplyMultValidLacs_Group(grpLacMan, grpNet, grpBlackList);
+    bool fRefValid = alsMan.ApplyMultValidLacs(refLacMan, refNet, refBlackList);
+    EXPECT_TRUE(fRefValid);
+    EXPECT_EQ(fGrpValid, fRefValid);
+    // the committed groups keep the real maximum error within the bound, as the per-LAC commits do
+    int nPo = accNet.GetPoNum();
+    auto pDevNet = GenDevCompNetEmbedErrBound(GenDevCompNet(METR_TYPE::MAXED, nPo), nPo, bound);
+    EXPECT_EQ(ErrMan(accNet, grpNet, *pDevNet).SolveSat(), CMSat::l_False);
+    EXPECT_EQ(ErrMan(accNet, refNet, *pDevNet).SolveSat(), CMSat::l_False);
+    EXPECT_LE(static_cast<ll>(ErrMan(accNet, grpNet).ComputeMaxErr(METR_TYPE::MAXED)), bound);
+    EXPECT_LT(grpNet.GetNodeNum(), accNet.GetNodeNum());
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, TruncErrManTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan accNet("./als/tests/benchmarks/absdiff.blif");
+    NetMan appNet(accNet);
+    auto constIds = appNet.CreateConstsIfNotExist();
+    appNet.MergeConst();
+    TruncErrMan truncMan(accNet, appNet, METR_TYPE::MAXED);
+    IntVect replTrace;
+    for (int iPo = 0; iPo < std::min(4, appNet.GetPoNum()); ++iPo) {
+        auto drivId = appNet.GetPoDrivId(iPo);
+        BigInt maxErrs[2];
+        for (int val = 0; val < 2; ++val) {
+            int constId = val? constIds.second: constIds.first;
+            maxErrs[val] = truncMan.TryTrunc(iPo, val);
+            if (drivId != constId)
+                appNet.TempRepl_v2(drivId, constId, replTrace, false);
+            auto maxErrRef = ErrMan(accNet, appNet).ComputeMaxErr(METR_TYPE::MAXED);
+            if (drivId != constId)
+                appNet.Recov_v2(replTrace, false);
+            EXPECT_EQ(maxErrs[val], maxErrRef);
+        }
+        int val = maxErrs[1] < maxErrs[0];
+        int constId = val? constIds.second: constIds.first;
+        if (drivId != constId)
+            appNet.TempRepl_v2(drivId, constId, replTrace, false);
+        truncMan.CommitTrunc(iPo, val);
+    }
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, BitSliceMaxAbsDiffTest) {
+    boost::random::mt19937 rng(2025);
+    const int nRow = 12, nPatt = 1000;
+    std::vector<BitVect> app(nRow, BitVect(nPatt, 0)), acc(nRow, BitVect(nPatt, 0));
+    LLVect diffs(nPatt);
+    for (int iPatt = 0; iPatt < nPatt; ++iPatt) {
+        ll y = rng() % (1 << nRow), a = (iPatt % 7 == 0)? (y ^ (rng() % 64)): y;
+        for (int k = 0; k < nRow; ++k) {
+            app[k][iPatt] = (y >> k) & 1;
+            acc[k][iPatt] = (a >> k) & 1;
+        }
+        diffs[iPatt] = std::abs(y - a);
+    }
+    int nWord = GetBitSliceWordNum(nPatt);
+    std::vector<ull> appWords, accWords, scratch;
+    LoadBitSlices(app, nWord, appWords);
+    LoadBitSlices(acc, nWord, accWords);
+    for (ll bound: {0ll, 15ll, 40ll, 63ll}) {
+        auto res = ScanMaxAbsDiff(appWords.data(), accWords.data(), nRow, nWord, bound, scratch);
+        int firstExceed = -1;
+        ll maxErr = 0;
+        for (int iPatt = 0; iPatt < nPatt && firstExceed == -1; ++iPatt) {
+            if (diffs[iPatt] > bound)
+                firstExceed = iPatt;
+            else
+                maxErr = std::max(maxErr, diffs[iPatt]);
+        }
+        if (firstExceed == -1) {
+            EXPECT_EQ(res.iWordExceed, -1);
+            EXPECT_EQ(res.maxErr, maxErr);
+        }
+        else {
+            ASSERT_NE(res.iWordExceed, -1);
+            EXPECT_LE(res.iWordExceed * 64, firstExceed);
+            ll prefMaxErr = 0;
+            for (int iPatt = 0; iPatt < res.iWordExceed * 64; ++iPatt)
+                prefMaxErr = std::max(prefMaxErr, diffs[iPatt]);
+            EXPECT_EQ(res.maxErr, prefMaxErr);
+        }
+    }
+}
+
+
+TEST(ALSTest, BitMatKernelTest) {
+    boost::random::mt19937 rng(2025);
+    const int nPatt = 1000;
+    BitMat mat(4, nPatt);
+    std::vector<BitVect> refs(3, BitVect(nPatt, 0));
+    for (int i = 0; i < 3; ++i) {
+        for (int iPatt = 0; iPatt < nPatt; ++iPatt) {
+            bool val = rng() & 1;
+            refs[i][iPatt] = val;
+            mat[i].Set(iPatt, val);
+        }
+        EXPECT_EQ(mat[i].ToBitVect(), refs[i]);
+    }
+    EXPECT_EQ(CountXor(mat[0], mat[1]), static_cast<int>((refs[0] ^ refs[1]).count()));
+    for (int comb = 0; comb < 4; ++comb) {
+        bool fCompl0 = comb & 1, fCompl1 = comb >> 1;
+        auto dat0 = fCompl0? ~refs[0]: refs[0], dat1 = fCompl1? ~refs[1]: refs[1];
+        EXPECT_EQ(CountAndXor(mat[0], fCompl0, mat[1], fCompl1, mat[2]), static_cast<int>(((dat0 & dat1) ^ refs[2]).count()));
+        mat[3].AssignAnd(mat[0], fCompl0, mat[1], fCompl1);
+        EXPECT_EQ(mat[3].ToBitVect(), dat0 & dat1);
+        EXPECT_EQ(IsAndNone(mat[0], fCompl0, mat[3]), (dat0 & (dat0 & dat1)).none());
+    }
+    mat[3].AssignNot(mat[0]);
+    EXPECT_EQ(mat[3].Count(), static_cast<int>((~refs[0]).count()));
+    mat.ResizeBits(nPatt + 1000);
+    EXPECT_EQ(mat[3].Count(), static_cast<int>((~refs[0]).count()));
+    mat.ResizeBits(100);
+    refs[0].resize(100);
+    EXPECT_EQ(mat[0].ToBitVect(), refs[0]);
+    EXPECT_EQ(mat[3].Count(), static_cast<int>((~refs[0]).count()));
+}
+
+
+TEST(ALSTest, PatternBankTest) {
+    PatternBank bank(3, 2);
+    EXPECT_TRUE(bank.Add({0, 1, 1}));
+    EXPECT_FALSE(bank.Add({0, 1, 1}));
+    EXPECT_EQ(bank.GetPattNum(), 1);
+    EXPECT_EQ(bank.GetScore(0), 2);
+    EXPECT_TRUE(bank.Add({1, 0, 0}));
+    bank.AddScores({0, 5});
+    // the bank is full, so the lowest-scored pattern {0, 1, 1} is evicted
+    EXPECT_TRUE(bank.Add({1, 1, 1}));
+    EXPECT_EQ(bank.GetPattNum(), 2);
+    EXPECT_EQ(bank.GetScore(0), 1);
+    EXPECT_EQ(bank.GetScore(1), 6);
+    EXPECT_TRUE(bank.Add({0, 1, 1}));
+    EXPECT_EQ(bank.GetScore(0), 1);
+    bank.Decay();
+    EXPECT_EQ(bank.GetScore(1), 3);
+}
+
+
+TEST(ALSTest, PatternBankCkptTest) {
+    PatternBank bank(3, 4);
+    bank.Add({0, 1, 1});
+    bank.Add({1, 0, 0});
+    bank.AddScores({2, 0});
+    // the saved bank is restored with the same patterns, scores, and deduplication
+    std::stringstream ss;
+    bank.Save(ss);
+    PatternBank loadBank(3, 4);
+    loadBank.Load(ss);
+    EXPECT_EQ(loadBank.GetPattNum(), 2);
+    EXPECT_EQ(loadBank.GetScore(0), 3);
+    EXPECT_EQ(loadBank.GetScore(1), 1);
+    EXPECT_FALSE(loadBank.Add({1, 0, 0}));
+    EXPECT_EQ(loadBank.GetScore(1), 2);
+}
+
+
+TEST(ALSTest, IncLacGenTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan appNet("./als/tests/benchmarks/absdiff.blif");
+    auto getKey2Gain = [](const LACMan& lacMan) {
+        std::unordered_map<ull, int> key2Gain;
+        for (const auto& lac: lacMan.GetLacs())
+            key2Gain.emplace(lac.GetKey(), lac.GetSizeGain());
+        return key2Gain;
+    };
+    // the first call generates all LACs
+    LACMan incMan, refMan;
+    incMan.GenLACsInc(LAC_TYPE::SASIMI, appNet, 0, 0, 0, 100000);
+    refMan.GenSasimiLACs(appNet, 100000);
+    EXPECT_EQ(getKey2Gain(incMan), getKey2Gain(refMan));
+    // after applying a LAC, the kept LACs are still valid and have up-to-date size gains
+    incMan.CacheLacs();
+    int iLac = 0;
+    while (appNet.GetFanoutNum(incMan.GetLac(iLac).GetTargId()) == 0 || appNet.IsPoDriver(incMan.GetLac(iLac).GetTargId()))
+        ++iLac;
+    ApplyLac(appNet, incMan.GetLac(iLac));
+    incMan.GenLACsInc(LAC_TYPE::SASIMI, appNet, 0, 0, 0, 100000);
+    refMan.GenSasimiLACs(appNet, 100000);
+    auto refKey2Gain = getKey2Gain(refMan);
+    EXPECT_GT(incMan.GetLacNum(), 0);
+    for (const auto& lac: incMan.GetLacs()) {
+        EXPECT_TRUE(appNet.IsNode(lac.GetTargId()));
+        for (int divId: lac.GetDivIds())
+            EXPECT_TRUE(appNet.IsObj(divId));
+        auto it = refKey2Gain.find(lac.GetKey());
+        if (it != refKey2Gain.end())
+            EXPECT_EQ(lac.GetSizeGain(), it->second);
+    }
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, ParLacGenTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan net("./als/tests/benchmarks/absdiff.blif");
+    // the read-only size gain is the same as the one by dereferencing and referencing
+    std::unordered_map<int, int> nDeref;
+    for (int nodeId = 0; nodeId < net.GetIdMaxPlus1(); ++nodeId) {
+        if (!net.IsNode(nodeId))
+            continue;
+        EXPECT_EQ(net.GetSizeGainReadOnly(nodeId, IntVect{}, nDeref), net.GetSizeGain(nodeId, IntVect{}));
+        if (net.GetFaninNum(nodeId) > 0) {
+            IntVect divIds{net.GetFaninId(nodeId, 0)};
+            EXPECT_EQ(net.GetSizeGainReadOnly(nodeId, divIds, nDeref), net.GetSizeGain(nodeId, divIds));
+        }
+    }
+    // the parallel generation gives the same LACs in the same order as the serial one
+    LACMan serMan, parMan;
+    serMan.GenSasimiLACs(net, 100000, true, nullptr, 1);
+    parMan.GenSasimiLACs(net, 100000, true, nullptr, 4);
+    ASSERT_EQ(serMan.GetLacNum(), parMan.GetLacNum());
+    for (int i = 0; i < serMan.GetLacNum(); ++i) {
+        EXPECT_EQ(serMan.GetLac(i).GetKey(), parMan.GetLac(i).GetKey());
+        EXPECT_EQ(serMan.GetLac(i).GetSizeGain(), parMan.GetLac(i).GetSizeGain());
+    }
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, ParEnumPruneTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan net("./als/tests/benchmarks/absdiff.blif");
+    Simulator accSmlt(net, 0, 1 << 12, DISTR_TYPE::UNIF);
+    accSmlt.LogicSim();
+    // the serial and the parallel enumeration give the same errors in the same order
+    const ll errUppBound = 8;
+    LACMan serMan, parMan;
+    serMan.GenSasimiLACs(net, 100000);
+    parMan.GenSasimiLACs(net, 100000);
+    BatchErrEst(METR_TYPE::MAXED, 0, 1 << 12, 1).CompLacErrsByEnumAndPruneBadLacs(serMan, accSmlt, net, errUppBound);
+    BatchErrEst(METR_TYPE::MAXED, 0, 1 << 12, 4).CompLacErrsByEnumAndPruneBadLacs(parMan, accSmlt, net, errUppBound);
+    ASSERT_GT(serMan.GetLacNum(), 0);
+    ASSERT_EQ(serMan.GetLacNum(), parMan.GetLacNum());
+    for (int i = 0; i < serMan.GetLacNum(); ++i) {
+        EXPECT_EQ(serMan.GetLac(i).GetKey(), parMan.GetLac(i).GetKey());
+        EXPECT_EQ(serMan.GetLac(i).GetErr(), parMan.GetLac(i).GetErr());
+    }
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, SigIndexTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan net("./als/tests/benchmarks/absdiff.blif");
+    Simulator smlt(net, 0, 256, DISTR_TYPE::UNIF);
+    smlt.LogicSim();
+    SigIndex sigIndex(smlt);
+    IntVect ids;
+    for (int id = 0; id < net.GetIdMaxPlus1(); ++id) {
+        if (net.IsObj(id) && (net.IsObjPi(id) || net.IsNode(id)))
+            ids.emplace_back(id);
+    }
+    // the signatures equal to each other or to the complement of each other are in one class
+    for (int id0: ids) {
+        const auto& cls = sigIndex.GetClass(id0);
+        EXPECT_TRUE(std::find(cls.begin(), cls.end(), id0) != cls.end());
+        for (int id1: ids) {
+            int diff = CountXor(smlt.GetDat(id0), smlt.GetDat(id1));
+            if (diff == 0 || diff == smlt.GetFrameNumb())
+                EXPECT_TRUE(sigIndex.IsSameClass(id0, id1));
+        }
+    }
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, AigLacTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan accNet("./als/tests/benchmarks/absdiff.blif");
+    auto strashNet = accNet;
+    strashNet.Comm("st");
+    ASSERT_TRUE(strashNet.IsStrash());
+    // the error miter is built on the AIG directly
+    {ErrMan errMan(accNet, strashNet);
+    EXPECT_EQ(static_cast<ll>(errMan.ComputeMaxErr(METR_TYPE::MAXED)), 0);}
+    // the LACs are generated and applied on the AIG
+    LACMan lacMan;
+    lacMan.GenSasimiLACs(strashNet, 1000);
+    ASSERT_GT(lacMan.GetLacNum(), 0);
+    for (int iLac: {0, lacMan.GetLacNum() / 2, lacMan.GetLacNum() - 1}) {
+        auto appNet = strashNet;
+        ApplyLac(appNet, lacMan.GetLac(iLac));
+        EXPECT_TRUE(appNet.IsStrash());
+        EXPECT_TRUE(appNet.Check());
+        ErrMan errMan(accNet, appNet);
+        EXPECT_EQ(static_cast<ll>(errMan.ComputeMaxErr(METR_TYPE::MAXED)), errMan.GetMaxErrDistUsingEnum());
+    }
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, ErrMitMapTestAbsdiff) {
+    GlobStartAbc();
+
+    NetMan accNet("./als/tests/benchmarks/absdiff.blif");
+    auto appNet = accNet;
+    auto pDevNet = GenDevCompNet(METR_TYPE::MAXED, accNet.GetPoNum());
+    ErrMan errMan(accNet, appNet);
+    ErrMitMap mitMap;
+    auto pErrMit = errMan.BuildErrMit(accNet, appNet, *pDevNet, &mitMap);
+    EXPECT_TRUE(pErrMit->Check());
+    EXPECT_EQ(pErrMit->GetPiNum(), accNet.GetPiNum() + accNet.GetPoNum());
+    // the PIs are shared by index and keep their names
+    for (int i = 0; i < accNet.GetPiNum(); ++i) {
+        int mitId = mitMap.acc2Mit[accNet.GetPi(i)->Id];
+        EXPECT_EQ(mitId, pErrMit->GetPi(i)->Id);
+        EXPECT_EQ(mitMap.app2Mit[appNet.GetPi(i)->Id], mitId);
+        EXPECT_EQ(pErrMit->GetPiName(i), accNet.GetPiName(i));
+    }
+    // the accurate and the approximate nodes are copied separately
+    for (int id = 0; id < accNet.GetIdMaxPlus1(); ++id) {
+        if (accNet.IsNode(id) && !accNet.IsConst(id)) {
+            ASSERT_NE(mitMap.acc2Mit[id], -1);
+            ASSERT_NE(mitMap.app2Mit[id], -1);
+            EXPECT_NE(mitMap.acc2Mit[id], mitMap.app2Mit[id]);
+            EXPECT_EQ(pErrMit->GetFaninNum(mitMap.acc2Mit[id]), accNet.GetFaninNum(id));
+        }
+    }
+
+    GlobStopAbc();
+}
+
+
+TEST(ALSTest, SatSchedTest) {
+    SatSched sched(1 << 10, 1 << 15, 1, 0, 4);
+    EXPECT_EQ(sched.GetInitConfl(), 1 << 10);
+    EXPECT_EQ(sched.GetNextConfl(1 << 10), 1 << 12);
+    EXPECT_EQ(sched.GetNextConfl(1 << 14), 1 << 15);
+    EXPECT_EQ(sched.GetNextConfl(1 << 15), -1);
+    EXPECT_FALSE(sched.IsTimeOut());
+    SatSched timedSched(1 << 10, 1 << 15, 1, 1e-6);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_TRUE(timedSched.IsTimeOut());
+}
+
+
+TEST(ALSTest, ProfilerTrace) {
+    auto tracePath = (std::filesystem::temp_directory_path() / "als_prof_test.jsonl").string();
+    auto& prof = Profiler::Get();
+    prof.Config(true, tracePath);
+    EXPECT_TRUE(prof.IsQuiet());
+    {
+        ProfTimer timer(PROF_PHASE::SAT_SOLVE);
+    }
+    prof.AddCnt(PROF_CNT::SAT_UNSAT, 2);
+    prof.EndRound(1, "TEST");
+    // the round statistics are reset after each round
+    prof.EndRound(2, "TEST");
+    std::ifstream fin(tracePath);
+    std::string line0, line1;
+    ASSERT_TRUE(std::getline(fin, line0));
+    ASSERT_TRUE(std::getline(fin, line1));
+    EXPECT_NE(line0.find("\"round\": 1"), std::string::npos);
+    EXPECT_NE(line0.find("\"n_unsat\": 2"), std::string::npos);
+    EXPECT_NE(line1.find("\"n_unsat\": 0"), std::string::npos);
+    fin.close();
+    prof.Config(false, "");
+    std::filesystem::remove(tracePath);
+}